@@ -0,0 +1,218 @@
+/*
+ * Arquivo:  blas1.h
+ * Objetivo: kernels BLAS-1 distribuídos para os programas de vetores
+ *           (questao4, questao7, questao9).
+ *           - kernels locais sobre o bloco de cada processo: axpy, scal,
+ *             dot, soma dos quadrados (nrm2), e versões fundidas que
+ *             fazem várias operações numa única passada pela memória:
+ *             axpy+dot, waxpby, scal+soma dos quadrados
+ *           - reduções em lote: os resultados escalares de várias
+ *             reduções vão juntos num único MPI_Allreduce
+ *
+ * Uso:      #include "../include/blas1.h"     (compilar com -lm)
+ *
+ *           Blas1_batch b;
+ *           Blas1_batch_init(&b);
+ *           int s_xy = Blas1_batch_add(&b, Blas1_axpy_dot(n, a, x, y, w));
+ *           int s_xx = Blas1_batch_add(&b, Blas1_sumsq(n, x));
+ *           Blas1_batch_allreduce(&b, comm);     -> b.val[s_xy], b.val[s_xx]
+ *
+ * Notas:
+ * 1. Os kernels são laços simples sem dependência entre iterações; as
+ *    reduções usam 4 acumuladores independentes (o compilador gera
+ *    instruções SIMD sem precisar de -ffast-math).  Os laços são
+ *    sempre marcados "omp simd" (BLAS1_SIMD_FOR / BLAS1_SIMD_SUM),
+ *    que valem com -fopenmp-simd ou -fopenmp e são ignorados sem
+ *    elas.  gemv.h, gemm.h, trsv.h e pack.h usam as mesmas macros.
+ * 2. nrm2 = sqrt(soma dos quadrados), sem o reescalonamento do BLAS de
+ *    referência: os vetores destes programas não chegam perto de
+ *    overflow/underflow.
+ */
+
+#ifndef BLAS1_H
+#define BLAS1_H
+
+#include <math.h>
+#include <mpi.h>
+
+#define BLAS1_MAX_BATCH 16
+
+#define BLAS1_SIMD_FOR _Pragma("omp simd")
+#define BLAS1_SIMD_SUM _Pragma("omp simd reduction(+:s0,s1,s2,s3)")
+
+/* sem -fopenmp-simd as marcas "omp simd" são ignoradas, sem aviso */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+
+/*-------------------------------------------------------------------
+ * y = a*x + y
+ */
+static inline void Blas1_axpy(int n, double a, const double* restrict x,
+      double* restrict y) {
+   BLAS1_SIMD_FOR
+   for (int i = 0; i < n; i++)
+      y[i] += a * x[i];
+}
+
+
+/*-------------------------------------------------------------------
+ * x = a*x
+ */
+static inline void Blas1_scal(int n, double a, double* restrict x) {
+   BLAS1_SIMD_FOR
+   for (int i = 0; i < n; i++)
+      x[i] *= a;
+}
+
+
+/*-------------------------------------------------------------------
+ * w = a*x + b*y
+ */
+static inline void Blas1_waxpby(int n, double a, const double* restrict x,
+      double b, const double* restrict y, double* restrict w) {
+   BLAS1_SIMD_FOR
+   for (int i = 0; i < n; i++)
+      w[i] = a * x[i] + b * y[i];
+}
+
+
+/*-------------------------------------------------------------------
+ * Produto escalar local x.y
+ */
+static inline double Blas1_dot(int n, const double* restrict x,
+      const double* restrict y) {
+   double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+   int i;
+
+   BLAS1_SIMD_SUM
+   for (i = 0; i < n - 3; i += 4) {
+      s0 += x[i]   * y[i];
+      s1 += x[i+1] * y[i+1];
+      s2 += x[i+2] * y[i+2];
+      s3 += x[i+3] * y[i+3];
+   }
+   for (; i < n; i++)
+      s0 += x[i] * y[i];
+   return (s0 + s1) + (s2 + s3);
+}
+
+
+/*-------------------------------------------------------------------
+ * Soma local dos quadrados de x (nrm2 = sqrt da soma global)
+ */
+static inline double Blas1_sumsq(int n, const double* restrict x) {
+   double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+   int i;
+
+   BLAS1_SIMD_SUM
+   for (i = 0; i < n - 3; i += 4) {
+      s0 += x[i]   * x[i];
+      s1 += x[i+1] * x[i+1];
+      s2 += x[i+2] * x[i+2];
+      s3 += x[i+3] * x[i+3];
+   }
+   for (; i < n; i++)
+      s0 += x[i] * x[i];
+   return (s0 + s1) + (s2 + s3);
+}
+
+
+/*-------------------------------------------------------------------
+ * Fundido: y = a*x + y e devolve o produto local y.w (com o y novo),
+ *    numa passada só (w pode ser o próprio y)
+ */
+static inline double Blas1_axpy_dot(int n, double a,
+      const double* restrict x, double* y, const double* w) {
+   double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+   int i;
+
+   BLAS1_SIMD_SUM
+   for (i = 0; i < n - 3; i += 4) {
+      double y0 = y[i]   + a * x[i];
+      double y1 = y[i+1] + a * x[i+1];
+      double y2 = y[i+2] + a * x[i+2];
+      double y3 = y[i+3] + a * x[i+3];
+      y[i] = y0; y[i+1] = y1; y[i+2] = y2; y[i+3] = y3;
+      s0 += y0 * w[i];      /* w lido depois da escrita: w == y ok */
+      s1 += y1 * w[i+1];
+      s2 += y2 * w[i+2];
+      s3 += y3 * w[i+3];
+   }
+   for (; i < n; i++) {
+      y[i] += a * x[i];
+      s0 += y[i] * w[i];
+   }
+   return (s0 + s1) + (s2 + s3);
+}
+
+
+/*-------------------------------------------------------------------
+ * Fundido: x = a*x e devolve a soma local dos quadrados de y
+ *    (escalar um vetor e calcular a norma de outro numa passada)
+ */
+static inline double Blas1_scal_sumsq(int n, double a, double* restrict x,
+      const double* restrict y) {
+   double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+   int i;
+
+   BLAS1_SIMD_SUM
+   for (i = 0; i < n - 3; i += 4) {
+      x[i]   *= a; x[i+1] *= a; x[i+2] *= a; x[i+3] *= a;
+      s0 += y[i]   * y[i];
+      s1 += y[i+1] * y[i+1];
+      s2 += y[i+2] * y[i+2];
+      s3 += y[i+3] * y[i+3];
+   }
+   for (; i < n; i++) {
+      x[i] *= a;
+      s0 += y[i] * y[i];
+   }
+   return (s0 + s1) + (s2 + s3);
+}
+
+
+/*-------------------------------------------------------------------
+ * Reduções em lote: acumula escalares locais e soma todos com um
+ *    único MPI_Allreduce
+ */
+typedef struct {
+   double val[BLAS1_MAX_BATCH];
+   int    n;
+} Blas1_batch;
+
+static inline void Blas1_batch_init(Blas1_batch* b) {
+   b->n = 0;
+}
+
+/* devolve a posição do valor em b->val (ou -1 se o lote está cheio) */
+static inline int Blas1_batch_add(Blas1_batch* b, double local_val) {
+   if (b->n == BLAS1_MAX_BATCH) return -1;
+   b->val[b->n] = local_val;
+   return b->n++;
+}
+
+static inline void Blas1_batch_allreduce(Blas1_batch* b, MPI_Comm comm) {
+   if (b->n > 0)
+      MPI_Allreduce(MPI_IN_PLACE, b->val, b->n, MPI_DOUBLE, MPI_SUM, comm);
+}
+
+
+/*-------------------------------------------------------------------
+ * Versões distribuídas de uma operação só (uma redução cada)
+ */
+static inline double Blas1_pdot(int n, const double* x, const double* y,
+      MPI_Comm comm) {
+   double s = Blas1_dot(n, x, y);
+   MPI_Allreduce(MPI_IN_PLACE, &s, 1, MPI_DOUBLE, MPI_SUM, comm);
+   return s;
+}
+
+static inline double Blas1_pnrm2(int n, const double* x, MPI_Comm comm) {
+   double s = Blas1_sumsq(n, x);
+   MPI_Allreduce(MPI_IN_PLACE, &s, 1, MPI_DOUBLE, MPI_SUM, comm);
+   return sqrt(s);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
@@ -0,0 +1,290 @@
+/*
+ * Arquivo:  dvec.h
+ * Objetivo: vetor distribuído de doubles com descritor de distribuição
+ *           (layout) para qualquer n e qualquer número de processos:
+ *           - DVEC_BLOCK:        blocos contíguos, os n % p primeiros
+ *                                processos ficam com um elemento a mais
+ *           - DVEC_CYCLIC:       elemento g no processo g % p
+ *           - DVEC_BLOCK_CYCLIC: blocos de nb elementos distribuídos
+ *                                ciclicamente (o último pode ser menor)
+ *           O layout guarda, no processo raiz, um tipo derivado por
+ *           processo (já com commit) descrevendo onde os elementos dele
+ *           estão no vetor global; scatter/gather usam esses tipos num
+ *           único MPI_Alltoallw, sem empacotar no raiz, e os tipos são
+ *           criados uma vez e reaproveitados por todos os vetores com o
+ *           mesmo layout.  A troca de layout (Dvec_redistribute) é um
+ *           MPI_Alltoallv com empacotamento O(local_n).
+ *
+ * Uso:      #include "../include/dvec.h"
+ *
+ *           Dvec_layout lay;
+ *           Dvec x;
+ *           Dvec_layout_init(&lay, n, DVEC_BLOCK_CYCLIC, nb, comm);
+ *           Dvec_create(&x, &lay);
+ *           Dvec_scatter(&x, a, 0);      (a só é lido no processo 0)
+ *           ... x.local[0 .. lay.local_n-1] ...
+ *           Dvec_free(&x);
+ *           Dvec_layout_free(&lay);
+ *
+ * Nota:     os deslocamentos do MPI_Alltoallw são int em bytes, então
+ *           o vetor global no raiz deve ter menos de 2^31 bytes.
+ */
+
+#ifndef DVEC_H
+#define DVEC_H
+
+#include <stdlib.h>
+#include <mpi.h>
+
+typedef enum { DVEC_BLOCK, DVEC_CYCLIC, DVEC_BLOCK_CYCLIC } Dvec_kind;
+
+typedef struct {
+   Dvec_kind kind;
+   int n;             /* ordem do vetor global                      */
+   int nb;            /* tamanho do bloco (1 em DVEC_CYCLIC)        */
+   int p, my_rank;
+   int local_n;       /* elementos deste processo                   */
+   MPI_Comm comm;
+   int root;          /* raiz dos tipos em cache (-1: nenhum ainda) */
+   MPI_Datatype* types;   /* [p] tipos por processo, só no raiz     */
+} Dvec_layout;
+
+typedef struct {
+   Dvec_layout* lay;    /* compartilhado, não é liberado aqui */
+   double* local;
+} Dvec;
+
+
+/*-------------------------------------------------------------------
+ * Mapeamento índice global <-> (processo, índice local)
+ */
+static inline int Dvec_local_size(const Dvec_layout* L, int q) {
+   if (L->kind == DVEC_BLOCK)
+      return L->n / L->p + (q < L->n % L->p);
+
+   int n_blocks = (L->n + L->nb - 1) / L->nb;
+   int mine = n_blocks / L->p + (q < n_blocks % L->p);
+   int last = n_blocks - 1;
+   if (n_blocks > 0 && last % L->p == q)
+      mine = mine * L->nb - (n_blocks * L->nb - L->n);
+   else
+      mine = mine * L->nb;
+   return mine;
+}
+
+/* índice global do primeiro elemento do bloco DVEC_BLOCK de q */
+static inline int Dvec_block_first(const Dvec_layout* L, int q) {
+   int rem = L->n % L->p;
+   return q * (L->n / L->p) + (q < rem ? q : rem);
+}
+
+static inline int Dvec_owner(const Dvec_layout* L, int g) {
+   if (L->kind == DVEC_BLOCK) {
+      int base = L->n / L->p, rem = L->n % L->p;
+      int big = rem * (base + 1);
+      return (g < big) ? g / (base + 1) : rem + (g - big) / base;
+   }
+   return (g / L->nb) % L->p;
+}
+
+static inline int Dvec_local_index(const Dvec_layout* L, int g) {
+   if (L->kind == DVEC_BLOCK)
+      return g - Dvec_block_first(L, Dvec_owner(L, g));
+   int b = g / L->nb;
+   return (b / L->p) * L->nb + g % L->nb;
+}
+
+/* índice global do elemento local l do processo q */
+static inline int Dvec_global_index(const Dvec_layout* L, int q, int l) {
+   if (L->kind == DVEC_BLOCK)
+      return Dvec_block_first(L, q) + l;
+   return ((l / L->nb) * L->p + q) * L->nb + l % L->nb;
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_layout_init: nb só é usado em DVEC_BLOCK_CYCLIC (nb >= 1)
+ */
+static inline void Dvec_layout_init(Dvec_layout* L, int n, Dvec_kind kind,
+      int nb, MPI_Comm comm) {
+   L->kind = kind;
+   L->n = n;
+   L->nb = (kind == DVEC_BLOCK_CYCLIC && nb > 0) ? nb : 1;
+   L->comm = comm;
+   MPI_Comm_size(comm, &L->p);
+   MPI_Comm_rank(comm, &L->my_rank);
+   L->local_n = Dvec_local_size(L, L->my_rank);
+   L->root = -1;
+   L->types = NULL;
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_type_of: tipo com os elementos de q dentro do vetor global,
+ *    a partir do primeiro deles (deslocamento dado no Alltoallw)
+ */
+static inline MPI_Datatype Dvec_type_of(const Dvec_layout* L, int q) {
+   MPI_Datatype t, full;
+   int size = Dvec_local_size(L, q);
+
+   if (L->kind == DVEC_BLOCK || size == 0) {
+      MPI_Type_contiguous(size, MPI_DOUBLE, &t);
+   } else {
+      /* k_full blocos inteiros com passo nb*p, e talvez um bloco final
+         menor (o último bloco do vetor) */
+      int k_full = size / L->nb, tail = size % L->nb;
+      MPI_Type_vector(k_full, L->nb, L->nb * L->p, MPI_DOUBLE, &full);
+      if (tail == 0) {
+         t = full;
+      } else {
+         MPI_Datatype parts[2] = { full, MPI_DOUBLE };
+         int lens[2] = { 1, tail };
+         MPI_Aint displs[2] = { 0,
+               (MPI_Aint) k_full * L->nb * L->p * sizeof(double) };
+         MPI_Type_create_struct(2, lens, displs, parts, &t);
+         MPI_Type_free(&full);
+      }
+   }
+   MPI_Type_commit(&t);
+   return t;
+}
+
+/* cria (uma vez por raiz) os tipos por processo */
+static inline void Dvec_cache_types(Dvec_layout* L, int root) {
+   if (L->root == root) return;
+   if (L->types != NULL) {
+      for (int q = 0; q < L->p; q++)
+         MPI_Type_free(&L->types[q]);
+      free(L->types);
+      L->types = NULL;
+   }
+   if (L->my_rank == root) {
+      L->types = malloc(L->p * sizeof(MPI_Datatype));
+      for (int q = 0; q < L->p; q++)
+         L->types[q] = Dvec_type_of(L, q);
+   }
+   L->root = root;
+}
+
+static inline void Dvec_layout_free(Dvec_layout* L) {
+   if (L->types != NULL) {
+      for (int q = 0; q < L->p; q++)
+         MPI_Type_free(&L->types[q]);
+      free(L->types);
+   }
+   L->types = NULL;
+   L->root = -1;
+}
+
+
+/*-------------------------------------------------------------------
+ * Vetores
+ */
+static inline void Dvec_create(Dvec* v, Dvec_layout* L) {
+   v->lay = L;
+   v->local = malloc((L->local_n > 0 ? L->local_n : 1) * sizeof(double));
+}
+
+static inline void Dvec_free(Dvec* v) {
+   free(v->local);
+   v->local = NULL;
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_xfer: scatter (dir = 0) ou gather (dir = 1) entre o vetor global
+ *    a do raiz e os blocos locais, com um MPI_Alltoallw em que só os
+ *    pares (raiz, q) têm contagem não nula
+ */
+static inline void Dvec_xfer(Dvec* v, double* a, int root, int dir) {
+   Dvec_layout* L = v->lay;
+   int p = L->p;
+   int* counts = calloc(4 * p, sizeof(int));
+   int *r_counts = counts + p, *displs = counts + 2*p, *zeros = counts + 3*p;
+   MPI_Datatype* dtypes = malloc(2 * p * sizeof(MPI_Datatype));
+   MPI_Datatype* r_types = dtypes + p;
+
+   Dvec_cache_types(L, root);
+   for (int q = 0; q < p; q++) {
+      dtypes[q] = MPI_DOUBLE;
+      r_types[q] = MPI_DOUBLE;
+   }
+
+   /* lado do raiz: 1 elemento do tipo de q a partir do primeiro dele */
+   if (L->my_rank == root)
+      for (int q = 0; q < p; q++) {
+         counts[q] = 1;
+         dtypes[q] = L->types[q];
+         displs[q] = (Dvec_local_size(L, q) > 0) ?
+               Dvec_global_index(L, q, 0) * (int) sizeof(double) : 0;
+      }
+   /* lado local: local_n doubles contíguos de/para o raiz */
+   r_counts[root] = L->local_n;
+
+   if (dir == 0)
+      MPI_Alltoallw(a, counts, displs, dtypes,
+                    v->local, r_counts, zeros, r_types, L->comm);
+   else
+      MPI_Alltoallw(v->local, r_counts, zeros, r_types,
+                    a, counts, displs, dtypes, L->comm);
+
+   free(counts);
+   free(dtypes);
+}
+
+/* a (no raiz) -> v */
+static inline void Dvec_scatter(Dvec* v, double* a, int root) {
+   Dvec_xfer(v, a, root, 0);
+}
+
+/* v -> a (no raiz) */
+static inline void Dvec_gather(Dvec* v, double* a, int root) {
+   Dvec_xfer(v, a, root, 1);
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_redistribute: y = x com outro layout (mesmo n e comm)
+ *    Nos três layouts o índice global cresce com o índice local, então
+ *    o que q manda para r já chega na ordem em que r o guarda: basta
+ *    empacotar por destino, MPI_Alltoallv, e desempacotar percorrendo
+ *    os índices locais de y com um cursor por origem.
+ */
+static inline void Dvec_redistribute(const Dvec* x, Dvec* y) {
+   const Dvec_layout *from = x->lay, *to = y->lay;
+   int p = from->p, me = from->my_rank;
+   int* cnt = calloc(4 * p, sizeof(int));
+   int *s_displs = cnt + p, *r_cnt = cnt + 2*p, *r_displs = cnt + 3*p;
+   int* cursor = malloc(p * sizeof(int));
+   double* s_buf = calloc(from->local_n + 1, sizeof(double));
+   double* r_buf = malloc((to->local_n + 1) * sizeof(double));
+
+   for (int l = 0; l < from->local_n; l++)
+      cnt[Dvec_owner(to, Dvec_global_index(from, me, l))]++;
+   for (int l = 0; l < to->local_n; l++)
+      r_cnt[Dvec_owner(from, Dvec_global_index(to, me, l))]++;
+   for (int q = 1; q < p; q++) {
+      s_displs[q] = s_displs[q-1] + cnt[q-1];
+      r_displs[q] = r_displs[q-1] + r_cnt[q-1];
+   }
+
+   for (int q = 0; q < p; q++) cursor[q] = s_displs[q];
+   for (int l = 0; l < from->local_n; l++)
+      s_buf[cursor[Dvec_owner(to, Dvec_global_index(from, me, l))]++] =
+            x->local[l];
+
+   MPI_Alltoallv(s_buf, cnt, s_displs, MPI_DOUBLE,
+                 r_buf, r_cnt, r_displs, MPI_DOUBLE, from->comm);
+
+   for (int q = 0; q < p; q++) cursor[q] = r_displs[q];
+   for (int l = 0; l < to->local_n; l++)
+      y->local[l] =
+            r_buf[cursor[Dvec_owner(from, Dvec_global_index(to, me, l))]++];
+
+   free(cnt);
+   free(cursor);
+   free(s_buf);
+   free(r_buf);
+}
+
+#endif
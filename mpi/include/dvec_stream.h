@@ -0,0 +1,258 @@
+/*
+ * Arquivo:  dvec_stream.h
+ * Objetivo: leitura e escrita em fluxo de vetores distribuídos (dvec.h):
+ *           o processo raiz nunca guarda o vetor inteiro.
+ *           - Dvec_stream_read: o raiz lê o texto com o leitor de
+ *             fastio.h, converte DVEC_CHUNK números por vez e manda a
+ *             parte de cada dono com
+ *             MPI_Isend enquanto converte o próximo pedaço (dois
+ *             buffers alternados); os outros processos postam antes
+ *             todos os MPI_Irecv direto no vetor local
+ *           - Dvec_stream_write: o inverso; os processos mandam seus
+ *             pedaços com MPI_Isend, o raiz recebe o pedaço k+1
+ *             enquanto formata o pedaço k (Fio_out de fastio.h)
+ *           Memória no raiz: O(DVEC_CHUNK + buffers de texto), não O(n).
+ *           Como cada processo recebe/envia os pedaços na ordem global,
+ *           uma única tag basta (mensagens do mesmo par não se
+ *           ultrapassam).
+ *
+ * Uso:      #include "../include/dvec_stream.h"   (inclui dvec.h, fastio.h)
+ *
+ *           Fio_in* in = NULL;                (só o raiz abre o leitor)
+ *           if (my_rank == 0) in = Fio_open(stdin);
+ *           Dvec_io_stats st;
+ *           Dvec_stream_read(&x, in, 0, &st);
+ *           Dvec_stream_write(&x, stdout, 6, 0, &st);   (= "%f " por número)
+ *           if (my_rank == 0) Fio_close(in);
+ *           st.secs, st.bytes, st.count: válidos no raiz
+ */
+
+#ifndef DVEC_STREAM_H
+#define DVEC_STREAM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "dvec.h"
+#include "fastio.h"
+
+#ifndef DVEC_CHUNK
+#define DVEC_CHUNK 65536          /* números por pedaço            */
+#endif
+#define DVEC_STREAM_TAG 77
+
+typedef struct {
+   double    secs;    /* tempo do raiz na operação toda   */
+   long long bytes;   /* bytes de texto lidos/escritos    */
+   long long count;   /* números lidos/escritos           */
+} Dvec_io_stats;
+
+
+/* taxa de uma leitura/escrita, em stderr (stdout fica só com os dados) */
+static inline void Dvec_print_rate(const char* what, const Dvec_io_stats* st) {
+   double secs = (st->secs > 0.0) ? st->secs : 1e-9;
+   fprintf(stderr, "%s: %lld números em %.3f s (%.3e números/s, %.1f MB/s)\n",
+         what, st->count, st->secs, st->count / secs, st->bytes / secs / 1e6);
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_chunk_counts: quantos elementos de cada processo há em
+ *    [g0, g1), e onde começa a parte de cada um no buffer do pedaço
+ */
+static inline void Dvec_chunk_counts(const Dvec_layout* L, int g0, int g1,
+      int cnt[], int displs[]) {
+   for (int q = 0; q < L->p; q++) cnt[q] = 0;
+   for (int g = g0; g < g1; g++)
+      cnt[Dvec_owner(L, g)]++;
+   displs[0] = 0;
+   for (int q = 1; q < L->p; q++)
+      displs[q] = displs[q-1] + cnt[q-1];
+}
+
+/* receptor/emissor fora do raiz: [início, quantidade) local por pedaço,
+   na ordem dos pedaços; devolve o número de pedaços não vazios */
+static inline int Dvec_my_chunks(const Dvec_layout* L, int first[],
+      int count[]) {
+   int n_parts = 0, l = 0;
+   for (int g0 = 0; g0 < L->n && l < L->local_n; g0 += DVEC_CHUNK) {
+      int g1 = g0 + DVEC_CHUNK, l0 = l;
+      while (l < L->local_n && Dvec_global_index(L, L->my_rank, l) < g1)
+         l++;
+      if (l > l0) {
+         first[n_parts] = l0;
+         count[n_parts] = l - l0;
+         n_parts++;
+      }
+   }
+   return n_parts;
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_stream_read: lê os n números de v do leitor in (só usado no
+ *    raiz) e distribui conforme o layout de v
+ */
+static inline void Dvec_stream_read(Dvec* v, Fio_in* in, int root,
+      Dvec_io_stats* st) {
+   Dvec_layout* L = v->lay;
+   int p = L->p;
+   double start = MPI_Wtime();
+
+   st->secs = 0.0;
+   st->bytes = st->count = 0;
+
+   if (L->my_rank != root) {
+      int max_parts = L->local_n + 1;
+      int* first = malloc(2 * max_parts * sizeof(int));
+      int* count = first + max_parts;
+      int n_parts = Dvec_my_chunks(L, first, count);
+      MPI_Request* reqs = malloc((n_parts + 1) * sizeof(MPI_Request));
+      for (int k = 0; k < n_parts; k++)
+         MPI_Irecv(v->local + first[k], count[k], MPI_DOUBLE, root,
+               DVEC_STREAM_TAG, L->comm, &reqs[k]);
+      MPI_Waitall(n_parts, reqs, MPI_STATUSES_IGNORE);
+      free(reqs);
+      free(first);
+      return;
+   }
+
+   long long consumed0 = in->consumed;
+   double* buf[2] = { malloc(DVEC_CHUNK * sizeof(double)),
+                      malloc(DVEC_CHUNK * sizeof(double)) };
+   MPI_Request* reqs[2] = { malloc(p * sizeof(MPI_Request)),
+                            malloc(p * sizeof(MPI_Request)) };
+   int n_reqs[2] = { 0, 0 };
+   int* cnt = malloc(3 * p * sizeof(int));
+   int *displs = cnt + p, *cursor = cnt + 2*p;
+   int my_l = 0, b = 0;
+
+   for (int g0 = 0; g0 < L->n; g0 += DVEC_CHUNK, b ^= 1) {
+      int g1 = (g0 + DVEC_CHUNK < L->n) ? g0 + DVEC_CHUNK : L->n;
+
+      /* o buffer b só é reutilizado depois que seus envios acabaram */
+      MPI_Waitall(n_reqs[b], reqs[b], MPI_STATUSES_IGNORE);
+      n_reqs[b] = 0;
+
+      Dvec_chunk_counts(L, g0, g1, cnt, displs);
+      memcpy(cursor, displs, p * sizeof(int));
+      for (int g = g0; g < g1; g++) {
+         double x;
+         if (!Fio_read_double(in, &x)) x = 0.0;
+         int q = Dvec_owner(L, g);
+         if (q == root) v->local[my_l++] = x;
+         else           buf[b][cursor[q]++] = x;
+      }
+      for (int q = 0; q < p; q++)
+         if (q != root && cnt[q] > 0)
+            MPI_Isend(buf[b] + displs[q], cnt[q], MPI_DOUBLE, q,
+                  DVEC_STREAM_TAG, L->comm, &reqs[b][n_reqs[b]++]);
+   }
+   MPI_Waitall(n_reqs[0], reqs[0], MPI_STATUSES_IGNORE);
+   MPI_Waitall(n_reqs[1], reqs[1], MPI_STATUSES_IGNORE);
+
+   st->secs = MPI_Wtime() - start;
+   st->bytes = in->consumed - consumed0;
+   st->count = L->n;
+
+   free(buf[0]); free(buf[1]);
+   free(reqs[0]); free(reqs[1]);
+   free(cnt);
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_post_chunk: no raiz, posta os MPI_Irecv do pedaço que começa em
+ *    g0 em buf (partes por processo em displs); devolve quantos
+ */
+static inline int Dvec_post_chunk(Dvec* v, int g0, int root, double* buf,
+      int cnt[], int displs[], MPI_Request reqs[]) {
+   Dvec_layout* L = v->lay;
+   int g1 = (g0 + DVEC_CHUNK < L->n) ? g0 + DVEC_CHUNK : L->n;
+   int n_reqs = 0;
+
+   Dvec_chunk_counts(L, g0, g1, cnt, displs);
+   for (int q = 0; q < L->p; q++)
+      if (q != root && cnt[q] > 0)
+         MPI_Irecv(buf + displs[q], cnt[q], MPI_DOUBLE, q,
+               DVEC_STREAM_TAG, L->comm, &reqs[n_reqs++]);
+   return n_reqs;
+}
+
+
+/*-------------------------------------------------------------------
+ * Dvec_stream_write: escreve v em f (no raiz), cada número como
+ *    printf("%.*f ", prec, x), seguido de '\n'; prec < 0: formato
+ *    mais curto que volta ao mesmo valor
+ */
+static inline void Dvec_stream_write(Dvec* v, FILE* f, int prec,
+      int root, Dvec_io_stats* st) {
+   Dvec_layout* L = v->lay;
+   int p = L->p;
+   double start = MPI_Wtime();
+
+   st->secs = 0.0;
+   st->bytes = st->count = 0;
+
+   if (L->my_rank != root) {
+      int max_parts = L->local_n + 1;
+      int* first = malloc(2 * max_parts * sizeof(int));
+      int* count = first + max_parts;
+      int n_parts = Dvec_my_chunks(L, first, count);
+      MPI_Request* reqs = malloc((n_parts + 1) * sizeof(MPI_Request));
+      for (int k = 0; k < n_parts; k++)
+         MPI_Isend(v->local + first[k], count[k], MPI_DOUBLE, root,
+               DVEC_STREAM_TAG, L->comm, &reqs[k]);
+      MPI_Waitall(n_parts, reqs, MPI_STATUSES_IGNORE);
+      free(reqs);
+      free(first);
+      return;
+   }
+
+   Fio_out* out = Fio_out_open(f);
+   double* buf[2] = { malloc(DVEC_CHUNK * sizeof(double)),
+                      malloc(DVEC_CHUNK * sizeof(double)) };
+   MPI_Request* reqs[2] = { malloc(p * sizeof(MPI_Request)),
+                            malloc(p * sizeof(MPI_Request)) };
+   int n_reqs[2] = { 0, 0 };
+   int* cnt = malloc(6 * p * sizeof(int));
+   int *displs = cnt + p, *cursor = cnt + 2*p;
+   int *cnt2 = cnt + 3*p, *displs2 = cnt + 4*p;
+   int *c_cnt[2] = { cnt, cnt2 }, *c_displs[2] = { displs, displs2 };
+   int my_l = 0, b = 0;
+
+   if (L->n > 0)
+      n_reqs[0] = Dvec_post_chunk(v, 0, root, buf[0], c_cnt[0], c_displs[0],
+            reqs[0]);
+   for (int g0 = 0; g0 < L->n; g0 += DVEC_CHUNK, b ^= 1) {
+      int g1 = (g0 + DVEC_CHUNK < L->n) ? g0 + DVEC_CHUNK : L->n;
+
+      MPI_Waitall(n_reqs[b], reqs[b], MPI_STATUSES_IGNORE);
+      if (g1 < L->n)
+         n_reqs[b^1] = Dvec_post_chunk(v, g1, root, buf[b^1], c_cnt[b^1],
+               c_displs[b^1], reqs[b^1]);
+
+      memcpy(cursor, c_displs[b], p * sizeof(int));
+      for (int g = g0; g < g1; g++) {
+         int q = Dvec_owner(L, g);
+         double x = (q == root) ? v->local[my_l++] : buf[b][cursor[q]++];
+         if (prec >= 0) Fio_write_fixed(out, x, prec, ' ');
+         else           Fio_write_shortest(out, x, ' ');
+      }
+   }
+   Fio_write_char(out, '\n');
+   Fio_out_flush(out);
+   st->bytes = out->written;
+   Fio_out_close(out);
+
+   st->secs = MPI_Wtime() - start;
+   st->count = L->n;
+
+   free(buf[0]); free(buf[1]);
+   free(reqs[0]); free(reqs[1]);
+   free(cnt);
+}
+
+#endif
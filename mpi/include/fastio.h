@@ -0,0 +1,484 @@
+/*
+ * Arquivo:  fastio.h
+ * Objetivo: E/S de texto rápida para o processo 0 (leitura e impressão
+ *           de listas e vetores), no lugar de scanf/printf por elemento.
+ *           - Fio_in: lê blocos grandes do FILE (fread) ou mapeia o
+ *             arquivo inteiro (mmap, Fio_open_path); os conversores
+ *             trabalham direto no buffer, sem locale e sem cópia.
+ *             Se o FILE não é um arquivo comum (terminal, ou o pipe
+ *             pelo qual o mpirun repassa o stdin) lê linha a linha
+ *             (fgets), para que os programas com prompt não esperem
+ *             pelo fim da entrada
+ *           - inteiros: 8 dígitos por vez com aritmética SWAR (64 bits)
+ *           - doubles: caminho rápido exato (Clinger) para decimais de
+ *             até 19 dígitos e |expoente| <= 22, senão strtod
+ *           - Fio_out: buffer de saída de 1 MB; inteiros com tabela de
+ *             dois dígitos; doubles com precisão fixa (mesmo texto de
+ *             printf("%.*f")) ou num texto que volta ao mesmo double
+ *             quando relido (round-trip): o mais curto para valores
+ *             com até 17 casas decimais, "%.17g" para os outros
+ *
+ * Uso:      #include "../include/fastio.h"
+ *
+ *           Fio_in* in = Fio_open(stdin);     ou Fio_open_path("x.txt")
+ *           int k;  double x;
+ *           while (Fio_read_int(in, &k)) ...  /  Fio_read_double(in, &x)
+ *           Fio_close(in);
+ *
+ *           Fio_out* out = Fio_out_open(stdout);
+ *           Fio_write_int(out, k, ' ');
+ *           Fio_write_fixed(out, x, 6, ' ');  (= printf("%f "))
+ *           Fio_write_shortest(out, x, '\n');
+ *           Fio_out_close(out);               (descarrega; não fecha o FILE)
+ *
+ * Notas:
+ * 1. Depois de Fio_open(f), todas as leituras de f devem passar pelo
+ *    leitor: ele guarda o texto lido adiantado.  Leituras anteriores
+ *    com scanf são válidas (o buffer do FILE é respeitado).
+ * 2. Fio_out_open faz fflush(f) antes, para manter a ordem do que já
+ *    foi impresso com printf.
+ */
+
+#ifndef FASTIO_H
+#define FASTIO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FIO_BUF (1 << 20)
+#define FIO_PAD 64          /* bytes lidos adiante pelos conversores */
+
+typedef struct {
+   FILE*       f;          /* NULL se o arquivo foi mapeado         */
+   char*       buf;        /* buffer próprio ou região mapeada      */
+   size_t      len, pos;
+   size_t      map_len;
+   int         eof;
+   int         lines;      /* f não é arquivo comum: lê por linha   */
+   long long   consumed;   /* bytes já convertidos                  */
+} Fio_in;
+
+typedef struct {
+   FILE*       f;
+   char*       buf;
+   size_t      used;
+   long long   written;
+} Fio_out;
+
+static const double Fio_p10[23] = {
+   1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+
+/*-------------------------------------------------------------------
+ * Leitor
+ */
+static inline Fio_in* Fio_open(FILE* f) {
+   Fio_in* in = malloc(sizeof(Fio_in));
+   in->f = f;
+   in->buf = malloc(FIO_BUF + FIO_PAD);
+   in->len = in->pos = in->map_len = 0;
+   in->eof = 0;
+   struct stat sb;
+   in->lines = !(fstat(fileno(f), &sb) == 0 && S_ISREG(sb.st_mode));
+   in->consumed = 0;
+   return in;
+}
+
+/* mapeia o arquivo inteiro; NULL se não der (use Fio_open então) */
+static inline Fio_in* Fio_open_path(const char* path) {
+   int fd = open(path, O_RDONLY);
+   struct stat sb;
+   if (fd < 0) return NULL;
+   if (fstat(fd, &sb) != 0 || sb.st_size == 0) { close(fd); return NULL; }
+   void* p = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (p == MAP_FAILED) return NULL;
+   madvise(p, sb.st_size, MADV_SEQUENTIAL);
+
+   Fio_in* in = malloc(sizeof(Fio_in));
+   in->f = NULL;
+   in->buf = p;
+   in->len = in->map_len = sb.st_size;
+   in->pos = 0;
+   in->eof = 1;
+   in->lines = 0;
+   in->consumed = 0;
+   return in;
+}
+
+static inline void Fio_close(Fio_in* in) {
+   if (in->f == NULL) munmap(in->buf, in->map_len);
+   else               free(in->buf);
+   free(in);
+}
+
+/* pelo menos want bytes à frente, se o arquivo tiver; os bytes após
+   len são zerados para os conversores poderem ler 8 de uma vez.  Fora
+   de arquivo comum para no fim da linha: fread esperaria o bloco
+   inteiro (ou o fim da entrada) */
+static inline void Fio_fill(Fio_in* in, size_t want) {
+   if (in->len - in->pos >= want || in->eof) return;
+   if (in->lines && in->len > in->pos && in->buf[in->len-1] == '\n')
+      return;                  /* nenhum número atravessa a linha */
+   memmove(in->buf, in->buf + in->pos, in->len - in->pos);
+   in->len -= in->pos;
+   in->pos = 0;
+   while (in->len < want && !in->eof) {
+      size_t got;
+      if (in->lines) {
+         char* line = in->buf + in->len;
+         if (fgets(line, (int) (FIO_BUF - in->len + 1), in->f) == NULL) {
+            in->eof = 1;
+            break;
+         }
+         got = strlen(line);
+         in->len += got;
+         if (got > 0 && line[got-1] == '\n') break;
+         continue;
+      }
+      got = fread(in->buf + in->len, 1, FIO_BUF - in->len, in->f);
+      in->len += got;
+      if (got == 0) in->eof = 1;
+   }
+   memset(in->buf + in->len, 0, FIO_PAD);   /* só no buffer próprio */
+}
+
+/* pula espaços; 0 no fim do arquivo */
+static inline int Fio_skip_space(Fio_in* in) {
+   for (;;) {
+      Fio_fill(in, FIO_PAD);
+      while (in->pos < in->len && (unsigned char) in->buf[in->pos] <= ' ')
+         in->pos++;
+      if (in->pos < in->len) {
+         Fio_fill(in, 400);
+         return 1;
+      }
+      if (in->eof) return 0;
+   }
+}
+
+/* 8 dígitos ASCII em s (little-endian) -> valor, ou -1 se algum não é
+   dígito */
+static inline int64_t Fio_eight_digits(const char* s) {
+#  if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   uint64_t v;
+   memcpy(&v, s, 8);
+   if ((((v & 0xF0F0F0F0F0F0F0F0ULL) |
+         (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+        != 0x3333333333333333ULL))
+      return -1;
+   v -= 0x3030303030303030ULL;
+   v = (v * 10) + (v >> 8);
+   v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+        (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))))
+       >> 32;
+   return (int64_t) v;
+#  else
+   (void) s;
+   return -1;
+#  endif
+}
+
+/*-------------------------------------------------------------------
+ * Fio_read_ll: próximo inteiro (sinal opcional); 0 no fim do arquivo
+ *    ou se o token não tem dígitos (um "-" sozinho, texto), que é
+ *    pulado
+ */
+static inline int Fio_read_ll(Fio_in* in, long long* x_p) {
+   if (!Fio_skip_space(in)) return 0;
+
+   const char *s = in->buf + in->pos, *end = in->buf + in->len;
+   const char* start = s;
+   int neg = 0;
+   uint64_t m = 0;
+
+   if (*s == '-' || *s == '+') neg = (*s++ == '-');
+   const char* digits = s;
+   int64_t eight;
+   while (end - s >= 8 && (eight = Fio_eight_digits(s)) >= 0) {
+      m = m * 100000000ULL + (uint64_t) eight;
+      s += 8;
+   }
+   while (s < end && *s >= '0' && *s <= '9')
+      m = 10*m + (uint64_t) (*s++ - '0');
+
+   int ok = (s > digits);
+   if (!ok)                       /* não é número: pula o token */
+      while (s < end && (unsigned char) *s > ' ') s++;
+   else
+      *x_p = neg ? -(long long) m : (long long) m;
+   in->consumed += s - start;
+   in->pos = s - in->buf;
+   return ok;
+}
+
+static inline int Fio_read_int(Fio_in* in, int* x_p) {
+   long long x = 0;
+   if (!Fio_read_ll(in, &x)) return 0;
+   *x_p = (int) x;
+   return 1;
+}
+
+/*-------------------------------------------------------------------
+ * Fio_read_double: próximo número real; 0 no fim do arquivo ou se
+ *    o token não é número (pulado, como em Fio_read_ll).  Até 19 dígitos significativos sem dígitos descartados e expoente
+ *    decimal |e| <= 22: m * 10^e ou m / 10^-e arredonda uma única vez,
+ *    o mesmo resultado de strtod.  Senão (ou inf/nan/hex), strtod.
+ */
+static inline int Fio_read_double(Fio_in* in, double* x_p) {
+   if (!Fio_skip_space(in)) return 0;
+
+   const char *s = in->buf + in->pos, *end = in->buf + in->len;
+   const char* start = s;
+   int neg = 0, n_dig = 0, n_seen = 0, exp10 = 0, dropped = 0, ok = 1;
+   uint64_t m = 0;
+
+   if (*s == '-' || *s == '+') neg = (*s++ == '-');
+   while (s < end && *s >= '0' && *s <= '9') {
+      if (n_dig < 19) { m = 10*m + (*s - '0'); if (m) n_dig++; }
+      else { exp10++; dropped |= (*s != '0'); }
+      s++;
+      n_seen++;
+   }
+   if (s < end && *s == '.') {
+      s++;
+      while (s < end && *s >= '0' && *s <= '9') {
+         if (n_dig < 19) { m = 10*m + (*s - '0'); if (m) n_dig++; exp10--; }
+         else dropped |= (*s != '0');
+         s++;
+         n_seen++;
+      }
+   }
+   if (s < end && (*s == 'e' || *s == 'E')) {
+      const char* e = s + 1;
+      int e_neg = 0, e_val = 0;
+      if (e < end && (*e == '-' || *e == '+')) e_neg = (*e++ == '-');
+      if (e < end && *e >= '0' && *e <= '9') {
+         while (e < end && *e >= '0' && *e <= '9') {
+            if (e_val < 100000) e_val = 10*e_val + (*e - '0');
+            e++;
+         }
+         exp10 += e_neg ? -e_val : e_val;
+         s = e;
+      }
+   }
+
+   int plain = n_seen > 0 && (s == end || (unsigned char) *s <= ' ');
+   if (plain && !dropped && m < (1ULL << 53) && exp10 >= -22 &&
+       exp10 <= 22) {
+      double x = (double) m;
+      x = (exp10 < 0) ? x / Fio_p10[-exp10] : x * Fio_p10[exp10];
+      *x_p = neg ? -x : x;
+   } else {
+      char tok[401], *stop;
+      size_t k = 0;
+      s = start;
+      while (s < end && (unsigned char) *s > ' ' && k < 400)
+         tok[k++] = *s++;
+      tok[k] = '\0';
+      double x = strtod(tok, &stop);
+      if (stop == tok) ok = 0;
+      else             *x_p = x;
+   }
+   in->consumed += s - start;
+   in->pos = s - in->buf;
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Escritor
+ */
+static inline Fio_out* Fio_out_open(FILE* f) {
+   Fio_out* out = malloc(sizeof(Fio_out));
+   fflush(f);
+   out->f = f;
+   out->buf = malloc(FIO_BUF);
+   out->used = 0;
+   out->written = 0;
+   return out;
+}
+
+static inline void Fio_out_flush(Fio_out* out) {
+   fwrite(out->buf, 1, out->used, out->f);
+   out->written += out->used;
+   out->used = 0;
+}
+
+static inline void Fio_out_close(Fio_out* out) {
+   Fio_out_flush(out);
+   fflush(out->f);
+   free(out->buf);
+   free(out);
+}
+
+/* garante espaço para mais need bytes */
+static inline char* Fio_reserve(Fio_out* out, size_t need) {
+   if (out->used + need > FIO_BUF) Fio_out_flush(out);
+   return out->buf + out->used;
+}
+
+static inline void Fio_write_char(Fio_out* out, char c) {
+   *Fio_reserve(out, 1) = c;
+   out->used++;
+}
+
+static inline void Fio_write_str(Fio_out* out, const char* str) {
+   size_t len = strlen(str);
+   if (len > FIO_BUF / 2) {
+      Fio_out_flush(out);
+      fwrite(str, 1, len, out->f);
+      out->written += len;
+      return;
+   }
+   memcpy(Fio_reserve(out, len), str, len);
+   out->used += len;
+}
+
+/* dígitos de u em p (sem terminador); devolve quantos */
+static inline int Fio_utoa(uint64_t u, char* p) {
+   static const char pairs[201] =
+      "00010203040506070809101112131415161718192021222324252627282930"
+      "31323334353637383940414243444546474849505152535455565758596061"
+      "62636465666768697071727374757677787980818283848586878889909192"
+      "93949596979899";
+   char tmp[20];
+   int k = 20;
+   while (u >= 100) {
+      int r = (int) (u % 100);
+      u /= 100;
+      tmp[--k] = pairs[2*r + 1];
+      tmp[--k] = pairs[2*r];
+   }
+   if (u >= 10) {
+      tmp[--k] = pairs[2*u + 1];
+      tmp[--k] = pairs[2*u];
+   } else {
+      tmp[--k] = (char) ('0' + u);
+   }
+   memcpy(p, tmp + k, 20 - k);
+   return 20 - k;
+}
+
+/* inteiro seguido de sep (sep = 0: nenhum) */
+static inline void Fio_write_ll(Fio_out* out, long long x, char sep) {
+   char* p = Fio_reserve(out, 24);
+   int k = 0;
+   uint64_t u = (uint64_t) x;
+   if (x < 0) { p[k++] = '-'; u = 0 - u; }
+   k += Fio_utoa(u, p + k);
+   if (sep) p[k++] = sep;
+   out->used += k;
+}
+
+static inline void Fio_write_int(Fio_out* out, int x, char sep) {
+   Fio_write_ll(out, x, sep);
+}
+
+/* inteiro |m| < 2^63 com a vírgula decimal k dígitos da direita */
+static inline int Fio_put_scaled(char* p, int neg, uint64_t m, int k) {
+   char digits[24];
+   int n = Fio_utoa(m, digits), len = 0;
+   if (neg) p[len++] = '-';
+   if (n <= k) {                         /* 0.000ddd */
+      p[len++] = '0';
+      p[len++] = '.';
+      memset(p + len, '0', k - n);
+      len += k - n;
+      memcpy(p + len, digits, n);
+      len += n;
+   } else {
+      memcpy(p + len, digits, n - k);
+      len += n - k;
+      if (k > 0) {
+         p[len++] = '.';
+         memcpy(p + len, digits + n - k, k);
+         len += k;
+      }
+   }
+   return len;
+}
+
+/*-------------------------------------------------------------------
+ * Fio_write_fixed: o mesmo texto de printf("%.*f", prec, x)
+ *    Caminho rápido quando x*10^prec < 2^43 e não está perto de um
+ *    empate de arredondamento (onde o produto em double poderia
+ *    arredondar para o lado errado); senão usa snprintf num espaço
+ *    reservado para o pior caso (309 dígitos inteiros + prec), ou
+ *    fprintf direto se nem isso cabe no buffer.
+ */
+static inline void Fio_write_fixed(Fio_out* out, double x, int prec,
+      char sep) {
+   size_t need = 320 + (size_t) (prec >= 0 ? prec : 6);
+   if (need > FIO_BUF / 2) {
+      Fio_out_flush(out);
+      out->written += fprintf(out->f, "%.*f", prec, x);
+      if (sep) {
+         fputc(sep, out->f);
+         out->written++;
+      }
+      return;
+   }
+   char* p = Fio_reserve(out, need);
+   int len;
+   double a = fabs(x);
+
+   if (prec >= 0 && prec <= 15 && a * Fio_p10[prec] < 8.0e12) {
+      double scaled = a * Fio_p10[prec];
+      double fl = floor(scaled), frac = scaled - fl;
+      if (fabs(frac - 0.5) > 0.01) {
+         uint64_t m = (uint64_t) fl + (frac > 0.5);
+         len = Fio_put_scaled(p, signbit(x) != 0, m, prec);
+         if (sep) p[len++] = sep;
+         out->used += len;
+         return;
+      }
+   }
+   len = snprintf(p, need, "%.*f", prec, x);
+   if (sep) p[len++] = sep;
+   out->used += len;
+}
+
+/*-------------------------------------------------------------------
+ * Fio_write_shortest: texto curto que relido dá x
+ *    Caminho rápido: o menor k <= 17 com m = x*10^k inteiro, |m| < 2^53
+ *    e m / 10^k == x (a divisão de dois valores exatos arredonda uma
+ *    vez, como strtod faria) sai em notação fixa: é o texto mais curto
+ *    para os valores com poucas casas (dados lidos de texto, medidas).
+ *    Senão sai "%.17g", que sempre volta ao mesmo valor mas pode ter um
+ *    ou dois dígitos a mais que o mínimo: procurar o mínimo com
+ *    snprintf + strtod custava mais que o próprio fprintf, e um
+ *    algoritmo de menor representação (Ryu, Grisu) não cabe aqui.
+ */
+static inline void Fio_write_shortest(Fio_out* out, double x, char sep) {
+   char* p = Fio_reserve(out, 40);
+   int len = 0;
+   double a = fabs(x);
+
+   if (isfinite(x) && a < 9007199254740992.0) {
+      for (int k = 0; k <= 17; k++) {
+         double m = a * Fio_p10[k];
+         if (m >= 9007199254740992.0) break;
+         double r = nearbyint(m);
+         if (r / Fio_p10[k] == a) {
+            len = Fio_put_scaled(p, signbit(x) != 0, (uint64_t) r, k);
+            if (sep) p[len++] = sep;
+            out->used += len;
+            return;
+         }
+      }
+   }
+   len = snprintf(p, 40, "%.17g", x);
+   if (sep) p[len++] = sep;
+   out->used += len;
+}
+
+#endif
@@ -0,0 +1,398 @@
+/*
+ * Arquivo:  gemm.h
+ * Objetivo: produto de matrizes distribuído C = A B em doubles numa
+ *           grade 2-D de processos (MPI_Cart_create), com A m x k,
+ *           B k x n e C m x n em blocos 2-D (o processo (i, j) guarda
+ *           A[I_i, K_j], B[K_i, J_j] e C[I_i, J_j], linha-maior):
+ *           - SUMMA (grade pr x pc qualquer): k é percorrido em painéis
+ *             de até kb colunas de A / linhas de B; o painel de A vai por
+ *             MPI_Ibcast na linha da grade e o de B na coluna, e o painel
+ *             t+1 já está a caminho enquanto o t é multiplicado
+ *           - Cannon (grade q x q, periódica): alinhamento inicial e q
+ *             passos de deslocamento (A para a esquerda, B para cima),
+ *             com o deslocamento do passo seguinte em MPI_Isend/Irecv
+ *             durante a multiplicação
+ *           Kernel local (Gemm_local): C += A B em blocos MC x KC x NC
+ *           para a cache, com A e B reempacotados em fatias contíguas e
+ *           um microkernel GEMM_MR x GEMM_NR que mantém o bloco de C em
+ *           registradores (laço interno marcado "omp simd" pela macro
+ *           de blas1.h: compilar com -fopenmp-simd).
+ *
+ * Uso:      #include "../include/gemm.h"    (inclui dvec.h e blas1.h; -lm)
+ *
+ *           Gemm_grid G;
+ *           Gemm_grid_init(&G, m, n, k, 0, comm);   (1: grade q x q)
+ *           A_loc: G.m_loc x G.ka_loc, B_loc: G.kb_loc x G.n_loc,
+ *           C_loc: G.m_loc x G.n_loc (zerada antes)
+ *           Gemm_summa(&G, A_loc, B_loc, C_loc, kb);
+ *           Gemm_cannon(&G, A_loc, B_loc, C_loc);
+ *           Gemm_grid_free(&G);
+ *
+ * Notas:
+ * 1. As dimensões não precisam ser múltiplas da grade: os blocos vêm dos
+ *    layouts em bloco de dvec.h (os primeiros ficam com um a mais).
+ * 2. Gemm_cannon exige pr == pc (use Gemm_grid_init com square = 1).
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "dvec.h"
+#include "blas1.h"
+
+/* sem -fopenmp-simd as marcas "omp simd" são ignoradas, sem aviso */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+
+#define GEMM_MR 4          /* microkernel: 4 x 8 doubles de C     */
+#define GEMM_NR 8
+#ifndef GEMM_MC
+#define GEMM_MC 96         /* bloco de A empacotado: ~ cache L2   */
+#endif
+#ifndef GEMM_KC
+#define GEMM_KC 256
+#endif
+#ifndef GEMM_NC
+#define GEMM_NC 4096       /* painel de B empacotado: ~ cache L3  */
+#endif
+
+
+/*-------------------------------------------------------------------
+ * Microkernel: c[0..mr)[0..nr) += a b, com a = fatia empacotada de
+ *    GEMM_MR linhas (kc x MR, k por fora) e b = fatia de GEMM_NR
+ *    colunas (kc x NR).  O acumulador MR x NR fica em registradores;
+ *    mr < MR ou nr < NR só nas bordas (as fatias vêm com zeros).
+ */
+static inline void Gemm_micro(int kc, const double* restrict a,
+      const double* restrict b, double* restrict c, int ldc, int mr,
+      int nr) {
+   double acc[GEMM_MR][GEMM_NR];
+
+   for (int i = 0; i < GEMM_MR; i++)
+      for (int j = 0; j < GEMM_NR; j++)
+         acc[i][j] = 0.0;
+   for (int p = 0; p < kc; p++) {
+      const double* bp = b + p * GEMM_NR;
+      const double* ap = a + p * GEMM_MR;
+      for (int i = 0; i < GEMM_MR; i++) {
+         double ai = ap[i];
+         BLAS1_SIMD_FOR
+         for (int j = 0; j < GEMM_NR; j++)
+            acc[i][j] += ai * bp[j];
+      }
+   }
+   if (mr == GEMM_MR && nr == GEMM_NR) {
+      for (int i = 0; i < GEMM_MR; i++)
+         for (int j = 0; j < GEMM_NR; j++)
+            c[i * ldc + j] += acc[i][j];
+   } else {
+      for (int i = 0; i < mr; i++)
+         for (int j = 0; j < nr; j++)
+            c[i * ldc + j] += acc[i][j];
+   }
+}
+
+/* A[0..mc)[0..kc) -> fatias de MR linhas, completadas com zeros */
+static inline void Gemm_pack_a(int mc, int kc, const double* A, int lda,
+      double* restrict a) {
+   for (int i0 = 0; i0 < mc; i0 += GEMM_MR) {
+      int mr = (mc - i0 < GEMM_MR) ? mc - i0 : GEMM_MR;
+      for (int p = 0; p < kc; p++) {
+         for (int i = 0; i < mr; i++)
+            a[p * GEMM_MR + i] = A[(size_t) (i0 + i) * lda + p];
+         for (int i = mr; i < GEMM_MR; i++)
+            a[p * GEMM_MR + i] = 0.0;
+      }
+      a += (size_t) kc * GEMM_MR;
+   }
+}
+
+/* B[0..kc)[0..nc) -> fatias de NR colunas, completadas com zeros */
+static inline void Gemm_pack_b(int kc, int nc, const double* B, int ldb,
+      double* restrict b) {
+   for (int j0 = 0; j0 < nc; j0 += GEMM_NR) {
+      int nr = (nc - j0 < GEMM_NR) ? nc - j0 : GEMM_NR;
+      for (int p = 0; p < kc; p++) {
+         const double* row = B + (size_t) p * ldb + j0;
+         for (int j = 0; j < nr; j++)
+            b[p * GEMM_NR + j] = row[j];
+         for (int j = nr; j < GEMM_NR; j++)
+            b[p * GEMM_NR + j] = 0.0;
+      }
+      b += (size_t) kc * GEMM_NR;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Gemm_local: C += A B, A m x k, B k x n, C m x n, linha-maior
+ */
+static inline void Gemm_local(int m, int n, int k, const double* A, int lda,
+      const double* B, int ldb, double* C, int ldc) {
+   if (m <= 0 || n <= 0 || k <= 0) return;
+
+   int nc_max = (n < GEMM_NC) ? n : GEMM_NC;
+   int kc_max = (k < GEMM_KC) ? k : GEMM_KC;
+   double* a = malloc((size_t) GEMM_MC * kc_max * sizeof(double));
+   double* b = malloc((size_t) (nc_max + GEMM_NR) * kc_max * sizeof(double));
+
+   for (int jc = 0; jc < n; jc += GEMM_NC) {
+      int nc = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+      for (int pc = 0; pc < k; pc += GEMM_KC) {
+         int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+         Gemm_pack_b(kc, nc, B + (size_t) pc * ldb + jc, ldb, b);
+         for (int ic = 0; ic < m; ic += GEMM_MC) {
+            int mc = (m - ic < GEMM_MC) ? m - ic : GEMM_MC;
+            Gemm_pack_a(mc, kc, A + (size_t) ic * lda + pc, lda, a);
+            for (int jr = 0; jr < nc; jr += GEMM_NR) {
+               int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+               for (int ir = 0; ir < mc; ir += GEMM_MR) {
+                  int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+                  Gemm_micro(kc, a + (size_t) ir * kc,
+                        b + (size_t) jr * kc,
+                        C + (size_t) (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+               }
+            }
+         }
+      }
+   }
+   free(a);
+   free(b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Grade e blocos
+ */
+typedef struct {
+   int m, n, k;
+   int pr, pc, my_row, my_col;
+   MPI_Comm grid, row_comm, col_comm;
+   Dvec_layout rows;     /* m em blocos por pr (em col_comm)        */
+   Dvec_layout cols;     /* n em blocos por pc (em row_comm)        */
+   Dvec_layout ka;       /* k em blocos por pc: colunas de A        */
+   Dvec_layout kb;       /* k em blocos por pr: linhas de B         */
+   int m_loc, n_loc, ka_loc, kb_loc;
+   double t_comm, t_comp;
+} Gemm_grid;
+
+/* square = 1: grade q x q (Cannon; p tem que ser quadrado perfeito) */
+static inline int Gemm_grid_init(Gemm_grid* G, int m, int n, int k,
+      int square, MPI_Comm comm) {
+   int p, rank, dims[2] = {0, 0}, periods[2] = {1, 1}, coords[2];
+   int keep_col[2] = {0, 1}, keep_row[2] = {1, 0};
+
+   MPI_Comm_size(comm, &p);
+   if (square) {
+      int q = 0;
+      while ((q + 1) * (q + 1) <= p) q++;
+      if (q * q != p) return 0;
+      dims[0] = dims[1] = q;
+   } else {
+      MPI_Dims_create(p, 2, dims);
+   }
+
+   G->m = m;
+   G->n = n;
+   G->k = k;
+   G->pr = dims[0];
+   G->pc = dims[1];
+   MPI_Cart_create(comm, 2, dims, periods, 0, &G->grid);
+   MPI_Comm_rank(G->grid, &rank);
+   MPI_Cart_coords(G->grid, rank, 2, coords);
+   G->my_row = coords[0];
+   G->my_col = coords[1];
+   MPI_Cart_sub(G->grid, keep_col, &G->row_comm);
+   MPI_Cart_sub(G->grid, keep_row, &G->col_comm);
+
+   Dvec_layout_init(&G->rows, m, DVEC_BLOCK, 0, G->col_comm);
+   Dvec_layout_init(&G->cols, n, DVEC_BLOCK, 0, G->row_comm);
+   Dvec_layout_init(&G->ka, k, DVEC_BLOCK, 0, G->row_comm);
+   Dvec_layout_init(&G->kb, k, DVEC_BLOCK, 0, G->col_comm);
+   G->m_loc = G->rows.local_n;
+   G->n_loc = G->cols.local_n;
+   G->ka_loc = G->ka.local_n;
+   G->kb_loc = G->kb.local_n;
+   G->t_comm = G->t_comp = 0.0;
+   return 1;
+}
+
+static inline void Gemm_grid_free(Gemm_grid* G) {
+   MPI_Comm_free(&G->row_comm);
+   MPI_Comm_free(&G->col_comm);
+   MPI_Comm_free(&G->grid);
+}
+
+
+/*-------------------------------------------------------------------
+ * SUMMA: os painéis não cruzam fronteiras de bloco de A (por pc) nem
+ *    de B (por pr), então cada um tem um único dono na linha e na
+ *    coluna.  Dois buffers por matriz: enquanto o painel t é
+ *    multiplicado, os MPI_Ibcast do t+1 estão pendentes.
+ */
+typedef struct {
+   int k0, kw;           /* colunas de A / linhas de B [k0, k0+kw) */
+   int a_root, b_root;   /* dono na linha e na coluna da grade     */
+} Gemm_panel;
+
+static inline int Gemm_panels(const Gemm_grid* G, int kb_max,
+      Gemm_panel* pan) {
+   int n_pan = 0, k0 = 0;
+   while (k0 < G->k) {
+      int qa = Dvec_owner(&G->ka, k0), qb = Dvec_owner(&G->kb, k0);
+      int end_a = Dvec_block_first(&G->ka, qa) + Dvec_local_size(&G->ka, qa);
+      int end_b = Dvec_block_first(&G->kb, qb) + Dvec_local_size(&G->kb, qb);
+      int k1 = k0 + kb_max;
+      if (k1 > end_a) k1 = end_a;
+      if (k1 > end_b) k1 = end_b;
+      if (pan != NULL) {
+         pan[n_pan].k0 = k0;
+         pan[n_pan].kw = k1 - k0;
+         pan[n_pan].a_root = qa;
+         pan[n_pan].b_root = qb;
+      }
+      n_pan++;
+      k0 = k1;
+   }
+   return n_pan;
+}
+
+static inline void Gemm_post_panel(Gemm_grid* G, const Gemm_panel* P,
+      const double* A_loc, const double* B_loc, double* a_buf,
+      double* b_buf, MPI_Request reqs[2]) {
+   int m_loc = G->m_loc, n_loc = G->n_loc;
+
+   if (G->my_col == P->a_root) {
+      int c0 = P->k0 - Dvec_block_first(&G->ka, G->my_col);
+      for (int i = 0; i < m_loc; i++)
+         memcpy(a_buf + (size_t) i * P->kw,
+               A_loc + (size_t) i * G->ka_loc + c0, P->kw * sizeof(double));
+   }
+   if (G->my_row == P->b_root) {
+      int r0 = P->k0 - Dvec_block_first(&G->kb, G->my_row);
+      memcpy(b_buf, B_loc + (size_t) r0 * n_loc,
+            (size_t) P->kw * n_loc * sizeof(double));
+   }
+   MPI_Ibcast(a_buf, m_loc * P->kw, MPI_DOUBLE, P->a_root, G->row_comm,
+         &reqs[0]);
+   MPI_Ibcast(b_buf, P->kw * n_loc, MPI_DOUBLE, P->b_root, G->col_comm,
+         &reqs[1]);
+}
+
+/* C_loc += (A B)_loc, com painéis de até kb_max */
+static inline void Gemm_summa(Gemm_grid* G, const double* A_loc,
+      const double* B_loc, double* C_loc, int kb_max) {
+   if (kb_max <= 0) kb_max = 256;
+   int n_pan = Gemm_panels(G, kb_max, NULL);
+   Gemm_panel* pan = malloc((n_pan + 1) * sizeof(Gemm_panel));
+   Gemm_panels(G, kb_max, pan);
+
+   size_t a_sz = (size_t) G->m_loc * kb_max + 1;
+   size_t b_sz = (size_t) kb_max * G->n_loc + 1;
+   double* a_buf[2] = { malloc(a_sz * sizeof(double)),
+                        malloc(a_sz * sizeof(double)) };
+   double* b_buf[2] = { malloc(b_sz * sizeof(double)),
+                        malloc(b_sz * sizeof(double)) };
+   MPI_Request reqs[2][2];
+
+   double t0 = MPI_Wtime();
+   Gemm_post_panel(G, &pan[0], A_loc, B_loc, a_buf[0], b_buf[0], reqs[0]);
+   for (int t = 0; t < n_pan; t++) {
+      int cur = t & 1;
+      MPI_Waitall(2, reqs[cur], MPI_STATUSES_IGNORE);
+      if (t + 1 < n_pan)
+         Gemm_post_panel(G, &pan[t+1], A_loc, B_loc, a_buf[cur^1],
+               b_buf[cur^1], reqs[cur^1]);
+      double t1 = MPI_Wtime();
+      G->t_comm += t1 - t0;
+
+      Gemm_local(G->m_loc, G->n_loc, pan[t].kw, a_buf[cur], pan[t].kw,
+            b_buf[cur], G->n_loc, C_loc, G->n_loc);
+      t0 = MPI_Wtime();
+      G->t_comp += t0 - t1;
+   }
+
+   free(a_buf[0]); free(a_buf[1]);
+   free(b_buf[0]); free(b_buf[1]);
+   free(pan);
+}
+
+
+/*-------------------------------------------------------------------
+ * Cannon: no passo t o processo (i, j) tem o bloco A[I_i, K_s] e
+ *    B[K_s, J_j] com s = (i + j + t) mod q.  Os blocos podem ter
+ *    tamanhos diferentes: cada um viaja com o tamanho do seu s, e os
+ *    buffers têm o tamanho do maior.
+ */
+static inline void Gemm_cannon(Gemm_grid* G, const double* A_loc,
+      const double* B_loc, double* C_loc) {
+   int q = G->pr, i = G->my_row, j = G->my_col;
+   int m_loc = G->m_loc, n_loc = G->n_loc;
+   int k_max = Dvec_local_size(&G->ka, 0);         /* o 1o é o maior */
+   size_t a_sz = (size_t) m_loc * k_max + 1, b_sz = (size_t) k_max * n_loc + 1;
+   double* a[2] = { malloc(a_sz * sizeof(double)), malloc(a_sz * sizeof(double)) };
+   double* b[2] = { malloc(b_sz * sizeof(double)), malloc(b_sz * sizeof(double)) };
+   int left, right, up, down, src, dst;
+   MPI_Request reqs[4];
+
+   MPI_Cart_shift(G->grid, 1, -1, &right, &left);  /* A vai para a esquerda */
+   MPI_Cart_shift(G->grid, 0, -1, &down, &up);     /* B vai para cima       */
+
+   double t0 = MPI_Wtime();
+   /* alinhamento: A[i, j] -> (i, j - i), B[i, j] -> (i - j, j);
+      chega A[I_i, K_s] e B[K_s, J_j] com s = i + j */
+   int s = (i + j) % q;
+   int my_ka = G->ka_loc, my_kb = G->kb_loc;
+   int ka_s = Dvec_local_size(&G->ka, s), kb_s = Dvec_local_size(&G->kb, s);
+   int coords[2];
+
+   coords[0] = i; coords[1] = (j - i + q) % q;
+   MPI_Cart_rank(G->grid, coords, &dst);
+   coords[1] = (j + i) % q;
+   MPI_Cart_rank(G->grid, coords, &src);
+   MPI_Sendrecv(A_loc, m_loc * my_ka, MPI_DOUBLE, dst, 1,
+         a[0], m_loc * ka_s, MPI_DOUBLE, src, 1, G->grid, MPI_STATUS_IGNORE);
+   coords[0] = (i - j + q) % q; coords[1] = j;
+   MPI_Cart_rank(G->grid, coords, &dst);
+   coords[0] = (i + j) % q;
+   MPI_Cart_rank(G->grid, coords, &src);
+   MPI_Sendrecv(B_loc, my_kb * n_loc, MPI_DOUBLE, dst, 2,
+         b[0], kb_s * n_loc, MPI_DOUBLE, src, 2, G->grid, MPI_STATUS_IGNORE);
+   double t1 = MPI_Wtime();
+   G->t_comm += t1 - t0;
+
+   for (int t = 0; t < q; t++) {
+      int cur = t & 1, kw = Dvec_local_size(&G->ka, s);
+      int s_next = (s + 1) % q, kw_next = Dvec_local_size(&G->ka, s_next);
+      int n_reqs = 0;
+
+      t0 = MPI_Wtime();
+      if (t + 1 < q) {
+         MPI_Irecv(a[cur^1], m_loc * kw_next, MPI_DOUBLE, right, 3,
+               G->grid, &reqs[n_reqs++]);
+         MPI_Irecv(b[cur^1], kw_next * n_loc, MPI_DOUBLE, down, 4,
+               G->grid, &reqs[n_reqs++]);
+         MPI_Isend(a[cur], m_loc * kw, MPI_DOUBLE, left, 3, G->grid,
+               &reqs[n_reqs++]);
+         MPI_Isend(b[cur], kw * n_loc, MPI_DOUBLE, up, 4, G->grid,
+               &reqs[n_reqs++]);
+      }
+      t1 = MPI_Wtime();
+      Gemm_local(m_loc, n_loc, kw, a[cur], kw, b[cur], n_loc, C_loc, n_loc);
+      double t2 = MPI_Wtime();
+      MPI_Waitall(n_reqs, reqs, MPI_STATUSES_IGNORE);
+      G->t_comp += t2 - t1;
+      G->t_comm += (t1 - t0) + (MPI_Wtime() - t2);
+      s = s_next;
+   }
+
+   free(a[0]); free(a[1]);
+   free(b[0]); free(b[1]);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
@@ -0,0 +1,210 @@
+/*
+ * Arquivo:  gemv.h
+ * Objetivo: produto matriz-vetor distribuído y = A x, A m x n em
+ *           doubles, com três distribuições de A numa grade de
+ *           processos pr x pc (MPI_Cart_create, linha-maior):
+ *           - GEMV_ROW: blocos de linhas    (grade p x 1)
+ *           - GEMV_COL: blocos de colunas   (grade 1 x p)
+ *           - GEMV_2D:  tabuleiro (checkerboard), grade de MPI_Dims_create
+ *           O processo (i, j) guarda o bloco A[I_i, J_j] (linhas em
+ *           blocos por pr, colunas em blocos por pc), em ordem linha-maior
+ *           com lda = n_loc.  Os três casos usam o mesmo algoritmo:
+ *             1. x_J   = MPI_Allgatherv dos pedaços de x na coluna j
+ *             2. y_I  += A[I, J] x_J          (kernel local em blocos)
+ *             3. pedaço de y_I = MPI_Reduce_scatter na linha i
+ *           Em GEMV_ROW o passo 3 é só uma cópia (linha de 1 processo);
+ *           em GEMV_COL o passo 1 é.
+ *           Distribuição dos vetores: o segmento J_j de x é dividido em
+ *           blocos entre os pr processos da coluna j (o pedaço i fica em
+ *           (i, j)); o segmento I_i de y, entre os pc processos da linha
+ *           i (o pedaço j fica em (i, j)).  Tamanhos e inícios desses
+ *           pedaços: x_lay e y_lay (layouts em bloco de dvec.h).
+ *
+ * Uso:      #include "../include/gemv.h"  (inclui dvec.h e blas1.h; -lm)
+ *
+ *           Gemv_plan P;
+ *           Gemv_plan_init(&P, m, n, GEMV_2D, comm);
+ *           A_loc: P.m_loc x P.n_loc, linhas P.row0.., colunas P.col0..
+ *           x_loc: P.x_lay.local_n doubles, y_loc: P.y_lay.local_n
+ *           Gemv(&P, A_loc, x_loc, y_loc);
+ *           Gemv_plan_free(&P);
+ *
+ * Notas:
+ * 1. O kernel local percorre A em faixas de GEMV_NB colunas (o pedaço
+ *    de x da faixa fica na cache enquanto todas as linhas passam) e 4
+ *    linhas por vez (cada x[j] carregado serve 4 produtos); o laço
+ *    interno é uma redução com 4 acumuladores marcada "omp simd" pelas
+ *    macros de blas1.h (compilar com -fopenmp-simd).
+ * 2. P.t_gather, P.t_comp, P.t_reduce acumulam o tempo de cada passo.
+ */
+
+#ifndef GEMV_H
+#define GEMV_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "dvec.h"
+#include "blas1.h"
+
+/* sem -fopenmp-simd as marcas "omp simd" são ignoradas, sem aviso */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+
+#ifndef GEMV_NB
+#define GEMV_NB 2048      /* colunas por faixa: 16 KB de x */
+#endif
+
+typedef enum { GEMV_ROW, GEMV_COL, GEMV_2D } Gemv_kind;
+
+typedef struct {
+   Gemv_kind kind;
+   int m, n;
+   int pr, pc;                /* grade de processos                    */
+   int my_row, my_col;        /* coordenadas deste processo            */
+   MPI_Comm grid, row_comm, col_comm;
+   int m_loc, n_loc;          /* bloco local de A                      */
+   int row0, col0;            /* primeira linha/coluna global do bloco */
+   Dvec_layout x_lay;         /* x_J entre os pr processos da coluna   */
+   Dvec_layout y_lay;         /* y_I entre os pc processos da linha    */
+   int *x_cnt, *x_displs;     /* MPI_Allgatherv em col_comm            */
+   int *y_cnt;                /* MPI_Reduce_scatter em row_comm        */
+   double *x_buf, *y_buf;     /* x_J e y_I parcial                     */
+   double t_gather, t_comp, t_reduce;
+} Gemv_plan;
+
+
+/*-------------------------------------------------------------------
+ * Kernel local: y = A x, A m x n linha-maior com lda >= n
+ */
+static inline void Gemv_local(int m, int n, const double* A, int lda,
+      const double* restrict x, double* restrict y) {
+   int i;
+
+   for (i = 0; i < m; i++) y[i] = 0.0;
+   for (int jb = 0; jb < n; jb += GEMV_NB) {
+      int nb = (n - jb < GEMV_NB) ? n - jb : GEMV_NB;
+      const double* xb = x + jb;
+
+      for (i = 0; i + 3 < m; i += 4) {
+         const double* restrict a0 = A + (size_t) i * lda + jb;
+         const double* restrict a1 = a0 + lda;
+         const double* restrict a2 = a1 + lda;
+         const double* restrict a3 = a2 + lda;
+         double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+         BLAS1_SIMD_SUM
+         for (int j = 0; j < nb; j++) {
+            double xj = xb[j];
+            s0 += a0[j] * xj;
+            s1 += a1[j] * xj;
+            s2 += a2[j] * xj;
+            s3 += a3[j] * xj;
+         }
+         y[i]   += s0;
+         y[i+1] += s1;
+         y[i+2] += s2;
+         y[i+3] += s3;
+      }
+      for (; i < m; i++)
+         y[i] += Blas1_dot(nb, A + (size_t) i * lda + jb, xb);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Gemv_plan_init: cria a grade, os comunicadores de linha e coluna e
+ *    os tamanhos de todos os pedaços
+ */
+static inline void Gemv_plan_init(Gemv_plan* P, int m, int n,
+      Gemv_kind kind, MPI_Comm comm) {
+   int p, dims[2] = {0, 0}, periods[2] = {0, 0}, coords[2];
+   int keep_col[2] = {0, 1}, keep_row[2] = {1, 0};
+   Dvec_layout rows, cols;
+
+   MPI_Comm_size(comm, &p);
+   if (kind == GEMV_ROW)      { dims[0] = p; dims[1] = 1; }
+   else if (kind == GEMV_COL) { dims[0] = 1; dims[1] = p; }
+   else                       MPI_Dims_create(p, 2, dims);
+
+   P->kind = kind;
+   P->m = m;
+   P->n = n;
+   P->pr = dims[0];
+   P->pc = dims[1];
+   MPI_Cart_create(comm, 2, dims, periods, 0, &P->grid);
+   MPI_Comm_rank(P->grid, &p);
+   MPI_Cart_coords(P->grid, p, 2, coords);
+   P->my_row = coords[0];
+   P->my_col = coords[1];
+   MPI_Cart_sub(P->grid, keep_col, &P->row_comm);   /* mesma linha  */
+   MPI_Cart_sub(P->grid, keep_row, &P->col_comm);   /* mesma coluna */
+
+   /* blocos de linhas por pr e de colunas por pc */
+   Dvec_layout_init(&rows, m, DVEC_BLOCK, 0, P->col_comm);
+   Dvec_layout_init(&cols, n, DVEC_BLOCK, 0, P->row_comm);
+   P->m_loc = rows.local_n;
+   P->n_loc = cols.local_n;
+   P->row0 = Dvec_block_first(&rows, P->my_row);
+   P->col0 = Dvec_block_first(&cols, P->my_col);
+
+   /* pedaços de x_J na coluna e de y_I na linha */
+   Dvec_layout_init(&P->x_lay, P->n_loc, DVEC_BLOCK, 0, P->col_comm);
+   Dvec_layout_init(&P->y_lay, P->m_loc, DVEC_BLOCK, 0, P->row_comm);
+   P->x_cnt = malloc((2 * P->pr + P->pc) * sizeof(int));
+   P->x_displs = P->x_cnt + P->pr;
+   P->y_cnt = P->x_displs + P->pr;
+   for (int q = 0; q < P->pr; q++) {
+      P->x_cnt[q] = Dvec_local_size(&P->x_lay, q);
+      P->x_displs[q] = Dvec_block_first(&P->x_lay, q);
+   }
+   for (int q = 0; q < P->pc; q++)
+      P->y_cnt[q] = Dvec_local_size(&P->y_lay, q);
+
+   P->x_buf = malloc((P->n_loc > 0 ? P->n_loc : 1) * sizeof(double));
+   P->y_buf = malloc((P->m_loc > 0 ? P->m_loc : 1) * sizeof(double));
+   P->t_gather = P->t_comp = P->t_reduce = 0.0;
+}
+
+static inline void Gemv_plan_free(Gemv_plan* P) {
+   free(P->x_cnt);
+   free(P->x_buf);
+   free(P->y_buf);
+   MPI_Comm_free(&P->row_comm);
+   MPI_Comm_free(&P->col_comm);
+   MPI_Comm_free(&P->grid);
+}
+
+
+/*-------------------------------------------------------------------
+ * Gemv: y_loc = pedaço local de A x
+ */
+static inline void Gemv(Gemv_plan* P, const double* A_loc,
+      const double* x_loc, double* y_loc) {
+   double t0 = MPI_Wtime();
+
+   memcpy(P->x_buf + P->x_displs[P->my_row], x_loc,
+         P->x_cnt[P->my_row] * sizeof(double));
+   if (P->pr > 1)
+      MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, P->x_buf,
+            P->x_cnt, P->x_displs, MPI_DOUBLE, P->col_comm);
+   double t1 = MPI_Wtime();
+
+   Gemv_local(P->m_loc, P->n_loc, A_loc, P->n_loc, P->x_buf, P->y_buf);
+   double t2 = MPI_Wtime();
+
+   if (P->pc > 1)
+      MPI_Reduce_scatter(P->y_buf, y_loc, P->y_cnt, MPI_DOUBLE, MPI_SUM,
+            P->row_comm);
+   else
+      memcpy(y_loc, P->y_buf, P->m_loc * sizeof(double));
+   double t3 = MPI_Wtime();
+
+   P->t_gather += t1 - t0;
+   P->t_comp   += t2 - t1;
+   P->t_reduce += t3 - t2;
+}
+
+#pragma GCC diagnostic pop
+
+#endif
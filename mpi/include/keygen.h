@@ -0,0 +1,168 @@
+/*
+ * Arquivo:  keygen.h
+ * Objetivo: geração determinística das chaves de entrada dos programas
+ *           de ordenação, baseada em contador.
+ *           A chave i da lista global é função só de (seed, i): o
+ *           Philox-4x32-10 cifra o contador i com a chave seed, então
+ *           qualquer processo gera qualquer trecho da lista sem gerar o
+ *           que vem antes (pular adiante não custa nada) e a lista
+ *           global é a mesma para todo p.  Os laços de preenchimento
+ *           não têm estado entre iterações, então vetorizam, e com
+ *           -fopenmp são divididos entre as threads.
+ *
+ * Uso:      #include "../include/keygen.h"   (ligar com -lm)
+ *
+ *           Keygen_fill_int(local_A, first, local_n, global_n, dist,
+ *                 rmax, KEYGEN_SEED);
+ *           com first = índice de local_A[0] na lista global.
+ *
+ * Distribuições (dist):
+ *    u  uniforme em [0, rmax)
+ *    f  faixa toda: qualquer valor de 32 bits (int) ou 64 bits (long long)
+ *    z  tipo Zipf em [0, rmax): inversão contínua de P(k) ~ 1/(k+1)
+ *    g  gaussiana, média rmax/2, desvio rmax/8, cortada em [0, rmax)
+ *    s  já ordenada (não decrescente na lista global)
+ *    r  ordem inversa (não crescente na lista global)
+ *    d  poucos valores: KEYGEN_UNIQUE valores distintos em [0, rmax)
+ */
+
+#ifndef KEYGEN_H
+#define KEYGEN_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define KEYGEN_SEED   0x5eed2024u
+#define KEYGEN_UNIQUE 16
+#define KEYGEN_TWO_PI 6.283185307179586
+
+/* constantes do Philox-4x32 (Salmon et al., SC'11) */
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+/*-------------------------------------------------------------------
+ * Philox4x32: dez rodadas sobre o contador (c0, c1, 0, 0) com a chave
+ *    (k0, k1); as quatro palavras de saída vão em out[]
+ */
+static inline void Philox4x32(uint32_t c0, uint32_t c1, uint32_t k0,
+      uint32_t k1, uint32_t out[4]) {
+
+   uint32_t x0 = c0, x1 = c1, x2 = 0, x3 = 0;
+
+   for (int r = 0; r < 10; r++) {
+      uint64_t p0 = (uint64_t) PHILOX_M0 * x0;
+      uint64_t p1 = (uint64_t) PHILOX_M1 * x2;
+      uint32_t y0 = (uint32_t) (p1 >> 32) ^ x1 ^ k0;
+      uint32_t y2 = (uint32_t) (p0 >> 32) ^ x3 ^ k1;
+      x1 = (uint32_t) p1;
+      x3 = (uint32_t) p0;
+      x0 = y0;
+      x2 = y2;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+   }
+   out[0] = x0; out[1] = x1; out[2] = x2; out[3] = x3;
+}
+
+
+/*-------------------------------------------------------------------
+ * Keygen_bits: 128 bits aleatórios para o índice global i
+ */
+static inline void Keygen_bits(uint64_t seed, long long i, uint32_t out[4]) {
+   Philox4x32((uint32_t) i, (uint32_t) ((uint64_t) i >> 32),
+         (uint32_t) seed, (uint32_t) (seed >> 32), out);
+}
+
+
+/*-------------------------------------------------------------------
+ * Keygen_unit: double em [0, 1) com os 53 bits de cima dos 64
+ */
+static inline double Keygen_unit(uint32_t hi, uint32_t lo) {
+   return (double) ((((uint64_t) hi << 32) | lo) >> 11) * 0x1.0p-53;
+}
+
+
+/*-------------------------------------------------------------------
+ * Keygen_key: chave i da lista global de global_n chaves
+ *    Devolvida em 64 bits; em 'f' os 64 bits são aleatórios e quem usa
+ *    chaves int fica com os 32 de baixo.  As outras distribuições
+ *    ficam em [0, rmax).
+ */
+static inline long long Keygen_key(long long i, long long global_n,
+      char dist, long long rmax, uint64_t seed) {
+
+   uint32_t w[4];
+   double u;
+
+   switch (dist) {
+      case 's':
+         return (long long) ((double) i / global_n * rmax);
+      case 'r':
+         return rmax - 1 - (long long) ((double) i / global_n * rmax);
+      default:
+         break;
+   }
+
+   Keygen_bits(seed, i, w);
+   switch (dist) {
+      case 'f':
+         return (long long) (((uint64_t) w[0] << 32) | w[1]);
+      case 'z':
+         /* P(key < k) ~ log(k+1)/log(rmax+1) */
+         u = Keygen_unit(w[0], w[1]);
+         i = (long long) exp(u * log((double) rmax + 1.0)) - 1;
+         return i < rmax ? i : rmax - 1;
+      case 'g': {
+         /* Box-Muller com duas uniformes independentes */
+         double u1 = 1.0 - Keygen_unit(w[0], w[1]);   /* (0, 1] */
+         double u2 = Keygen_unit(w[2], w[3]);
+         double z = sqrt(-2.0 * log(u1)) * cos(KEYGEN_TWO_PI * u2);
+         long long k = (long long) floor(rmax / 2.0 + z * rmax / 8.0);
+         return k < 0 ? 0 : (k >= rmax ? rmax - 1 : k);
+      }
+      case 'd':
+         return (long long) (((uint64_t) w[0] * KEYGEN_UNIQUE) >> 32)
+               * (rmax / KEYGEN_UNIQUE);
+      default:   /* 'u': escala um double uniforme, sem o viés do módulo */
+         return (long long) (Keygen_unit(w[0], w[1]) * rmax);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Keygen_fill_int: A[j] = 32 bits de baixo da chave first+j, j < n
+ */
+static inline void Keygen_fill_int(int A[], long long first, int n,
+      long long global_n, char dist, long long rmax, uint64_t seed) {
+#  ifdef _OPENMP
+#  pragma omp parallel for schedule(static)
+#  endif
+   for (int j = 0; j < n; j++)
+      A[j] = (int) Keygen_key(first + j, global_n, dist, rmax, seed);
+}
+
+
+/*-------------------------------------------------------------------
+ * Keygen_fill_ll: A[j] = chave first+j, j < n
+ */
+static inline void Keygen_fill_ll(long long A[], long long first, int n,
+      long long global_n, char dist, long long rmax, uint64_t seed) {
+#  ifdef _OPENMP
+#  pragma omp parallel for schedule(static)
+#  endif
+   for (int j = 0; j < n; j++)
+      A[j] = Keygen_key(first + j, global_n, dist, rmax, seed);
+}
+
+
+/*-------------------------------------------------------------------
+ * Keygen_valid_dist: 1 se dist é uma das letras acima
+ */
+static inline int Keygen_valid_dist(char dist) {
+   return dist == 'u' || dist == 'f' || dist == 'z' || dist == 'g' ||
+          dist == 's' || dist == 'r' || dist == 'd';
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Arquivo:  mergepath.h
+ * Objetivo: intercalação (merge) de duas listas ordenadas de n inteiros
+ *           dividida entre as threads OpenMP por merge path: o intervalo
+ *           de saída é cortado em diagonais iguais, uma busca binária
+ *           acha onde cada diagonal cruza as duas listas e cada thread
+ *           intercala a sua parte com um laço sem desvio dependente dos
+ *           dados.  É o Merge_low / Merge_high do odd-even sort:
+ *           - menores n de A U B: Mpath_merge(A, B, n, out, 0, n)
+ *           - maiores n:          Mpath_merge(A, B, n, out, n, n)
+ *
+ * Uso:      #include "../include/mergepath.h"
+ *           compilar com -fopenmp para usar as threads
+ *           (OMP_NUM_THREADS=<t>); sem -fopenmp é sequencial
+ *
+ * Notas:
+ * 1. Empates vão para A, como nos merges sequenciais dos programas.
+ * 2. Abaixo de MPATH_MIN chaves de saída não vale abrir a região
+ *    paralela: uma thread só faz tudo.
+ */
+#ifndef MERGEPATH_H
+#define MERGEPATH_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef MPATH_MIN
+#define MPATH_MIN (1 << 14)
+#endif
+
+/* quantas chaves de A estão entre as diag primeiras de merge(A, B) */
+static inline int Mpath_split(const int A[], const int B[], int n, int diag) {
+   int lo = (diag > n) ? diag - n : 0;
+   int hi = (diag < n) ? diag : n;
+
+   while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (A[mid] <= B[diag - mid - 1])
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+/* len chaves a partir de A[i], B[j]; enquanto as duas listas têm chaves
+ * a comparação só escolhe (cmov) e avança i ou j aritmeticamente */
+static inline void Mpath_segment(const int A[], const int B[], int n, int i,
+      int j, int out[], int len) {
+   int k = 0;
+
+   while (k < len && i < n && j < n) {
+      int a = A[i], b = B[j];
+      int take_a = (a <= b);
+      out[k++] = take_a ? a : b;
+      i += take_a;
+      j += 1 - take_a;
+   }
+   while (k < len && i < n)
+      out[k++] = A[i++];
+   while (k < len && j < n)
+      out[k++] = B[j++];
+}
+
+/* posições [first, first+len) de merge(A, B) em out; a thread t fica
+ * com uma fatia igual das diagonais de saída */
+static inline void Mpath_merge(const int A[], const int B[], int n, int out[],
+      int first, int len) {
+#ifdef _OPENMP
+#  pragma omp parallel if (len >= MPATH_MIN)
+   {
+      int t = omp_get_thread_num();
+      int n_threads = omp_get_num_threads();
+#else
+   {
+      int t = 0, n_threads = 1;
+#endif
+      int d_begin = first + (int) ((long long) len * t / n_threads);
+      int d_end   = first + (int) ((long long) len * (t + 1) / n_threads);
+      int i = Mpath_split(A, B, n, d_begin);
+
+      Mpath_segment(A, B, n, i, d_begin - i, out + (d_begin - first),
+                    d_end - d_begin);
+   }
+}
+
+#endif
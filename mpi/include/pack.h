@@ -0,0 +1,269 @@
+/*
+ * Arquivo:  pack.h
+ * Objetivo: empacotamento manual de dados não contíguos (coluna,
+ *           triângulo, submatriz, campos de um vetor de structs) num
+ *           buffer contíguo, e a tabela com o método mais rápido para
+ *           cada forma, medido por ../questao10/mpi_pack_bench.c:
+ *           - PACK_TYPE:   tipo derivado direto em MPI_Send/MPI_Recv
+ *           - PACK_MPI:    MPI_Pack / MPI_Unpack + MPI_PACKED
+ *           - PACK_MANUAL: as funções Pack_* / Unpack_* daqui
+ *
+ *           Pack_send_column / Pack_recv_column e Pack_send_fields /
+ *           Pack_recv_fields escolhem o método por Pack_best.
+ *
+ * Uso:      #include "../include/pack.h"
+ *
+ *           Pack_send_column(A, n, lda, j, dest, tag, comm);
+ *           Pack_recv_column(A, n, lda, j, src, tag, comm);
+ *           Pack_send_fields(P, count, sizeof(P[0]), nf, off, len, rec,
+ *                            dest, tag, comm);
+ *           (rec: tipo MPI de um registro, já com commit e com extent
+ *           sizeof(P[0]), usado quando Pack_best não é PACK_MANUAL)
+ *
+ * Notas:
+ * 1. Os laços de blocos curtos são marcados "omp simd" com a
+ *    BLAS1_SIMD_FOR de blas1.h (compilar com -fopenmp-simd); blocos de
+ *    PACK_MEMCPY_MIN doubles ou mais vão por memcpy.
+ * 2. Pack_best veio de mpi_pack_bench com Open MPI 4.1, 2 processos no
+ *    mesmo nó (memória compartilhada): o motor de tipos ganha nos
+ *    blocos longos (triângulo, submatriz) e perde feio nos campos
+ *    pequenos de structs. Rodar de novo entre nós ou ao mudar de MPI e
+ *    trocar a tabela pela linha "Pack_best" que ele imprime.
+ */
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <mpi.h>
+#include "blas1.h"
+
+#define PACK_MEMCPY_MIN 16
+
+/* sem -fopenmp-simd as marcas "omp simd" são ignoradas, sem aviso */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+
+typedef enum { PACK_TYPE, PACK_MPI, PACK_MANUAL } Pack_method;
+
+typedef enum { PACK_CONTIG, PACK_COLUMN, PACK_TRIANGLE, PACK_SUBMATRIX,
+               PACK_STRUCT, PACK_NSHAPES } Pack_shape;
+
+static const char* const Pack_method_names[3] = { "tipo", "MPI_Pack", "manual" };
+static const char* const Pack_shape_names[PACK_NSHAPES] = {
+   "contíguo", "coluna", "triângulo", "submatriz", "structs" };
+
+/* método mais rápido por forma (mpi_pack_bench, maioria dos tamanhos);
+ * no contíguo "manual" é mandar o buffer direto, igual ao tipo */
+static const Pack_method Pack_best[PACK_NSHAPES] = {
+   PACK_MANUAL, PACK_MANUAL, PACK_TYPE, PACK_TYPE, PACK_MANUAL };
+
+/*-------------------------------------------------------------------
+ * Blocos de mesmo tamanho: count blocos de blocklen doubles, o início
+ * de um a stride doubles do anterior (coluna: blocklen = 1, submatriz:
+ * blocklen = colunas, stride = lda)
+ */
+static inline void Pack_strided(double* restrict dst,
+      const double* restrict src, int count, int blocklen, int stride) {
+   if (blocklen >= PACK_MEMCPY_MIN) {
+      for (int b = 0; b < count; b++)
+         memcpy(dst + (size_t) b * blocklen, src + (size_t) b * stride,
+                blocklen * sizeof(double));
+   } else if (blocklen == 1) {
+      BLAS1_SIMD_FOR
+      for (int b = 0; b < count; b++)
+         dst[b] = src[(size_t) b * stride];
+   } else {
+      for (int b = 0; b < count; b++) {
+         const double* s = src + (size_t) b * stride;
+         double* d = dst + (size_t) b * blocklen;
+         BLAS1_SIMD_FOR
+         for (int l = 0; l < blocklen; l++)
+            d[l] = s[l];
+      }
+   }
+}
+
+static inline void Unpack_strided(double* restrict dst,
+      const double* restrict src, int count, int blocklen, int stride) {
+   if (blocklen >= PACK_MEMCPY_MIN) {
+      for (int b = 0; b < count; b++)
+         memcpy(dst + (size_t) b * stride, src + (size_t) b * blocklen,
+                blocklen * sizeof(double));
+   } else if (blocklen == 1) {
+      BLAS1_SIMD_FOR
+      for (int b = 0; b < count; b++)
+         dst[(size_t) b * stride] = src[b];
+   } else {
+      for (int b = 0; b < count; b++) {
+         const double* s = src + (size_t) b * blocklen;
+         double* d = dst + (size_t) b * stride;
+         BLAS1_SIMD_FOR
+         for (int l = 0; l < blocklen; l++)
+            d[l] = s[l];
+      }
+   }
+}
+
+/*-------------------------------------------------------------------
+ * Triangular superior de uma matriz n x n densa (linha i: colunas
+ * i..n-1), na ordem de mpi_triangular_superio.c e de pmat.h
+ */
+static inline void Pack_upper(double* restrict dst, const double* restrict A,
+      int n, int lda) {
+   for (int i = 0; i < n; i++) {
+      int len = n - i;
+      memcpy(dst, A + (size_t) i * lda + i, len * sizeof(double));
+      dst += len;
+   }
+}
+
+static inline void Unpack_upper(double* restrict A, const double* restrict src,
+      int n, int lda) {
+   for (int i = 0; i < n; i++) {
+      int len = n - i;
+      memcpy(A + (size_t) i * lda + i, src, len * sizeof(double));
+      src += len;
+   }
+}
+
+/*-------------------------------------------------------------------
+ * Campos de um vetor de structs: de cada um dos count registros (extent
+ * bytes cada) copia nf campos (off[f], len[f] em bytes), um registro
+ * atrás do outro, sem os buracos
+ */
+static inline size_t Pack_record_size(int nf, const int len[]) {
+   size_t s = 0;
+   for (int f = 0; f < nf; f++) s += len[f];
+   return s;
+}
+
+static inline void Pack_fields(void* restrict dst, const void* restrict src,
+      int count, size_t extent, int nf, const int off[], const int len[]) {
+   char* d = dst;
+   const char* s = src;
+   for (int r = 0; r < count; r++, s += extent)
+      for (int f = 0; f < nf; f++) {
+         memcpy(d, s + off[f], len[f]);
+         d += len[f];
+      }
+}
+
+static inline void Unpack_fields(void* restrict dst, const void* restrict src,
+      int count, size_t extent, int nf, const int off[], const int len[]) {
+   char* d = dst;
+   const char* s = src;
+   for (int r = 0; r < count; r++, d += extent)
+      for (int f = 0; f < nf; f++) {
+         memcpy(d + off[f], s, len[f]);
+         s += len[f];
+      }
+}
+
+/*-------------------------------------------------------------------
+ * Envio e recepção pelo método de Pack_best[shape]: buf/count/type
+ * descrevem os dados no lugar (PACK_TYPE e PACK_MPI); packed tem os
+ * bytes bytes já empacotados à mão (PACK_MANUAL)
+ */
+static inline void Pack_send_by(Pack_shape shape, const void* buf, int count,
+      MPI_Datatype type, const void* packed, size_t bytes, int dest, int tag,
+      MPI_Comm comm) {
+   if (Pack_best[shape] == PACK_MANUAL) {
+      MPI_Send(packed, (int) bytes, MPI_BYTE, dest, tag, comm);
+   } else if (Pack_best[shape] == PACK_TYPE) {
+      MPI_Send(buf, count, type, dest, tag, comm);
+   } else {
+      int psize, pos = 0;
+      MPI_Pack_size(count, type, comm, &psize);
+      char* pbuf = malloc(psize);
+      MPI_Pack(buf, count, type, pbuf, psize, &pos, comm);
+      MPI_Send(pbuf, pos, MPI_PACKED, dest, tag, comm);
+      free(pbuf);
+   }
+}
+
+static inline void Pack_recv_by(Pack_shape shape, void* buf, int count,
+      MPI_Datatype type, void* packed, size_t bytes, int src, int tag,
+      MPI_Comm comm) {
+   if (Pack_best[shape] == PACK_MANUAL) {
+      MPI_Recv(packed, (int) bytes, MPI_BYTE, src, tag, comm,
+               MPI_STATUS_IGNORE);
+   } else if (Pack_best[shape] == PACK_TYPE) {
+      MPI_Recv(buf, count, type, src, tag, comm, MPI_STATUS_IGNORE);
+   } else {
+      int psize, pos = 0;
+      MPI_Pack_size(count, type, comm, &psize);
+      char* pbuf = malloc(psize);
+      MPI_Recv(pbuf, psize, MPI_PACKED, src, tag, comm, MPI_STATUS_IGNORE);
+      MPI_Unpack(pbuf, psize, &pos, buf, count, type, comm);
+      free(pbuf);
+   }
+}
+
+/* coluna j (n linhas) de A com linhas de lda doubles */
+static inline void Pack_send_column(const double* A, int n, int lda, int j,
+      int dest, int tag, MPI_Comm comm) {
+   MPI_Datatype col = MPI_DATATYPE_NULL;
+   double* packed = NULL;
+   if (Pack_best[PACK_COLUMN] == PACK_MANUAL) {
+      packed = malloc((n > 0 ? n : 1) * sizeof(double));
+      Pack_strided(packed, A + j, n, 1, lda);
+   } else {
+      MPI_Type_vector(n, 1, lda, MPI_DOUBLE, &col);
+      MPI_Type_commit(&col);
+   }
+   Pack_send_by(PACK_COLUMN, A + j, 1, col, packed, n * sizeof(double), dest,
+                tag, comm);
+   if (col != MPI_DATATYPE_NULL) MPI_Type_free(&col);
+   free(packed);
+}
+
+static inline void Pack_recv_column(double* A, int n, int lda, int j, int src,
+      int tag, MPI_Comm comm) {
+   MPI_Datatype col = MPI_DATATYPE_NULL;
+   double* packed = NULL;
+   if (Pack_best[PACK_COLUMN] == PACK_MANUAL) {
+      packed = malloc((n > 0 ? n : 1) * sizeof(double));
+   } else {
+      MPI_Type_vector(n, 1, lda, MPI_DOUBLE, &col);
+      MPI_Type_commit(&col);
+   }
+   Pack_recv_by(PACK_COLUMN, A + j, 1, col, packed, n * sizeof(double), src,
+                tag, comm);
+   if (packed != NULL) Unpack_strided(A + j, packed, n, 1, lda);
+   if (col != MPI_DATATYPE_NULL) MPI_Type_free(&col);
+   free(packed);
+}
+
+/* campos off/len de count registros de extent bytes; rec descreve os
+ * mesmos campos de um registro */
+static inline void Pack_send_fields(const void* src, int count, size_t extent,
+      int nf, const int off[], const int len[], MPI_Datatype rec, int dest,
+      int tag, MPI_Comm comm) {
+   size_t bytes = (size_t) count * Pack_record_size(nf, len);
+   void* packed = NULL;
+   if (Pack_best[PACK_STRUCT] == PACK_MANUAL) {
+      packed = malloc(bytes > 0 ? bytes : 1);
+      Pack_fields(packed, src, count, extent, nf, off, len);
+   }
+   Pack_send_by(PACK_STRUCT, src, count, rec, packed, bytes, dest, tag, comm);
+   free(packed);
+}
+
+static inline void Pack_recv_fields(void* dst, int count, size_t extent,
+      int nf, const int off[], const int len[], MPI_Datatype rec, int src,
+      int tag, MPI_Comm comm) {
+   size_t bytes = (size_t) count * Pack_record_size(nf, len);
+   void* packed = NULL;
+   if (Pack_best[PACK_STRUCT] == PACK_MANUAL)
+      packed = malloc(bytes > 0 ? bytes : 1);
+   Pack_recv_by(PACK_STRUCT, dst, count, rec, packed, bytes, src, tag, comm);
+   if (packed != NULL)
+      Unpack_fields(dst, packed, count, extent, nf, off, len);
+   free(packed);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
@@ -0,0 +1,423 @@
+/*
+ * Arquivo:  pmat.h
+ * Objetivo: matrizes n x n triangulares, simétricas e de banda em
+ *           armazenamento compactado: só os elementos guardados, linha
+ *           por linha (linha-maior), com o início de cada linha em off[].
+ *           - PMAT_UPPER: colunas i..n-1 da linha i
+ *           - PMAT_LOWER: colunas 0..i
+ *           - PMAT_SYM:   simétrica, guardada como a triangular superior
+ *                         (colunas i..n-1); Pmat_get troca (i, j) com
+ *                         i > j por (j, i)
+ *           - PMAT_BAND:  colunas i-kl..i+ku (cortadas nas bordas)
+ *           Um Pmat pode ter só as linhas [r0, r1) (pedaço distribuído):
+ *           as linhas de um intervalo são contíguas em val[], então
+ *           enviar, espalhar e juntar pedaços não precisa de tipo
+ *           derivado nenhum.
+ *           Para mandar a parte guardada de uma matriz densa (como em
+ *           mpi_triangular_superio.c), Pmat_dense_type devolve um tipo
+ *           MPI_Type_create_hindexed já com commit, guardado numa cache
+ *           indexada pela forma (tipo, n, kl, ku, linhas, lda): o mesmo
+ *           tipo é criado uma vez e reaproveitado.
+ *
+ * Uso:      #include "../include/pmat.h"
+ *
+ *           Pmat_shape sh = Pmat_shape_make(PMAT_UPPER, n, 0, 0);
+ *           Pmat M;
+ *           Pmat_create(&M, &sh, 0, n);
+ *           *Pmat_at(&M, i, j) = ...;        (i <= j)
+ *           Pmat_send(&M, 1, tag, comm);  /  Pmat_recv(&M, 0, tag, comm);
+ *           Pmat_send_dense(A, n, &sh, 0, n, 1, tag, comm);  (A denso)
+ *           Pmat_scatter(&M, &sh, 0, &M_loc, comm);  (linhas com nnz
+ *                                                    parecido)
+ *           Pmat_gather(&M_loc, 0, &M, comm);    (M inteira, só no raiz)
+ *           Pmat_free(&M);
+ *           Pmat_type_cache_free();              (antes de MPI_Finalize)
+ *
+ * Notas:
+ * 1. Matrizes grandes: mensagens com mais de PMAT_MAX_MSG elementos são
+ *    divididas em grupos de linhas (o emissor e o receptor dividem do
+ *    mesmo jeito), então nnz pode passar de 2^31; Pmat_scatter e
+ *    Pmat_gather passam de MPI_Scatterv/Gatherv a envios ponto a ponto
+ *    quando a matriz inteira não cabe numa mensagem.
+ * 2. A cache é estática no arquivo que inclui este cabeçalho (os
+ *    programas do repositório são de um arquivo só).
+ */
+
+#ifndef PMAT_H
+#define PMAT_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#ifndef PMAT_MAX_MSG
+#define PMAT_MAX_MSG (1 << 27)     /* elementos por mensagem (1 GB) */
+#endif
+#define PMAT_CACHE_MAX 32
+
+typedef enum { PMAT_UPPER, PMAT_LOWER, PMAT_SYM, PMAT_BAND } Pmat_kind;
+
+typedef struct {
+   Pmat_kind kind;
+   int n;
+   int kl, ku;          /* só em PMAT_BAND */
+} Pmat_shape;
+
+typedef struct {
+   Pmat_shape sh;
+   int r0, r1;          /* linhas guardadas [r0, r1)               */
+   long long* off;      /* off[i - r0]: início da linha i em val[]  */
+   long long nnz;       /* = off[r1 - r0]                           */
+   double* val;
+} Pmat;
+
+
+/*-------------------------------------------------------------------
+ * Forma: colunas guardadas de cada linha
+ */
+static inline Pmat_shape Pmat_shape_make(Pmat_kind kind, int n, int kl,
+      int ku) {
+   Pmat_shape sh = { kind, n, 0, 0 };
+   if (kind == PMAT_BAND) {
+      sh.kl = kl;
+      sh.ku = ku;
+   }
+   return sh;
+}
+
+/* PMAT_SYM guarda as mesmas colunas que PMAT_UPPER (j >= i) */
+static inline int Pmat_first_col(const Pmat_shape* sh, int i) {
+   switch (sh->kind) {
+      case PMAT_LOWER: return 0;
+      case PMAT_BAND:  return (i - sh->kl > 0) ? i - sh->kl : 0;
+      case PMAT_UPPER:
+      case PMAT_SYM:
+      default:         return i;
+   }
+}
+
+/* uma depois da última */
+static inline int Pmat_end_col(const Pmat_shape* sh, int i) {
+   switch (sh->kind) {
+      case PMAT_LOWER: return i + 1;
+      case PMAT_BAND:  return (i + sh->ku + 1 < sh->n) ? i + sh->ku + 1 : sh->n;
+      case PMAT_UPPER:
+      case PMAT_SYM:
+      default:         return sh->n;
+   }
+}
+
+static inline int Pmat_row_len(const Pmat_shape* sh, int i) {
+   return Pmat_end_col(sh, i) - Pmat_first_col(sh, i);
+}
+
+static inline long long Pmat_rows_nnz(const Pmat_shape* sh, int r0, int r1) {
+   long long s = 0;
+   for (int i = r0; i < r1; i++)
+      s += Pmat_row_len(sh, i);
+   return s;
+}
+
+/* fim do grupo de linhas que começa em r: no máximo PMAT_MAX_MSG
+   elementos (pelo menos uma linha) */
+static inline int Pmat_group_end(const Pmat_shape* sh, int r, int r1) {
+   long long s = Pmat_row_len(sh, r);
+   int e = r + 1;
+   while (e < r1 && s + Pmat_row_len(sh, e) <= PMAT_MAX_MSG)
+      s += Pmat_row_len(sh, e++);
+   return e;
+}
+
+
+/*-------------------------------------------------------------------
+ * Criação e acesso
+ */
+static inline void Pmat_create(Pmat* M, const Pmat_shape* sh, int r0,
+      int r1) {
+   M->sh = *sh;
+   M->r0 = r0;
+   M->r1 = r1;
+   M->off = malloc((r1 - r0 + 1) * sizeof(long long));
+   M->off[0] = 0;
+   for (int i = r0; i < r1; i++)
+      M->off[i - r0 + 1] = M->off[i - r0] + Pmat_row_len(sh, i);
+   M->nnz = M->off[r1 - r0];
+   M->val = malloc((M->nnz > 0 ? M->nnz : 1) * sizeof(double));
+}
+
+static inline void Pmat_free(Pmat* M) {
+   free(M->off);
+   free(M->val);
+   M->off = NULL;
+   M->val = NULL;
+}
+
+/* endereço de (i, j) ou NULL se não é guardado (i em [r0, r1)); em
+   PMAT_SYM, (i, j) com i > j é o mesmo que (j, i) só se j está no
+   pedaço: use Pmat_get */
+static inline double* Pmat_at(const Pmat* M, int i, int j) {
+   if (i < M->r0 || i >= M->r1) return NULL;
+   int c0 = Pmat_first_col(&M->sh, i);
+   if (j < c0 || j >= Pmat_end_col(&M->sh, i)) return NULL;
+   return M->val + M->off[i - M->r0] + (j - c0);
+}
+
+/* valor de (i, j) na matriz cheia (0 fora da parte guardada) */
+static inline double Pmat_get(const Pmat* M, int i, int j) {
+   if (M->sh.kind == PMAT_SYM && i > j) {
+      int t = i; i = j; j = t;
+   }
+   double* p = Pmat_at(M, i, j);
+   return (p != NULL) ? *p : 0.0;
+}
+
+/* vista das linhas [r0, r1) de M, sem cópia (não liberar) */
+static inline Pmat Pmat_rows_view(const Pmat* M, int r0, int r1) {
+   Pmat V = M[0];
+   V.r0 = r0;
+   V.r1 = r1;
+   V.off = M->off + (r0 - M->r0);    /* índices continuam em M->val */
+   V.nnz = M->off[r1 - M->r0] - M->off[r0 - M->r0];
+   return V;
+}
+
+/* linhas [r0, r1) de M <-> matriz densa A (linha-maior, A aponta a
+   linha 0) */
+static inline void Pmat_from_dense(Pmat* M, const double* A, int lda) {
+   for (int i = M->r0; i < M->r1; i++)
+      memcpy(M->val + M->off[i - M->r0],
+            A + (size_t) i * lda + Pmat_first_col(&M->sh, i),
+            Pmat_row_len(&M->sh, i) * sizeof(double));
+}
+
+static inline void Pmat_to_dense(const Pmat* M, double* A, int lda) {
+   for (int i = M->r0; i < M->r1; i++) {
+      double* row = A + (size_t) i * lda;
+      int c0 = Pmat_first_col(&M->sh, i), c1 = Pmat_end_col(&M->sh, i);
+      memset(row, 0, c0 * sizeof(double));
+      memcpy(row + c0, M->val + M->off[i - M->r0],
+            (c1 - c0) * sizeof(double));
+      memset(row + c1, 0, (M->sh.n - c1) * sizeof(double));
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Tipos derivados para a parte guardada de uma matriz densa
+ */
+/* linhas [r0, r1) com deslocamentos a partir do início da linha r0 */
+static inline MPI_Datatype Pmat_build_dense_type(const Pmat_shape* sh,
+      int r0, int r1, int lda) {
+   int rows = r1 - r0;
+   int* lens = malloc((rows > 0 ? rows : 1) * sizeof(int));
+   MPI_Aint* displs = malloc((rows > 0 ? rows : 1) * sizeof(MPI_Aint));
+   MPI_Datatype t;
+
+   for (int i = r0; i < r1; i++) {
+      lens[i - r0] = Pmat_row_len(sh, i);
+      displs[i - r0] = ((MPI_Aint) (i - r0) * lda + Pmat_first_col(sh, i))
+            * (MPI_Aint) sizeof(double);
+   }
+   MPI_Type_create_hindexed(rows, lens, displs, MPI_DOUBLE, &t);
+   MPI_Type_commit(&t);
+   free(lens);
+   free(displs);
+   return t;
+}
+
+typedef struct {
+   Pmat_shape sh;
+   int r0, r1, lda;
+   MPI_Datatype t;
+} Pmat_cache_entry;
+
+static Pmat_cache_entry Pmat_cache[PMAT_CACHE_MAX];
+static int Pmat_cache_n = 0, Pmat_cache_next = 0;
+static long long Pmat_cache_hits = 0, Pmat_cache_misses = 0;
+
+/* tipo da cache; cheia, substitui a entrada mais antiga */
+static inline MPI_Datatype Pmat_dense_type(const Pmat_shape* sh, int r0,
+      int r1, int lda) {
+   for (int e = 0; e < Pmat_cache_n; e++) {
+      Pmat_cache_entry* c = &Pmat_cache[e];
+      if (c->sh.kind == sh->kind && c->sh.n == sh->n && c->sh.kl == sh->kl &&
+          c->sh.ku == sh->ku && c->r0 == r0 && c->r1 == r1 && c->lda == lda) {
+         Pmat_cache_hits++;
+         return c->t;
+      }
+   }
+   Pmat_cache_misses++;
+   int e;
+   if (Pmat_cache_n < PMAT_CACHE_MAX) {
+      e = Pmat_cache_n++;
+   } else {
+      e = Pmat_cache_next;
+      Pmat_cache_next = (e + 1) % PMAT_CACHE_MAX;
+      MPI_Type_free(&Pmat_cache[e].t);
+   }
+   Pmat_cache[e].sh = *sh;
+   Pmat_cache[e].r0 = r0;
+   Pmat_cache[e].r1 = r1;
+   Pmat_cache[e].lda = lda;
+   Pmat_cache[e].t = Pmat_build_dense_type(sh, r0, r1, lda);
+   return Pmat_cache[e].t;
+}
+
+static inline void Pmat_type_cache_free(void) {
+   for (int e = 0; e < Pmat_cache_n; e++)
+      MPI_Type_free(&Pmat_cache[e].t);
+   Pmat_cache_n = Pmat_cache_next = 0;
+}
+
+
+/*-------------------------------------------------------------------
+ * Envio e recebimento (em grupos de linhas de até PMAT_MAX_MSG)
+ */
+static inline void Pmat_send(const Pmat* M, int dest, int tag, MPI_Comm comm) {
+   for (int r = M->r0; r < M->r1; ) {
+      int e = Pmat_group_end(&M->sh, r, M->r1);
+      MPI_Send(M->val + M->off[r - M->r0],
+            (int) (M->off[e - M->r0] - M->off[r - M->r0]), MPI_DOUBLE, dest,
+            tag, comm);
+      r = e;
+   }
+}
+
+/* M já criado com a mesma forma e as mesmas linhas do emissor */
+static inline void Pmat_recv(Pmat* M, int src, int tag, MPI_Comm comm) {
+   for (int r = M->r0; r < M->r1; ) {
+      int e = Pmat_group_end(&M->sh, r, M->r1);
+      MPI_Recv(M->val + M->off[r - M->r0],
+            (int) (M->off[e - M->r0] - M->off[r - M->r0]), MPI_DOUBLE, src,
+            tag, comm, MPI_STATUS_IGNORE);
+      r = e;
+   }
+}
+
+/* parte guardada das linhas [r0, r1) da matriz densa A (linha 0 em A);
+   o receptor usa Pmat_recv num Pmat com essas linhas */
+static inline void Pmat_send_dense(const double* A, int lda,
+      const Pmat_shape* sh, int r0, int r1, int dest, int tag,
+      MPI_Comm comm) {
+   for (int r = r0; r < r1; ) {
+      int e = Pmat_group_end(sh, r, r1);
+      MPI_Send(A + (size_t) r * lda, 1, Pmat_dense_type(sh, r, e, lda), dest,
+            tag, comm);
+      r = e;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Distribuição por linhas com nnz parecido (numa triangular, blocos
+ *    de linhas iguais dariam ao último processo quase nada)
+ */
+static inline void Pmat_partition(const Pmat_shape* sh, int p, int bounds[]) {
+   long long total = Pmat_rows_nnz(sh, 0, sh->n), s = 0;
+   int q = 1;
+
+   bounds[0] = 0;
+   for (int i = 0; i < sh->n && q < p; i++) {
+      s += Pmat_row_len(sh, i);
+      while (q < p && s * p >= total * q)
+         bounds[q++] = i + 1;
+   }
+   while (q <= p)
+      bounds[q++] = sh->n;
+}
+
+/* M (inteira, só no raiz) -> M_loc com as linhas deste processo;
+   com mais de 2^31 elementos no total os deslocamentos não cabem em
+   int e o raiz manda cada pedaço com Pmat_send */
+static inline void Pmat_scatter(const Pmat* M, const Pmat_shape* sh,
+      int root, Pmat* M_loc, MPI_Comm comm) {
+   int p, me;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &me);
+   int* bounds = malloc((3 * p + 1) * sizeof(int));
+   int *cnt = bounds + p + 1, *displs = cnt + p;
+
+   Pmat_partition(sh, p, bounds);
+   Pmat_create(M_loc, sh, bounds[me], bounds[me + 1]);
+   if (Pmat_rows_nnz(sh, 0, sh->n) > PMAT_MAX_MSG) {
+      if (me == root) {
+         for (int q = 0; q < p; q++) {
+            Pmat V = Pmat_rows_view(M, bounds[q], bounds[q+1]);
+            if (q == root)
+               memcpy(M_loc->val, M->val + V.off[0], V.nnz * sizeof(double));
+            else
+               Pmat_send(&V, q, 0, comm);
+         }
+      } else {
+         Pmat_recv(M_loc, root, 0, comm);
+      }
+   } else {
+      if (me == root)
+         for (int q = 0; q < p; q++) {
+            cnt[q] = (int) (M->off[bounds[q+1]] - M->off[bounds[q]]);
+            displs[q] = (int) M->off[bounds[q]];
+         }
+      MPI_Scatterv(me == root ? M->val : NULL, cnt, displs, MPI_DOUBLE,
+            M_loc->val, (int) M_loc->nnz, MPI_DOUBLE, root, comm);
+   }
+   free(bounds);
+}
+
+/* inverso de Pmat_scatter: M (criada inteira no raiz) */
+static inline void Pmat_gather(const Pmat* M_loc, int root, Pmat* M,
+      MPI_Comm comm) {
+   const Pmat_shape* sh = &M_loc->sh;
+   int p, me;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &me);
+   int* bounds = malloc((3 * p + 1) * sizeof(int));
+   int *cnt = bounds + p + 1, *displs = cnt + p;
+
+   Pmat_partition(sh, p, bounds);
+   if (Pmat_rows_nnz(sh, 0, sh->n) > PMAT_MAX_MSG) {
+      if (me == root) {
+         for (int q = 0; q < p; q++) {
+            Pmat V = Pmat_rows_view(M, bounds[q], bounds[q+1]);
+            if (q == root)
+               memcpy(M->val + V.off[0], M_loc->val, V.nnz * sizeof(double));
+            else
+               Pmat_recv(&V, q, 0, comm);
+         }
+      } else {
+         Pmat_send(M_loc, root, 0, comm);
+      }
+   } else {
+      if (me == root)
+         for (int q = 0; q < p; q++) {
+            cnt[q] = (int) (M->off[bounds[q+1]] - M->off[bounds[q]]);
+            displs[q] = (int) M->off[bounds[q]];
+         }
+      MPI_Gatherv(M_loc->val, (int) M_loc->nnz, MPI_DOUBLE,
+            me == root ? M->val : NULL, cnt, displs, MPI_DOUBLE, root, comm);
+   }
+   free(bounds);
+}
+
+/* como Pmat_scatter, mas o raiz tem a matriz densa A: cada processo
+   recebe só a parte guardada das suas linhas (tipos da cache) */
+static inline void Pmat_scatter_dense(const double* A, int lda,
+      const Pmat_shape* sh, int root, Pmat* M_loc, MPI_Comm comm) {
+   int p, me;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &me);
+   int* bounds = malloc((p + 1) * sizeof(int));
+
+   Pmat_partition(sh, p, bounds);
+   Pmat_create(M_loc, sh, bounds[me], bounds[me + 1]);
+   if (me == root) {
+      for (int q = 0; q < p; q++)
+         if (q != root)
+            Pmat_send_dense(A, lda, sh, bounds[q], bounds[q+1], q, 0, comm);
+      Pmat_from_dense(M_loc, A, lda);
+   } else {
+      Pmat_recv(M_loc, root, 0, comm);
+   }
+   free(bounds);
+}
+
+#endif
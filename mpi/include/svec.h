@@ -0,0 +1,551 @@
+/*
+ * Arquivo:  svec.h
+ * Objetivo: vetor distribuído esparso, com o mesmo descritor de
+ *           distribuição de dvec.h (bloco, cíclico ou bloco-cíclico).
+ *           Cada processo guarda a sua parte em uma de duas formas:
+ *           - esparsa: nnz pares (índice local, valor), índices crescentes
+ *           - densa:   local_n doubles, como um Dvec
+ *           A forma densa é escolhida sozinha quando a densidade local
+ *           passa de SVEC_DENSE_FRAC (Svec_adapt, chamado depois das
+ *           operações que mudam nnz), e as operações tratam as quatro
+ *           combinações:
+ *           - Svec_axpy / Svec_waxpby: soma por intercalação (merge) de
+ *             duas listas esparsas, ou espalhando a esparsa sobre a densa
+ *           - Svec_pdot: esparso-esparso (interseção das listas),
+ *             esparso-denso (O(nnz)) ou denso-denso (Blas1_dot)
+ *           - Svec_scatter / Svec_gather: o raiz guarda o vetor global
+ *             como pares (índice global, valor); só os não nulos viajam
+ *             (MPI_Scatterv/MPI_Gatherv de índices e valores).  Quando
+ *             mandar o vetor denso sai mais barato (12 bytes por não nulo
+ *             contra 8 por elemento: nnz >= 2n/3), usa Dvec_scatter /
+ *             Dvec_gather.
+ *
+ * Uso:      #include "../include/svec.h"   (inclui dvec.h e blas1.h; -lm)
+ *
+ *           Dvec_layout lay;
+ *           Svec x, y;
+ *           Dvec_layout_init(&lay, n, DVEC_BLOCK, 0, comm);
+ *           Svec_create(&x, &lay);  Svec_create(&y, &lay);
+ *           Svec_scatter(&x, nnz, idx, val, 0);   (idx/val só no raiz)
+ *           ...
+ *           Svec_axpy(2.0, &x, &y);               (y = 2x + y)
+ *           double d = Svec_pdot(&x, &y);
+ *           Svec_gather(&y, 0, &nnz, &idx, &val); (malloc no raiz)
+ *           Svec_free(&x);  Svec_free(&y);
+ *
+ * Notas:
+ * 1. Os índices globais do raiz devem estar em ordem crescente e sem
+ *    repetição; Svec_gather devolve-os assim.
+ * 2. Somas que dão exatamente 0.0 saem da lista esparsa.
+ */
+
+#ifndef SVEC_H
+#define SVEC_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "dvec.h"
+#include "blas1.h"
+
+#ifndef SVEC_DENSE_FRAC
+#define SVEC_DENSE_FRAC 0.25     /* densidade local que passa a densa */
+#endif
+
+typedef struct {
+   Dvec_layout* lay;    /* compartilhado, não é liberado aqui        */
+   int     dense;       /* 1: valores em local[0 .. local_n-1]       */
+   int     nnz, cap;    /* forma esparsa: pares em idx[], val[]      */
+   int*    idx;         /* índices locais, crescentes                */
+   double* val;
+   double* local;       /* forma densa (NULL na esparsa)             */
+} Svec;
+
+
+/*-------------------------------------------------------------------
+ * Criação, liberação e troca de forma
+ */
+static inline void Svec_create(Svec* v, Dvec_layout* L) {
+   v->lay = L;
+   v->dense = 0;
+   v->nnz = v->cap = 0;
+   v->idx = NULL;
+   v->val = NULL;
+   v->local = NULL;
+}
+
+static inline void Svec_free(Svec* v) {
+   free(v->idx);
+   free(v->val);
+   free(v->local);
+   Svec_create(v, v->lay);
+}
+
+/* forma esparsa vazia com espaço para cap pares (reaproveita os
+   vetores se já cabem) */
+static inline void Svec_reset_sparse(Svec* v, int cap) {
+   v->nnz = 0;
+   if (!v->dense && v->cap >= cap && v->idx != NULL) return;
+   Svec_free(v);
+   v->cap = (cap > 0) ? cap : 1;
+   v->idx = malloc(v->cap * sizeof(int));
+   v->val = malloc(v->cap * sizeof(double));
+}
+
+/* forma densa com conteúdo indefinido (reaproveita local se já é) */
+static inline void Svec_reset_dense(Svec* v) {
+   if (v->dense) return;
+   int n = v->lay->local_n;
+   Svec_free(v);
+   v->dense = 1;
+   v->local = malloc((n > 0 ? n : 1) * sizeof(double));
+}
+
+/* troca os pares de v pelos de idx/val (que passam a ser de v) */
+static inline void Svec_adopt(Svec* v, int nnz, int cap, int* idx,
+      double* val) {
+   Svec_free(v);
+   v->nnz = nnz;
+   v->cap = cap;
+   v->idx = idx;
+   v->val = val;
+}
+
+static inline void Svec_densify(Svec* v) {
+   if (v->dense) return;
+   int n = v->lay->local_n;
+   double* a = calloc(n > 0 ? n : 1, sizeof(double));
+   for (int k = 0; k < v->nnz; k++)
+      a[v->idx[k]] = v->val[k];
+   Svec_free(v);
+   v->dense = 1;
+   v->local = a;
+}
+
+static inline void Svec_sparsify(Svec* v) {
+   if (!v->dense) return;
+   int n = v->lay->local_n, nnz = 0;
+   for (int l = 0; l < n; l++)
+      nnz += (v->local[l] != 0.0);
+   int* idx = malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+   double* val = malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+   for (int l = 0, k = 0; l < n; l++)
+      if (v->local[l] != 0.0) {
+         idx[k] = l;
+         val[k++] = v->local[l];
+      }
+   free(v->local);
+   v->local = NULL;
+   v->dense = 0;
+   v->nnz = nnz;
+   v->cap = (nnz > 0) ? nnz : 1;
+   v->idx = idx;
+   v->val = val;
+}
+
+/*-------------------------------------------------------------------
+ * Svec_adapt: escolhe a forma pela densidade local.  Esparsa passa a
+ *    densa com nnz >= SVEC_DENSE_FRAC*local_n; densa só volta a ser
+ *    esparsa abaixo da metade disso (não fica trocando de forma perto
+ *    do limite).  Na forma densa conta os não nulos: O(local_n).
+ */
+static inline void Svec_adapt(Svec* v) {
+   double n = v->lay->local_n;
+   if (!v->dense) {
+      if (v->nnz > 0 && v->nnz >= SVEC_DENSE_FRAC * n)
+         Svec_densify(v);
+   } else {
+      int nnz = 0;
+      for (int l = 0; l < v->lay->local_n; l++)
+         nnz += (v->local[l] != 0.0);
+      if (nnz < 0.5 * SVEC_DENSE_FRAC * n)
+         Svec_sparsify(v);
+   }
+}
+
+/* não nulos locais (na forma densa, conta) */
+static inline int Svec_local_nnz(const Svec* v) {
+   if (!v->dense) return v->nnz;
+   int nnz = 0;
+   for (int l = 0; l < v->lay->local_n; l++)
+      nnz += (v->local[l] != 0.0);
+   return nnz;
+}
+
+
+/*-------------------------------------------------------------------
+ * Svec_merge: w = a*x + b*y para duas listas esparsas, numa
+ *    intercalação; w_idx/w_val têm espaço para nx + ny pares.
+ *    Devolve o número de pares de w (resultados 0.0 ficam de fora).
+ */
+static inline int Svec_merge(double a, int nx, const int* x_idx,
+      const double* x_val, double b, int ny, const int* y_idx,
+      const double* y_val, int* w_idx, double* w_val) {
+   int i = 0, j = 0, k = 0;
+   while (i < nx && j < ny) {
+      int xi = x_idx[i], yj = y_idx[j];
+      double s;
+      if (xi < yj)      { s = a * x_val[i++];                   w_idx[k] = xi; }
+      else if (yj < xi) { s = b * y_val[j++];                   w_idx[k] = yj; }
+      else              { s = a * x_val[i++] + b * y_val[j++];  w_idx[k] = xi; }
+      w_val[k] = s;
+      k += (s != 0.0);
+   }
+   for (; i < nx; i++) {
+      w_idx[k] = x_idx[i];
+      w_val[k] = a * x_val[i];
+      k += (w_val[k] != 0.0);
+   }
+   for (; j < ny; j++) {
+      w_idx[k] = y_idx[j];
+      w_val[k] = b * y_val[j];
+      k += (w_val[k] != 0.0);
+   }
+   return k;
+}
+
+/* w_densa = w_densa + a*x_esparso */
+static inline void Svec_scatter_add(double a, const Svec* x, double* w) {
+   for (int k = 0; k < x->nnz; k++)
+      w[x->idx[k]] += a * x->val[k];
+}
+
+
+/*-------------------------------------------------------------------
+ * x = a*x
+ */
+static inline void Svec_scal(double a, Svec* x) {
+   if (a == 0.0) {
+      Svec_reset_sparse(x, 1);
+   } else if (x->dense) {
+      Blas1_scal(x->lay->local_n, a, x->local);
+   } else {
+      for (int k = 0; k < x->nnz; k++)
+         x->val[k] *= a;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * y = a*x + y  (x e y com o mesmo layout)
+ */
+static inline void Svec_axpy(double a, const Svec* x, Svec* y) {
+   int n = y->lay->local_n;
+
+   if (!x->dense && y->dense) {
+      Svec_scatter_add(a, x, y->local);
+   } else if (!x->dense) {
+      int cap = x->nnz + y->nnz;
+      int* idx = malloc((cap > 0 ? cap : 1) * sizeof(int));
+      double* val = malloc((cap > 0 ? cap : 1) * sizeof(double));
+      int nnz = Svec_merge(a, x->nnz, x->idx, x->val, 1.0, y->nnz, y->idx,
+            y->val, idx, val);
+      Svec_adopt(y, nnz, cap > 0 ? cap : 1, idx, val);
+      Svec_adapt(y);
+   } else {
+      Svec_densify(y);
+      Blas1_axpy(n, a, x->local, y->local);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * w = a*x + b*y  (w diferente de x e de y; w esparso só se x e y são)
+ */
+static inline void Svec_waxpby(double a, const Svec* x, double b,
+      const Svec* y, Svec* w) {
+   int n = w->lay->local_n;
+
+   if (!x->dense && !y->dense) {
+      Svec_reset_sparse(w, x->nnz + y->nnz);
+      w->nnz = Svec_merge(a, x->nnz, x->idx, x->val, b, y->nnz, y->idx,
+            y->val, w->idx, w->val);
+      Svec_adapt(w);
+      return;
+   }
+
+   Svec_reset_dense(w);
+   if (x->dense && y->dense) {
+      Blas1_waxpby(n, a, x->local, b, y->local, w->local);
+   } else {
+      /* a parte densa escalada, e a esparsa espalhada por cima */
+      const Svec *d = x->dense ? x : y, *s = x->dense ? y : x;
+      double ad = x->dense ? a : b, as = x->dense ? b : a;
+      for (int l = 0; l < n; l++)
+         w->local[l] = ad * d->local[l];
+      Svec_scatter_add(as, s, w->local);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Produtos escalares locais
+ */
+/* x esparso . y denso (y: local_n doubles, p.ex. Dvec.local) */
+static inline double Svec_dot_dense(const Svec* x, const double* y) {
+   double s0 = 0.0, s1 = 0.0;
+   int k;
+   for (k = 0; k < x->nnz - 1; k += 2) {
+      s0 += x->val[k]   * y[x->idx[k]];
+      s1 += x->val[k+1] * y[x->idx[k+1]];
+   }
+   if (k < x->nnz)
+      s0 += x->val[k] * y[x->idx[k]];
+   return s0 + s1;
+}
+
+static inline double Svec_dot_local(const Svec* x, const Svec* y) {
+   int n = x->lay->local_n;
+
+   if (x->dense && y->dense) return Blas1_dot(n, x->local, y->local);
+   if (y->dense)             return Svec_dot_dense(x, y->local);
+   if (x->dense)             return Svec_dot_dense(y, x->local);
+
+   /* interseção das duas listas crescentes */
+   double s = 0.0;
+   int i = 0, j = 0;
+   while (i < x->nnz && j < y->nnz) {
+      int xi = x->idx[i], yj = y->idx[j];
+      if (xi == yj) s += x->val[i] * y->val[j];
+      i += (xi <= yj);
+      j += (yj <= xi);
+   }
+   return s;
+}
+
+static inline double Svec_sumsq(const Svec* x) {
+   if (x->dense) return Blas1_sumsq(x->lay->local_n, x->local);
+   return Blas1_sumsq(x->nnz, x->val);
+}
+
+static inline double Svec_pdot(const Svec* x, const Svec* y) {
+   double s = Svec_dot_local(x, y);
+   MPI_Allreduce(MPI_IN_PLACE, &s, 1, MPI_DOUBLE, MPI_SUM, x->lay->comm);
+   return s;
+}
+
+static inline double Svec_pnrm2(const Svec* x) {
+   double s = Svec_sumsq(x);
+   MPI_Allreduce(MPI_IN_PLACE, &s, 1, MPI_DOUBLE, MPI_SUM, x->lay->comm);
+   return sqrt(s);
+}
+
+
+/*-------------------------------------------------------------------
+ * Svec_dense_transfer: 1 se mandar o vetor denso custa menos que os
+ *    pares (8n bytes contra 12 nnz bytes)
+ */
+static inline int Svec_dense_transfer(long long nnz, int n) {
+   return 3 * nnz >= 2 * (long long) n;
+}
+
+
+/*-------------------------------------------------------------------
+ * Svec_scatter: o raiz tem nnz pares (índice global crescente, valor)
+ *    em g_idx/g_val; cada processo fica com os seus.  nnz, g_idx e g_val
+ *    só são lidos no raiz.
+ */
+static inline void Svec_scatter(Svec* v, int nnz, const int* g_idx,
+      const double* g_val, int root) {
+   Dvec_layout* L = v->lay;
+   int p = L->p;
+
+   MPI_Bcast(&nnz, 1, MPI_INT, root, L->comm);
+
+   if (Svec_dense_transfer(nnz, L->n)) {
+      double* a = NULL;
+      if (L->my_rank == root) {
+         a = calloc(L->n > 0 ? L->n : 1, sizeof(double));
+         for (int k = 0; k < nnz; k++)
+            a[g_idx[k]] = g_val[k];
+      }
+      Svec_reset_dense(v);
+      Dvec d = { L, v->local };
+      Dvec_scatter(&d, a, root);
+      free(a);
+      Svec_adapt(v);
+      return;
+   }
+
+   int *cnt = NULL, *displs = NULL, *s_idx = NULL;
+   double* s_val = NULL;
+   int my_nnz;
+
+   if (L->my_rank == root) {
+      /* pares agrupados por dono, já com índice local; como o índice
+         local cresce com o global, cada grupo sai em ordem */
+      int* cursor = malloc(p * sizeof(int));
+      cnt = calloc(2 * p, sizeof(int));
+      displs = cnt + p;
+      for (int k = 0; k < nnz; k++)
+         cnt[Dvec_owner(L, g_idx[k])]++;
+      for (int q = 1; q < p; q++)
+         displs[q] = displs[q-1] + cnt[q-1];
+      memcpy(cursor, displs, p * sizeof(int));
+      s_idx = malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+      s_val = malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+      for (int k = 0; k < nnz; k++) {
+         int q = Dvec_owner(L, g_idx[k]);
+         s_idx[cursor[q]] = Dvec_local_index(L, g_idx[k]);
+         s_val[cursor[q]++] = g_val[k];
+      }
+      free(cursor);
+   }
+
+   MPI_Scatter(cnt, 1, MPI_INT, &my_nnz, 1, MPI_INT, root, L->comm);
+   Svec_reset_sparse(v, my_nnz);
+   MPI_Scatterv(s_idx, cnt, displs, MPI_INT, v->idx, my_nnz, MPI_INT,
+         root, L->comm);
+   MPI_Scatterv(s_val, cnt, displs, MPI_DOUBLE, v->val, my_nnz, MPI_DOUBLE,
+         root, L->comm);
+   v->nnz = my_nnz;
+   Svec_adapt(v);
+
+   free(cnt);
+   free(s_idx);
+   free(s_val);
+}
+
+
+/*-------------------------------------------------------------------
+ * Svec_kway_merge: junta no raiz as p listas de índices globais
+ *    crescentes (a de q em [displs[q], displs[q]+cnt[q])) numa só, com
+ *    um heap de p cabeças: O(nnz log p).  No layout em bloco as listas
+ *    já saem em ordem e isto não é chamado.
+ */
+static inline void Svec_kway_merge(int p, const int cnt[], const int displs[],
+      const int* r_idx, const double* r_val, int* g_idx, double* g_val) {
+   int* heap = malloc((p > 0 ? p : 1) * sizeof(int));   /* processos */
+   int* pos = malloc((p > 0 ? p : 1) * sizeof(int));
+   int h = 0, k = 0;
+
+#define SVEC_KEY(q) r_idx[pos[q]]
+   for (int q = 0; q < p; q++) {
+      pos[q] = displs[q];
+      if (cnt[q] == 0) continue;
+      int c = h++;                                 /* sobe */
+      while (c > 0 && SVEC_KEY(heap[(c-1)/2]) > SVEC_KEY(q)) {
+         heap[c] = heap[(c-1)/2];
+         c = (c-1)/2;
+      }
+      heap[c] = q;
+   }
+   while (h > 0) {
+      int q = heap[0];
+      g_idx[k] = r_idx[pos[q]];
+      g_val[k++] = r_val[pos[q]++];
+      if (pos[q] == displs[q] + cnt[q])
+         q = heap[--h];                            /* tira q */
+      int c = 0;                                   /* desce q da raiz */
+      while (h > 0) {
+         int m = 2*c + 1;
+         if (m >= h) break;
+         if (m + 1 < h && SVEC_KEY(heap[m+1]) < SVEC_KEY(heap[m])) m++;
+         if (SVEC_KEY(heap[m]) >= SVEC_KEY(q)) break;
+         heap[c] = heap[m];
+         c = m;
+      }
+      if (h > 0) heap[c] = q;
+   }
+#undef SVEC_KEY
+
+   free(heap);
+   free(pos);
+}
+
+
+/*-------------------------------------------------------------------
+ * Svec_gather: junta v no raiz como *nnz_p pares (índice global
+ *    crescente, valor) nos vetores *g_idx_p e *g_val_p, alocados com
+ *    malloc (liberar no raiz)
+ */
+static inline void Svec_gather(Svec* v, int root, int* nnz_p, int** g_idx_p,
+      double** g_val_p) {
+   Dvec_layout* L = v->lay;
+   int p = L->p, me = L->my_rank;
+   int my_nnz = Svec_local_nnz(v), nnz;
+
+   MPI_Allreduce(&my_nnz, &nnz, 1, MPI_INT, MPI_SUM, L->comm);
+
+   int* g_idx = NULL;
+   double* g_val = NULL;
+   if (me == root) {
+      g_idx = malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+      g_val = malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+   }
+
+   if (Svec_dense_transfer(nnz, L->n)) {
+      double* a = (me == root) ?
+            malloc((L->n > 0 ? L->n : 1) * sizeof(double)) : NULL;
+      double* mine = v->local;
+      if (!v->dense) {
+         mine = calloc(L->local_n > 0 ? L->local_n : 1, sizeof(double));
+         for (int k = 0; k < v->nnz; k++)
+            mine[v->idx[k]] = v->val[k];
+      }
+      Dvec d = { L, mine };
+      Dvec_gather(&d, a, root);
+      if (me == root) {
+         int k = 0;
+         for (int g = 0; g < L->n; g++)
+            if (a[g] != 0.0) {
+               g_idx[k] = g;
+               g_val[k++] = a[g];
+            }
+      }
+      if (mine != v->local) free(mine);
+      free(a);
+   } else {
+      /* pares de cada processo com índice global */
+      int* s_idx = malloc((my_nnz > 0 ? my_nnz : 1) * sizeof(int));
+      double* s_val = malloc((my_nnz > 0 ? my_nnz : 1) * sizeof(double));
+      if (v->dense) {
+         for (int l = 0, k = 0; l < L->local_n; l++)
+            if (v->local[l] != 0.0) {
+               s_idx[k] = Dvec_global_index(L, me, l);
+               s_val[k++] = v->local[l];
+            }
+      } else {
+         for (int k = 0; k < my_nnz; k++) {
+            s_idx[k] = Dvec_global_index(L, me, v->idx[k]);
+            s_val[k] = v->val[k];
+         }
+      }
+
+      int *cnt = NULL, *displs = NULL;
+      int *r_idx = g_idx;
+      double* r_val = g_val;
+      if (me == root) {
+         cnt = malloc(2 * p * sizeof(int));
+         displs = cnt + p;
+      }
+      MPI_Gather(&my_nnz, 1, MPI_INT, cnt, 1, MPI_INT, root, L->comm);
+      if (me == root) {
+         displs[0] = 0;
+         for (int q = 1; q < p; q++)
+            displs[q] = displs[q-1] + cnt[q-1];
+         if (L->kind != DVEC_BLOCK) {
+            r_idx = malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+            r_val = malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+         }
+      }
+      MPI_Gatherv(s_idx, my_nnz, MPI_INT, r_idx, cnt, displs, MPI_INT,
+            root, L->comm);
+      MPI_Gatherv(s_val, my_nnz, MPI_DOUBLE, r_val, cnt, displs, MPI_DOUBLE,
+            root, L->comm);
+      if (me == root && L->kind != DVEC_BLOCK) {
+         Svec_kway_merge(p, cnt, displs, r_idx, r_val, g_idx, g_val);
+         free(r_idx);
+         free(r_val);
+      }
+      free(cnt);
+      free(s_idx);
+      free(s_val);
+   }
+
+   *nnz_p = nnz;
+   *g_idx_p = g_idx;
+   *g_val_p = g_val;
+}
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Arquivo:  trsv.h
+ * Objetivo: resolver A X = B com A n x n triangular (inferior: substituição
+ *           para frente; superior: para trás) e nrhs lados direitos, com
+ *           as linhas de A e de B distribuídas:
+ *           - Trsv_pipelined: linhas em blocos cíclicos de nb (dvec.h,
+ *             DVEC_BLOCK_CYCLIC). O dono do bloco k resolve o bloco
+ *             diagonal e manda o pedaço x_k (nb x nrhs) ao vizinho num
+ *             anel; cada processo repassa x_k com MPI_Isend antes de
+ *             usá-lo, atualiza primeiro o próximo bloco da sequência (se
+ *             for dele), resolve e já o envia, e só então atualiza o
+ *             resto das suas linhas com x_k. Assim o bloco k+1 sai antes
+ *             do processo terminar o trabalho do bloco k.
+ *           - Trsv_naive: linhas em blocos contíguos (DVEC_BLOCK), um
+ *             processo de cada vez: recebe todo o x já calculado, atualiza
+ *             as suas linhas, resolve e passa o x aumentado ao próximo.
+ *           Cada processo guarda as suas linhas inteiras de A (A_loc,
+ *           local_n x n, só o triângulo é lido) e de B (B_loc, local_n x
+ *           nrhs), que no fim tem as linhas correspondentes de X.
+ *
+ * Uso:      #include "../include/trsv.h"  (inclui gemm.h e blas1.h; -lm)
+ *
+ *           Trsv_plan P;
+ *           Trsv_plan_init(&P, n, DVEC_BLOCK_CYCLIC, nb, upper, comm);
+ *           linha local l de A_loc e B_loc = linha global
+ *              Dvec_global_index(&P.rows, P.my_rank, l)
+ *           Trsv_pipelined(&P, A_loc, B_loc, nrhs);
+ *           (ou DVEC_BLOCK e Trsv_naive)
+ *           Trsv_plan_free(&P);
+ *
+ * Notas:
+ * 1. As mensagens do anel vão num comunicador duplicado, todas com tag
+ *    0: cada processo só recebe do vizinho de cima, na ordem dos
+ *    blocos, e o MPI não deixa mensagens do mesmo emissor se
+ *    ultrapassarem.
+ * 2. x_k só vai até o último processo que ainda tem blocos depois de k
+ *    (nos p - 1 últimos blocos o anel encurta).
+ * 3. A atualização B -= A X usa Blas1_dot com nrhs = 1 e Gemm_local
+ *    (com -X) a partir de TRSV_GEMM_MIN lados direitos; os laços são
+ *    marcados "omp simd" pelas macros de blas1.h (compilar com
+ *    -fopenmp-simd).
+ */
+#ifndef TRSV_H
+#define TRSV_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "gemm.h"
+#include "blas1.h"
+
+/* sem -fopenmp-simd as marcas "omp simd" são ignoradas, sem aviso */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+
+#define TRSV_NBUF 4          /* buffers de x_k em trânsito no anel */
+#define TRSV_GEMM_MIN 8
+
+typedef struct {
+   int n, nb, upper;
+   int n_blocks;         /* blocos de nb linhas (Trsv_pipelined)     */
+   int p, my_rank;
+   int up, down;         /* vizinhos no anel: recebe de up, manda p/ down */
+   Dvec_layout rows;     /* linhas de A e B                          */
+   MPI_Comm comm;
+   double t_comm, t_comp;
+} Trsv_plan;
+
+static inline void Trsv_plan_init(Trsv_plan* P, int n, Dvec_kind kind, int nb,
+      int upper, MPI_Comm comm) {
+   P->n = n;
+   P->upper = upper;
+   MPI_Comm_dup(comm, &P->comm);
+   MPI_Comm_size(P->comm, &P->p);
+   MPI_Comm_rank(P->comm, &P->my_rank);
+   Dvec_layout_init(&P->rows, n, kind, nb, P->comm);
+   P->nb = P->rows.nb;
+   P->n_blocks = (n + P->nb - 1) / P->nb;
+   /* a sequência dos blocos anda para o próximo processo na inferior e
+    * para o anterior na superior */
+   int dir = upper ? P->p - 1 : 1;
+   P->down = (P->my_rank + dir) % P->p;
+   P->up = (P->my_rank + P->p - dir) % P->p;
+   P->t_comm = P->t_comp = 0.0;
+}
+
+static inline void Trsv_plan_free(Trsv_plan* P) {
+   Dvec_layout_free(&P->rows);
+   MPI_Comm_free(&P->comm);
+}
+
+
+/*-------------------------------------------------------------------
+ * Kernels locais
+ */
+
+/* B -= A X: A m x kb (lda), X kb x nrhs, B m x nrhs (contíguos) */
+static inline void Trsv_update(int m, int kb, int nrhs, const double* A,
+      int lda, const double* X, double* B) {
+   if (m <= 0 || kb <= 0) return;
+   if (nrhs == 1) {
+      for (int i = 0; i < m; i++)
+         B[i] -= Blas1_dot(kb, A + (size_t) i * lda, X);
+   } else if (nrhs >= TRSV_GEMM_MIN) {
+      double* Xn = malloc((size_t) kb * nrhs * sizeof(double));
+      for (size_t t = 0; t < (size_t) kb * nrhs; t++)
+         Xn[t] = -X[t];
+      Gemm_local(m, nrhs, kb, A, lda, Xn, nrhs, B, nrhs);
+      free(Xn);
+   } else {
+      for (int i = 0; i < m; i++) {
+         const double* a = A + (size_t) i * lda;
+         double* b = B + (size_t) i * nrhs;
+         for (int t = 0; t < kb; t++) {
+            double at = a[t];
+            const double* x = X + (size_t) t * nrhs;
+            BLAS1_SIMD_FOR
+            for (int c = 0; c < nrhs; c++)
+               b[c] -= at * x[c];
+         }
+      }
+   }
+}
+
+/* bloco diagonal bs x bs (A aponta o elemento diagonal da 1a linha),
+ * B (bs x nrhs) é sobrescrito com a solução */
+static inline void Trsv_diag(int upper, int bs, int nrhs, const double* A,
+      int lda, double* B) {
+   for (int s = 0; s < bs; s++) {
+      int i = upper ? bs - 1 - s : s;
+      const double* a = A + (size_t) i * lda;
+      double* b = B + (size_t) i * nrhs;
+      int t0 = upper ? i + 1 : 0, t1 = upper ? bs : i;
+      for (int t = t0; t < t1; t++) {
+         double at = a[t];
+         const double* x = B + (size_t) t * nrhs;
+         BLAS1_SIMD_FOR
+         for (int c = 0; c < nrhs; c++)
+            b[c] -= at * x[c];
+      }
+      double d = 1.0 / a[i];
+      for (int c = 0; c < nrhs; c++)
+         b[c] *= d;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Trsv_pipelined (layout DVEC_BLOCK_CYCLIC)
+ */
+
+/* linhas locais dos blocos 0..k deste processo (k < 0: nenhuma) */
+static inline int Trsv_rows_upto(const Trsv_plan* P, int k) {
+   if (k < P->my_rank) return 0;
+   int l = ((k - P->my_rank) / P->p + 1) * P->nb;
+   return (l < P->rows.local_n) ? l : P->rows.local_n;
+}
+
+static inline int Trsv_block_size(const Trsv_plan* P, int k) {
+   int r = P->n - k * P->nb;
+   return (r < P->nb) ? r : P->nb;
+}
+
+/* resolve o bloco k (deste processo) e manda x_k para baixo no anel */
+static inline void Trsv_solve_block(Trsv_plan* P, const double* A, double* B,
+      int nrhs, int k, int hops, MPI_Request* req) {
+   int l0 = Trsv_rows_upto(P, k - 1), bs = Trsv_block_size(P, k);
+   double start = MPI_Wtime();
+   Trsv_diag(P->upper, bs, nrhs, A + (size_t) l0 * P->n + k * P->nb, P->n,
+             B + (size_t) l0 * nrhs);
+   P->t_comp += MPI_Wtime() - start;
+   if (hops > 0)
+      MPI_Isend(B + (size_t) l0 * nrhs, bs * nrhs, MPI_DOUBLE, P->down, 0,
+                P->comm, req);
+}
+
+static inline void Trsv_pipelined(Trsv_plan* P, const double* A, double* B,
+      int nrhs) {
+   int p = P->p, me = P->my_rank, nblk = P->n_blocks, n = P->n;
+   int dir = P->upper ? -1 : 1, ahead = -1, n_own = 0;
+   double* slot[TRSV_NBUF];
+   MPI_Request fwd[TRSV_NBUF];
+   MPI_Request* own = malloc((nblk / p + 1) * sizeof(MPI_Request));
+
+   for (int b = 0; b < TRSV_NBUF; b++) {
+      slot[b] = malloc((size_t) P->nb * nrhs * sizeof(double));
+      fwd[b] = MPI_REQUEST_NULL;
+   }
+
+   for (int s = 0; s < nblk; s++) {
+      int k = P->upper ? nblk - 1 - s : s;
+      int owner = k % p, bs = Trsv_block_size(P, k);
+      int hops = (nblk - 1 - s < p - 1) ? nblk - 1 - s : p - 1;
+      const double* xk;
+
+      if (owner == me) {
+         if (k != ahead) {
+            own[n_own] = MPI_REQUEST_NULL;
+            Trsv_solve_block(P, A, B, nrhs, k, hops, &own[n_own++]);
+         }
+         xk = B + (size_t) Trsv_rows_upto(P, k - 1) * nrhs;
+      } else {
+         int d = ((me - owner) * dir % p + p) % p;
+         if (d > hops) continue;           /* não tenho blocos depois de k */
+         int b = s % TRSV_NBUF;
+         double start = MPI_Wtime();
+         MPI_Wait(&fwd[b], MPI_STATUS_IGNORE);
+         MPI_Recv(slot[b], bs * nrhs, MPI_DOUBLE, P->up, 0, P->comm,
+                  MPI_STATUS_IGNORE);
+         if (d < hops)
+            MPI_Isend(slot[b], bs * nrhs, MPI_DOUBLE, P->down, 0, P->comm,
+                      &fwd[b]);
+         P->t_comm += MPI_Wtime() - start;
+         xk = slot[b];
+      }
+
+      /* próximo bloco da sequência primeiro, se for deste processo */
+      int k2 = k + dir, next = -1;
+      if (s + 1 < nblk && k2 % p == me) {
+         int l0 = Trsv_rows_upto(P, k2 - 1), bs2 = Trsv_block_size(P, k2);
+         int hops2 = (nblk - 2 - s < p - 1) ? nblk - 2 - s : p - 1;
+         double start = MPI_Wtime();
+         Trsv_update(bs2, bs, nrhs, A + (size_t) l0 * n + k * P->nb, n, xk,
+                     B + (size_t) l0 * nrhs);
+         P->t_comp += MPI_Wtime() - start;
+         own[n_own] = MPI_REQUEST_NULL;
+         Trsv_solve_block(P, A, B, nrhs, k2, hops2, &own[n_own++]);
+         ahead = next = k2;
+      }
+
+      /* resto das linhas locais que vêm depois de k na sequência */
+      int r0, r1;
+      if (P->upper) {
+         r0 = 0;
+         r1 = Trsv_rows_upto(P, (next >= 0 ? next : k) - 1);
+      } else {
+         r0 = Trsv_rows_upto(P, next >= 0 ? next : k);
+         r1 = P->rows.local_n;
+      }
+      double start = MPI_Wtime();
+      Trsv_update(r1 - r0, bs, nrhs, A + (size_t) r0 * n + k * P->nb, n, xk,
+                  B + (size_t) r0 * nrhs);
+      P->t_comp += MPI_Wtime() - start;
+   }
+
+   double start = MPI_Wtime();
+   MPI_Waitall(TRSV_NBUF, fwd, MPI_STATUSES_IGNORE);
+   MPI_Waitall(n_own, own, MPI_STATUSES_IGNORE);
+   P->t_comm += MPI_Wtime() - start;
+   for (int b = 0; b < TRSV_NBUF; b++)
+      free(slot[b]);
+   free(own);
+}
+
+
+/*-------------------------------------------------------------------
+ * Trsv_naive (layout DVEC_BLOCK): um processo de cada vez
+ */
+static inline void Trsv_naive(Trsv_plan* P, const double* A, double* B,
+      int nrhs) {
+   int n = P->n, me = P->my_rank, m = P->rows.local_n;
+   int g0 = Dvec_block_first(&P->rows, me), g1 = g0 + m;
+   int have0 = P->upper ? g1 : 0, have1 = P->upper ? n : g0;  /* x recebido */
+   int out0 = P->upper ? g0 : 0, out1 = P->upper ? n : g1;    /* x enviado  */
+   int first = P->upper ? P->p - 1 : 0, last = P->upper ? 0 : P->p - 1;
+   double* x = malloc(((size_t) (out1 - out0) * nrhs + 1) * sizeof(double));
+   double* xin = x + (size_t) (have0 - out0) * nrhs;
+
+   double start = MPI_Wtime();
+   if (me != first)
+      MPI_Recv(xin, (have1 - have0) * nrhs, MPI_DOUBLE, P->up, 0, P->comm,
+               MPI_STATUS_IGNORE);
+   P->t_comm += MPI_Wtime() - start;
+
+   start = MPI_Wtime();
+   Trsv_update(m, have1 - have0, nrhs, A + have0, n, xin, B);
+   Trsv_diag(P->upper, m, nrhs, A + g0, n, B);
+   P->t_comp += MPI_Wtime() - start;
+
+   start = MPI_Wtime();
+   if (me != last) {
+      memcpy(x + (size_t) (g0 - out0) * nrhs, B, (size_t) m * nrhs * sizeof(double));
+      MPI_Send(x, (out1 - out0) * nrhs, MPI_DOUBLE, P->down, 0, P->comm);
+   }
+   P->t_comm += MPI_Wtime() - start;
+   free(x);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Produto de matrizes distribuído C = A B (../include/gemm.h): SUMMA com
+ * painéis em MPI_Ibcast adiantados e Cannon com deslocamentos
+ * sobrepostos ao cálculo, em GFLOP/s por núcleo e eficiência paralela.
+ *
+ * Compilar:  mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_gemm mpi_gemm.c -lm
+ * Executar:  mpirun -np <p> ./mpi_gemm [n] [s | c | a] [kb]
+ *
+ * - n: ordem das matrizes quadradas (padrão 8192)
+ * - s = SUMMA, c = Cannon (p quadrado perfeito), a = os dois (padrão;
+ *   Cannon é pulado se p não for quadrado)
+ * - kb: largura máxima dos painéis do SUMMA (padrão 256)
+ * - referência de 1 núcleo: Gemm_local em todos os processos ao mesmo
+ *   tempo num problema local de GEMM_REF^3, melhor de 2 (mesma disputa
+ *   por memória do caso distribuído); eficiência = GFLOP/s por núcleo /
+ *   referência.
+ *   A linha "laço ikj" mostra o mesmo produto com o laço triplo simples.
+ * - tempos: mínimo de REPS execuções entre barreiras
+ * - A e B têm valores múltiplos de 1/4: as somas são exatas e cada
+ *   processo confere até 64 elementos do seu bloco de C
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/gemm.h"
+
+#define REPS 3
+#define GEMM_REF 768
+
+double A_entry(int i, int j) { return ((i + 3 * j) % 9 - 4) * 0.25; }
+double B_entry(int i, int j) { return ((2 * i + j) % 7 - 3) * 0.25; }
+
+double Ref_rate(int naive, MPI_Comm comm);
+void   Run(int n, int cannon, int kb, double ref, int my_rank, MPI_Comm comm);
+
+int main(int argc, char* argv[]) {
+    int my_rank, comm_sz;
+    MPI_Comm comm = MPI_COMM_WORLD;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &comm_sz);
+
+    int n = (argc > 1) ? atoi(argv[1]) : 8192;
+    char which = (argc > 2) ? argv[2][0] : 'a';
+    int kb = (argc > 3) ? atoi(argv[3]) : 256;
+    if (n <= 0 || kb <= 0 || strchr("sca", which) == NULL) {
+        if (my_rank == 0)
+            fprintf(stderr, "uso: mpirun -np <p> %s [n] [s | c | a] [kb]\n",
+                    argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    double ref = Ref_rate(0, comm), naive = Ref_rate(1, comm);
+    if (my_rank == 0) {
+        printf("\n(comm_sz = %d processos, n = %d, kb = %d)\n", comm_sz, n, kb);
+        printf("Referência (%d^3 por processo): Gemm_local %.2f GFLOP/s, "
+               "laço ikj %.2f GFLOP/s (%.1fx)\n\n", GEMM_REF, ref, naive,
+               ref / naive);
+        printf("%-8s %7s %11s %9s %11s %10s %8s  %s\n", "método", "grade",
+               "tempo (s)", "GFLOP/s", "GFLOP/s/p", "eficiência", "% comm",
+               "resultado");
+    }
+
+    if (which == 's' || which == 'a') Run(n, 0, kb, ref, my_rank, comm);
+    if (which == 'c' || which == 'a') Run(n, 1, kb, ref, my_rank, comm);
+    if (my_rank == 0) printf("\n");
+
+    MPI_Finalize();
+    return 0;
+}
+
+/* GFLOP/s médio por processo num produto local GEMM_REF^3 */
+double Ref_rate(int naive, MPI_Comm comm) {
+    int r = GEMM_REF, p;
+    double* A = malloc((size_t) r * r * sizeof(double));
+    double* B = malloc((size_t) r * r * sizeof(double));
+    double* C = calloc((size_t) r * r, sizeof(double));
+
+    for (int i = 0; i < r; i++)
+        for (int j = 0; j < r; j++) {
+            A[(size_t) i * r + j] = A_entry(i, j);
+            B[(size_t) i * r + j] = B_entry(i, j);
+        }
+    double best = 1e30;
+    for (int rep = 0; rep < 2; rep++) {         /* a 1a aquece */
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        if (naive) {
+            for (int i = 0; i < r; i++)
+                for (int k = 0; k < r; k++) {
+                    double a = A[(size_t) i * r + k];
+                    for (int j = 0; j < r; j++)
+                        C[(size_t) i * r + j] += a * B[(size_t) k * r + j];
+                }
+        } else {
+            Gemm_local(r, r, r, A, r, B, r, C, r);
+        }
+        double t = MPI_Wtime() - start;
+        if (t < best) best = t;
+    }
+    double rate = 2.0 * r * r * r / best / 1e9;
+    MPI_Allreduce(MPI_IN_PLACE, &rate, 1, MPI_DOUBLE, MPI_SUM, comm);
+    MPI_Comm_size(comm, &p);
+
+    free(A);
+    free(B);
+    free(C);
+    return rate / p;
+}
+
+/* mede e confere SUMMA (cannon = 0) ou Cannon (cannon = 1) */
+void Run(int n, int cannon, int kb, double ref, int my_rank, MPI_Comm comm) {
+    Gemm_grid G;
+    if (!Gemm_grid_init(&G, n, n, n, cannon, comm)) {
+        if (my_rank == 0)
+            printf("%-8s  (pulado: p não é quadrado perfeito)\n", "Cannon");
+        return;
+    }
+
+    int r0 = Dvec_block_first(&G.rows, G.my_row);
+    int c0 = Dvec_block_first(&G.cols, G.my_col);
+    int ka0 = Dvec_block_first(&G.ka, G.my_col);
+    int kb0 = Dvec_block_first(&G.kb, G.my_row);
+    double* A = malloc(((size_t) G.m_loc * G.ka_loc + 1) * sizeof(double));
+    double* B = malloc(((size_t) G.kb_loc * G.n_loc + 1) * sizeof(double));
+    double* C = malloc(((size_t) G.m_loc * G.n_loc + 1) * sizeof(double));
+
+    for (int i = 0; i < G.m_loc; i++)
+        for (int j = 0; j < G.ka_loc; j++)
+            A[(size_t) i * G.ka_loc + j] = A_entry(r0 + i, ka0 + j);
+    for (int i = 0; i < G.kb_loc; i++)
+        for (int j = 0; j < G.n_loc; j++)
+            B[(size_t) i * G.n_loc + j] = B_entry(kb0 + i, c0 + j);
+
+    double best = 1e30, comm_frac = 0.0;
+    for (int rep = 0; rep < REPS; rep++) {
+        memset(C, 0, (size_t) G.m_loc * G.n_loc * sizeof(double));
+        G.t_comm = G.t_comp = 0.0;
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        if (cannon) Gemm_cannon(&G, A, B, C);
+        else        Gemm_summa(&G, A, B, C, kb);
+        MPI_Barrier(comm);
+        double t = MPI_Wtime() - start;
+        if (t < best) {
+            best = t;
+            comm_frac = G.t_comm / (G.t_comm + G.t_comp);
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &comm_frac, 1, MPI_DOUBLE, MPI_MAX, comm);
+
+    /* até 64 elementos do bloco local, espalhados */
+    int ok = 1;
+    for (int t = 0; t < 64 && G.m_loc > 0 && G.n_loc > 0; t++) {
+        int i = (int) ((long long) t * 7919 % G.m_loc);
+        int j = (int) ((long long) t * 104729 % G.n_loc);
+        double s = 0.0;
+        for (int l = 0; l < n; l++)
+            s += A_entry(r0 + i, l) * B_entry(l, c0 + j);
+        ok &= (s == C[(size_t) i * G.n_loc + j]);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+
+    if (my_rank == 0) {
+        int p = G.pr * G.pc;
+        double gflops = 2.0 * n * (double) n * n / best / 1e9;
+        char grid[32];
+        snprintf(grid, sizeof(grid), "%dx%d", G.pr, G.pc);
+        printf("%-8s %7s %11.4f %9.2f %11.2f %9.1f%% %7.1f%%  %s\n",
+               cannon ? "Cannon" : "SUMMA", grid, best, gflops, gflops / p,
+               100.0 * gflops / p / ref, 100.0 * comm_frac,
+               ok ? "correto" : "INCORRETO");
+    }
+
+    free(A);
+    free(B);
+    free(C);
+    Gemm_grid_free(&G);
+}
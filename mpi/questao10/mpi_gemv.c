@@ -0,0 +1,126 @@
+/*
+ * Produto matriz-vetor distribuído y = A x (../include/gemv.h) com A em
+ * blocos de linhas, blocos de colunas e tabuleiro 2-D: tempo por
+ * produto, GFLOP/s total e por processo, e quanto do tempo vai em cada
+ * passo (Allgatherv de x, kernel local, Reduce_scatter de y).
+ *
+ * Compilar:  mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_gemv mpi_gemv.c -lm
+ * Executar:  mpirun -np <p> ./mpi_gemv [m] [n] [r | c | 2 | a]
+ *
+ * - m, n: ordem de A (padrão 16384 x 16384)
+ * - r = linhas, c = colunas, 2 = tabuleiro, a = os três (padrão)
+ * - cada processo gera o seu bloco de A e o seu pedaço de x (não há
+ *   distribuição de A no tempo medido)
+ * - tempos: mínimo de REPS produtos, cada um entre barreiras; os passos
+ *   são a média do processo mais lento
+ * - A e x têm valores múltiplos de 1/4 e 1/2: todas as somas são exatas,
+ *   e o y distribuído tem que ser igual ao calculado elemento a elemento
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/gemv.h"
+
+#define REPS 10
+
+static const char* names[3] = { "linhas", "colunas", "tabuleiro" };
+
+double A_entry(int i, int j) { return ((i + 2 * j) % 7 - 3) * 0.25; }
+double x_entry(int j)        { return (j % 5 - 2) * 0.5; }
+
+void Run_layout(int m, int n, Gemv_kind kind, int my_rank, MPI_Comm comm);
+
+int main(int argc, char* argv[]) {
+    int my_rank, comm_sz;
+    MPI_Comm comm = MPI_COMM_WORLD;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &comm_sz);
+
+    int m = (argc > 1) ? atoi(argv[1]) : 16384;
+    int n = (argc > 2) ? atoi(argv[2]) : m;
+    char which = (argc > 3) ? argv[3][0] : 'a';
+    if (m <= 0 || n <= 0 || strchr("rc2a", which) == NULL) {
+        if (my_rank == 0)
+            fprintf(stderr, "uso: mpirun -np <p> %s [m] [n] [r | c | 2 | a]\n",
+                    argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (my_rank == 0) {
+        printf("\n(comm_sz = %d processos, A %d x %d)\n\n", comm_sz, m, n);
+        printf("%-10s %7s %11s %9s %11s %9s %9s %9s  %s\n", "layout", "grade",
+               "tempo (s)", "GFLOP/s", "GFLOP/s/p", "% gather", "% kernel",
+               "% reduce", "resultado");
+    }
+    if (which == 'r' || which == 'a') Run_layout(m, n, GEMV_ROW, my_rank, comm);
+    if (which == 'c' || which == 'a') Run_layout(m, n, GEMV_COL, my_rank, comm);
+    if (which == '2' || which == 'a') Run_layout(m, n, GEMV_2D, my_rank, comm);
+    if (my_rank == 0) printf("\n");
+
+    MPI_Finalize();
+    return 0;
+}
+
+/* mede e confere um layout */
+void Run_layout(int m, int n, Gemv_kind kind, int my_rank, MPI_Comm comm) {
+    Gemv_plan P;
+    Gemv_plan_init(&P, m, n, kind, comm);
+
+    int nx = P.x_lay.local_n, ny = P.y_lay.local_n;
+    int x0 = P.col0 + Dvec_block_first(&P.x_lay, P.my_row);
+    int y0 = P.row0 + Dvec_block_first(&P.y_lay, P.my_col);
+    double* A = malloc(((size_t) P.m_loc * P.n_loc + 1) * sizeof(double));
+    double* x = malloc((nx + 1) * sizeof(double));
+    double* y = malloc((ny + 1) * sizeof(double));
+
+    for (int i = 0; i < P.m_loc; i++)
+        for (int j = 0; j < P.n_loc; j++)
+            A[(size_t) i * P.n_loc + j] = A_entry(P.row0 + i, P.col0 + j);
+    for (int l = 0; l < nx; l++)
+        x[l] = x_entry(x0 + l);
+
+    Gemv(&P, A, x, y);                          /* aquecimento */
+    P.t_gather = P.t_comp = P.t_reduce = 0.0;
+    double best = 1e30;
+    for (int rep = 0; rep < REPS; rep++) {
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        Gemv(&P, A, x, y);
+        MPI_Barrier(comm);
+        double t = MPI_Wtime() - start;
+        if (t < best) best = t;
+    }
+    double steps[3] = { P.t_gather / REPS, P.t_comp / REPS, P.t_reduce / REPS };
+    MPI_Allreduce(MPI_IN_PLACE, steps, 3, MPI_DOUBLE, MPI_MAX, comm);
+
+    /* confere o pedaço local de y elemento a elemento */
+    int ok = 1;
+    for (int l = 0; l < ny; l++) {
+        double s = 0.0;
+        for (int j = 0; j < n; j++)
+            s += A_entry(y0 + l, j) * x_entry(j);
+        if (s != y[l]) ok = 0;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+
+    if (my_rank == 0) {
+        int p = P.pr * P.pc;
+        double gflops = 2.0 * m * n / best / 1e9;
+        double sum = steps[0] + steps[1] + steps[2];
+        char grid[32];
+        snprintf(grid, sizeof(grid), "%dx%d", P.pr, P.pc);
+        printf("%-10s %7s %11.6f %9.2f %11.3f %8.1f%% %8.1f%% %8.1f%%  %s\n",
+               names[kind], grid, best, gflops, gflops / p,
+               100.0 * steps[0] / sum, 100.0 * steps[1] / sum,
+               100.0 * steps[2] / sum, ok ? "correto" : "INCORRETO");
+    }
+
+    free(A);
+    free(x);
+    free(y);
+    Gemv_plan_free(&P);
+}
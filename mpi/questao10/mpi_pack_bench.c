@@ -0,0 +1,394 @@
+/*
+ * Tipos derivados x MPI_Pack x empacotamento manual (../include/pack.h)
+ * para os mesmos dados lógicos em cinco formas, do processo 0 para o 1:
+ *   contíguo   matriz n x n inteira           MPI_Type_contiguous
+ *   coluna     coluna 0 da matriz             MPI_Type_vector
+ *   triângulo  triangular superior            MPI_Type_indexed
+ *                                             (mpi_triangular_superio.c)
+ *   submatriz  bloco n/2 x n/2 do meio        MPI_Type_create_subarray
+ *   structs    n^2/8 partículas, só id e pos  MPI_Type_create_struct
+ *              (28 dos 64 bytes de cada)      + MPI_Type_create_resized
+ * Para cada forma e cada n mede a banda (bytes lógicos / tempo de
+ * empacotar + enviar + receber + desempacotar), marca o mais rápido e
+ * no fim escolhe o método que ganhou em mais tamanhos (empate: menor
+ * tempo somado), impresso como a tabela Pack_best de pack.h.
+ *
+ * Compilar:  mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_pack_bench mpi_pack_bench.c
+ * Executar:  mpirun -np 2 ./mpi_pack_bench [n_max]
+ *
+ * - n = 256, 512, ... até n_max (padrão 4096, no máximo 8192)
+ * - manual no contíguo: o buffer vai direto (não há o que empacotar)
+ * - com -np 1 o processo 0 manda para si mesmo; com mais de 2 os outros
+ *   só esperam nas barreiras
+ * - tempos: mínimo de REPS envios entre barreiras; o receptor confere
+ *   os dados de cada envio
+ * - no fim (com 2 processos ou mais) confere também Pack_send_column e
+ *   Pack_send_fields de pack.h, que vão pelo método de Pack_best
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <mpi.h>
+#include "../include/pack.h"
+
+#define REPS 5
+#define N_MIN 256
+
+typedef struct {
+    int    id;
+    double pos[3];
+    double vel[3];
+    char   tag;
+} Particle;
+
+static const int part_off[2] = { offsetof(Particle, id),
+                                  offsetof(Particle, pos) };
+static const int part_len[2] = { sizeof(int), 3 * sizeof(double) };
+
+typedef struct {
+    Pack_shape   shape;
+    int          n;
+    size_t       buf_bytes;  /* buffer de origem / destino inteiro */
+    size_t       bytes;      /* dados lógicos (e buffer manual) */
+    MPI_Datatype type;       /* um elemento = a forma toda */
+} Test;
+
+void Test_init(Test* T, Pack_shape shape, int n);
+void Fill(const Test* T, void* buf);
+void Manual_pack(const Test* T, void* packed, const void* buf);
+void Manual_unpack(const Test* T, void* buf, const void* packed);
+double Run(const Test* T, Pack_method m, void* buf, void* work, void* expect,
+           int my_rank, int partner, int* ok, MPI_Comm comm);
+void Check_helpers(int n, int my_rank, int partner, int* ok, MPI_Comm comm);
+
+int main(int argc, char* argv[]) {
+    int my_rank, comm_sz;
+    MPI_Comm comm = MPI_COMM_WORLD;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &comm_sz);
+
+    int n_max = (argc > 1) ? atoi(argv[1]) : 4096;
+    if (n_max < N_MIN || n_max > 8192) {
+        if (my_rank == 0)
+            fprintf(stderr, "uso: mpirun -np 2 %s [n_max]  (%d <= n_max <= 8192)\n",
+                    argv[0], N_MIN);
+        MPI_Finalize();
+        return 1;
+    }
+    int partner = (comm_sz > 1) ? 1 : 0, ok = 1;
+    if (my_rank == 0)
+        printf("\n(comm_sz = %d, envio 0 -> %d, GB/s = bytes lógicos / tempo)\n",
+               comm_sz, partner);
+
+    Pack_method best[PACK_NSHAPES];
+    for (int s = 0; s < PACK_NSHAPES; s++) {
+        int wins[3] = { 0, 0, 0 };
+        double sum[3] = { 0.0, 0.0, 0.0 };
+        if (my_rank == 0) {
+            printf("\n=== %s ===\n", Pack_shape_names[s]);
+            printf("%6s %12s %10s %10s %10s  %s\n", "n", "bytes",
+                   Pack_method_names[0], Pack_method_names[1],
+                   Pack_method_names[2], "melhor");
+        }
+        for (int n = N_MIN; n <= n_max; n *= 2) {
+            Test T;
+            Test_init(&T, (Pack_shape) s, n);
+            void* buf = NULL, *work = NULL, *expect = NULL;
+            if (my_rank == 0 || my_rank == partner) {
+                buf = malloc(T.buf_bytes);
+                work = malloc(T.bytes);
+                expect = malloc(T.bytes);
+                Fill(&T, buf);
+                Manual_pack(&T, expect, buf);
+            }
+
+            double t[3];
+            int w = 0;
+            for (int m = 0; m < 3; m++) {
+                t[m] = Run(&T, (Pack_method) m, buf, work, expect, my_rank,
+                           partner, &ok, comm);
+                sum[m] += t[m];
+                if (t[m] < t[w]) w = m;
+            }
+            wins[w]++;
+            if (my_rank == 0)
+                printf("%6d %12zu %10.2f %10.2f %10.2f  %s\n", n, T.bytes,
+                       T.bytes / t[0] / 1e9, T.bytes / t[1] / 1e9,
+                       T.bytes / t[2] / 1e9, Pack_method_names[w]);
+
+            free(buf);
+            free(work);
+            free(expect);
+            MPI_Type_free(&T.type);
+        }
+        int b = 0;
+        for (int m = 1; m < 3; m++)
+            if (wins[m] > wins[b] || (wins[m] == wins[b] && sum[m] < sum[b]))
+                b = m;
+        best[s] = (Pack_method) b;
+    }
+    if (partner != 0) Check_helpers(n_max, my_rank, partner, &ok, comm);
+
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+    if (my_rank == 0) {
+        static const char* enum_names[3] = { "PACK_TYPE", "PACK_MPI",
+                                             "PACK_MANUAL" };
+        printf("\nPack_best[PACK_NSHAPES] = {");
+        for (int s = 0; s < PACK_NSHAPES; s++)
+            printf(" %s%s", enum_names[best[s]],
+                   (s < PACK_NSHAPES - 1) ? "," : " };\n");
+        printf("Resultado: %s\n\n", ok ? "correto" : "INCORRETO");
+    }
+
+    MPI_Finalize();
+    return 0;
+}
+
+/* tamanhos e tipo derivado de uma forma */
+void Test_init(Test* T, Pack_shape shape, int n) {
+    T->shape = shape;
+    T->n = n;
+    T->buf_bytes = (size_t) n * n * sizeof(double);
+    switch (shape) {
+    case PACK_CONTIG:
+        T->bytes = T->buf_bytes;
+        MPI_Type_contiguous(n * n, MPI_DOUBLE, &T->type);
+        break;
+    case PACK_COLUMN:
+        T->bytes = (size_t) n * sizeof(double);
+        MPI_Type_vector(n, 1, n, MPI_DOUBLE, &T->type);
+        break;
+    case PACK_TRIANGLE: {
+        int* lens = malloc(n * sizeof(int));
+        int* displs = malloc(n * sizeof(int));
+        for (int i = 0; i < n; i++) {
+            lens[i] = n - i;
+            displs[i] = i * n + i;
+        }
+        T->bytes = (size_t) n * (n + 1) / 2 * sizeof(double);
+        MPI_Type_indexed(n, lens, displs, MPI_DOUBLE, &T->type);
+        free(lens);
+        free(displs);
+        break;
+    }
+    case PACK_SUBMATRIX: {
+        int sizes[2] = { n, n }, sub[2] = { n / 2, n / 2 },
+            starts[2] = { n / 4, n / 4 };
+        T->bytes = (size_t) (n / 2) * (n / 2) * sizeof(double);
+        MPI_Type_create_subarray(2, sizes, sub, starts, MPI_ORDER_C,
+                                 MPI_DOUBLE, &T->type);
+        break;
+    }
+    default: {  /* PACK_STRUCT */
+        int count = n * n / 8, lens[2] = { 1, 3 };
+        MPI_Aint displs[2] = { part_off[0], part_off[1] };
+        MPI_Datatype types[2] = { MPI_INT, MPI_DOUBLE }, one, all;
+        T->buf_bytes = (size_t) count * sizeof(Particle);
+        T->bytes = (size_t) count * Pack_record_size(2, part_len);
+        MPI_Type_create_struct(2, lens, displs, types, &one);
+        MPI_Type_create_resized(one, 0, sizeof(Particle), &all);
+        MPI_Type_contiguous(count, all, &T->type);
+        MPI_Type_free(&one);
+        MPI_Type_free(&all);
+        break;
+    }
+    }
+    MPI_Type_commit(&T->type);
+}
+
+/* valores distintos em todo o buffer (inclusive fora da forma) */
+void Fill(const Test* T, void* buf) {
+    if (T->shape == PACK_STRUCT) {
+        Particle* P = buf;
+        size_t count = T->buf_bytes / sizeof(Particle);
+        memset(buf, 0, T->buf_bytes);
+        for (size_t r = 0; r < count; r++) {
+            P[r].id = (int) r;
+            for (int d = 0; d < 3; d++) {
+                P[r].pos[d] = r + d / 4.0;
+                P[r].vel[d] = -(r + d / 4.0);
+            }
+            P[r].tag = (char) (r % 128);
+        }
+    } else {
+        double* A = buf;
+        size_t count = T->buf_bytes / sizeof(double);
+        for (size_t k = 0; k < count; k++)
+            A[k] = k / 8.0;
+    }
+}
+
+void Manual_pack(const Test* T, void* packed, const void* buf) {
+    int n = T->n;
+    const double* A = buf;
+    switch (T->shape) {
+    case PACK_CONTIG:
+        memcpy(packed, buf, T->bytes);
+        break;
+    case PACK_COLUMN:
+        Pack_strided(packed, A, n, 1, n);
+        break;
+    case PACK_TRIANGLE:
+        Pack_upper(packed, A, n, n);
+        break;
+    case PACK_SUBMATRIX:
+        Pack_strided(packed, A + (size_t) (n / 4) * n + n / 4, n / 2, n / 2, n);
+        break;
+    default:
+        Pack_fields(packed, buf, n * n / 8, sizeof(Particle), 2, part_off,
+                    part_len);
+    }
+}
+
+void Manual_unpack(const Test* T, void* buf, const void* packed) {
+    int n = T->n;
+    double* A = buf;
+    switch (T->shape) {
+    case PACK_CONTIG:
+        memcpy(buf, packed, T->bytes);
+        break;
+    case PACK_COLUMN:
+        Unpack_strided(A, packed, n, 1, n);
+        break;
+    case PACK_TRIANGLE:
+        Unpack_upper(A, packed, n, n);
+        break;
+    case PACK_SUBMATRIX:
+        Unpack_strided(A + (size_t) (n / 4) * n + n / 4, packed, n / 2, n / 2, n);
+        break;
+    default:
+        Unpack_fields(buf, packed, n * n / 8, sizeof(Particle), 2, part_off,
+                      part_len);
+    }
+}
+
+/* melhor de REPS envios 0 -> partner com o método m; o receptor zera o
+ * buffer antes (fora do tempo) e confere depois */
+double Run(const Test* T, Pack_method m, void* buf, void* work, void* expect,
+           int my_rank, int partner, int* ok, MPI_Comm comm) {
+    int psize = 0;
+    char* pbuf = NULL;
+    int self = (partner == 0);
+    double best = 1e30;
+
+    if (m == PACK_MPI && (my_rank == 0 || my_rank == partner)) {
+        MPI_Pack_size(1, T->type, comm, &psize);
+        pbuf = malloc(psize);
+    }
+    /* com -np 1 o receptor precisa de um buffer separado */
+    void* dst = buf;
+    char* rbuf = pbuf;
+    if (self) {
+        dst = malloc(T->buf_bytes);
+        memcpy(dst, buf, T->buf_bytes);
+        if (m == PACK_MPI) rbuf = malloc(psize);
+    }
+    void* rwork = self ? malloc(T->bytes) : work;
+
+    for (int rep = 0; rep < REPS; rep++) {
+        if (my_rank == partner) memset(dst, 0, T->buf_bytes);
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        MPI_Request req = MPI_REQUEST_NULL;
+        if (my_rank == 0) {
+            if (m == PACK_TYPE) {
+                MPI_Isend(buf, 1, T->type, partner, m, comm, &req);
+            } else if (m == PACK_MPI) {
+                int pos = 0;
+                MPI_Pack(buf, 1, T->type, pbuf, psize, &pos, comm);
+                MPI_Isend(pbuf, pos, MPI_PACKED, partner, m, comm, &req);
+            } else if (T->shape == PACK_CONTIG) {
+                MPI_Isend(buf, (int) T->bytes, MPI_BYTE, partner, m, comm, &req);
+            } else {
+                Manual_pack(T, work, buf);
+                MPI_Isend(work, (int) T->bytes, MPI_BYTE, partner, m, comm, &req);
+            }
+        }
+        if (my_rank == partner) {
+            if (m == PACK_TYPE) {
+                MPI_Recv(dst, 1, T->type, 0, m, comm, MPI_STATUS_IGNORE);
+            } else if (m == PACK_MPI) {
+                int pos = 0;
+                MPI_Recv(rbuf, psize, MPI_PACKED, 0, m, comm, MPI_STATUS_IGNORE);
+                MPI_Unpack(rbuf, psize, &pos, dst, 1, T->type, comm);
+            } else if (T->shape == PACK_CONTIG) {
+                MPI_Recv(dst, (int) T->bytes, MPI_BYTE, 0, m, comm,
+                         MPI_STATUS_IGNORE);
+            } else {
+                MPI_Recv(rwork, (int) T->bytes, MPI_BYTE, 0, m, comm,
+                         MPI_STATUS_IGNORE);
+                Manual_unpack(T, dst, rwork);
+            }
+        }
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        MPI_Barrier(comm);
+        double t = MPI_Wtime() - start;
+        if (t < best) best = t;
+
+        if (my_rank == partner) {
+            Manual_pack(T, rwork, dst);
+            if (memcmp(rwork, expect, T->bytes) != 0) *ok = 0;
+        }
+    }
+
+    if (self) {
+        free(dst);
+        free(rwork);
+        if (m == PACK_MPI) free(rbuf);
+    }
+    free(pbuf);
+    return best;
+}
+
+/* coluna 3 de uma matriz n x n e id + pos de n^2/8 partículas pelas
+ * funções de envio de pack.h; o receptor confere contra Fill */
+void Check_helpers(int n, int my_rank, int partner, int* ok, MPI_Comm comm) {
+    if (my_rank != 0 && my_rank != partner) return;
+
+    Test T;
+    Test_init(&T, PACK_COLUMN, n);
+    double* A = malloc(T.buf_bytes);
+    Fill(&T, A);
+    if (my_rank == 0) {
+        Pack_send_column(A, n, n, 3, partner, 0, comm);
+    } else {
+        double* B = calloc((size_t) n * n, sizeof(double));
+        Pack_recv_column(B, n, n, 3, 0, 0, comm);
+        for (int i = 0; i < n; i++)
+            if (B[(size_t) i * n + 3] != A[(size_t) i * n + 3]) *ok = 0;
+        free(B);
+    }
+    free(A);
+    MPI_Type_free(&T.type);
+
+    int count = n * n / 8, lens[2] = { 1, 3 };
+    MPI_Aint displs[2] = { part_off[0], part_off[1] };
+    MPI_Datatype types[2] = { MPI_INT, MPI_DOUBLE }, one, rec;
+    MPI_Type_create_struct(2, lens, displs, types, &one);
+    MPI_Type_create_resized(one, 0, sizeof(Particle), &rec);
+    MPI_Type_commit(&rec);
+    MPI_Type_free(&one);
+
+    Test_init(&T, PACK_STRUCT, n);
+    Particle* P = malloc(T.buf_bytes);
+    Fill(&T, P);
+    if (my_rank == 0) {
+        Pack_send_fields(P, count, sizeof(Particle), 2, part_off, part_len,
+                         rec, partner, 1, comm);
+    } else {
+        Particle* Q = calloc(count, sizeof(Particle));
+        Pack_recv_fields(Q, count, sizeof(Particle), 2, part_off, part_len,
+                         rec, 0, 1, comm);
+        for (int r = 0; r < count; r++)
+            if (Q[r].id != P[r].id
+                    || memcmp(Q[r].pos, P[r].pos, sizeof(P[r].pos)) != 0)
+                *ok = 0;
+        free(Q);
+    }
+    free(P);
+    MPI_Type_free(&T.type);
+    MPI_Type_free(&rec);
+}
@@ -0,0 +1,231 @@
+/*
+ * Armazenamento compactado de matrizes (../include/pmat.h) comparado com a
+ * matriz densa + MPI_Type_indexed de mpi_triangular_superio.c: memória,
+ * envio do processo 0 para o 1 e distribuição por linhas para todos.
+ *
+ * Compilar:  mpicc -O2 -Wall -o mpi_packed_matrix mpi_packed_matrix.c
+ * Executar:  mpirun -np <p> ./mpi_packed_matrix [n] [u | l | s | b | a] [bw]
+ *
+ * - n: ordem da matriz (padrão 4096)
+ * - u = triangular superior, l = inferior, s = simétrica, b = banda com
+ *   kl = ku = bw (padrão n/64), a = todas (padrão)
+ * - envio 0 -> 1 (p >= 2), mínimo de REPS:
+ *     denso inteiro       MPI_Send das n^2 posições
+ *     denso+indexed novo  cria, faz commit e libera o tipo a cada envio
+ *                         (como mpi_triangular_superio.c)
+ *     denso+tipo em cache Pmat_send_dense (tipo da cache)
+ *     compactado          Pmat_send (contíguo)
+ *   o receptor sempre guarda em Pmat e confere todos os elementos
+ * - distribuição (linhas com nnz parecido por processo):
+ *     Pmat_scatter (raiz compactado, MPI_Scatterv) x Pmat_scatter_dense
+ *     (raiz denso, um tipo da cache por processo); o que Pmat_scatter
+ *     distribuiu volta ao raiz com Pmat_gather (MPI_Gatherv), que
+ *     confere a matriz inteira
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/pmat.h"
+
+#define REPS 5
+
+static const char* kind_names[4] = { "superior", "inferior", "simétrica",
+                                     "banda" };
+
+double Entry(int i, int j) { return i + j / 65536.0; }
+
+void Run_shape(const Pmat_shape* sh, int my_rank, int comm_sz, MPI_Comm comm);
+int  Check(const Pmat* M);
+void Send_dense(const double* A, int n, int dest, int tag, MPI_Comm comm);
+void Recv_dense(double* A, int n, int src, int tag, MPI_Comm comm);
+void Report(const char* what, long long bytes, double secs);
+
+int main(int argc, char* argv[]) {
+    int my_rank, comm_sz;
+    MPI_Comm comm = MPI_COMM_WORLD;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &comm_sz);
+
+    int n = (argc > 1) ? atoi(argv[1]) : 4096;
+    char which = (argc > 2) ? argv[2][0] : 'a';
+    int bw = (argc > 3) ? atoi(argv[3]) : n / 64;
+    if (n <= 0 || bw < 0 || strchr("ulsba", which) == NULL) {
+        if (my_rank == 0)
+            fprintf(stderr, "uso: mpirun -np <p> %s [n] [u | l | s | b | a] [bw]\n",
+                    argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    const char* codes = "ulsb";
+    for (int k = 0; k < 4; k++)
+        if (which == 'a' || which == codes[k]) {
+            Pmat_shape sh = Pmat_shape_make((Pmat_kind) k, n, bw, bw);
+            Run_shape(&sh, my_rank, comm_sz, comm);
+        }
+
+    if (my_rank == 0)
+        printf("\ncache de tipos: %lld acertos, %lld tipos criados\n\n",
+               Pmat_cache_hits, Pmat_cache_misses);
+    Pmat_type_cache_free();
+    MPI_Finalize();
+    return 0;
+}
+
+void Run_shape(const Pmat_shape* sh, int my_rank, int comm_sz, MPI_Comm comm) {
+    int n = sh->n, ok = 1;
+    long long nnz = Pmat_rows_nnz(sh, 0, n);
+    double* A = NULL;
+    Pmat M;
+
+    /* matriz densa (zeros fora da parte guardada) e compactada no 0 */
+    Pmat_create(&M, sh, 0, n);
+    if (my_rank == 0) {
+        A = malloc((size_t) n * n * sizeof(double));
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                A[(size_t) i * n + j] = (Pmat_at(&M, i, j) != NULL) ?
+                                        Entry(i, j) : 0.0;
+        Pmat_from_dense(&M, A, n);
+    }
+
+    if (my_rank == 0) {
+        printf("\n=== %s, n = %d", kind_names[sh->kind], n);
+        if (sh->kind == PMAT_BAND) printf(", kl = ku = %d", sh->kl);
+        printf(" ===\n");
+        printf("memória: densa %.1f MB, compactada %.1f MB (%.1f%%)\n",
+               n * (double) n * 8 / 1e6, nnz * 8 / 1e6,
+               100.0 * nnz / ((double) n * n));
+    }
+
+    /* envio 0 -> 1 */
+    if (comm_sz >= 2) {
+        double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+        double* D = (my_rank == 1) ? malloc((size_t) n * n * sizeof(double))
+                                   : NULL;
+        for (int rep = 0; rep < REPS; rep++)
+            for (int m = 0; m < 4; m++) {
+                if (my_rank == 1) memset(M.val, 0, M.nnz * sizeof(double));
+                MPI_Barrier(comm);
+                double start = MPI_Wtime();
+                if (my_rank == 0) {
+                    if (m == 0) {
+                        Send_dense(A, n, 1, m, comm);
+                    } else if (m == 1) {
+                        for (int r = 0; r < n; ) {
+                            int e = Pmat_group_end(sh, r, n);
+                            MPI_Datatype t = Pmat_build_dense_type(sh, r, e, n);
+                            MPI_Send(A + (size_t) r * n, 1, t, 1, m, comm);
+                            MPI_Type_free(&t);
+                            r = e;
+                        }
+                    } else if (m == 2) {
+                        Pmat_send_dense(A, n, sh, 0, n, 1, m, comm);
+                    } else {
+                        Pmat_send(&M, 1, m, comm);
+                    }
+                } else if (my_rank == 1) {
+                    if (m == 0) {
+                        Recv_dense(D, n, 0, m, comm);
+                        Pmat_from_dense(&M, D, n);
+                    } else {
+                        Pmat_recv(&M, 0, m, comm);
+                    }
+                    ok &= Check(&M);
+                }
+                double t = MPI_Wtime() - start;
+                if (t < best[m]) best[m] = t;
+            }
+        free(D);
+
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+        if (my_rank == 0) {
+            printf("\n%-22s %14s %11s %10s\n", "envio 0 -> 1", "bytes",
+                   "tempo (s)", "GB/s");
+            Report("denso inteiro", (long long) n * n * 8, best[0]);
+            Report("denso+indexed novo", nnz * 8, best[1]);
+            Report("denso+tipo em cache", nnz * 8, best[2]);
+            Report("compactado", nnz * 8, best[3]);
+        }
+    }
+
+    /* distribuição para todos e volta ao 0 (em G, só no 0) */
+    double best[3] = { 1e30, 1e30, 1e30 };
+    Pmat G;
+    if (my_rank == 0) Pmat_create(&G, sh, 0, n);
+    for (int rep = 0; rep < REPS; rep++)
+        for (int m = 0; m < 2; m++) {
+            Pmat L;
+            MPI_Barrier(comm);
+            double start = MPI_Wtime();
+            if (m == 0) Pmat_scatter(&M, sh, 0, &L, comm);
+            else        Pmat_scatter_dense(A, n, sh, 0, &L, comm);
+            MPI_Barrier(comm);
+            double t = MPI_Wtime() - start;
+            if (t < best[m]) best[m] = t;
+            ok &= Check(&L);
+            if (m == 0) {
+                /* -1 não é valor de Entry: elemento não recebido falha */
+                if (my_rank == 0)
+                    for (long long e = 0; e < G.nnz; e++) G.val[e] = -1.0;
+                MPI_Barrier(comm);
+                start = MPI_Wtime();
+                Pmat_gather(&L, 0, &G, comm);
+                MPI_Barrier(comm);
+                t = MPI_Wtime() - start;
+                if (t < best[2]) best[2] = t;
+                if (my_rank == 0) ok &= Check(&G);
+            }
+            Pmat_free(&L);
+        }
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+    if (my_rank == 0) Pmat_free(&G);
+
+    if (my_rank == 0) {
+        printf("\n%-22s %14s %11s %10s\n", "distribuição", "bytes",
+               "tempo (s)", "GB/s");
+        Report("Pmat_scatter", nnz * 8, best[0]);
+        Report("Pmat_scatter_dense", nnz * 8, best[1]);
+        Report("Pmat_gather", nnz * 8, best[2]);
+        printf("Resultado: %s\n", ok ? "correto" : "INCORRETO");
+    }
+
+    free(A);
+    Pmat_free(&M);
+}
+
+/* todas as posições guardadas de M têm o valor de Entry */
+int Check(const Pmat* M) {
+    for (int i = M->r0; i < M->r1; i++) {
+        int c0 = Pmat_first_col(&M->sh, i), c1 = Pmat_end_col(&M->sh, i);
+        const double* row = M->val + M->off[i - M->r0];
+        for (int j = c0; j < c1; j++)
+            if (row[j - c0] != Entry(i, j)) return 0;
+    }
+    return 1;
+}
+
+/* n^2 doubles numa mensagem, ou linha a linha se não couber */
+void Send_dense(const double* A, int n, int dest, int tag, MPI_Comm comm) {
+    if ((long long) n * n <= PMAT_MAX_MSG)
+        MPI_Send(A, n * n, MPI_DOUBLE, dest, tag, comm);
+    else
+        for (int r = 0; r < n; r++)
+            MPI_Send(A + (size_t) r * n, n, MPI_DOUBLE, dest, tag, comm);
+}
+
+void Recv_dense(double* A, int n, int src, int tag, MPI_Comm comm) {
+    if ((long long) n * n <= PMAT_MAX_MSG)
+        MPI_Recv(A, n * n, MPI_DOUBLE, src, tag, comm, MPI_STATUS_IGNORE);
+    else
+        for (int r = 0; r < n; r++)
+            MPI_Recv(A + (size_t) r * n, n, MPI_DOUBLE, src, tag, comm,
+                     MPI_STATUS_IGNORE);
+}
+
+void Report(const char* what, long long bytes, double secs) {
+    printf("%-22s %14lld %11.6f %10.2f\n", what, bytes, secs, bytes / secs / 1e9);
+}
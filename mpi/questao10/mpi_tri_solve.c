@@ -0,0 +1,148 @@
+/*
+ * Sistema triangular distribuído A X = B (../include/trsv.h): substituição
+ * em pipeline com linhas em blocos cíclicos, x_k repassado num anel com
+ * MPI_Isend, contra a versão ingênua em que um processo de cada vez
+ * recebe o x já calculado, resolve as suas linhas e passa adiante.
+ *
+ * Compilar:  mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_tri_solve mpi_tri_solve.c -lm
+ * Executar:  mpirun -np <p> ./mpi_tri_solve [n] [nrhs] [nb] [l | u | a]
+ *
+ * - n: ordem de A (padrão 8192); nrhs: lados direitos (padrão 1)
+ * - nb: linhas por bloco do pipeline (padrão 64)
+ * - l = inferior (para frente), u = superior (para trás), a = as duas
+ * - cada processo gera as suas linhas de A, de X verdadeiro e B = A X
+ *   (fora do tempo); A tem diagonal n + 1 e o resto em [-0.75, 0.75],
+ *   então o sistema é bem condicionado e o erro máximo |X - X_verdadeiro|
+ *   tem que ficar perto do arredondamento
+ * - tempos: mínimo de REPS soluções entre barreiras; "% comm" é a fração
+ *   do processo mais lento esperando mensagens
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#include "../include/trsv.h"
+
+#define REPS 3
+#define TOL 1e-10
+
+double A_entry(int n, int upper, int i, int j) {
+    if (i == j) return n + 1.0;
+    if (upper ? j < i : j > i) return 0.0;
+    return ((i + 2 * j) % 7 - 3) * 0.25;
+}
+double X_entry(int i, int c) { return ((i + 3 * c) % 5 - 2) * 0.5 + 0.25; }
+
+void Run(int n, int nrhs, int nb, int upper, int pipelined, double t_naive[2],
+         int my_rank, MPI_Comm comm);
+
+int main(int argc, char* argv[]) {
+    int my_rank, comm_sz;
+    MPI_Comm comm = MPI_COMM_WORLD;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &comm_sz);
+
+    int n = (argc > 1) ? atoi(argv[1]) : 8192;
+    int nrhs = (argc > 2) ? atoi(argv[2]) : 1;
+    int nb = (argc > 3) ? atoi(argv[3]) : 64;
+    char which = (argc > 4) ? argv[4][0] : 'a';
+    if (n <= 0 || nrhs <= 0 || nb <= 0 || strchr("lua", which) == NULL) {
+        if (my_rank == 0)
+            fprintf(stderr, "uso: mpirun -np <p> %s [n] [nrhs] [nb] [l | u | a]\n",
+                    argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (my_rank == 0) {
+        printf("\n(comm_sz = %d processos, n = %d, nrhs = %d, nb = %d)\n\n",
+               comm_sz, n, nrhs, nb);
+        printf("%-10s %-10s %11s %9s %8s %8s %10s  %s\n", "matriz", "método",
+               "tempo (s)", "GFLOP/s", "% comm", "speedup", "erro máx",
+               "resultado");
+    }
+    double t_naive[2];
+    for (int upper = 0; upper < 2; upper++) {
+        if (which != 'a' && which != "lu"[upper]) continue;
+        Run(n, nrhs, nb, upper, 0, t_naive, my_rank, comm);
+        Run(n, nrhs, nb, upper, 1, t_naive, my_rank, comm);
+    }
+    if (my_rank == 0) printf("\n");
+
+    MPI_Finalize();
+    return 0;
+}
+
+/* mede e confere a versão ingênua (pipelined = 0, guarda o tempo em
+ * t_naive[upper]) ou a em pipeline (speedup sobre t_naive[upper]) */
+void Run(int n, int nrhs, int nb, int upper, int pipelined, double t_naive[2],
+         int my_rank, MPI_Comm comm) {
+    Trsv_plan P;
+    Trsv_plan_init(&P, n, pipelined ? DVEC_BLOCK_CYCLIC : DVEC_BLOCK, nb,
+                   upper, comm);
+
+    int m = P.rows.local_n;
+    double* A = malloc(((size_t) m * n + 1) * sizeof(double));
+    double* B0 = malloc(((size_t) m * nrhs + 1) * sizeof(double));
+    double* B = malloc(((size_t) m * nrhs + 1) * sizeof(double));
+
+    for (int l = 0; l < m; l++) {
+        int i = Dvec_global_index(&P.rows, my_rank, l);
+        double* a = A + (size_t) l * n;
+        double* b = B0 + (size_t) l * nrhs;
+        for (int j = 0; j < n; j++)
+            a[j] = A_entry(n, upper, i, j);
+        memset(b, 0, nrhs * sizeof(double));
+        int j0 = upper ? i : 0, j1 = upper ? n : i + 1;
+        for (int j = j0; j < j1; j++)
+            for (int c = 0; c < nrhs; c++)
+                b[c] += a[j] * X_entry(j, c);
+    }
+
+    double best = 1e30, comm_frac = 0.0;
+    for (int rep = 0; rep < REPS; rep++) {
+        memcpy(B, B0, (size_t) m * nrhs * sizeof(double));
+        P.t_comm = P.t_comp = 0.0;
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        if (pipelined) Trsv_pipelined(&P, A, B, nrhs);
+        else           Trsv_naive(&P, A, B, nrhs);
+        MPI_Barrier(comm);
+        double t = MPI_Wtime() - start;
+        if (t < best) {
+            best = t;
+            comm_frac = P.t_comm / t;
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &comm_frac, 1, MPI_DOUBLE, MPI_MAX, comm);
+
+    double err = 0.0;
+    for (int l = 0; l < m; l++) {
+        int i = Dvec_global_index(&P.rows, my_rank, l);
+        for (int c = 0; c < nrhs; c++) {
+            double e = fabs(B[(size_t) l * nrhs + c] - X_entry(i, c));
+            if (e > err) err = e;
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &err, 1, MPI_DOUBLE, MPI_MAX, comm);
+
+    if (!pipelined) t_naive[upper] = best;
+    if (my_rank == 0) {
+        char speedup[16] = "-";
+        if (pipelined)
+            snprintf(speedup, sizeof(speedup), "%.2fx", t_naive[upper] / best);
+        printf("%-10s %-10s %11.6f %9.3f %7.1f%% %8s %10.2e  %s\n",
+               upper ? "superior" : "inferior",
+               pipelined ? "pipeline" : "ingênuo", best,
+               (double) n * n * nrhs / best / 1e9, 100.0 * comm_frac, speedup,
+               err, (err < TOL) ? "correto" : "INCORRETO");
+    }
+
+    free(A);
+    free(B0);
+    free(B);
+    Trsv_plan_free(&P);
+}
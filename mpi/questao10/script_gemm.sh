@@ -0,0 +1,42 @@
+#!/bin/bash
+#SBATCH --nodes=6
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_gemm
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_gemm_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questao10/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_gemm mpi_gemm.c -lm
+
+# quadrados perfeitos (Cannon e SUMMA) e múltiplos de 24 (só SUMMA)
+for N in 8192 16384
+do
+    for NP in 1 4 16 24 36 48 64 96 100 144
+    do
+        echo ""
+        echo ">>> n=$N | p=$NP"
+        mpirun -np $NP ./mpi_gemm $N a 256
+    done
+done
+
+# largura do painel do SUMMA
+for KB in 64 128 512
+do
+    echo ""
+    echo ">>> n=16384 | p=144 | kb=$KB"
+    mpirun -np 144 ./mpi_gemm 16384 s $KB
+done
+
+echo ""
+echo "FIM DO JOB"
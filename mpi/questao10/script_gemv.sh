@@ -0,0 +1,39 @@
+#!/bin/bash
+#SBATCH --nodes=6
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_gemv
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_gemv_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questao10/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_gemv mpi_gemv.c -lm
+
+# A quadrada (a de 32768 ocupa 8 GB, ~340 MB por processo com p=24)
+# e uma retangular larga/alta para ver o efeito de m x n no layout
+for SIZE in "16384 16384" "32768 32768" "4096 131072" "131072 4096"
+do
+    echo ""
+    echo "######################################"
+    echo "### A = $SIZE"
+    echo "######################################"
+    for NP in 24 48 72 96 120 144
+    do
+        echo ""
+        echo ">>> p=$NP | A = $SIZE"
+        mpirun -np $NP ./mpi_gemv $SIZE a
+    done
+done
+
+echo ""
+echo "FIM DO JOB"
@@ -0,0 +1,33 @@
+#!/bin/bash
+#SBATCH --nodes=2
+#SBATCH --ntasks-per-node=2
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_pack_bench
+#SBATCH --exclusive
+#SBATCH --time=00:10:00
+#SBATCH --output=resultado_pack_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questao10/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_pack_bench mpi_pack_bench.c
+
+# mesmo nó (memória compartilhada)
+echo ""
+echo ">>> 2 processos no mesmo nó"
+mpirun -np 2 --map-by core ./mpi_pack_bench 8192
+
+# nós diferentes (rede)
+echo ""
+echo ">>> 2 processos em nós diferentes"
+mpirun -np 2 --map-by node ./mpi_pack_bench 8192
+
+echo ""
+echo "FIM DO JOB"
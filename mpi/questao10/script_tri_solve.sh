@@ -0,0 +1,42 @@
+#!/bin/bash
+#SBATCH --nodes=6
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_tri_solve
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_tri_solve_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questao10/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_tri_solve mpi_tri_solve.c -lm
+
+# pipeline x ingênuo, 1 e 16 lados direitos
+for NRHS in 1 16
+do
+    for NP in 1 2 4 8 16 24 48 96 144
+    do
+        echo ""
+        echo ">>> n=16384 | nrhs=$NRHS | p=$NP"
+        mpirun -np $NP ./mpi_tri_solve 16384 $NRHS 64 a
+    done
+done
+
+# tamanho do bloco do pipeline
+for NB in 16 32 128 256
+do
+    echo ""
+    echo ">>> n=16384 | nrhs=16 | p=144 | nb=$NB"
+    mpirun -np 144 ./mpi_tri_solve 16384 16 $NB a
+done
+
+echo ""
+echo "FIM DO JOB"
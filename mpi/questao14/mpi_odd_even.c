@@ -3,7 +3,8 @@
  * Purpose:  Implement parallel odd-even sort of an array of 
  *           nonnegative ints (pointer-swapping merge)
  *
- * Compile:  mpicc -g -Wall -o mpi_odd_even mpi_odd_even.c
+ * Compile:  mpicc -g -Wall -o mpi_odd_even mpi_odd_even.c -lm
+ *           (add -fopenmp for multithreaded merges, see note 4)
  * Run:
  *    mpiexec -n <p> mpi_odd_even <g|i> <global_n> 
  *
@@ -11,18 +12,24 @@
  * 1. global_n must be evenly divisible by p
  * 2. Except for debug output, process 0 does all I/O
  * 3. Optional -DDEBUG compile flag for verbose output
+ * 4. With -fopenmp, Merge_low/Merge_high split the merge among
+ *    OMP_NUM_THREADS threads by merge path (../include/mergepath.h);
+ *    only the main thread calls MPI
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+#include "../include/mergepath.h"
 
 const int RMAX = 100;
 
 /* ----------------- Prototypes ----------------- */
 void Usage(char* program);
-void Generate_list(int local_A[], int local_n, int my_rank);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n);
 void Read_list(int local_A[], int local_n, int my_rank, int p, MPI_Comm comm);
 void Print_list(int local_A[], int local_n, int rank);
 void Print_local_lists(int local_A[], int local_n, int my_rank, int p, MPI_Comm comm);
@@ -50,7 +57,12 @@ int main(int argc, char* argv[]) {
     int global_n, local_n;
     MPI_Comm comm;
 
+#ifdef _OPENMP
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+#else
     MPI_Init(&argc, &argv);
+#endif
     comm = MPI_COMM_WORLD;
     MPI_Comm_size(comm, &p);
     MPI_Comm_rank(comm, &my_rank);
@@ -64,7 +76,7 @@ int main(int argc, char* argv[]) {
     }
 
     if (g_i == 'g') {
-        Generate_list(local_A, local_n, my_rank);
+        Generate_list(local_A, local_n, my_rank, global_n);
         Print_local_lists(local_A, local_n, my_rank, p, comm);
     } else {
         Read_list(local_A, local_n, my_rank, p, comm);
@@ -93,11 +105,11 @@ int main(int argc, char* argv[]) {
 
 /* ----------------- Utility functions ----------------- */
 
-void Generate_list(int local_A[], int local_n, int my_rank) {
-   int i;
-   srandom(my_rank+1);
-   for (i = 0; i < local_n; i++)
-      local_A[i] = random() % RMAX;
+/* this process' block of the global list (keygen.h, uniform in
+   [0, RMAX), the same for every p) */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, 'u', RMAX, KEYGEN_SEED);
 } 
 
 void Usage(char* program) {
@@ -161,8 +173,10 @@ void Read_list(int local_A[], int local_n, int my_rank, int p,
          MPI_Abort(comm, 1);
       }
       printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
       for (i = 0; i < p * local_n; i++)
-         scanf("%d", &temp[i]);
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
    } 
 
    MPI_Scatter(temp, local_n, MPI_INT, local_A, local_n, MPI_INT,
@@ -217,8 +231,10 @@ void Print_global_list(int local_A[], int local_n, int my_rank, int p,
       }
       MPI_Gather(local_A, local_n, MPI_INT, A, local_n, MPI_INT, 0, comm);
       printf("Global list:\n");
+      Fio_out* out = Fio_out_open(stdout);
       for (i = 0; i < n; i++)
-         printf("%d ", A[i]);
+         Fio_write_int(out, A[i], ' ');
+      Fio_out_close(out);
       printf("\n\n");
       free(A);
    } else {
@@ -235,7 +251,7 @@ void Print_global_list(int local_A[], int local_n, int my_rank, int p,
  *  - allocates two auxiliary buffers:
  *      recv_buf: target for MPI_Recv (can be overwritten safely each phase)
  *      buffer:   target for merge output
- *  - After each merge, swaps *local_A_ptr and buffer pointer
+ *  - After each merge, *local_A_ptr and buffer are swapped (in Odd_even_iter)
  *  - At the end frees the auxiliary buffer that is not the final *local_A_ptr (only if it
  *    was allocated inside Sort), and frees recv_buf.
  *
@@ -271,20 +287,13 @@ void Sort(int **local_A_ptr, int local_n, int my_rank, int p, MPI_Comm comm) {
     /* Sort local list using built-in quick sort (on whatever *local_A_ptr points to) */
     qsort(*local_A_ptr, local_n, sizeof(int), Compare);
 
-    /* Main odd-even loop: Odd_even_iter will do the receive into recv_buf and merge into buffer.
-       After calling Odd_even_iter, we must swap *local_A_ptr and buffer (so next phase uses result). */
-    for (phase = 0; phase < p; phase++) {
+    /* Main odd-even loop: Odd_even_iter does the receive into recv_buf, the merge into buffer
+       and, only when it merged, swaps *local_A_ptr and buffer (so next phase uses the result).
+       An idle process keeps its list: swapping there would replace it with the stale spare array. */
+    for (phase = 0; phase < p; phase++)
         Odd_even_iter(local_A_ptr, &buffer, recv_buf, local_n, phase,
                       even_partner, odd_partner, my_rank, p, comm);
 
-        /* swap pointers: *local_A_ptr points to new sorted buffer; buffer becomes old array */
-        int *tmp = *local_A_ptr;
-        *local_A_ptr = buffer;
-        buffer = tmp;
-        /* Note: After swap, buffer holds the old array (may be orig_local or previously allocated buffer).
-           The next merge will write into buffer (overwriting its contents). */
-    }
-
     /* free recv_buf (always allocated here) */
     free(recv_buf);
 
@@ -304,7 +313,8 @@ void Sort(int **local_A_ptr, int local_n, int my_rank, int p, MPI_Comm comm) {
  *  - partner is determined by phase (even_partner or odd_partner)
  *  - MPI_Sendrecv is used to exchange current local array with partner; recv into recv_buf
  *  - call Merge_low or Merge_high to merge A and recv_buf into buffer (buffer is *buffer_ptr)
- *  - IMPORTANT: Odd_even_iter does NOT swap pointers itself; Sort will swap after Odd_even_iter returns.
+ *  - after the merge, swaps *local_A_ptr and *buffer_ptr; an idle process
+ *    (partner == MPI_PROC_NULL) swaps nothing
  *
  * Note: buffer_ptr is pointer-to-pointer so we can pass the current buffer pointer by reference.
  */
@@ -333,6 +343,11 @@ void Odd_even_iter(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
             else
                 Merge_low(*local_A_ptr, recv_buf, *buffer_ptr, local_n);
         }
+
+        /* *local_A_ptr points to the merged keys; the old array becomes the spare buffer */
+        int *tmp = *local_A_ptr;
+        *local_A_ptr = *buffer_ptr;
+        *buffer_ptr = tmp;
     }
     /* if partner < 0 (MPI_PROC_NULL), do nothing (idle in this phase) */
 }
@@ -344,9 +359,12 @@ void Odd_even_iter(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
  *  - buffer: output array (must have size local_n)
  *  - merges the smallest local_n elements of (A U recv_keys) into buffer
  *
- * Note: does NOT swap pointers; Sort will swap afterwards.
+ * Note: does NOT swap pointers; Odd_even_iter swaps afterwards.
  */
 void Merge_low(int *A, int recv_keys[], int buffer[], int local_n) {
+#ifdef _OPENMP
+    Mpath_merge(A, recv_keys, local_n, buffer, 0, local_n);
+#else
     int m_i = 0, r_i = 0, t_i = 0;
 
     while (t_i < local_n) {
@@ -356,6 +374,7 @@ void Merge_low(int *A, int recv_keys[], int buffer[], int local_n) {
             buffer[t_i++] = recv_keys[r_i++];
         }
     }
+#endif
 }
 
 /*
@@ -363,6 +382,9 @@ void Merge_low(int *A, int recv_keys[], int buffer[], int local_n) {
  *  - merges the largest local_n elements of (A U recv_keys) into buffer
  */
 void Merge_high(int *A, int recv_keys[], int buffer[], int local_n) {
+#ifdef _OPENMP
+    Mpath_merge(A, recv_keys, local_n, buffer, local_n, local_n);
+#else
     int ai = local_n - 1;
     int bi = local_n - 1;
     int ci = local_n - 1;
@@ -374,6 +396,7 @@ void Merge_high(int *A, int recv_keys[], int buffer[], int local_n) {
             buffer[ci--] = recv_keys[bi--];
         }
     }
+#endif
 }
 
 /* ----------------- Compare function ----------------- */
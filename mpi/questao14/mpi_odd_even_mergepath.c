@@ -0,0 +1,351 @@
+/*
+ * File:     mpi_odd_even_mergepath.c
+ * Purpose:  Parallel odd-even sort whose Merge_low/Merge_high run on an
+ *           OpenMP thread team using merge path: the output range is
+ *           cut into equal diagonals, a binary search finds where each
+ *           diagonal crosses the two input lists, and every thread
+ *           merges its own diagonal with a branchless inner loop.
+ *
+ * Compile:  mpicc -O2 -Wall -fopenmp -o mpi_odd_even_mergepath mpi_odd_even_mergepath.c -lm
+ * Run:
+ *    OMP_NUM_THREADS=<t> mpiexec -n <p> mpi_odd_even_mergepath <g|i> <global_n> [s|c]
+ *
+ * Notes:
+ * 1. global_n must be evenly divisible by p
+ * 2. s (default): merge into the spare buffer and swap pointers, as
+ *    in mpi_odd_even.c; c: merge into temp and memcpy back, as in
+ *    ../questoes12E13/mpi_odd_even_time.c
+ * 3. The merge itself is Mpath_merge from ../include/mergepath.h,
+ *    also used by mpi_odd_even.c and mpi_odd_even_time.c under -fopenmp
+ * 4. Reports the time spent merging and the merge throughput per
+ *    thread, so runs with different OMP_NUM_THREADS can be compared
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+#define MPATH_MIN 0   /* always the whole team: this is what is measured */
+#include "../include/mergepath.h"
+#include <omp.h>
+
+#define REPS 5   /* Number of repetitions for timing */
+const int RMAX = 100;
+
+/* ----------------- Prototypes ----------------- */
+void Usage(char* program);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n);
+void Read_list(int local_A[], int local_n, int my_rank, int p, MPI_Comm comm);
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, char* mode_p, int my_rank, int p, MPI_Comm comm);
+int  Compare(const void* a_p, const void* b_p);
+
+void Sort(int **local_A_ptr, int local_n, char mode, int my_rank, int p,
+         MPI_Comm comm, double* merge_time_p, long long* merged_p);
+void Odd_even_iter(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
+         int local_n, int phase, int even_partner, int odd_partner,
+         char mode, int my_rank, MPI_Comm comm, double* merge_time_p,
+         long long* merged_p);
+void Merge_low(int *A, int recv_keys[], int buffer[], int local_n);
+void Merge_high(int *A, int recv_keys[], int buffer[], int local_n);
+
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm);
+
+/* ----------------- main ----------------- */
+int main(int argc, char* argv[]) {
+
+    int my_rank, p, provided;
+    char g_i, mode;
+    int *local_A;
+    int global_n, local_n;
+    int n_threads = omp_get_max_threads();
+    MPI_Comm comm;
+    double best = 0.0, best_merge = 0.0;
+    long long merged = 0;
+    int ok = 1;
+
+    /* only the main thread calls MPI */
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    comm = MPI_COMM_WORLD;
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    Get_args(argc, argv, &global_n, &local_n, &g_i, &mode, my_rank, p, comm);
+
+    local_A = (int*) malloc(local_n * sizeof(int));
+    if (local_A == NULL) {
+        fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+        MPI_Abort(comm, 1);
+    }
+
+    for (int rep = 0; rep < REPS; rep++) {
+        double merge_time, elapsed, max_elapsed, max_merge;
+
+        if (g_i == 'g')
+            Generate_list(local_A, local_n, my_rank, global_n);
+        else
+            Read_list(local_A, local_n, my_rank, p, comm);
+
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+
+        /* Pass pointer-to-pointer so Sort can swap the array pointer */
+        Sort(&local_A, local_n, mode, my_rank, p, comm, &merge_time, &merged);
+
+        elapsed = MPI_Wtime() - start;
+        MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(&merge_time, &max_merge, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        if (rep == 0 || max_elapsed < best) {
+            best = max_elapsed;
+            best_merge = max_merge;
+        }
+        ok &= Check_sorted(local_A, local_n, my_rank, p, comm);
+    }
+
+    if (my_rank == 0) {
+        printf("p = %d, threads/proc = %d, global_n = %d, mode = %s\n",
+               p, n_threads, global_n,
+               mode == 's' ? "pointer swap" : "memcpy back");
+        printf("Tempo de execução (mínimo de %d): %e segundos\n", REPS, best);
+        printf("Tempo de merge (proc mais lento): %e segundos\n", best_merge);
+        if (best_merge > 0.0) {
+            printf("Merge throughput: %.3e chaves/s por proc, "
+                   "%.3e chaves/s por thread\n",
+                   merged / best_merge, merged / best_merge / n_threads);
+        }
+        printf("Resultado: %s\n", ok ? "ordenado" : "NÃO ORDENADO");
+    }
+
+    free(local_A);
+
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+/* ----------------- Utility functions ----------------- */
+
+/* this process' block of the global list (keygen.h, uniform in
+   [0, RMAX), the same for every p) */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, 'u', RMAX, KEYGEN_SEED);
+}
+
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n> [s|c]\n", program);
+   fprintf(stderr, "   - p: the number of processes \n");
+   fprintf(stderr, "   - g: generate random, distributed list\n");
+   fprintf(stderr, "   - i: user will input list on process 0\n");
+   fprintf(stderr, "   - global_n: number of elements in global list");
+   fprintf(stderr, " (must be evenly divisible by p)\n");
+   fprintf(stderr, "   - s: merge into spare buffer and swap (default)\n");
+   fprintf(stderr, "   - c: merge into temp buffer and copy back\n");
+   fprintf(stderr, "   Threads per process come from OMP_NUM_THREADS\n");
+   fflush(stderr);
+}  /* Usage */
+
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, char* mode_p, int my_rank, int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 3 && argc != 4) {
+         Usage(argv[0]);
+         *global_n_p = -1;  /* Bad args, quit */
+      } else {
+         *gi_p = argv[1][0];
+         *mode_p = (argc == 4) ? argv[3][0] : 's';
+         if ((*gi_p != 'g' && *gi_p != 'i') ||
+             (*mode_p != 's' && *mode_p != 'c')) {
+            Usage(argv[0]);
+            *global_n_p = -1;  /* Bad args, quit */
+         } else {
+            *global_n_p = atoi(argv[2]);
+            if (*global_n_p % p != 0) {
+               Usage(argv[0]);
+               *global_n_p = -1;
+            }
+         }
+      }
+   }  /* my_rank == 0 */
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(mode_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p / p;
+}  /* Get_args */
+
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+   int i;
+   int *temp = NULL;
+
+   if (my_rank == 0) {
+      temp = (int*) malloc(p * local_n * sizeof(int));
+      if (temp == NULL) {
+         fprintf(stderr, "Proc 0: malloc failed in Read_list\n");
+         MPI_Abort(comm, 1);
+      }
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (i = 0; i < p * local_n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatter(temp, local_n, MPI_INT, local_A, local_n, MPI_INT,
+       0, comm);
+
+   if (my_rank == 0)
+      free(temp);
+}  /* Read_list */
+
+/*
+ * Check_sorted:
+ *  - each process checks its own list and the first key of its right
+ *    neighbour; returns 1 on every process if the global list is sorted
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+   int local_ok = 1, ok;
+   int next_first = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p - 1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   MPI_Sendrecv(&local_A[0], 1, MPI_INT, left, 1,
+                &next_first, 1, MPI_INT, right, 1, comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL && local_A[local_n-1] > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}  /* Check_sorted */
+
+/* ----------------- Sort / Odd-even with merge path ----------------- */
+
+/*
+ * Sort:
+ *  - same buffer handling as mpi_odd_even.c: recv_buf receives the
+ *    partner's keys, buffer receives the merge
+ *  - mode 's': swap *local_A_ptr and buffer after each merge
+ *  - mode 'c': copy buffer back into *local_A_ptr after each merge
+ *  - *merge_time_p / *merged_p accumulate time in Merge_low/Merge_high
+ *    and the number of keys they produced
+ */
+void Sort(int **local_A_ptr, int local_n, char mode, int my_rank, int p,
+         MPI_Comm comm, double* merge_time_p, long long* merged_p) {
+
+    int phase;
+    int even_partner, odd_partner;
+    int *recv_buf = NULL;
+    int *buffer = NULL;
+
+    recv_buf = (int*) malloc(local_n * sizeof(int));
+    buffer   = (int*) malloc(local_n * sizeof(int));
+    if (recv_buf == NULL || buffer == NULL) {
+        fprintf(stderr, "Proc %d: malloc failed in Sort\n", my_rank);
+        MPI_Abort(comm, 1);
+    }
+
+    /* Find partners */
+    if (my_rank % 2 != 0) {
+        even_partner = my_rank - 1;
+        odd_partner  = my_rank + 1;
+        if (odd_partner == p) odd_partner = MPI_PROC_NULL;
+    } else {
+        even_partner = my_rank + 1;
+        if (even_partner == p) even_partner = MPI_PROC_NULL;
+        odd_partner  = my_rank - 1;
+    }
+
+    qsort(*local_A_ptr, local_n, sizeof(int), Compare);
+
+    *merge_time_p = 0.0;
+    *merged_p = 0;
+    for (phase = 0; phase < p; phase++) {
+        Odd_even_iter(local_A_ptr, &buffer, recv_buf, local_n, phase,
+                      even_partner, odd_partner, mode, my_rank, comm,
+                      merge_time_p, merged_p);
+    }
+
+    free(recv_buf);
+
+    /* buffer is the spare array; main's pointer has been moved to the
+       one holding the result, so the spare one is freed here even when
+       it is the array main allocated (repetitions reuse local_A). */
+    free(buffer);
+}
+
+/*
+ * Odd_even_iter:
+ *  - exchange with the partner of this phase, merge into *buffer_ptr
+ *  - the lower rank of the pair keeps the small half (Merge_low)
+ *  - in mode 's' the merged buffer becomes *local_A_ptr; idle
+ *    processes (partner == MPI_PROC_NULL) swap nothing
+ */
+void Odd_even_iter(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
+         int local_n, int phase, int even_partner, int odd_partner,
+         char mode, int my_rank, MPI_Comm comm, double* merge_time_p,
+         long long* merged_p) {
+
+    MPI_Status status;
+    int partner = (phase % 2 == 0 ? even_partner : odd_partner);
+
+    if (partner >= 0 && partner != MPI_PROC_NULL) {
+
+        MPI_Sendrecv(*local_A_ptr, local_n, MPI_INT, partner, 0,
+                     recv_buf, local_n, MPI_INT, partner, 0, comm, &status);
+
+        double start = MPI_Wtime();
+        if (my_rank < partner)
+            Merge_low(*local_A_ptr, recv_buf, *buffer_ptr, local_n);
+        else
+            Merge_high(*local_A_ptr, recv_buf, *buffer_ptr, local_n);
+        *merge_time_p += MPI_Wtime() - start;
+        *merged_p += local_n;
+
+        if (mode == 's') {
+            int *tmp = *local_A_ptr;
+            *local_A_ptr = *buffer_ptr;
+            *buffer_ptr = tmp;
+        } else {
+            memcpy(*local_A_ptr, *buffer_ptr, local_n * sizeof(int));
+        }
+    }
+}
+
+/*
+ * Merge_low:
+ *  - buffer receives the smallest local_n keys of (A U recv_keys),
+ *    i.e. output positions [0, local_n) of the full merge
+ */
+void Merge_low(int *A, int recv_keys[], int buffer[], int local_n) {
+    Mpath_merge(A, recv_keys, local_n, buffer, 0, local_n);
+}
+
+/*
+ * Merge_high:
+ *  - buffer receives the largest local_n keys of (A U recv_keys),
+ *    i.e. output positions [local_n, 2*local_n) of the full merge
+ */
+void Merge_high(int *A, int recv_keys[], int buffer[], int local_n) {
+    Mpath_merge(A, recv_keys, local_n, buffer, local_n, local_n);
+}
+
+/* ----------------- Compare function ----------------- */
+int Compare(const void* a_p, const void* b_p) {
+    int a = *((int*)a_p);
+    int b = *((int*)b_p);
+    return (a > b) - (a < b);
+}
@@ -0,0 +1,374 @@
+/*
+ * File:     mpi_odd_even_rma.c
+ * Purpose:  Parallel odd-even sort (pointer-swapping merge) with a
+ *           one-sided exchange: every process exposes its receive
+ *           buffer in an MPI window and, in each phase, MPI_Puts its
+ *           keys straight into the partner's window.  The phase is
+ *           synchronized with PSCW (MPI_Win_post/start/complete/wait)
+ *           restricted to the partner, so no process waits for any
+ *           other.  Each repetition also runs the two-sided version
+ *           (MPI_Sendrecv, as in mpi_odd_even.c) on the same input.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_rma mpi_odd_even_rma.c -lm
+ * Run:
+ *    mpiexec -n <p> mpi_odd_even_rma <g|i> <global_n>
+ *
+ * Notes:
+ * 1. global_n must be evenly divisible by p
+ * 2. Buffers, window and partner groups are created once, before
+ *    the timed repetitions, for both versions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+
+#define REPS 5   /* Number of repetitions for timing */
+const int RMAX = 100;
+
+/* ----------------- Prototypes ----------------- */
+void Usage(char* program);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n);
+void Read_list(int local_A[], int local_n, int my_rank, int p, MPI_Comm comm);
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, int my_rank, int p, MPI_Comm comm);
+int  Compare(const void* a_p, const void* b_p);
+void Find_partners(int my_rank, int p, int partner[]);
+
+void Sort_sendrecv(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
+         int local_n, int partner[], int my_rank, int p, MPI_Comm comm);
+void Sort_rma(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
+         int local_n, int partner[], MPI_Group partner_group[],
+         MPI_Win win, int my_rank, int p);
+void Merge_low(int *A, int recv_keys[], int buffer[], int local_n);
+void Merge_high(int *A, int recv_keys[], int buffer[], int local_n);
+
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm);
+
+/* ----------------- main ----------------- */
+int main(int argc, char* argv[]) {
+
+    int my_rank, p;
+    char g_i;
+    int *local_A, *buffer, *input, *recv_buf;
+    int global_n, local_n;
+    int partner[2];
+    MPI_Group world_group, partner_group[2];
+    MPI_Win win;
+    MPI_Comm comm;
+    double best_sr = 0.0, best_rma = 0.0;
+    int ok = 1;
+
+    MPI_Init(&argc, &argv);
+    comm = MPI_COMM_WORLD;
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    Get_args(argc, argv, &global_n, &local_n, &g_i, my_rank, p, comm);
+
+    local_A = (int*) malloc(local_n * sizeof(int));
+    buffer  = (int*) malloc(local_n * sizeof(int));
+    input   = (int*) malloc(local_n * sizeof(int));
+    if (local_A == NULL || buffer == NULL || input == NULL) {
+        fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+        MPI_Abort(comm, 1);
+    }
+
+    /* recv_buf is the window: partners MPI_Put their keys into it */
+    MPI_Win_allocate((MPI_Aint) local_n * sizeof(int), sizeof(int),
+                     MPI_INFO_NULL, comm, &recv_buf, &win);
+
+    /* one-process groups for the even and odd partners */
+    Find_partners(my_rank, p, partner);
+    MPI_Comm_group(comm, &world_group);
+    for (int k = 0; k < 2; k++) {
+        if (partner[k] != MPI_PROC_NULL)
+            MPI_Group_incl(world_group, 1, &partner[k], &partner_group[k]);
+        else
+            partner_group[k] = MPI_GROUP_NULL;
+    }
+
+    for (int rep = 0; rep < REPS; rep++) {
+        double elapsed, max_elapsed;
+
+        if (g_i == 'g')
+            Generate_list(input, local_n, my_rank, global_n);
+        else
+            Read_list(input, local_n, my_rank, p, comm);
+
+        /* Two-sided exchange (reference) */
+        memcpy(local_A, input, local_n * sizeof(int));
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        Sort_sendrecv(&local_A, &buffer, recv_buf, local_n, partner,
+                      my_rank, p, comm);
+        elapsed = MPI_Wtime() - start;
+        MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        if (rep == 0 || max_elapsed < best_sr) best_sr = max_elapsed;
+        ok &= Check_sorted(local_A, local_n, my_rank, p, comm);
+
+        /* One-sided exchange on the same input */
+        memcpy(local_A, input, local_n * sizeof(int));
+        MPI_Barrier(comm);
+        start = MPI_Wtime();
+        Sort_rma(&local_A, &buffer, recv_buf, local_n, partner,
+                 partner_group, win, my_rank, p);
+        elapsed = MPI_Wtime() - start;
+        MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        if (rep == 0 || max_elapsed < best_rma) best_rma = max_elapsed;
+        ok &= Check_sorted(local_A, local_n, my_rank, p, comm);
+    }
+
+    if (my_rank == 0) {
+        printf("p = %d, global_n = %d\n", p, global_n);
+        printf("Tempo MPI_Sendrecv (mínimo de %d): %e segundos\n",
+               REPS, best_sr);
+        printf("Tempo MPI_Put+PSCW (mínimo de %d): %e segundos\n",
+               REPS, best_rma);
+        printf("Resultado: %s\n", ok ? "ordenado" : "NÃO ORDENADO");
+    }
+
+    for (int k = 0; k < 2; k++)
+        if (partner_group[k] != MPI_GROUP_NULL)
+            MPI_Group_free(&partner_group[k]);
+    MPI_Group_free(&world_group);
+    MPI_Win_free(&win);
+    free(local_A);
+    free(buffer);
+    free(input);
+
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+/* ----------------- Utility functions ----------------- */
+
+/* this process' block of the global list (keygen.h, uniform in
+   [0, RMAX), the same for every p) */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, 'u', RMAX, KEYGEN_SEED);
+}
+
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n>\n", program);
+   fprintf(stderr, "   - p: the number of processes \n");
+   fprintf(stderr, "   - g: generate random, distributed list\n");
+   fprintf(stderr, "   - i: user will input list on process 0\n");
+   fprintf(stderr, "   - global_n: number of elements in global list");
+   fprintf(stderr, " (must be evenly divisible by p)\n");
+   fflush(stderr);
+}  /* Usage */
+
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, int my_rank, int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 3) {
+         Usage(argv[0]);
+         *global_n_p = -1;  /* Bad args, quit */
+      } else {
+         *gi_p = argv[1][0];
+         if (*gi_p != 'g' && *gi_p != 'i') {
+            Usage(argv[0]);
+            *global_n_p = -1;  /* Bad args, quit */
+         } else {
+            *global_n_p = atoi(argv[2]);
+            if (*global_n_p % p != 0) {
+               Usage(argv[0]);
+               *global_n_p = -1;
+            }
+         }
+      }
+   }  /* my_rank == 0 */
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p / p;
+}  /* Get_args */
+
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+   int i;
+   int *temp = NULL;
+
+   if (my_rank == 0) {
+      temp = (int*) malloc(p * local_n * sizeof(int));
+      if (temp == NULL) {
+         fprintf(stderr, "Proc 0: malloc failed in Read_list\n");
+         MPI_Abort(comm, 1);
+      }
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (i = 0; i < p * local_n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatter(temp, local_n, MPI_INT, local_A, local_n, MPI_INT,
+       0, comm);
+
+   if (my_rank == 0)
+      free(temp);
+}  /* Read_list */
+
+/*
+ * Find_partners:
+ *  - partner[0]: even phases, partner[1]: odd phases
+ *  - MPI_PROC_NULL for the processes at the ends that sit out a phase
+ */
+void Find_partners(int my_rank, int p, int partner[]) {
+    if (my_rank % 2 != 0) {
+        partner[0] = my_rank - 1;
+        partner[1] = my_rank + 1;
+        if (partner[1] == p) partner[1] = MPI_PROC_NULL;
+    } else {
+        partner[0] = my_rank + 1;
+        if (partner[0] == p) partner[0] = MPI_PROC_NULL;
+        partner[1] = my_rank - 1;
+        if (partner[1] < 0) partner[1] = MPI_PROC_NULL;
+    }
+}  /* Find_partners */
+
+/*
+ * Check_sorted:
+ *  - each process checks its own list and the first key of its right
+ *    neighbour; returns 1 on every process if the global list is sorted
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+   int local_ok = 1, ok;
+   int next_first = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p - 1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   MPI_Sendrecv(&local_A[0], 1, MPI_INT, left, 1,
+                &next_first, 1, MPI_INT, right, 1, comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL && local_A[local_n-1] > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}  /* Check_sorted */
+
+/* ----------------- Sort: two-sided and one-sided exchange ----------------- */
+
+/*
+ * Sort_sendrecv:
+ *  - same algorithm as mpi_odd_even.c: MPI_Sendrecv into recv_buf,
+ *    merge into *buffer_ptr, swap it with *local_A_ptr
+ */
+void Sort_sendrecv(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
+         int local_n, int partner[], int my_rank, int p, MPI_Comm comm) {
+
+    qsort(*local_A_ptr, local_n, sizeof(int), Compare);
+
+    for (int phase = 0; phase < p; phase++) {
+        int q = partner[phase % 2];
+        if (q == MPI_PROC_NULL) continue;
+
+        MPI_Sendrecv(*local_A_ptr, local_n, MPI_INT, q, 0,
+                     recv_buf, local_n, MPI_INT, q, 0, comm,
+                     MPI_STATUS_IGNORE);
+
+        if (my_rank < q)
+            Merge_low(*local_A_ptr, recv_buf, *buffer_ptr, local_n);
+        else
+            Merge_high(*local_A_ptr, recv_buf, *buffer_ptr, local_n);
+
+        int *tmp = *local_A_ptr;
+        *local_A_ptr = *buffer_ptr;
+        *buffer_ptr = tmp;
+    }
+}
+
+/*
+ * Sort_rma:
+ *  - recv_buf is this process' window memory
+ *  - per phase: post exposes recv_buf to the partner, start/complete
+ *    bracket the MPI_Put of our keys into the partner's window, and
+ *    wait returns once the partner's keys are in recv_buf
+ *  - the next post comes after the merge, so the next partner can not
+ *    overwrite recv_buf while it is still being read
+ */
+void Sort_rma(int **local_A_ptr, int **buffer_ptr, int recv_buf[],
+         int local_n, int partner[], MPI_Group partner_group[],
+         MPI_Win win, int my_rank, int p) {
+
+    qsort(*local_A_ptr, local_n, sizeof(int), Compare);
+
+    for (int phase = 0; phase < p; phase++) {
+        int q = partner[phase % 2];
+        if (q == MPI_PROC_NULL) continue;
+
+        MPI_Win_post(partner_group[phase % 2], 0, win);
+        MPI_Win_start(partner_group[phase % 2], 0, win);
+        MPI_Put(*local_A_ptr, local_n, MPI_INT, q, 0, local_n, MPI_INT,
+                win);
+        MPI_Win_complete(win);
+        MPI_Win_wait(win);
+
+        if (my_rank < q)
+            Merge_low(*local_A_ptr, recv_buf, *buffer_ptr, local_n);
+        else
+            Merge_high(*local_A_ptr, recv_buf, *buffer_ptr, local_n);
+
+        int *tmp = *local_A_ptr;
+        *local_A_ptr = *buffer_ptr;
+        *buffer_ptr = tmp;
+    }
+}
+
+/*
+ * Merge_low:
+ *  - merges the smallest local_n elements of (A U recv_keys) into buffer
+ */
+void Merge_low(int *A, int recv_keys[], int buffer[], int local_n) {
+    int m_i = 0, r_i = 0, t_i = 0;
+
+    while (t_i < local_n) {
+        if (A[m_i] <= recv_keys[r_i]) {
+            buffer[t_i++] = A[m_i++];
+        } else {
+            buffer[t_i++] = recv_keys[r_i++];
+        }
+    }
+}
+
+/*
+ * Merge_high:
+ *  - merges the largest local_n elements of (A U recv_keys) into buffer
+ */
+void Merge_high(int *A, int recv_keys[], int buffer[], int local_n) {
+    int ai = local_n - 1;
+    int bi = local_n - 1;
+    int ci = local_n - 1;
+
+    while (ci >= 0) {
+        if (A[ai] >= recv_keys[bi]) {
+            buffer[ci--] = A[ai--];
+        } else {
+            buffer[ci--] = recv_keys[bi--];
+        }
+    }
+}
+
+/* ----------------- Compare function ----------------- */
+int Compare(const void* a_p, const void* b_p) {
+    int a = *((int*)a_p);
+    int b = *((int*)b_p);
+    return (a > b) - (a < b);
+}
@@ -2,16 +2,21 @@
 #include <stdlib.h>
 #include <math.h>
 #include <mpi.h>
+#include "../include/blas1.h"
+#include "../include/dvec_stream.h"
 
 int main(int argc, char* argv[]) {
     int my_rank, comm_sz;
     int n, local_n;
     double escalar;
 
-    double *v1 = NULL, *v2 = NULL;
-    double *local_v1, *local_v2;
     double local_sum = 0.0, global_sum = 0.0;
 
+    Dvec_layout lay;
+    Dvec local_v1, local_v2;
+    Fio_in* in = NULL;
+    Dvec_io_stats st1, st2, st_out;
+
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &comm_sz);
@@ -26,72 +31,66 @@ int main(int argc, char* argv[]) {
         fflush(stdout);
         scanf("%lf", &escalar);
 
-        v1 = malloc(n * sizeof(double));
-        v2 = malloc(n * sizeof(double));
-
-        printf("Digite os elementos do vetor 1:\n");
-        for (int i = 0; i < n; i++){
-            fflush(stdout);
-            scanf("%lf", &v1[i]);
-            }
-
-        printf("Digite os elementos do vetor 2:\n");
-        for (int i = 0; i < n; i++){
-            fflush(stdout);
-            scanf("%lf", &v2[i]);
-        }
+        /* os vetores são lidos em pedaços pelo leitor em blocos */
+        in = Fio_open(stdin);
     }
 
     /* Distribuir n e escalar */
     MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&escalar, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
-    local_n = n / comm_sz;
+    /* Blocos de n / comm_sz elementos (com n divisível por comm_sz,
+       a mesma divisão do MPI_Scatter) */
+    Dvec_layout_init(&lay, n, DVEC_BLOCK, 0, MPI_COMM_WORLD);
+    local_n = lay.local_n;
 
     /* Alocar vetores locais */
-    local_v1 = malloc(local_n * sizeof(double));
-    local_v2 = malloc(local_n * sizeof(double));
-
-    /* Distribuir vetores */
-    MPI_Scatter(v1, local_n, MPI_DOUBLE,
-                local_v1, local_n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    Dvec_create(&local_v1, &lay);
+    Dvec_create(&local_v2, &lay);
 
-    MPI_Scatter(v2, local_n, MPI_DOUBLE,
-                local_v2, local_n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-
-    /* Multiplicar vetor 1 pelo escalar */
-    for (int i = 0; i < local_n; i++)
-        local_v1[i] *= escalar;
+    /* Ler e distribuir os vetores: o processo 0 converte um pedaço
+       enquanto o anterior é enviado */
+    if (my_rank == 0) {
+        printf("Digite os elementos do vetor 1:\n");
+        fflush(stdout);
+    }
+    Dvec_stream_read(&local_v1, in, 0, &st1);
+    if (my_rank == 0) {
+        printf("Digite os elementos do vetor 2:\n");
+        fflush(stdout);
+    }
+    Dvec_stream_read(&local_v2, in, 0, &st2);
 
-    /* Calcular soma parcial dos quadrados do vetor 2 */
-    for (int i = 0; i < local_n; i++)
-        local_sum += local_v2[i] * local_v2[i];
+    /* Multiplicar vetor 1 pelo escalar e somar os quadrados do vetor 2
+       numa única passada pelos dois blocos */
+    local_sum = Blas1_scal_sumsq(local_n, escalar, local_v1.local,
+                                 local_v2.local);
 
     /* Redução para calcular norma */
     MPI_Reduce(&local_sum, &global_sum, 1, MPI_DOUBLE,
                MPI_SUM, 0, MPI_COMM_WORLD);
 
-    /* Coletar vetor 1 modificado */
-    MPI_Gather(local_v1, local_n, MPI_DOUBLE,
-               v1, local_n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-
-    /* Processo 0 imprime resultados */
+    /* Coletar e imprimir vetor 1 modificado, em pedaços */
     if (my_rank == 0) {
         printf("\nVetor 1 após multiplicação pelo escalar:\n");
-        for (int i = 0; i < n; i++)
-            printf("%.2f ", v1[i]);
-        printf("\n");
+        fflush(stdout);
+    }
+    Dvec_stream_write(&local_v1, stdout, 2, 0, &st_out);
 
+    /* Processo 0 imprime resultados */
+    if (my_rank == 0) {
         printf("\nNorma do vetor 2: %.6f\n", sqrt(global_sum));
+
+        Dvec_print_rate("Leitura do vetor 1", &st1);
+        Dvec_print_rate("Leitura do vetor 2", &st2);
+        Dvec_print_rate("Escrita do vetor 1", &st_out);
+        Fio_close(in);
     }
 
     /* Liberar memória */
-    free(local_v1);
-    free(local_v2);
-    if (my_rank == 0) {
-        free(v1);
-        free(v2);
-    }
+    Dvec_free(&local_v1);
+    Dvec_free(&local_v2);
+    Dvec_layout_free(&lay);
 
     MPI_Finalize();
     return 0;
@@ -0,0 +1,219 @@
+/*
+ * Ring e butterfly allreduce, versões de dois lados (MPI_Sendrecv, como
+ * em mpi_allreduce_compare.c) e de um lado (MPI_Put com sincronização
+ * PSCW: MPI_Win_post/start/complete/wait), medidas lado a lado.
+ *
+ * Compilar:  mpicc -O2 -Wall -o mpi_allreduce_rma mpi_allreduce_rma.c
+ * Executar:  mpirun -np <p> ./mpi_allreduce_rma
+ *
+ * - O butterfly exige comm_sz potência de 2 (senão é pulado).
+ * - Os buffers de recepção são a memória da janela (MPI_Win_allocate),
+ *   então as versões de dois lados usam os mesmos buffers e o consumo
+ *   de memória é o mesmo de mpi_allreduce_compare.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+#ifndef MSG_SIZE
+#define MSG_SIZE 100000000
+#endif
+
+int Check(int my_array[], int expected);
+MPI_Group Group_of(MPI_Group world_group, int rank);
+
+int main() {
+    int my_rank, comm_sz;
+    MPI_Status status;
+    MPI_Group world_group, dest_group, source_group;
+    MPI_Group partner_group[32];
+    MPI_Win win;
+    int *win_buf;
+
+    MPI_Init(NULL, NULL);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &comm_sz);
+    MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+
+    int *my_array = malloc(MSG_SIZE * sizeof(int));
+
+    /* janela com dois blocos de MSG_SIZE ints: [0] e [1] */
+    MPI_Win_allocate(2 * (MPI_Aint) MSG_SIZE * sizeof(int), sizeof(int),
+                     MPI_INFO_NULL, MPI_COMM_WORLD, &win_buf, &win);
+    int *temp_array = win_buf;
+    int *recv_array = win_buf + MSG_SIZE;
+
+    int dest = (my_rank + 1) % comm_sz;
+    int source = (my_rank - 1 + comm_sz) % comm_sz;
+    dest_group = Group_of(world_group, dest);
+    source_group = Group_of(world_group, source);
+
+    /*                RING ALLREDUCE (Sendrecv)               */
+    for (int i = 0; i < MSG_SIZE; i++)
+        my_array[i] = 1;
+    for (int i = 0; i < MSG_SIZE; i++)
+        temp_array[i] = my_array[i];
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    for (int step = 1; step < comm_sz; step++) {
+
+        MPI_Sendrecv_replace(temp_array, MSG_SIZE, MPI_INT,
+                             dest, 0,
+                             source, 0,
+                             MPI_COMM_WORLD, &status);
+
+        // acumular soma
+        for (int i = 0; i < MSG_SIZE; i++)
+            my_array[i] += temp_array[i];
+    }
+
+    double local_time = MPI_Wtime() - start;
+    int ring_ok = Check(my_array, comm_sz);
+
+    double ring_time;
+    MPI_Reduce(&local_time, &ring_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    /*                RING ALLREDUCE (Put + PSCW)             */
+    /* passo s: recebe no bloco s%2 e envia o bloco (s-1)%2, que
+       chegou no passo anterior; o vizinho só escreve no bloco depois
+       do nosso MPI_Win_post, então não há sobrescrita antes da soma */
+    for (int i = 0; i < MSG_SIZE; i++)
+        my_array[i] = 1;
+    for (int i = 0; i < MSG_SIZE; i++)
+        win_buf[i] = my_array[i];
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+
+    for (int step = 1; step < comm_sz; step++) {
+        int *send_blk = win_buf + ((step - 1) % 2) * (MPI_Aint) MSG_SIZE;
+        int *recv_blk = win_buf + (step % 2) * (MPI_Aint) MSG_SIZE;
+
+        MPI_Win_post(source_group, 0, win);
+        MPI_Win_start(dest_group, 0, win);
+        MPI_Put(send_blk, MSG_SIZE, MPI_INT, dest,
+                (step % 2) * (MPI_Aint) MSG_SIZE, MSG_SIZE, MPI_INT, win);
+        MPI_Win_complete(win);
+        MPI_Win_wait(win);
+
+        // acumular soma
+        for (int i = 0; i < MSG_SIZE; i++)
+            my_array[i] += recv_blk[i];
+    }
+
+    local_time = MPI_Wtime() - start;
+    int ring_rma_ok = Check(my_array, comm_sz);
+
+    double ring_rma_time;
+    MPI_Reduce(&local_time, &ring_rma_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    int steps = 0;
+    while ((1 << steps) < comm_sz) steps++;
+    int pow2 = ((1 << steps) == comm_sz);
+    double butterfly_time = 0.0, butterfly_rma_time = 0.0;
+    int butterfly_ok = 1, butterfly_rma_ok = 1;
+
+    if (pow2) {
+        /*                BUTTERFLY ALLREDUCE (Sendrecv)          */
+        for (int i = 0; i < MSG_SIZE; i++)
+            my_array[i] = 1;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        start = MPI_Wtime();
+
+        for (int i = 0; i < steps; i++) {
+            int partner = my_rank ^ (1 << i);
+
+            MPI_Sendrecv(my_array, MSG_SIZE, MPI_INT,
+                         partner, 0,
+                         recv_array, MSG_SIZE, MPI_INT,
+                         partner, 0,
+                         MPI_COMM_WORLD, &status);
+
+            // soma a parte recebida
+            for (int j = 0; j < MSG_SIZE; j++)
+                my_array[j] += recv_array[j];
+        }
+
+        local_time = MPI_Wtime() - start;
+        butterfly_ok = Check(my_array, comm_sz);
+        MPI_Reduce(&local_time, &butterfly_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+        /*                BUTTERFLY ALLREDUCE (Put + PSCW)        */
+        /* o parceiro escreve my_array dele em recv_array (bloco 1);
+           my_array só muda depois do MPI_Win_complete */
+        for (int i = 0; i < MSG_SIZE; i++)
+            my_array[i] = 1;
+        for (int i = 0; i < steps; i++)
+            partner_group[i] = Group_of(world_group, my_rank ^ (1 << i));
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        start = MPI_Wtime();
+
+        for (int i = 0; i < steps; i++) {
+            int partner = my_rank ^ (1 << i);
+
+            MPI_Win_post(partner_group[i], 0, win);
+            MPI_Win_start(partner_group[i], 0, win);
+            MPI_Put(my_array, MSG_SIZE, MPI_INT, partner,
+                    MSG_SIZE, MSG_SIZE, MPI_INT, win);
+            MPI_Win_complete(win);
+            MPI_Win_wait(win);
+
+            // soma a parte recebida
+            for (int j = 0; j < MSG_SIZE; j++)
+                my_array[j] += recv_array[j];
+        }
+
+        local_time = MPI_Wtime() - start;
+        butterfly_rma_ok = Check(my_array, comm_sz);
+        for (int i = 0; i < steps; i++)
+            MPI_Group_free(&partner_group[i]);
+        MPI_Reduce(&local_time, &butterfly_rma_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    }
+
+    int ok = ring_ok && ring_rma_ok && butterfly_ok && butterfly_rma_ok;
+    int all_ok;
+    MPI_Reduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+
+    if (my_rank == 0) {
+        printf("\nTempo total (Ring, Sendrecv):      %.6f s\n", ring_time);
+        printf("Tempo total (Ring, Put+PSCW):      %.6f s\n", ring_rma_time);
+        if (pow2) {
+            printf("Tempo total (Butterfly, Sendrecv): %.6f s\n", butterfly_time);
+            printf("Tempo total (Butterfly, Put+PSCW): %.6f s\n", butterfly_rma_time);
+        } else {
+            printf("Butterfly pulado: comm_sz não é potência de 2\n");
+        }
+        printf("Resultado: %s\n", all_ok ? "correto" : "INCORRETO");
+
+        printf("\n(msg = %d)\n", MSG_SIZE);
+        printf("\n(comm_sz = %d processos)\n\n", comm_sz);
+    }
+
+    MPI_Group_free(&dest_group);
+    MPI_Group_free(&source_group);
+    MPI_Group_free(&world_group);
+    MPI_Win_free(&win);
+    free(my_array);
+
+    MPI_Finalize();
+    return 0;
+}
+
+/* 1 se todas as posições valem expected */
+int Check(int my_array[], int expected) {
+    for (int i = 0; i < MSG_SIZE; i++)
+        if (my_array[i] != expected)
+            return 0;
+    return 1;
+}
+
+/* grupo com um único processo de MPI_COMM_WORLD */
+MPI_Group Group_of(MPI_Group world_group, int rank) {
+    MPI_Group group;
+    MPI_Group_incl(world_group, 1, &rank, &group);
+    return group;
+}
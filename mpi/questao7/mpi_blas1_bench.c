@@ -0,0 +1,185 @@
+/*
+ * Benchmark dos kernels de ../include/blas1.h: banda agregada (GB/s) de
+ * cada kernel e porcentagem do STREAM triad medido no mesmo job, mais
+ * duas comparações de sequências de operações:
+ *   - y = y + a*x; rho = y.y         (axpy + nrm2 x axpy_dot fundido)
+ *   - |x|, |y|, x.y                  (3 MPI_Allreduce x 1 em lote)
+ *
+ * Compilar:  mpicc -O3 -march=native -fopenmp-simd -Wall -o mpi_blas1_bench mpi_blas1_bench.c -lm
+ * Executar:  mpirun -np <p> ./mpi_blas1_bench [n_local] [stream_GBs]
+ *
+ * - n_local: doubles por processo em cada vetor (padrão 4M = 32 MB,
+ *   bem maior que a cache)
+ * - stream_GBs: banda do STREAM triad da máquina em GB/s (soma dos
+ *   processos); se omitido, usa o triad medido aqui
+ * - tempos: mínimo de REPS repetições, cada uma entre barreiras
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#include "../include/blas1.h"
+
+#define REPS 10
+#define ALIGN 64
+
+enum { TRIAD, SCAL, AXPY, WAXPBY, DOT, NRM2, AXPY_DOT, N_KERNELS };
+
+static const char* names[N_KERNELS] = {
+    "triad (STREAM)", "scal", "axpy", "waxpby", "dot", "nrm2", "axpy+dot"
+};
+/* bytes movidos por elemento (leituras + escritas de doubles) */
+static const int bytes_per_elem[N_KERNELS] = { 24, 16, 24, 24, 16, 8, 24 };
+
+double Run(int kernel, int n, double* x, double* y, double* w, MPI_Comm comm);
+double* Alloc_vec(int n, double val);
+
+int main(int argc, char* argv[]) {
+    int my_rank, comm_sz;
+    MPI_Comm comm = MPI_COMM_WORLD;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &comm_sz);
+
+    int n = (argc > 1) ? atoi(argv[1]) : 4 * 1024 * 1024;
+    double stream_gbs = (argc > 2) ? atof(argv[2]) : 0.0;
+    if (n <= 0) {
+        if (my_rank == 0)
+            fprintf(stderr, "uso: mpirun -np <p> %s [n_local] [stream_GBs]\n",
+                    argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    double *x = Alloc_vec(n, 1.0), *y = Alloc_vec(n, 2.0);
+    double *w = Alloc_vec(n, 0.5);
+    double gbs[N_KERNELS];
+
+    /* kernels isolados */
+    for (int k = 0; k < N_KERNELS; k++) {
+        double best = 1e30;
+        for (int rep = 0; rep < REPS; rep++) {
+            double t = Run(k, n, x, y, w, comm);
+            if (t < best) best = t;
+        }
+        gbs[k] = (double) bytes_per_elem[k] * n * comm_sz / best / 1e9;
+    }
+    if (stream_gbs <= 0.0) stream_gbs = gbs[TRIAD];
+
+    /* sequência 1: y = y + a*x; rho = y.y */
+    double t_sep = 1e30, t_fus = 1e30, rho_sep = 0.0, rho_fus = 0.0;
+    for (int rep = 0; rep < REPS; rep++) {
+        for (int i = 0; i < n; i++) y[i] = 2.0;
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        Blas1_axpy(n, 0.5, x, y);
+        rho_sep = Blas1_pnrm2(n, y, comm);
+        double t = MPI_Wtime() - start;
+        if (t < t_sep) t_sep = t;
+
+        for (int i = 0; i < n; i++) y[i] = 2.0;
+        MPI_Barrier(comm);
+        start = MPI_Wtime();
+        rho_fus = Blas1_axpy_dot(n, 0.5, x, y, y);
+        MPI_Allreduce(MPI_IN_PLACE, &rho_fus, 1, MPI_DOUBLE, MPI_SUM, comm);
+        rho_fus = sqrt(rho_fus);
+        t = MPI_Wtime() - start;
+        if (t < t_fus) t_fus = t;
+    }
+
+    /* sequência 2: |x|, |y|, x.y com n pequeno (domina a latência) */
+    int n_small = (n < 1024) ? n : 1024;
+    double t_3red = 1e30, t_batch = 1e30, r3[3] = {0, 0, 0};
+    Blas1_batch b;
+    for (int rep = 0; rep < REPS; rep++) {
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        for (int it = 0; it < 100; it++) {
+            r3[0] = Blas1_pnrm2(n_small, x, comm);
+            r3[1] = Blas1_pnrm2(n_small, y, comm);
+            r3[2] = Blas1_pdot(n_small, x, y, comm);
+        }
+        double t = (MPI_Wtime() - start) / 100;
+        if (t < t_3red) t_3red = t;
+
+        MPI_Barrier(comm);
+        start = MPI_Wtime();
+        for (int it = 0; it < 100; it++) {
+            Blas1_batch_init(&b);
+            Blas1_batch_add(&b, Blas1_sumsq(n_small, x));
+            Blas1_batch_add(&b, Blas1_sumsq(n_small, y));
+            Blas1_batch_add(&b, Blas1_dot(n_small, x, y));
+            Blas1_batch_allreduce(&b, comm);
+        }
+        t = (MPI_Wtime() - start) / 100;
+        if (t < t_batch) t_batch = t;
+    }
+    int batch_ok = fabs(sqrt(b.val[0]) - r3[0]) <= 1e-12 * r3[0] &&
+                   fabs(sqrt(b.val[1]) - r3[1]) <= 1e-12 * r3[1] &&
+                   fabs(b.val[2] - r3[2]) <= 1e-12 * fabs(r3[2]);
+
+    if (my_rank == 0) {
+        printf("\n(comm_sz = %d processos, n_local = %d, STREAM = %.2f GB/s%s)\n\n",
+               comm_sz, n, stream_gbs, (argc > 2) ? "" : " medido");
+        printf("%-16s %10s %10s\n", "kernel", "GB/s", "% STREAM");
+        for (int k = 0; k < N_KERNELS; k++)
+            printf("%-16s %10.2f %9.1f%%\n", names[k], gbs[k],
+                   100.0 * gbs[k] / stream_gbs);
+
+        printf("\ny = y + a*x; rho = |y|\n");
+        printf("  axpy + nrm2 (2 passadas):  %.6f s\n", t_sep);
+        printf("  axpy+dot    (1 passada):   %.6f s  (%.2fx)\n", t_fus,
+               t_sep / t_fus);
+        printf("  rho: %.10e / %.10e\n", rho_sep, rho_fus);
+
+        printf("\n|x|, |y|, x.y (n_local = %d)\n", n_small);
+        printf("  3 MPI_Allreduce:   %.3e s\n", t_3red);
+        printf("  1 em lote:         %.3e s  (%.2fx)\n", t_batch,
+               t_3red / t_batch);
+        printf("  Resultado: %s\n\n", batch_ok ? "correto" : "INCORRETO");
+    }
+
+    free(x);
+    free(y);
+    free(w);
+    MPI_Finalize();
+    return 0;
+}
+
+/* tempo de uma execução do kernel em todos os processos */
+double Run(int kernel, int n, double* x, double* y, double* w, MPI_Comm comm) {
+    volatile double sink = 0.0;
+
+    MPI_Barrier(comm);
+    double start = MPI_Wtime();
+    switch (kernel) {
+        case TRIAD:
+            for (int i = 0; i < n; i++)
+                w[i] = x[i] + 0.5 * y[i];
+            break;
+        case SCAL:     Blas1_scal(n, 1.0000001, y);                break;
+        case AXPY:     Blas1_axpy(n, 1e-9, x, y);                  break;
+        case WAXPBY:   Blas1_waxpby(n, 1.0, x, 0.5, y, w);         break;
+        case DOT:      sink = Blas1_dot(n, x, y);                  break;
+        case NRM2:     sink = Blas1_sumsq(n, x);                   break;
+        case AXPY_DOT: sink = Blas1_axpy_dot(n, 1e-9, x, y, y);    break;
+    }
+    MPI_Barrier(comm);
+    (void) sink;
+    return MPI_Wtime() - start;
+}
+
+/* vetor alinhado, já tocado (sem page faults no tempo medido) */
+double* Alloc_vec(int n, double val) {
+    void* p = NULL;
+    if (posix_memalign(&p, ALIGN, (size_t) n * sizeof(double)) != 0) {
+        fprintf(stderr, "Sem memória para %d doubles\n", n);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    double* v = p;
+    for (int i = 0; i < n; i++)
+        v[i] = val;
+    return v;
+}
@@ -2,18 +2,20 @@
 #include <stdlib.h>
 #include <math.h>
 #include <mpi.h>
+#include "../include/blas1.h"
+#include "../include/dvec_stream.h"
 
 int main(int argc, char* argv[]) {
     int my_rank, comm_sz;
     int n;
     double escalar;
 
-    double *v1 = NULL, *v2 = NULL;
-    double *local_v1, *local_v2;
     double local_sum = 0.0, global_sum = 0.0;
 
-    int *sendcounts = NULL;
-    int *displs = NULL;
+    Dvec_layout lay;
+    Dvec local_v1, local_v2;
+    Fio_in* in = NULL;
+    Dvec_io_stats st1, st2, st_out;
     int local_n;
 
     MPI_Init(&argc, &argv);
@@ -30,91 +32,65 @@ int main(int argc, char* argv[]) {
         fflush(stdout);
         scanf("%lf", &escalar);
 
-        v1 = malloc(n * sizeof(double));
-        v2 = malloc(n * sizeof(double));
-
-        printf("Digite os elementos do vetor 1:\n");
-        for (int i = 0; i < n; i++){
-            fflush(stdout);
-            scanf("%lf", &v1[i]);
-            }
-
-        printf("Digite os elementos do vetor 2:\n");
-        for (int i = 0; i < n; i++){
-            fflush(stdout);
-            scanf("%lf", &v2[i]);
-        }
-
-        /* Alocar e preencher sendcounts e displs */
-        sendcounts = malloc(comm_sz * sizeof(int));
-        displs = malloc(comm_sz * sizeof(int));
-
-        int div = n / comm_sz;
-        int resto = n % comm_sz;
-
-        int offset = 0;
-        for (int i = 0; i < comm_sz; i++) {
-            sendcounts[i] = div + (i < resto ? 1 : 0);
-            displs[i] = offset;
-            offset += sendcounts[i];
-        }
+        /* daqui em diante o processo 0 lê stdin só pelo leitor em
+           blocos: os vetores não passam inteiros pela memória dele */
+        in = Fio_open(stdin);
     }
 
     /* Broadcast de n e escalar */
     MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&escalar, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
-    /* Cada processo descobre seu local_n */
-    int div = n / comm_sz;
-    int resto = n % comm_sz;
-    local_n = div + (my_rank < resto ? 1 : 0);
+    /* Distribuição em blocos (os n % comm_sz primeiros processos ficam
+       com um elemento a mais); o layout calcula local_n e os tipos
+       de cada processo */
+    Dvec_layout_init(&lay, n, DVEC_BLOCK, 0, MPI_COMM_WORLD);
+    local_n = lay.local_n;
 
     /* Alocar vetores locais */
-    local_v1 = malloc(local_n * sizeof(double));
-    local_v2 = malloc(local_n * sizeof(double));
-
-    /* Distribuir vetores com Scatterv */
-    MPI_Scatterv(v1, sendcounts, displs, MPI_DOUBLE,
-                 local_v1, local_n, MPI_DOUBLE,
-                 0, MPI_COMM_WORLD);
+    Dvec_create(&local_v1, &lay);
+    Dvec_create(&local_v2, &lay);
 
-    MPI_Scatterv(v2, sendcounts, displs, MPI_DOUBLE,
-                 local_v2, local_n, MPI_DOUBLE,
-                 0, MPI_COMM_WORLD);
-
-    /* Multiplicar vetor 1 pelo escalar */
-    for (int i = 0; i < local_n; i++)
-        local_v1[i] *= escalar;
+    /* Ler e distribuir os vetores em pedaços */
+    if (my_rank == 0) {
+        printf("Digite os elementos do vetor 1:\n");
+        fflush(stdout);
+    }
+    Dvec_stream_read(&local_v1, in, 0, &st1);
+    if (my_rank == 0) {
+        printf("Digite os elementos do vetor 2:\n");
+        fflush(stdout);
+    }
+    Dvec_stream_read(&local_v2, in, 0, &st2);
 
-    /* Soma parcial da norma do vetor 2 */
-    for (int i = 0; i < local_n; i++)
-        local_sum += local_v2[i] * local_v2[i];
+    /* Multiplicar vetor 1 pelo escalar e somar os quadrados do vetor 2
+       numa única passada pelos dois blocos */
+    local_sum = Blas1_scal_sumsq(local_n, escalar, local_v1.local,
+                                 local_v2.local);
 
     MPI_Reduce(&local_sum, &global_sum, 1, MPI_DOUBLE,
                MPI_SUM, 0, MPI_COMM_WORLD);
 
-    /* Coletar vetor 1 modificado */
-    MPI_Gatherv(local_v1, local_n, MPI_DOUBLE,
-                v1, sendcounts, displs, MPI_DOUBLE,
-                0, MPI_COMM_WORLD);
-
-    /* Processo 0 imprime */
+    /* Coletar e imprimir vetor 1 modificado, em pedaços */
     if (my_rank == 0) {
         printf("\nVetor 1 após multiplicação pelo escalar:\n");
-        for (int i = 0; i < n; i++)
-            printf("%.2f ", v1[i]);
-        printf("\n");
+        fflush(stdout);
+    }
+    Dvec_stream_write(&local_v1, stdout, 2, 0, &st_out);
 
+    /* Processo 0 imprime */
+    if (my_rank == 0) {
         printf("\nNorma do vetor 2: %.6f\n", sqrt(global_sum));
 
-        free(v1);
-        free(v2);
-        free(sendcounts);
-        free(displs);
+        Dvec_print_rate("Leitura do vetor 1", &st1);
+        Dvec_print_rate("Leitura do vetor 2", &st2);
+        Dvec_print_rate("Escrita do vetor 1", &st_out);
+        Fio_close(in);
     }
 
-    free(local_v1);
-    free(local_v2);
+    Dvec_free(&local_v1);
+    Dvec_free(&local_v2);
+    Dvec_layout_free(&lay);
 
     MPI_Finalize();
     return 0;
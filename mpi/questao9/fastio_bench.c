@@ -0,0 +1,237 @@
+/*
+ * Benchmark de ../include/fastio.h contra stdio: escreve e lê n inteiros
+ * e n doubles em arquivos de texto e compara tempos e resultados.
+ *
+ * Compilar:  gcc -O2 -Wall -o fastio_bench fastio_bench.c -lm
+ * Executar:  ./fastio_bench [n] [dir]
+ *
+ * - n: números de cada tipo (padrão 10000000)
+ * - dir: onde criar os arquivos temporários (padrão /tmp)
+ * - leitura: fscanf, Fio_open (fread em blocos) e Fio_open_path (mmap)
+ * - escrita: fprintf "%d " / "%f " / "%.17g " contra Fio_write_int,
+ *   Fio_write_fixed (texto idêntico, verificado) e Fio_write_shortest
+ *   (verificado relendo: todo valor volta igual)
+ * - os doubles aleatórios usam os 53 bits da mantissa, o pior caso de
+ *   Fio_write_shortest (cai no "%.17g"); a linha "2 casas" repete a
+ *   escrita com valores de 2 casas decimais, onde o caminho rápido vale
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/fastio.h"
+
+double Now(void);
+long   File_size(const char* path);
+int    Same_file(const char* a, const char* b);
+void   Report(const char* what, double secs, long long n, long bytes,
+          double base_secs);
+
+int main(int argc, char* argv[]) {
+    long long n = (argc > 1) ? atoll(argv[1]) : 10000000;
+    const char* dir = (argc > 2) ? argv[2] : "/tmp";
+    char f_std[512], f_fio[512], f_short[512];
+    int ok = 1;
+
+    snprintf(f_std, sizeof(f_std), "%s/fastio_bench_std.txt", dir);
+    snprintf(f_fio, sizeof(f_fio), "%s/fastio_bench_fio.txt", dir);
+    snprintf(f_short, sizeof(f_short), "%s/fastio_bench_short.txt", dir);
+
+    int *a = malloc(n * sizeof(int)), *b = malloc(n * sizeof(int));
+    double *x = malloc(n * sizeof(double)), *y = malloc(n * sizeof(double));
+    if (n <= 0 || !a || !b || !x || !y) {
+        fprintf(stderr, "uso: %s [n > 0] [dir]\n", argv[0]);
+        return 1;
+    }
+    srand(1);
+    for (long long i = 0; i < n; i++) {
+        a[i] = rand() - RAND_MAX / 2;
+        x[i] = (rand() - RAND_MAX / 2) / 1024.0 + rand() / (double) RAND_MAX;
+    }
+
+    printf("\nn = %lld\n\n%-28s %10s %12s %10s %8s\n", n, "operação",
+           "tempo (s)", "números/s", "MB/s", "x stdio");
+
+    /* ---------------- inteiros ---------------- */
+    double t = Now();
+    FILE* f = fopen(f_std, "w");
+    for (long long i = 0; i < n; i++)
+        fprintf(f, "%d ", a[i]);
+    fclose(f);
+    double t_base = Now() - t;
+    Report("int  escrita fprintf", t_base, n, File_size(f_std), t_base);
+
+    t = Now();
+    f = fopen(f_fio, "w");
+    Fio_out* out = Fio_out_open(f);
+    for (long long i = 0; i < n; i++)
+        Fio_write_int(out, a[i], ' ');
+    Fio_out_close(out);
+    fclose(f);
+    Report("int  escrita Fio", Now() - t, n, File_size(f_fio), t_base);
+    ok &= Same_file(f_std, f_fio);
+
+    t = Now();
+    f = fopen(f_std, "r");
+    for (long long i = 0; i < n; i++)
+        if (fscanf(f, "%d", &b[i]) != 1) ok = 0;
+    fclose(f);
+    t_base = Now() - t;
+    Report("int  leitura fscanf", t_base, n, File_size(f_std), t_base);
+
+    memset(b, 0, n * sizeof(int));
+    t = Now();
+    f = fopen(f_std, "r");
+    Fio_in* in = Fio_open(f);
+    for (long long i = 0; i < n; i++)
+        if (!Fio_read_int(in, &b[i])) ok = 0;
+    Fio_close(in);
+    fclose(f);
+    Report("int  leitura Fio (fread)", Now() - t, n, File_size(f_std), t_base);
+    ok &= memcmp(a, b, n * sizeof(int)) == 0;
+
+    memset(b, 0, n * sizeof(int));
+    t = Now();
+    in = Fio_open_path(f_std);
+    for (long long i = 0; in != NULL && i < n; i++)
+        if (!Fio_read_int(in, &b[i])) ok = 0;
+    if (in != NULL) Fio_close(in);
+    Report("int  leitura Fio (mmap)", Now() - t, n, File_size(f_std), t_base);
+    ok &= memcmp(a, b, n * sizeof(int)) == 0;
+
+    /* ---------------- doubles, "%f " ---------------- */
+    t = Now();
+    f = fopen(f_std, "w");
+    for (long long i = 0; i < n; i++)
+        fprintf(f, "%f ", x[i]);
+    fclose(f);
+    t_base = Now() - t;
+    Report("double escrita fprintf %f", t_base, n, File_size(f_std), t_base);
+
+    t = Now();
+    f = fopen(f_fio, "w");
+    out = Fio_out_open(f);
+    for (long long i = 0; i < n; i++)
+        Fio_write_fixed(out, x[i], 6, ' ');
+    Fio_out_close(out);
+    fclose(f);
+    Report("double escrita Fio fixed", Now() - t, n, File_size(f_fio), t_base);
+    ok &= Same_file(f_std, f_fio);
+
+    /* ---------------- doubles, ida e volta ---------------- */
+    t = Now();
+    f = fopen(f_std, "w");
+    for (long long i = 0; i < n; i++)
+        fprintf(f, "%.17g ", x[i]);
+    fclose(f);
+    t_base = Now() - t;
+    Report("double escrita fprintf %.17g", t_base, n, File_size(f_std), t_base);
+
+    t = Now();
+    f = fopen(f_short, "w");
+    out = Fio_out_open(f);
+    for (long long i = 0; i < n; i++)
+        Fio_write_shortest(out, x[i], ' ');
+    Fio_out_close(out);
+    fclose(f);
+    Report("double escrita Fio shortest", Now() - t, n, File_size(f_short),
+           t_base);
+
+    t = Now();
+    f = fopen(f_std, "r");
+    for (long long i = 0; i < n; i++)
+        if (fscanf(f, "%lf", &y[i]) != 1) ok = 0;
+    fclose(f);
+    t_base = Now() - t;
+    Report("double leitura fscanf", t_base, n, File_size(f_std), t_base);
+    ok &= memcmp(x, y, n * sizeof(double)) == 0;
+
+    memset(y, 0, n * sizeof(double));
+    t = Now();
+    f = fopen(f_std, "r");
+    in = Fio_open(f);
+    for (long long i = 0; i < n; i++)
+        if (!Fio_read_double(in, &y[i])) ok = 0;
+    Fio_close(in);
+    fclose(f);
+    Report("double leitura Fio (fread)", Now() - t, n, File_size(f_std),
+           t_base);
+    ok &= memcmp(x, y, n * sizeof(double)) == 0;
+
+    /* o texto curto também tem que voltar a x */
+    memset(y, 0, n * sizeof(double));
+    t = Now();
+    in = Fio_open_path(f_short);
+    for (long long i = 0; in != NULL && i < n; i++)
+        if (!Fio_read_double(in, &y[i])) ok = 0;
+    if (in != NULL) Fio_close(in);
+    Report("double leitura Fio (mmap)", Now() - t, n, File_size(f_short),
+           t_base);
+    ok &= memcmp(x, y, n * sizeof(double)) == 0;
+
+    /* valores curtos: fprintf %.17g x Fio shortest */
+    for (long long i = 0; i < n; i++)
+        y[i] = nearbyint(x[i] * 100.0) / 100.0;
+    t = Now();
+    f = fopen(f_fio, "w");
+    for (long long i = 0; i < n; i++)
+        fprintf(f, "%.17g ", y[i]);
+    fclose(f);
+    t_base = Now() - t;
+    t = Now();
+    f = fopen(f_fio, "w");
+    out = Fio_out_open(f);
+    for (long long i = 0; i < n; i++)
+        Fio_write_shortest(out, y[i], ' ');
+    Fio_out_close(out);
+    fclose(f);
+    Report("2 casas: Fio shortest", Now() - t, n, File_size(f_fio), t_base);
+    in = Fio_open_path(f_fio);
+    for (long long i = 0; in != NULL && i < n; i++) {
+        double z;
+        if (!Fio_read_double(in, &z) || z != y[i]) ok = 0;
+    }
+    if (in != NULL) Fio_close(in);
+
+
+    printf("\nResultado: %s\n\n", ok ? "correto" : "INCORRETO");
+
+    remove(f_std);
+    remove(f_fio);
+    remove(f_short);
+    free(a); free(b); free(x); free(y);
+    return ok ? 0 : 1;
+}
+
+double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+long File_size(const char* path) {
+    struct stat sb;
+    return (stat(path, &sb) == 0) ? (long) sb.st_size : 0;
+}
+
+/* 1 se os dois arquivos têm o mesmo conteúdo */
+int Same_file(const char* a, const char* b) {
+    FILE *fa = fopen(a, "r"), *fb = fopen(b, "r");
+    int same = (fa != NULL && fb != NULL);
+    char ba[1 << 16], bb[1 << 16];
+    while (same) {
+        size_t na = fread(ba, 1, sizeof(ba), fa);
+        size_t nb = fread(bb, 1, sizeof(bb), fb);
+        if (na != nb || memcmp(ba, bb, na) != 0) same = 0;
+        if (na == 0) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+void Report(const char* what, double secs, long long n, long bytes,
+        double base_secs) {
+    printf("%-28s %10.3f %12.3e %10.1f %7.2fx\n", what, secs, n / secs,
+           bytes / secs / 1e6, base_secs / secs);
+}
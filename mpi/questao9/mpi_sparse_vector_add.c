@@ -0,0 +1,203 @@
+/*
+ * Soma e produto escalar de vetores esparsos distribuídos (../include/svec.h)
+ * comparados com o caminho denso de mpi_vector_add (Dvec + blas1):
+ *   z = x + y,  d = x.y,  y = y + 2x,  |y|
+ * com scatter de x e y a partir do raiz e gather de z e y no raiz.
+ *
+ * Compilar:  mpicc -O2 -Wall -o mpi_sparse_vector_add mpi_sparse_vector_add.c -lm
+ * Executar:  mpirun -np <p> ./mpi_sparse_vector_add [n] [densidade] [b | c | k <nb>]
+ *
+ * - n: ordem dos vetores (padrão 10000000)
+ * - densidade: fração de não nulos de x e de y (padrão 0.005)
+ * - layout como em mpi_vector_add (padrão b)
+ * - tempos: mínimo de REPS repetições, do scatter ao gather
+ * - bytes: volume de dados dos scatters e gathers (sem contagens)
+ * - com nnz >= 2n/3 os dois caminhos mandam o mesmo volume (svec.h passa
+ *   a transferir denso); a diferença que sobra é a conversão pares <->
+ *   vetor denso no raiz
+ * - o resultado esparso tem que ser igual ao denso (z e y exatos, d e
+ *   |y| com erro relativo <= 1e-12)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#include "../include/svec.h"
+
+#define REPS 5
+
+void Gen_sparse(int n, double density, unsigned short seed, int* nnz_p,
+        int** idx_p, double** val_p, double* dense);
+int  Same_as_dense(int n, int nnz, const int* idx, const double* val,
+        const double* dense);
+long long Xfer_bytes(long long nnz, int n);
+
+int main(int argc, char* argv[]) {
+    int my_rank, comm_sz;
+    MPI_Comm comm = MPI_COMM_WORLD;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(comm, &my_rank);
+    MPI_Comm_size(comm, &comm_sz);
+
+    int n = (argc > 1) ? atoi(argv[1]) : 10000000;
+    double density = (argc > 2) ? atof(argv[2]) : 0.005;
+    Dvec_kind kind = DVEC_BLOCK;
+    int nb = 1;
+    if (argc > 3 && argv[3][0] == 'c') kind = DVEC_CYCLIC;
+    if (argc > 3 && argv[3][0] == 'k') {
+        kind = DVEC_BLOCK_CYCLIC;
+        nb = (argc > 4) ? atoi(argv[4]) : 0;
+    }
+    if (n <= 0 || density < 0.0 || density > 1.0 || nb <= 0) {
+        if (my_rank == 0)
+            fprintf(stderr, "uso: mpirun -np <p> %s [n] [densidade] "
+                    "[b | c | k <nb>]\n", argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    /* vetores globais no raiz: pares e versão densa de referência */
+    int nnz_x = 0, nnz_y = 0, *idx_x = NULL, *idx_y = NULL;
+    double *val_x = NULL, *val_y = NULL;
+    double *a_x = NULL, *a_y = NULL, *a_z = NULL, *a_y2 = NULL;
+    if (my_rank == 0) {
+        a_x = calloc(n, sizeof(double));
+        a_y = calloc(n, sizeof(double));
+        a_z = malloc(n * sizeof(double));
+        a_y2 = malloc(n * sizeof(double));
+        Gen_sparse(n, density, 1, &nnz_x, &idx_x, &val_x, a_x);
+        Gen_sparse(n, density, 2, &nnz_y, &idx_y, &val_y, a_y);
+    }
+
+    Dvec_layout lay;
+    Dvec_layout_init(&lay, n, kind, nb, comm);
+
+    /* caminho denso */
+    Dvec x, y, z;
+    Dvec_create(&x, &lay);
+    Dvec_create(&y, &lay);
+    Dvec_create(&z, &lay);
+    double t_dense = 1e30, d_dense = 0.0, nrm_dense = 0.0;
+    for (int rep = 0; rep < REPS; rep++) {
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        Dvec_scatter(&x, a_x, 0);
+        Dvec_scatter(&y, a_y, 0);
+        Blas1_waxpby(lay.local_n, 1.0, x.local, 1.0, y.local, z.local);
+        d_dense = Blas1_pdot(lay.local_n, x.local, y.local, comm);
+        Blas1_axpy(lay.local_n, 2.0, x.local, y.local);
+        nrm_dense = Blas1_pnrm2(lay.local_n, y.local, comm);
+        Dvec_gather(&z, a_z, 0);
+        Dvec_gather(&y, a_y2, 0);
+        double t = MPI_Wtime() - start;
+        if (t < t_dense) t_dense = t;
+    }
+    Dvec_free(&x);
+    Dvec_free(&y);
+    Dvec_free(&z);
+
+    /* caminho esparso */
+    Svec sx, sy, sz;
+    Svec_create(&sx, &lay);
+    Svec_create(&sy, &lay);
+    Svec_create(&sz, &lay);
+    int nnz_z = 0, nnz_y2 = 0, *idx_z = NULL, *idx_y2 = NULL;
+    double *val_z = NULL, *val_y2 = NULL;
+    double t_sparse = 1e30, d_sparse = 0.0, nrm_sparse = 0.0;
+    int n_dense = 0;
+    for (int rep = 0; rep < REPS; rep++) {
+        free(idx_z); free(val_z); free(idx_y2); free(val_y2);
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        Svec_scatter(&sx, nnz_x, idx_x, val_x, 0);
+        Svec_scatter(&sy, nnz_y, idx_y, val_y, 0);
+        Svec_waxpby(1.0, &sx, 1.0, &sy, &sz);
+        d_sparse = Svec_pdot(&sx, &sy);
+        Svec_axpy(2.0, &sx, &sy);
+        nrm_sparse = Svec_pnrm2(&sy);
+        Svec_gather(&sz, 0, &nnz_z, &idx_z, &val_z);
+        Svec_gather(&sy, 0, &nnz_y2, &idx_y2, &val_y2);
+        double t = MPI_Wtime() - start;
+        if (t < t_sparse) t_sparse = t;
+    }
+    int my_dense = sx.dense + sy.dense + sz.dense;
+    MPI_Reduce(&my_dense, &n_dense, 1, MPI_INT, MPI_SUM, 0, comm);
+    Svec_free(&sx);
+    Svec_free(&sy);
+    Svec_free(&sz);
+
+    if (my_rank == 0) {
+        int ok = Same_as_dense(n, nnz_z, idx_z, val_z, a_z) &&
+                 Same_as_dense(n, nnz_y2, idx_y2, val_y2, a_y2) &&
+                 fabs(d_sparse - d_dense) <= 1e-12 * fabs(d_dense) &&
+                 fabs(nrm_sparse - nrm_dense) <= 1e-12 * nrm_dense;
+        long long b_dense = 4LL * n * sizeof(double);
+        long long b_sparse = Xfer_bytes(nnz_x, n) + Xfer_bytes(nnz_y, n) +
+                             Xfer_bytes(nnz_z, n) + Xfer_bytes(nnz_y2, n);
+
+        printf("\n(comm_sz = %d, n = %d, densidade = %g, layout %s)\n",
+               comm_sz, n, density,
+               kind == DVEC_BLOCK ? "bloco" :
+               kind == DVEC_CYCLIC ? "cíclico" : "bloco-cíclico");
+        printf("nnz: x = %d, y = %d, x+y = %d;  partes locais densas: %d de %d\n\n",
+               nnz_x, nnz_y, nnz_z, n_dense, 3 * comm_sz);
+        printf("%-10s %12s %14s\n", "caminho", "tempo (s)", "bytes");
+        printf("%-10s %12.6f %14lld\n", "denso", t_dense, b_dense);
+        printf("%-10s %12.6f %14lld  (%.2fx)\n", "esparso", t_sparse,
+               b_sparse, t_dense / t_sparse);
+        printf("\nx.y = %.15e / %.15e\n", d_dense, d_sparse);
+        printf("Resultado: %s\n\n", ok ? "correto" : "INCORRETO");
+
+        free(idx_x); free(val_x); free(idx_y); free(val_y);
+        free(a_x); free(a_y); free(a_z); free(a_y2);
+    }
+    free(idx_z); free(val_z); free(idx_y2); free(val_y2);
+    Dvec_layout_free(&lay);
+    MPI_Finalize();
+    return 0;
+}
+
+/* cada posição é não nula com probabilidade density; preenche também
+   a versão densa */
+void Gen_sparse(int n, double density, unsigned short seed, int* nnz_p,
+        int** idx_p, double** val_p, double* dense) {
+    unsigned short xs[3] = { 0x330e, seed, 0x1234 };
+    int cap = (int) (1.1 * density * n) + 16, nnz = 0;
+    int* idx = malloc(cap * sizeof(int));
+    double* val = malloc(cap * sizeof(double));
+
+    for (int g = 0; g < n; g++) {
+        if (erand48(xs) >= density) continue;
+        if (nnz == cap) {
+            cap *= 2;
+            idx = realloc(idx, cap * sizeof(int));
+            val = realloc(val, cap * sizeof(double));
+        }
+        idx[nnz] = g;
+        val[nnz] = dense[g] = 1.0 + erand48(xs);
+        nnz++;
+    }
+    *nnz_p = nnz;
+    *idx_p = idx;
+    *val_p = val;
+}
+
+/* os pares (crescentes) são exatamente os não nulos de dense */
+int Same_as_dense(int n, int nnz, const int* idx, const double* val,
+        const double* dense) {
+    int k = 0;
+    for (int g = 0; g < n; g++) {
+        if (dense[g] == 0.0) continue;
+        if (k >= nnz || idx[k] != g || val[k] != dense[g]) return 0;
+        k++;
+    }
+    return k == nnz;
+}
+
+/* bytes de valores/índices de um scatter ou gather de svec.h */
+long long Xfer_bytes(long long nnz, int n) {
+    return Svec_dense_transfer(nnz, n) ? (long long) n * sizeof(double) :
+           nnz * (sizeof(int) + sizeof(double));
+}
@@ -1,48 +1,68 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <mpi.h>
+#include "../include/blas1.h"
+#include "../include/dvec_stream.h"
 
 void Check_for_error(int local_ok, char fname[], char message[], 
       MPI_Comm comm);
-void Read_n(int* n_p, int* local_n_p, int my_rank, int comm_sz, 
-      MPI_Comm comm);
-void Allocate_vectors(double** local_x_pp, double** local_y_pp,
-      double** local_z_pp, int local_n, MPI_Comm comm);
-void Read_vector(double local_a[], int local_n, int n, char vec_name[], 
-      int my_rank, MPI_Comm comm);
-void Print_vector(double local_b[], int local_n, int n, char title[], 
+void Get_layout(int argc, char* argv[], Dvec_kind* kind_p, int* nb_p,
       int my_rank, MPI_Comm comm);
+void Read_n(int* n_p, int my_rank, MPI_Comm comm);
+void Allocate_vectors(Dvec* x_p, Dvec* y_p, Dvec* z_p, Dvec_layout* lay,
+      MPI_Comm comm);
+void Read_vector(Dvec* a_p, Fio_in* in, char vec_name[], int my_rank);
+void Print_vector(Dvec* b_p, char title[], int my_rank);
 void Parallel_vector_sum(double local_x[], double local_y[], 
       double local_z[], int local_n);
+int  Check_redistribute(Dvec* v_p, MPI_Comm comm);
 
-int main(void) {
-   int n, local_n;
+/* Uso: mpirun -np <p> ./mpi_vector_add [b | c | k <nb>]
+ *      b = bloco (padrão), c = cíclica, k = bloco-cíclica com blocos
+ *      de nb elementos; n pode ser qualquer valor > 0 */
+int main(int argc, char* argv[]) {
+   int n, nb, ok;
    int comm_sz, my_rank;
-   double *local_x, *local_y, *local_z;
+   Dvec_kind kind;
+   Dvec_layout lay;
+   Dvec x, y, z;
+   Fio_in* in = NULL;
    MPI_Comm comm;
 
-   MPI_Init(NULL, NULL);
+   MPI_Init(&argc, &argv);
    comm = MPI_COMM_WORLD;
    MPI_Comm_size(comm, &comm_sz);
    MPI_Comm_rank(comm, &my_rank);
 
-   Read_n(&n, &local_n, my_rank, comm_sz, comm);
+   Get_layout(argc, argv, &kind, &nb, my_rank, comm);
+   Read_n(&n, my_rank, comm);
+   Dvec_layout_init(&lay, n, kind, nb, comm);
 #  ifdef DEBUG
-   printf("Proc %d > n = %d, local_n = %d\n", my_rank, n, local_n);
+   printf("Proc %d > n = %d, local_n = %d\n", my_rank, n, lay.local_n);
 #  endif
-   Allocate_vectors(&local_x, &local_y, &local_z, local_n, comm);
+   Allocate_vectors(&x, &y, &z, &lay, comm);
    
-   Read_vector(local_x, local_n, n, "x", my_rank, comm);
-   Print_vector(local_x, local_n, n, "x is", my_rank, comm);
-   Read_vector(local_y, local_n, n, "y", my_rank, comm);
-   Print_vector(local_y, local_n, n, "y is", my_rank, comm);
+   /* after n, process 0 reads stdin only through the block reader */
+   if (my_rank == 0) in = Fio_open(stdin);
+   Read_vector(&x, in, "x", my_rank);
+   Print_vector(&x, "x is", my_rank);
+   Read_vector(&y, in, "y", my_rank);
+   Print_vector(&y, "y is", my_rank);
+   if (my_rank == 0) Fio_close(in);
    
-   Parallel_vector_sum(local_x, local_y, local_z, local_n);
-   Print_vector(local_z, local_n, n, "The sum is", my_rank, comm);
+   /* x, y e z têm o mesmo layout: a soma é elemento a elemento local */
+   Parallel_vector_sum(x.local, y.local, z.local, lay.local_n);
+   Print_vector(&z, "The sum is", my_rank);
 
-   free(local_x);
-   free(local_y);
-   free(local_z);
+   /* z -> bloco -> cíclica -> bloco-cíclica -> layout de z */
+   ok = Check_redistribute(&z, comm);
+   if (my_rank == 0)
+      printf("Redistribution round trip: %s\n", ok ? "correct" : "WRONG");
+
+   Dvec_free(&x);
+   Dvec_free(&y);
+   Dvec_free(&z);
+   Dvec_layout_free(&lay);
 
    MPI_Finalize();
 
@@ -86,11 +106,60 @@ void Check_for_error(
    }
 }  /* Check_for_error */
 
+/*-------------------------------------------------------------------
+ * Function:  Get_layout
+ * Purpose:   Get the distribution of the vectors from the command line
+ *            on process 0 and broadcast it
+ * Out args:  kind_p:  DVEC_BLOCK, DVEC_CYCLIC or DVEC_BLOCK_CYCLIC
+ *            nb_p:    block size for DVEC_BLOCK_CYCLIC
+ */
+void Get_layout(
+      int        argc      /* in  */,
+      char*      argv[]    /* in  */,
+      Dvec_kind* kind_p    /* out */,
+      int*       nb_p      /* out */,
+      int        my_rank   /* in  */,
+      MPI_Comm   comm      /* in  */) {
+   int args[2] = {DVEC_BLOCK, 1};
+   int local_ok = 1;
+
+   if (my_rank == 0 && argc > 1) {
+      if (argv[1][0] == 'c') {
+         args[0] = DVEC_CYCLIC;
+      } else if (argv[1][0] == 'k') {
+         args[0] = DVEC_BLOCK_CYCLIC;
+         args[1] = (argc > 2) ? atoi(argv[2]) : 0;
+      } else if (argv[1][0] != 'b') {
+         args[1] = 0;
+      }
+   }
+   MPI_Bcast(args, 2, MPI_INT, 0, comm);
+   if (args[1] <= 0) local_ok = 0;
+   Check_for_error(local_ok, "Get_layout",
+         "usage: mpi_vector_add [b | c | k <nb>], nb > 0", comm);
+   *kind_p = (Dvec_kind) args[0];
+   *nb_p = args[1];
+}  /* Get_layout */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Read_n
+ * Purpose:   Get the order of the vectors from stdin on proc 0 and
+ *            broadcast to other processes.
+ * In args:   my_rank:    process rank in communicator
+ *            comm:       communicator containing all the processes
+ *                        calling Read_n
+ * Out arg:   n_p:        global value of n
+ *
+ * Errors:    n should be positive.  If it isn't, the program
+ *            prints a message and quits.
+ *
+ * Note:      n no longer has to be divisible by comm_sz: the layout
+ *            gives each process its own local size
+ */
 void Read_n(
       int*      n_p        /* out */, 
-      int*      local_n_p  /* out */, 
       int       my_rank    /* in  */, 
-      int       comm_sz    /* in  */,
       MPI_Comm  comm       /* in  */) {
    int local_ok = 1;
    char *fname = "Read_n";
@@ -100,38 +169,35 @@ void Read_n(
       scanf("%d", n_p);
    }
    MPI_Bcast(n_p, 1, MPI_INT, 0, comm);
-   if (*n_p =< 0 || *n_p % comm_sz != 0) local_ok = 0;
-   Check_for_error(local_ok, fname,
-         "n should be > 0 and evenly divisible by comm_sz", comm);
-   *local_n_p = *n_p/comm_sz;
+   if (*n_p <= 0) local_ok = 0;
+   Check_for_error(local_ok, fname, "n should be > 0", comm);
 }  /* Read_n */
 
 
 /*-------------------------------------------------------------------
  * Function:  Allocate_vectors
  * Purpose:   Allocate storage for x, y, and z
- * In args:   local_n:  the size of the local vectors
+ * In args:   lay:      layout shared by the three vectors
  *            comm:     the communicator containing the calling processes
- * Out args:  local_x_pp, local_y_pp, local_z_pp:  pointers to memory
- *               blocks to be allocated for local vectors
+ * Out args:  x_p, y_p, z_p:  distributed vectors with local storage
  *
  * Errors:    One or more of the calls to malloc fails
  */
 void Allocate_vectors(
-      double**   local_x_pp  /* out */, 
-      double**   local_y_pp  /* out */,
-      double**   local_z_pp  /* out */, 
-      int        local_n     /* in  */,
-      MPI_Comm   comm        /* in  */) {
+      Dvec*         x_p   /* out */, 
+      Dvec*         y_p   /* out */,
+      Dvec*         z_p   /* out */, 
+      Dvec_layout*  lay   /* in  */,
+      MPI_Comm      comm  /* in  */) {
    int local_ok = 1;
    char* fname = "Allocate_vectors";
 
-   *local_x_pp = malloc(local_n*sizeof(double));
-   *local_y_pp = malloc(local_n*sizeof(double));
-   *local_z_pp = malloc(local_n*sizeof(double));
+   Dvec_create(x_p, lay);
+   Dvec_create(y_p, lay);
+   Dvec_create(z_p, lay);
 
-   if (*local_x_pp == NULL || *local_y_pp == NULL || 
-       *local_z_pp == NULL) local_ok = 0;
+   if (x_p->local == NULL || y_p->local == NULL || 
+       z_p->local == NULL) local_ok = 0;
    Check_for_error(local_ok, fname, "Can't allocate local vector(s)", 
          comm);
 }  /* Allocate_vectors */
@@ -140,125 +206,72 @@ void Allocate_vectors(
 /*-------------------------------------------------------------------
  * Function:   Read_vector
  * Purpose:    Read a vector from stdin on process 0 and distribute
- *             among the processes using a block distribution.
- * In args:    local_n:  size of local vectors
- *             n:        size of global vector
+ *             among the processes according to a_p's layout.
+ * In args:    in:       block reader on stdin (used on process 0 only)
  *             vec_name: name of vector being read (e.g., "x")
- *             my_rank:  calling process' rank in comm
- *             comm:     communicator containing calling processes
- * Out arg:    local_a:  local vector read
- *
- * Errors:     if the malloc on process 0 for temporary storage
- *             fails the program terminates
+ *             my_rank:  calling process' rank in a_p's communicator
+ * Out arg:    a_p:      local part of the vector read
  *
  * Note: 
- *    This function assumes a block distribution and the order
- *   of the vector evenly divisible by comm_sz.
+ *    Process 0 parses DVEC_CHUNK numbers at a time and sends each
+ *    chunk to its owners with nonblocking sends while it parses the
+ *    next one, so it never stores the whole vector (see
+ *    dvec_stream.h).  The ingest rate goes to stderr.
  */
-/* Read_vector modificado usando MPI_Type_contiguous */
 void Read_vector(
-      double    local_a[]   /* out */, 
-      int       local_n     /* in  */, 
-      int       n           /* in  */,
-      char      vec_name[]  /* in  */,
-      int       my_rank     /* in  */, 
-      MPI_Comm  comm        /* in  */) {
-
-   double* a = NULL;
-   int i;
-   int local_ok = 1;
-   char* fname = "Read_vector";
-   MPI_Datatype block_type;
+      Dvec*          a_p         /* out */, 
+      Fio_in*        in          /* in  */,
+      char           vec_name[]  /* in  */,
+      int            my_rank     /* in  */) {
 
-   /* Cria o tipo derivado (cada processo recebe um bloco de local_n doubles) */
-   MPI_Type_contiguous(local_n, MPI_DOUBLE, &block_type);
-   MPI_Type_commit(&block_type);
+   Dvec_io_stats st;
+   char what[64];
 
    if (my_rank == 0) {
-      a = malloc(n * sizeof(double));
-      if (a == NULL) local_ok = 0;
-      Check_for_error(local_ok, fname, "Can't allocate temporary vector", comm);
-
       printf("Enter the vector %s\n", vec_name);
-      for (i = 0; i < n; i++)
-         scanf("%lf", &a[i]);
-
-      /* Agora usamos count = 1 e o tipo derivado block_type */
-      MPI_Scatter(a, 1, block_type,         /* sendbuf, sendcount, sendtype */
-                  local_a, 1, block_type,   /* recvbuf, recvcount, recvtype */
-                  0, comm);
-      free(a);
-   } else {
-      /* Processos não-root chamam a mesma rotina (sendbuf ignorado internamente) */
-      Check_for_error(local_ok, fname, "Can't allocate temporary vector", comm);
-      MPI_Scatter(a, 1, block_type, local_a, 1, block_type, 0, comm);
+      fflush(stdout);
    }
 
-   /* Liberar o tipo derivado */
-   MPI_Type_free(&block_type);
+   Dvec_stream_read(a_p, in, 0, &st);
+
+   if (my_rank == 0) {
+      snprintf(what, sizeof(what), "Read_vector %s", vec_name);
+      Dvec_print_rate(what, &st);
+   }
 }  /* Read_vector */
 
 
 
 /*-------------------------------------------------------------------
  * Function:  Print_vector
- * Purpose:   Print a vector that has a block distribution to stdout
- * In args:   local_b:  local storage for vector to be printed
- *            local_n:  order of local vectors
- *            n:        order of global vector (local_n*comm_sz)
+ * Purpose:   Print a distributed vector to stdout
+ * In args:   b_p:      distributed vector to be printed
  *            title:    title to precede print out
- *            comm:     communicator containing processes calling
- *                      Print_vector
- *
- * Error:     if process 0 can't allocate temporary storage for
- *            the full vector, the program terminates.
+ *            my_rank:  calling process' rank in b_p's communicator
  *
  * Note:
- *    Assumes order of vector is evenly divisible by the number of
- *    processes
+ *    Process 0 receives chunk k+1 while it formats chunk k into a
+ *    large output buffer; the emit rate goes to stderr.
  */
-/* Print_vector modificado usando MPI_Type_contiguous */
 void Print_vector(
-      double    local_b[]  /* in */, 
-      int       local_n    /* in */, 
-      int       n          /* in */, 
+      Dvec*     b_p        /* in */, 
       char      title[]    /* in */, 
-      int       my_rank    /* in */,
-      MPI_Comm  comm       /* in */) {
-
-   double* b = NULL;
-   int i;
-   int local_ok = 1;
-   char* fname = "Print_vector";
-   MPI_Datatype block_type;
+      int       my_rank    /* in */) {
 
-   /* Cria o tipo derivado para blocos de local_n doubles */
-   MPI_Type_contiguous(local_n, MPI_DOUBLE, &block_type);
-   MPI_Type_commit(&block_type);
+   Dvec_io_stats st;
+   char what[64];
 
    if (my_rank == 0) {
-      b = malloc(n * sizeof(double));
-      if (b == NULL) local_ok = 0;
-      Check_for_error(local_ok, fname, "Can't allocate temporary vector", comm);
-
-      /* GATHER com count = 1 e tipo derivado; root recebe em b */
-      MPI_Gather(local_b, 1, block_type,   /* sendbuf, sendcount, sendtype */
-                 b, 1, block_type,         /* recvbuf, recvcount, recvtype */
-                 0, comm);
-
       printf("%s\n", title);
-      for (i = 0; i < n; i++)
-         printf("%f ", b[i]);
-      printf("\n");
-      free(b);
-   } else {
-      Check_for_error(local_ok, fname, "Can't allocate temporary vector", comm);
-      /* não-root: b é ignorado, mas chamamos com os mesmos argumentos coletivos */
-      MPI_Gather(local_b, 1, block_type, b, 1, block_type, 0, comm);
+      fflush(stdout);
    }
 
-   /* Liberar o tipo derivado */
-   MPI_Type_free(&block_type);
+   Dvec_stream_write(b_p, stdout, 6, 0, &st);
+
+   if (my_rank == 0) {
+      snprintf(what, sizeof(what), "Print_vector %s", title);
+      Dvec_print_rate(what, &st);
+   }
 }  /* Print_vector */
 
 
@@ -276,8 +289,44 @@ void Parallel_vector_sum(
       double  local_y[]  /* in  */, 
       double  local_z[]  /* out */, 
       int     local_n    /* in  */) {
-   int local_i;
+   Blas1_waxpby(local_n, 1.0, local_x, 1.0, local_y, local_z);
+}  /* Parallel_vector_sum */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Check_redistribute
+ * Purpose:   Move v through the block, cyclic and block-cyclic (nb = 3)
+ *            layouts with Dvec_redistribute, bring it back to its own
+ *            layout and compare with the original
+ * In args:   v_p:      distributed vector
+ *            comm:     communicator of v_p's layout
+ * Return:    1 on every process if every element came back unchanged
+ */
+int Check_redistribute(
+      Dvec*     v_p        /* in */,
+      MPI_Comm  comm       /* in */) {
+   Dvec_layout lays[3];
+   Dvec w[3], back;
+   int local_ok = 1, ok;
+
+   Dvec_layout_init(&lays[0], v_p->lay->n, DVEC_BLOCK, 0, comm);
+   Dvec_layout_init(&lays[1], v_p->lay->n, DVEC_CYCLIC, 0, comm);
+   Dvec_layout_init(&lays[2], v_p->lay->n, DVEC_BLOCK_CYCLIC, 3, comm);
+   for (int k = 0; k < 3; k++) {
+      Dvec_create(&w[k], &lays[k]);
+      Dvec_redistribute((k == 0) ? v_p : &w[k-1], &w[k]);
+   }
+   Dvec_create(&back, v_p->lay);
+   Dvec_redistribute(&w[2], &back);
 
-   for (local_i = 0; local_i < local_n; local_i++)
-      local_z[local_i] = local_x[local_i] + local_y[local_i];
-}  /* Parallel_vector_sum */
\ No newline at end of file
+   for (int l = 0; l < v_p->lay->local_n; l++)
+      if (back.local[l] != v_p->local[l]) local_ok = 0;
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+
+   Dvec_free(&back);
+   for (int k = 0; k < 3; k++) {
+      Dvec_free(&w[k]);
+      Dvec_layout_free(&lays[k]);
+   }
+   return ok;
+}  /* Check_redistribute */
@@ -0,0 +1,564 @@
+/*
+ * File:     mpi_odd_even_io.c
+ * Purpose:  Parallel odd-even sort of a binary file with MPI-IO.
+ *           Every process reads and writes only its own range with
+ *           MPI_File_read_at_all / MPI_File_write_at_all, so no process
+ *           ever holds more than its share of the keys (compare with
+ *           Read_list/Print_global_list in mpi_odd_even_time.c, where
+ *           process 0 scanf's and prints the whole list).
+ *
+ * File format:
+ *    bytes 0..7    magic "PCDKEYS1"
+ *    bytes 8..15   n, number of keys (long long, native byte order)
+ *    bytes 16..    n ints (native byte order)
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_io mpi_odd_even_io.c -lm
+ * Run:
+ *    mpirun -np <p> ./mpi_odd_even_io w <file> <global_n>   (write random keys)
+ *    mpirun -np <p> ./mpi_odd_even_io s <in> <out>          (sort in -> out)
+ *
+ * Notes:
+ * 1. n need not be divisible by p: process q reads n/p keys, plus one
+ *    if q < n % p, and keeps that count through the sort; with n < p
+ *    processes n..p-1 have no keys and sit out the exchanges
+ * 2. Each process' output offset is the exclusive prefix sum
+ *    (MPI_Exscan) of the final counts
+ * 3. After the write the output file is read back (outside the timed
+ *    part) and checked for order, key count and key sum
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/keygen.h"
+
+#define HEADER_BYTES 16
+#define CHECK_BUF 65536      /* keys per read when checking the output */
+const char MAGIC[8] = {'P','C','D','K','E','Y','S','1'};
+const int RMAX = 100;
+
+/* Function prototypes */
+void Usage(char* program);
+void Get_args(int argc, char* argv[], char* mode_p, long long* global_n_p,
+          int my_rank, MPI_Comm comm);
+void Block_range(long long global_n, int my_rank, int p,
+          long long* first_p, int* local_n_p);
+
+void Write_random_file(char* fname, long long global_n, int my_rank,
+          int p, MPI_Comm comm);
+long long Read_header(MPI_File fh, int my_rank, MPI_Comm comm);
+void Write_header(MPI_File fh, long long global_n, int my_rank);
+int* Read_keys(char* fname, long long* global_n_p, int* local_n_p,
+          int my_rank, int p, MPI_Comm comm);
+void Write_keys(char* fname, int local_A[], int local_n,
+          long long global_n, int my_rank, MPI_Comm comm);
+
+int  Compare(const void* a_p, const void* b_p);
+void Sort(int local_A[], int local_n, long long global_n, int my_rank,
+          int p, MPI_Comm comm);
+int  Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+          int local_n, int partner, int my_rank, MPI_Comm comm);
+void Merge_low(int my_keys[], int my_n, int recv_keys[], int recv_n,
+          int temp_keys[]);
+void Merge_high(int my_keys[], int my_n, int recv_keys[], int recv_n,
+          int temp_keys[]);
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+int  Check_file(char* fname, long long global_n, long long key_sum,
+          int my_rank, int p, MPI_Comm comm);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char mode;
+   long long global_n;
+   int local_n;
+   int *local_A;
+   MPI_Comm comm;
+   double t_read, t_sort, t_write, t[4], t_max[3];
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &mode, &global_n, my_rank, comm);
+
+   if (mode == 'w') {
+      MPI_Barrier(comm);
+      t[0] = MPI_Wtime();
+      Write_random_file(argv[2], global_n, my_rank, p, comm);
+      t_write = MPI_Wtime() - t[0];
+      MPI_Reduce(&t_write, &t_max[0], 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+      if (my_rank == 0)
+         printf("Wrote %lld keys to %s in %e seconds (%.1f MB/s)\n",
+               global_n, argv[2], t_max[0],
+               global_n * sizeof(int) / t_max[0] / 1.0e6);
+      MPI_Finalize();
+      return 0;
+   }
+
+   MPI_Barrier(comm);
+   t[0] = MPI_Wtime();
+   local_A = Read_keys(argv[2], &global_n, &local_n, my_rank, p, comm);
+   t[1] = MPI_Wtime();
+   Sort(local_A, local_n, global_n, my_rank, p, comm);
+   t[2] = MPI_Wtime();
+   Write_keys(argv[3], local_A, local_n, global_n, my_rank, comm);
+   t[3] = MPI_Wtime();
+
+   t_read  = t[1] - t[0];
+   t_sort  = t[2] - t[1];
+   t_write = t[3] - t[2];
+   MPI_Reduce(&t_read,  &t_max[0], 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+   MPI_Reduce(&t_sort,  &t_max[1], 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+   MPI_Reduce(&t_write, &t_max[2], 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+   int ok = Check_sorted(local_A, local_n, my_rank, p, comm);
+   long long my_sum = 0, key_sum;
+   for (int i = 0; i < local_n; i++)
+      my_sum += local_A[i];
+   MPI_Allreduce(&my_sum, &key_sum, 1, MPI_LONG_LONG, MPI_SUM, comm);
+   int file_ok = Check_file(argv[3], global_n, key_sum, my_rank, p, comm);
+
+   if (my_rank == 0) {
+      double mb = global_n * sizeof(int) / 1.0e6;
+      printf("\n================ Timing results ================\n");
+      printf("p = %d, n = %lld keys (%.1f MB)\n", p, global_n, mb);
+      printf("Read  time : %e seconds (%.1f MB/s)\n", t_max[0],
+             mb / t_max[0]);
+      printf("Sort  time : %e seconds\n", t_max[1]);
+      printf("Write time : %e seconds (%.1f MB/s)\n", t_max[2],
+             mb / t_max[2]);
+      printf("Result check: %s\n", ok ? "sorted" : "NOT SORTED");
+      printf("Output file : %s\n", file_ok ? "sorted" : "NOT SORTED");
+      printf("================================================\n\n");
+   }
+
+   free(local_A);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s w <file> <global_n>\n",
+       program);
+   fprintf(stderr, "        mpirun -np <p> %s s <in> <out>\n", program);
+   fprintf(stderr, "   w: write global_n random keys to file\n");
+   fprintf(stderr, "   s: sort the keys of in into out\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ *    global_n is only meaningful for mode w (it is read from the file
+ *    header for mode s).
+ */
+void Get_args(int argc, char* argv[], char* mode_p, long long* global_n_p,
+         int my_rank, MPI_Comm comm) {
+
+   int ok = 1;
+
+   if (my_rank == 0) {
+      *mode_p = (argc == 4) ? argv[1][0] : '?';
+      *global_n_p = (*mode_p == 'w') ? atoll(argv[3]) : 0;
+      if ((*mode_p != 'w' && *mode_p != 's') ||
+          (*mode_p == 'w' && *global_n_p <= 0)) {
+         Usage(argv[0]);
+         ok = 0;
+      }
+   }
+
+   MPI_Bcast(&ok, 1, MPI_INT, 0, comm);
+   MPI_Bcast(mode_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_LONG_LONG, 0, comm);
+
+   if (!ok) {
+      MPI_Finalize();
+      exit(-1);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Block_range
+ * Purpose:    First key and number of keys of process my_rank in the
+ *             block distribution of global_n keys
+ */
+void Block_range(long long global_n, int my_rank, int p,
+         long long* first_p, int* local_n_p) {
+   long long div = global_n / p;
+   long long resto = global_n % p;
+
+   *local_n_p = (int) (div + (my_rank < resto ? 1 : 0));
+   *first_p = my_rank * div + (my_rank < resto ? my_rank : resto);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Write_random_file
+ * Purpose:    Each process generates and writes its own block
+ *             (keygen.h, uniform in [0, RMAX)): the file is the same
+ *             for every p
+ */
+void Write_random_file(char* fname, long long global_n, int my_rank,
+         int p, MPI_Comm comm) {
+
+   MPI_File fh;
+   long long first;
+   int local_n;
+   int* local_A;
+
+   Block_range(global_n, my_rank, p, &first, &local_n);
+   local_A = malloc((local_n > 0 ? local_n : 1) * sizeof(int));
+   Keygen_fill_int(local_A, first, local_n, global_n, 'u', RMAX,
+         KEYGEN_SEED);
+
+   if (MPI_File_open(comm, fname, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+            MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+      if (my_rank == 0) fprintf(stderr, "Can't create %s\n", fname);
+      MPI_Abort(comm, 1);
+   }
+   MPI_File_set_size(fh, HEADER_BYTES + global_n * sizeof(int));
+   Write_header(fh, global_n, my_rank);
+   MPI_File_write_at_all(fh, HEADER_BYTES + first * sizeof(int),
+         local_A, local_n, MPI_INT, MPI_STATUS_IGNORE);
+   MPI_File_close(&fh);
+
+   free(local_A);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_header
+ * Purpose:    Process 0 reads and checks the header; n is broadcast
+ */
+long long Read_header(MPI_File fh, int my_rank, MPI_Comm comm) {
+   char header[HEADER_BYTES];
+   long long global_n = -1;
+
+   if (my_rank == 0) {
+      MPI_File_read_at(fh, 0, header, HEADER_BYTES, MPI_BYTE,
+            MPI_STATUS_IGNORE);
+      if (memcmp(header, MAGIC, sizeof(MAGIC)) == 0)
+         memcpy(&global_n, header + 8, sizeof(long long));
+   }
+   MPI_Bcast(&global_n, 1, MPI_LONG_LONG, 0, comm);
+   return global_n;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Write_header
+ */
+void Write_header(MPI_File fh, long long global_n, int my_rank) {
+   char header[HEADER_BYTES];
+
+   if (my_rank == 0) {
+      memcpy(header, MAGIC, sizeof(MAGIC));
+      memcpy(header + 8, &global_n, sizeof(long long));
+      MPI_File_write_at(fh, 0, header, HEADER_BYTES, MPI_BYTE,
+            MPI_STATUS_IGNORE);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_keys
+ * Purpose:    Collective read of this process' block of the file
+ * Return:     newly allocated local list
+ */
+int* Read_keys(char* fname, long long* global_n_p, int* local_n_p,
+         int my_rank, int p, MPI_Comm comm) {
+
+   MPI_File fh;
+   long long first;
+   int* local_A;
+
+   if (MPI_File_open(comm, fname, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh)
+         != MPI_SUCCESS) {
+      if (my_rank == 0) fprintf(stderr, "Can't open %s\n", fname);
+      MPI_Abort(comm, 1);
+   }
+
+   *global_n_p = Read_header(fh, my_rank, comm);
+   if (*global_n_p <= 0) {
+      if (my_rank == 0) fprintf(stderr, "%s: bad header\n", fname);
+      MPI_Abort(comm, 1);
+   }
+
+   Block_range(*global_n_p, my_rank, p, &first, local_n_p);
+   local_A = malloc((*local_n_p > 0 ? *local_n_p : 1) * sizeof(int));
+   if (local_A == NULL) {
+      fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+      MPI_Abort(comm, 1);
+   }
+
+   MPI_File_read_at_all(fh, HEADER_BYTES + first * sizeof(int),
+         local_A, *local_n_p, MPI_INT, MPI_STATUS_IGNORE);
+   MPI_File_close(&fh);
+
+   return local_A;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Write_keys
+ * Purpose:    Collective write of the sorted list; each process writes
+ *             at the exclusive prefix sum of the final counts
+ */
+void Write_keys(char* fname, int local_A[], int local_n,
+         long long global_n, int my_rank, MPI_Comm comm) {
+
+   MPI_File fh;
+   long long my_n = local_n, first = 0;
+
+   MPI_Exscan(&my_n, &first, 1, MPI_LONG_LONG, MPI_SUM, comm);
+   if (my_rank == 0) first = 0;   /* Exscan leaves rank 0 undefined */
+
+   if (MPI_File_open(comm, fname, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+            MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+      if (my_rank == 0) fprintf(stderr, "Can't create %s\n", fname);
+      MPI_Abort(comm, 1);
+   }
+   MPI_File_set_size(fh, HEADER_BYTES + global_n * sizeof(int));
+   Write_header(fh, global_n, my_rank);
+   MPI_File_write_at_all(fh, HEADER_BYTES + first * sizeof(int),
+         local_A, local_n, MPI_INT, MPI_STATUS_IGNORE);
+   MPI_File_close(&fh);
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparator
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort
+ *    Blocks may differ in size by one, so each exchange trades counts
+ *    before keys; every process keeps its count.  Only processes with
+ *    keys (0..n_active-1) take part.  With equal blocks n_active
+ *    phases sort the list; with unequal ones they may not, so pairs
+ *    of phases repeat until an MPI_Allreduce reports that no process
+ *    changed its keys.
+ */
+void Sort(int local_A[], int local_n, long long global_n, int my_rank,
+         int p, MPI_Comm comm) {
+
+   int phase, partner;
+   int n_active = (global_n < p) ? (int) global_n : p;
+   int equal = (global_n % p == 0 || global_n < p);
+
+   if (my_rank >= n_active) {
+      /* no keys: only the termination checks below */
+      int changed = 0, any = 1;
+      if (!equal)
+         while (any)
+            MPI_Allreduce(&changed, &any, 1, MPI_INT, MPI_LOR, comm);
+      return;
+   }
+
+   int even_partner, odd_partner;
+   int *temp_B = malloc((local_n + 1)*sizeof(int));
+   int *temp_C = malloc((local_n + 1)*sizeof(int));
+
+   if (my_rank % 2 != 0) {
+      even_partner = my_rank - 1;
+      odd_partner = my_rank + 1;
+      if (odd_partner == n_active) odd_partner = MPI_PROC_NULL;
+   } else {
+      even_partner = my_rank + 1;
+      if (even_partner == n_active) even_partner = MPI_PROC_NULL;
+      odd_partner = my_rank - 1;
+   }
+
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   if (equal) {
+      for (phase = 0; phase < n_active; phase++) {
+         partner = (phase % 2 == 0) ? even_partner : odd_partner;
+         if (partner >= 0)
+            Odd_even_iter(local_A, temp_B, temp_C, local_n, partner,
+                          my_rank, comm);
+      }
+   } else {
+      int any = 1;
+      while (any) {
+         int changed = 0;
+         for (phase = 0; phase < 2; phase++) {
+            partner = (phase == 0) ? even_partner : odd_partner;
+            if (partner >= 0)
+               changed |= Odd_even_iter(local_A, temp_B, temp_C, local_n,
+                                        partner, my_rank, comm);
+         }
+         MPI_Allreduce(&changed, &any, 1, MPI_INT, MPI_LOR, comm);
+      }
+   }
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Odd_even_iter: one exchange with partner
+ *    Returns 1 if local_A changed.
+ */
+int Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+        int local_n, int partner, int my_rank, MPI_Comm comm) {
+
+   MPI_Status status;
+   int recv_n;
+
+   MPI_Sendrecv(&local_n, 1, MPI_INT, partner, 1,
+                &recv_n, 1, MPI_INT, partner, 1, comm, &status);
+   MPI_Sendrecv(local_A, local_n, MPI_INT, partner, 0,
+                temp_B, recv_n, MPI_INT, partner, 0, comm, &status);
+
+   /* blocks already in order: nothing to merge */
+   if (my_rank < partner) {
+      if (local_A[local_n-1] <= temp_B[0]) return 0;
+      Merge_low(local_A, local_n, temp_B, recv_n, temp_C);
+   } else {
+      if (local_A[0] >= temp_B[recv_n-1]) return 0;
+      Merge_high(local_A, local_n, temp_B, recv_n, temp_C);
+   }
+   return 1;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low: keep the my_n smallest of my_keys U recv_keys
+ */
+void Merge_low(int my_keys[], int my_n, int recv_keys[], int recv_n,
+               int temp_keys[]) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < my_n) {
+      if (r_i >= recv_n || my_keys[m_i] <= recv_keys[r_i])
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, my_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high: keep the my_n largest of my_keys U recv_keys
+ */
+void Merge_high(int my_keys[], int my_n, int recv_keys[], int recv_n,
+                int temp_keys[]) {
+
+   int ai = my_n-1;
+   int bi = recv_n-1;
+   int ci = my_n-1;
+
+   while (ci >= 0) {
+      if (bi < 0 || my_keys[ai] >= recv_keys[bi])
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, my_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_sorted: local order plus first key of the right neighbour
+ *    (empty blocks are only at the end, so the neighbour is enough)
+ *    Returns 1 on every rank if the distributed list is sorted.
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   int next_first = 0, next_n = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   MPI_Sendrecv(&local_n, 1, MPI_INT, left, 2,
+                &next_n, 1, MPI_INT, right, 2, comm, MPI_STATUS_IGNORE);
+   MPI_Sendrecv(local_A, local_n > 0 ? 1 : 0, MPI_INT, left, 1,
+                &next_first, next_n > 0 ? 1 : 0, MPI_INT, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (local_n > 0 && next_n > 0 && local_A[local_n-1] > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_file: every process reads its Block_range slice of fname back
+ *    in pieces of CHECK_BUF keys and checks the header count, the
+ *    order inside and across slices and the sum of the keys.
+ *    Returns 1 on every rank if fname holds the sorted input.
+ */
+int Check_file(char* fname, long long global_n, long long key_sum,
+         int my_rank, int p, MPI_Comm comm) {
+
+   MPI_File fh;
+   long long first, sum = 0, total;
+   int local_n, local_ok = 1, ok;
+   int first_key = 0, last_key = 0, next_first = 0, next_n = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+   int *buf = malloc(CHECK_BUF*sizeof(int));
+
+   if (MPI_File_open(comm, fname, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh)
+         != MPI_SUCCESS) {
+      if (my_rank == 0) fprintf(stderr, "Can't open %s\n", fname);
+      MPI_Abort(comm, 1);
+   }
+   if (Read_header(fh, my_rank, comm) != global_n) local_ok = 0;
+
+   Block_range(global_n, my_rank, p, &first, &local_n);
+   for (int done = 0; done < local_n; ) {
+      int len = (local_n - done < CHECK_BUF) ? local_n - done : CHECK_BUF;
+      MPI_File_read_at(fh, HEADER_BYTES + (first + done) * sizeof(int),
+            buf, len, MPI_INT, MPI_STATUS_IGNORE);
+      if (done == 0) first_key = last_key = buf[0];
+      for (int i = 0; i < len; i++) {
+         if (buf[i] < last_key) local_ok = 0;
+         last_key = buf[i];
+         sum += buf[i];
+      }
+      done += len;
+   }
+   MPI_File_close(&fh);
+   free(buf);
+
+   MPI_Sendrecv(&local_n, 1, MPI_INT, left, 2,
+                &next_n, 1, MPI_INT, right, 2, comm, MPI_STATUS_IGNORE);
+   MPI_Sendrecv(&first_key, local_n > 0 ? 1 : 0, MPI_INT, left, 1,
+                &next_first, next_n > 0 ? 1 : 0, MPI_INT, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (local_n > 0 && next_n > 0 && last_key > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&sum, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok && total == key_sum;
+}
@@ -0,0 +1,791 @@
+/*
+ * File:     mpi_odd_even_ooc.c
+ * Purpose:  Out-of-core parallel sort of a binary key file (same format
+ *           as mpi_odd_even_io.c) that may be larger than the memory
+ *           of all processes together.
+ *
+ *           Pass 1 (run formation), for each run of p*mem_keys keys:
+ *              - every process reads its block of the run (MPI-IO)
+ *              - the run is sorted with the in-memory odd-even sort
+ *              - every process cuts its sorted block at the global
+ *                splitters and sends each piece to the process that
+ *                owns that key range (MPI_Alltoallv); the pieces
+ *                arrive in rank order, so they are already sorted
+ *              - the result is spilled to node-local scratch with a
+ *                nonblocking write that overlaps the next run
+ *           Pass 2 (merge): every process k-way merges its own spilled
+ *              runs with double-buffered nonblocking reads (read-ahead)
+ *              and writes the output with double-buffered nonblocking
+ *              writes (write-behind) at the MPI_Exscan of its counts.
+ *
+ *           Splitters come from a sample of the whole input file.
+ *           Keys equal to a splitter are divided between the two
+ *           neighbouring owners in the proportion the sample predicts,
+ *           so heavy duplicates (e.g. keys in [0, 100)) stay balanced.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_ooc mpi_odd_even_ooc.c -lm
+ * Run:      mpirun -np <p> ./mpi_odd_even_ooc <in> <out> <mem_keys> [scratch_dir]
+ *
+ * Notes:
+ * 1. mem_keys: keys per process per run; each process needs about
+ *    4*mem_keys ints of memory in pass 1 (block, odd-even buffers,
+ *    spill buffer)
+ * 2. scratch_dir should be node-local (default /tmp); the run files
+ *    are deleted when the merge finishes
+ * 3. Input files can be written with "mpi_odd_even_io w <file> <n>"
+ * 4. Before the timings are printed the output file is read back and
+ *    checked for order, key count and key sum (not timed)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/keygen.h"
+
+#define HEADER_BYTES 16
+#define SAMPLE_CHUNKS 16     /* sample reads per process            */
+#define SAMPLE_LEN 64        /* keys per sample read                */
+#define MERGE_BUF 65536      /* keys per read-ahead/write-behind buffer */
+const char MAGIC[8] = {'P','C','D','K','E','Y','S','1'};
+
+/* One spilled run during the merge */
+typedef struct {
+   MPI_File    fh;
+   long long   len;        /* keys in the run                  */
+   long long   next_off;   /* next key to request from disk    */
+   int*        buf[2];
+   int         buf_len[2];
+   int         cur;        /* buffer being consumed            */
+   int         pos;        /* position in buf[cur]             */
+   MPI_Request req;        /* read-ahead into buf[1-cur]       */
+} Run;
+
+/* Function prototypes */
+void Usage(char* program);
+void Get_args(int argc, char* argv[], int* mem_keys_p, int my_rank,
+          MPI_Comm comm);
+void Block_range(long long n, int my_rank, int p, long long* first_p,
+          int* local_n_p);
+long long Read_header(MPI_File fh, int my_rank, MPI_Comm comm);
+int  Compare(const void* a_p, const void* b_p);
+
+void Choose_splitters(MPI_File fh, long long global_n, int my_rank, int p,
+          MPI_Comm comm, int split_val[], double split_frac[]);
+void Split_block(int A[], int n, int split_val[], double split_frac[],
+          int p, int send_counts[]);
+long long Form_runs(MPI_File in_fh, long long global_n, int mem_keys,
+          char* scratch, int split_val[], double split_frac[],
+          long long run_len[], long long* key_sum_p, int my_rank, int p,
+          MPI_Comm comm);
+void Run_name(char* name, char* scratch, int my_rank, int run);
+void Merge_runs(char* out_name, long long global_n, long long my_total,
+          long long run_len[], int n_runs, char* scratch, int my_rank,
+          MPI_Comm comm);
+void Run_refill(Run* r);
+void Sift_down(int heap_key[], int heap_run[], int root, int size);
+
+void Sort(int local_A[], int local_n, long long run_n, int max_n,
+          int my_rank, int p, MPI_Comm comm);
+int  Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+          int local_n, int partner, int my_rank, MPI_Comm comm);
+void Merge_low(int my_keys[], int my_n, int recv_keys[], int recv_n,
+          int temp_keys[]);
+void Merge_high(int my_keys[], int my_n, int recv_keys[], int recv_n,
+          int temp_keys[]);
+int  Check_file(char* fname, long long global_n, long long key_sum,
+          int my_rank, int p, MPI_Comm comm);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p, mem_keys, n_runs;
+   long long global_n, my_total, max_total, min_total, my_sum, key_sum;
+   long long *run_len;
+   int *split_val;
+   double *split_frac;
+   char *scratch;
+   MPI_File in_fh;
+   MPI_Comm comm;
+   double t0, t1, t2, t_pass[2], t_max[2];
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &mem_keys, my_rank, comm);
+   scratch = (argc == 5) ? argv[4] : "/tmp";
+
+   if (MPI_File_open(comm, argv[1], MPI_MODE_RDONLY, MPI_INFO_NULL, &in_fh)
+         != MPI_SUCCESS) {
+      if (my_rank == 0) fprintf(stderr, "Can't open %s\n", argv[1]);
+      MPI_Abort(comm, 1);
+   }
+   global_n = Read_header(in_fh, my_rank, comm);
+   if (global_n < p) {
+      if (my_rank == 0) fprintf(stderr, "%s: bad header or n < p\n", argv[1]);
+      MPI_Abort(comm, 1);
+   }
+
+   n_runs = (int) ((global_n + (long long) p*mem_keys - 1)
+                   / ((long long) p*mem_keys));
+   run_len = malloc(n_runs*sizeof(long long));
+   split_val = malloc(p*sizeof(int));
+   split_frac = malloc(p*sizeof(double));
+
+   MPI_Barrier(comm);
+   t0 = MPI_Wtime();
+   Choose_splitters(in_fh, global_n, my_rank, p, comm, split_val,
+         split_frac);
+   my_total = Form_runs(in_fh, global_n, mem_keys, scratch, split_val,
+         split_frac, run_len, &my_sum, my_rank, p, comm);
+   MPI_File_close(&in_fh);
+   t1 = MPI_Wtime();
+   Merge_runs(argv[2], global_n, my_total, run_len, n_runs, scratch,
+         my_rank, comm);
+   t2 = MPI_Wtime();
+
+   t_pass[0] = t1 - t0;
+   t_pass[1] = t2 - t1;
+   MPI_Reduce(t_pass, t_max, 2, MPI_DOUBLE, MPI_MAX, 0, comm);
+   MPI_Reduce(&my_total, &max_total, 1, MPI_LONG_LONG, MPI_MAX, 0, comm);
+   MPI_Reduce(&my_total, &min_total, 1, MPI_LONG_LONG, MPI_MIN, 0, comm);
+
+   MPI_Allreduce(&my_sum, &key_sum, 1, MPI_LONG_LONG, MPI_SUM, comm);
+   int ok = Check_file(argv[2], global_n, key_sum, my_rank, p, comm);
+
+   if (my_rank == 0) {
+      double mb = global_n * sizeof(int) / 1.0e6;
+      printf("\n================ Timing results ================\n");
+      printf("p = %d, n = %lld keys (%.1f MB), %d run(s) of %lld keys\n",
+             p, global_n, mb, n_runs, (long long) p*mem_keys);
+      printf("Pass 1 (read, sort, spill) : %e seconds (%.1f MB/s)\n",
+             t_max[0], mb / t_max[0]);
+      printf("Pass 2 (merge, write)      : %e seconds (%.1f MB/s)\n",
+             t_max[1], mb / t_max[1]);
+      printf("Output keys per process    : max = %lld, min = %lld\n",
+             max_total, min_total);
+      printf("Output file check          : %s\n",
+             ok ? "sorted" : "NOT SORTED");
+      printf("================================================\n\n");
+   }
+
+   free(run_len);
+   free(split_val);
+   free(split_frac);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr,
+       "usage:  mpirun -np <p> %s <in> <out> <mem_keys> [scratch_dir]\n",
+       program);
+   fprintf(stderr, "   mem_keys: keys per process per run\n");
+   fprintf(stderr, "   scratch_dir: node-local directory (default /tmp)\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* mem_keys_p, int my_rank,
+         MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 4 && argc != 5) {
+         Usage(argv[0]);
+         *mem_keys_p = -1;
+      } else {
+         *mem_keys_p = atoi(argv[3]);
+         if (*mem_keys_p <= 0) Usage(argv[0]);
+      }
+   }
+
+   MPI_Bcast(mem_keys_p, 1, MPI_INT, 0, comm);
+
+   if (*mem_keys_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Block_range
+ * Purpose:    First key and number of keys of process my_rank in the
+ *             block distribution of n keys
+ */
+void Block_range(long long n, int my_rank, int p, long long* first_p,
+         int* local_n_p) {
+   long long div = n / p;
+   long long resto = n % p;
+
+   *local_n_p = (int) (div + (my_rank < resto ? 1 : 0));
+   *first_p = my_rank * div + (my_rank < resto ? my_rank : resto);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_header
+ * Purpose:    Process 0 reads and checks the header; n is broadcast
+ */
+long long Read_header(MPI_File fh, int my_rank, MPI_Comm comm) {
+   char header[HEADER_BYTES];
+   long long global_n = -1;
+
+   if (my_rank == 0) {
+      MPI_File_read_at(fh, 0, header, HEADER_BYTES, MPI_BYTE,
+            MPI_STATUS_IGNORE);
+      if (memcmp(header, MAGIC, sizeof(MAGIC)) == 0)
+         memcpy(&global_n, header + 8, sizeof(long long));
+   }
+   MPI_Bcast(&global_n, 1, MPI_LONG_LONG, 0, comm);
+   return global_n;
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparator
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Choose_splitters
+ * Purpose:    Sample the whole file and pick, for each boundary
+ *             q = 1..p-1 between owners q-1 and q, a value split_val[q]
+ *             and the fraction split_frac[q] of the keys equal to it
+ *             that still belong to the left owner
+ *    The boundary should fall at global rank q*n/p; in the sorted
+ *    sample that is position q*S/p, holding value v.  If the sample
+ *    has "less" keys < v and "eq" keys == v, the left owner takes
+ *    (q*S/p - less) / eq of the keys equal to v.
+ */
+void Choose_splitters(MPI_File fh, long long global_n, int my_rank, int p,
+         MPI_Comm comm, int split_val[], double split_frac[]) {
+
+   int len = (global_n < SAMPLE_LEN) ? (int) global_n : SAMPLE_LEN;
+   int local_s = SAMPLE_CHUNKS * len;
+   int total_s = p * local_s;
+   int *local_sample = malloc(local_s*sizeof(int));
+   int *sample = malloc(total_s*sizeof(int));
+
+   for (int c = 0; c < SAMPLE_CHUNKS; c++) {
+      /* sample offsets from keygen.h: no shared random() state */
+      uint32_t w[4];
+      Keygen_bits(KEYGEN_SEED, (long long) my_rank*SAMPLE_CHUNKS + c, w);
+      long long r = (long long) ((((uint64_t) w[0] << 32) | w[1]) >> 1);
+      long long off = r % (global_n - len + 1);
+      MPI_File_read_at(fh, HEADER_BYTES + off * sizeof(int),
+            local_sample + c*len, len, MPI_INT, MPI_STATUS_IGNORE);
+   }
+
+   MPI_Allgather(local_sample, local_s, MPI_INT, sample, local_s, MPI_INT,
+         comm);
+   qsort(sample, total_s, sizeof(int), Compare);
+
+   for (int q = 1; q < p; q++) {
+      long long target = (long long) q * total_s / p;
+      int v = sample[target < total_s ? target : total_s - 1];
+      int less = 0, eq = 0;
+      while (less < total_s && sample[less] < v) less++;
+      while (less + eq < total_s && sample[less + eq] == v) eq++;
+      split_val[q] = v;
+      split_frac[q] = (double) (target - less) / eq;
+   }
+
+   free(local_sample);
+   free(sample);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Split_block
+ * Purpose:    Cut the sorted block A[0..n) into p pieces by the
+ *             splitters; send_counts[q] is the size of owner q's piece
+ */
+void Split_block(int A[], int n, int split_val[], double split_frac[],
+         int p, int send_counts[]) {
+
+   int prev = 0;
+
+   for (int q = 1; q < p; q++) {
+      int lo = 0, hi = n, lt, le;
+
+      /* lt = first index with A[i] >= v */
+      while (lo < hi) {
+         int mid = lo + (hi - lo) / 2;
+         if (A[mid] < split_val[q]) lo = mid + 1; else hi = mid;
+      }
+      lt = lo;
+      /* le = first index with A[i] > v */
+      hi = n;
+      while (lo < hi) {
+         int mid = lo + (hi - lo) / 2;
+         if (A[mid] <= split_val[q]) lo = mid + 1; else hi = mid;
+      }
+      le = lo;
+
+      int bound = lt + (int) (split_frac[q] * (le - lt) + 0.5);
+      if (bound < prev) bound = prev;
+      send_counts[q-1] = bound - prev;
+      prev = bound;
+   }
+   send_counts[p-1] = n - prev;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Run_name
+ */
+void Run_name(char* name, char* scratch, int my_rank, int run) {
+   sprintf(name, "%s/ooc_rank%d_run%d.bin", scratch, my_rank, run);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Form_runs
+ * Purpose:    Pass 1: read, sort, route and spill every run
+ * Return:     total number of keys this process owns
+ *    run_len[k] receives the length of this process' spilled run k and
+ *    *key_sum_p the sum of the input keys this process read.
+ *    Two spill buffers alternate so that the nonblocking write of
+ *    run k overlaps reading and sorting run k+1.
+ */
+long long Form_runs(MPI_File in_fh, long long global_n, int mem_keys,
+         char* scratch, int split_val[], double split_frac[],
+         long long run_len[], long long* key_sum_p, int my_rank, int p,
+         MPI_Comm comm) {
+
+   long long run_total = (long long) p * mem_keys;
+   long long total = 0;
+   int n_runs = (int) ((global_n + run_total - 1) / run_total);
+   int *local_A = malloc(mem_keys*sizeof(int));
+   int *spill[2] = {NULL, NULL};
+   int spill_cap[2] = {0, 0};
+   MPI_File spill_fh[2];
+   MPI_Request spill_req[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+   int *send_counts = malloc(p*sizeof(int));
+   int *send_displs = malloc(p*sizeof(int));
+   int *recv_counts = malloc(p*sizeof(int));
+   int *recv_displs = malloc(p*sizeof(int));
+   char name[1024];
+
+   *key_sum_p = 0;
+   for (int k = 0; k < n_runs; k++) {
+      long long run_first = k * run_total;
+      long long run_n = (global_n - run_first < run_total)
+                      ? global_n - run_first : run_total;
+      long long first;
+      int local_n, recv_n = 0, b = k % 2;
+
+      /* 1. read this process' block of the run */
+      Block_range(run_n, my_rank, p, &first, &local_n);
+      MPI_File_read_at_all(in_fh,
+            HEADER_BYTES + (run_first + first) * sizeof(int),
+            local_A, local_n, MPI_INT, MPI_STATUS_IGNORE);
+      for (int i = 0; i < local_n; i++)
+         *key_sum_p += local_A[i];
+
+      /* 2. in-memory distributed sort of the run */
+      Sort(local_A, local_n, run_n, mem_keys, my_rank, p, comm);
+
+      /* 3. route pieces to their owners */
+      Split_block(local_A, local_n, split_val, split_frac, p, send_counts);
+      MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+      send_displs[0] = recv_displs[0] = 0;
+      for (int q = 1; q < p; q++) {
+         send_displs[q] = send_displs[q-1] + send_counts[q-1];
+         recv_displs[q] = recv_displs[q-1] + recv_counts[q-1];
+      }
+      recv_n = recv_displs[p-1] + recv_counts[p-1];
+
+      /* the buffer of run k-2 may still be in flight */
+      if (spill_req[b] != MPI_REQUEST_NULL) {
+         MPI_Wait(&spill_req[b], MPI_STATUS_IGNORE);
+         MPI_File_close(&spill_fh[b]);
+      }
+      if (recv_n > spill_cap[b]) {
+         free(spill[b]);
+         spill[b] = malloc(recv_n*sizeof(int));
+         spill_cap[b] = recv_n;
+      }
+      MPI_Alltoallv(local_A, send_counts, send_displs, MPI_INT,
+                    spill[b], recv_counts, recv_displs, MPI_INT, comm);
+
+      /* 4. write-behind to node-local scratch */
+      Run_name(name, scratch, my_rank, k);
+      if (MPI_File_open(MPI_COMM_SELF, name,
+               MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+               &spill_fh[b]) != MPI_SUCCESS) {
+         fprintf(stderr, "Proc %d: can't create %s\n", my_rank, name);
+         MPI_Abort(comm, 1);
+      }
+      MPI_File_iwrite_at(spill_fh[b], 0, spill[b], recv_n, MPI_INT,
+            &spill_req[b]);
+      run_len[k] = recv_n;
+      total += recv_n;
+   }
+
+   for (int b = 0; b < 2; b++) {
+      if (spill_req[b] != MPI_REQUEST_NULL) {
+         MPI_Wait(&spill_req[b], MPI_STATUS_IGNORE);
+         MPI_File_close(&spill_fh[b]);
+      }
+      free(spill[b]);
+   }
+   free(local_A);
+   free(send_counts); free(send_displs);
+   free(recv_counts); free(recv_displs);
+   return total;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Run_refill
+ * Purpose:    Switch r to its read-ahead buffer once the current one is
+ *             used up, and start reading the next chunk into the
+ *             buffer just released
+ */
+void Run_refill(Run* r) {
+   MPI_Wait(&r->req, MPI_STATUS_IGNORE);
+   r->cur = 1 - r->cur;
+   r->pos = 0;
+
+   int other = 1 - r->cur;
+   long long left = r->len - r->next_off;
+   r->buf_len[other] = (left < MERGE_BUF) ? (int) left : MERGE_BUF;
+   if (r->buf_len[other] > 0) {
+      MPI_File_iread_at(r->fh, r->next_off * sizeof(int), r->buf[other],
+            r->buf_len[other], MPI_INT, &r->req);
+      r->next_off += r->buf_len[other];
+   } else {
+      r->req = MPI_REQUEST_NULL;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Sift_down
+ * Purpose:    Restore the min-heap below root (keys with their runs)
+ */
+void Sift_down(int heap_key[], int heap_run[], int root, int size) {
+   int child, tk, tr;
+
+   while ((child = 2*root + 1) < size) {
+      if (child + 1 < size && heap_key[child+1] < heap_key[child]) child++;
+      if (heap_key[root] <= heap_key[child]) break;
+      tk = heap_key[root]; heap_key[root] = heap_key[child]; heap_key[child] = tk;
+      tr = heap_run[root]; heap_run[root] = heap_run[child]; heap_run[child] = tr;
+      root = child;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Merge_runs
+ * Purpose:    Pass 2: k-way merge of this process' runs into the
+ *             output file, at the exclusive prefix sum of my_total
+ */
+void Merge_runs(char* out_name, long long global_n, long long my_total,
+         long long run_len[], int n_runs, char* scratch, int my_rank,
+         MPI_Comm comm) {
+
+   Run *runs = malloc(n_runs*sizeof(Run));
+   int *heap_key = malloc(n_runs*sizeof(int));
+   int *heap_run = malloc(n_runs*sizeof(int));
+   int *out_buf[2];
+   int out_len = 0, ob = 0, size = 0;
+   long long first = 0, written = 0;
+   MPI_Request out_req[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+   MPI_File out_fh;
+   char name[1024];
+
+   out_buf[0] = malloc(MERGE_BUF*sizeof(int));
+   out_buf[1] = malloc(MERGE_BUF*sizeof(int));
+
+   MPI_Exscan(&my_total, &first, 1, MPI_LONG_LONG, MPI_SUM, comm);
+   if (my_rank == 0) first = 0;   /* Exscan leaves rank 0 undefined */
+
+   if (MPI_File_open(comm, out_name, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+            MPI_INFO_NULL, &out_fh) != MPI_SUCCESS) {
+      if (my_rank == 0) fprintf(stderr, "Can't create %s\n", out_name);
+      MPI_Abort(comm, 1);
+   }
+   MPI_File_set_size(out_fh, HEADER_BYTES + global_n * sizeof(int));
+   if (my_rank == 0) {
+      char header[HEADER_BYTES];
+      memcpy(header, MAGIC, sizeof(MAGIC));
+      memcpy(header + 8, &global_n, sizeof(long long));
+      MPI_File_write_at(out_fh, 0, header, HEADER_BYTES, MPI_BYTE,
+            MPI_STATUS_IGNORE);
+   }
+
+   /* open every run, read its first chunk, start its read-ahead */
+   for (int k = 0; k < n_runs; k++) {
+      Run* r = &runs[k];
+      Run_name(name, scratch, my_rank, k);
+      MPI_File_open(MPI_COMM_SELF, name,
+            MPI_MODE_RDONLY | MPI_MODE_DELETE_ON_CLOSE, MPI_INFO_NULL,
+            &r->fh);
+      r->len = run_len[k];
+      r->buf[0] = malloc(MERGE_BUF*sizeof(int));
+      r->buf[1] = malloc(MERGE_BUF*sizeof(int));
+      r->cur = 1;
+      r->next_off = 0;
+      r->buf_len[0] = r->buf_len[1] = 0;
+      r->req = MPI_REQUEST_NULL;
+      Run_refill(r);   /* starts reading chunk 0 */
+      Run_refill(r);   /* waits for chunk 0, starts reading chunk 1 */
+      if (r->buf_len[r->cur] > 0) {
+         heap_key[size] = r->buf[r->cur][0];
+         heap_run[size] = k;
+         size++;
+      }
+   }
+   for (int i = size/2 - 1; i >= 0; i--)
+      Sift_down(heap_key, heap_run, i, size);
+
+   while (size > 0) {
+      Run* r = &runs[heap_run[0]];
+
+      out_buf[ob][out_len++] = heap_key[0];
+      if (out_len == MERGE_BUF) {
+         /* write-behind: buffer 1-ob must be free before reuse */
+         MPI_File_iwrite_at(out_fh,
+               HEADER_BYTES + (first + written) * sizeof(int),
+               out_buf[ob], out_len, MPI_INT, &out_req[ob]);
+         written += out_len;
+         ob = 1 - ob;
+         MPI_Wait(&out_req[ob], MPI_STATUS_IGNORE);
+         out_len = 0;
+      }
+
+      if (++r->pos == r->buf_len[r->cur])
+         Run_refill(r);
+      if (r->pos < r->buf_len[r->cur]) {
+         heap_key[0] = r->buf[r->cur][r->pos];
+      } else {
+         size--;
+         heap_key[0] = heap_key[size];
+         heap_run[0] = heap_run[size];
+      }
+      Sift_down(heap_key, heap_run, 0, size);
+   }
+
+   if (out_len > 0)
+      MPI_File_write_at(out_fh, HEADER_BYTES + (first + written) * sizeof(int),
+            out_buf[ob], out_len, MPI_INT, MPI_STATUS_IGNORE);
+   MPI_Wait(&out_req[1-ob], MPI_STATUS_IGNORE);
+   MPI_File_close(&out_fh);
+
+   for (int k = 0; k < n_runs; k++) {
+      MPI_File_close(&runs[k].fh);
+      free(runs[k].buf[0]);
+      free(runs[k].buf[1]);
+   }
+   free(runs);
+   free(heap_key);
+   free(heap_run);
+   free(out_buf[0]);
+   free(out_buf[1]);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort of one run of run_n keys
+ *    Blocks may differ by one key; max_n bounds any process' block.
+ *    Only processes with keys (0..n_active-1; the last run can be
+ *    shorter than p) take part.  With equal blocks n_active phases
+ *    sort the run; with unequal ones pairs of phases repeat until an
+ *    MPI_Allreduce reports that no process changed its keys.
+ */
+void Sort(int local_A[], int local_n, long long run_n, int max_n,
+         int my_rank, int p, MPI_Comm comm) {
+
+   int phase, partner;
+   int n_active = (run_n < p) ? (int) run_n : p;
+   int equal = (run_n % p == 0 || run_n < p);
+
+   if (my_rank >= n_active) {
+      /* no keys: only the termination checks below */
+      int changed = 0, any = 1;
+      if (!equal)
+         while (any)
+            MPI_Allreduce(&changed, &any, 1, MPI_INT, MPI_LOR, comm);
+      return;
+   }
+
+   int even_partner, odd_partner;
+   int *temp_B = malloc(max_n*sizeof(int));
+   int *temp_C = malloc(max_n*sizeof(int));
+
+   if (my_rank % 2 != 0) {
+      even_partner = my_rank - 1;
+      odd_partner = my_rank + 1;
+      if (odd_partner == n_active) odd_partner = MPI_PROC_NULL;
+   } else {
+      even_partner = my_rank + 1;
+      if (even_partner == n_active) even_partner = MPI_PROC_NULL;
+      odd_partner = my_rank - 1;
+   }
+
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   if (equal) {
+      for (phase = 0; phase < n_active; phase++) {
+         partner = (phase % 2 == 0) ? even_partner : odd_partner;
+         if (partner >= 0)
+            Odd_even_iter(local_A, temp_B, temp_C, local_n, partner,
+                          my_rank, comm);
+      }
+   } else {
+      int any = 1;
+      while (any) {
+         int changed = 0;
+         for (phase = 0; phase < 2; phase++) {
+            partner = (phase == 0) ? even_partner : odd_partner;
+            if (partner >= 0)
+               changed |= Odd_even_iter(local_A, temp_B, temp_C, local_n,
+                                        partner, my_rank, comm);
+         }
+         MPI_Allreduce(&changed, &any, 1, MPI_INT, MPI_LOR, comm);
+      }
+   }
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Odd_even_iter: one exchange with partner
+ *    Returns 1 if local_A changed.
+ */
+int Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+        int local_n, int partner, int my_rank, MPI_Comm comm) {
+
+   MPI_Status status;
+   int recv_n;
+
+   MPI_Sendrecv(&local_n, 1, MPI_INT, partner, 1,
+                &recv_n, 1, MPI_INT, partner, 1, comm, &status);
+   MPI_Sendrecv(local_A, local_n, MPI_INT, partner, 0,
+                temp_B, recv_n, MPI_INT, partner, 0, comm, &status);
+
+   /* blocks already in order: nothing to merge */
+   if (my_rank < partner) {
+      if (local_A[local_n-1] <= temp_B[0]) return 0;
+      Merge_low(local_A, local_n, temp_B, recv_n, temp_C);
+   } else {
+      if (local_A[0] >= temp_B[recv_n-1]) return 0;
+      Merge_high(local_A, local_n, temp_B, recv_n, temp_C);
+   }
+   return 1;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low: keep the my_n smallest of my_keys U recv_keys
+ */
+void Merge_low(int my_keys[], int my_n, int recv_keys[], int recv_n,
+               int temp_keys[]) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < my_n) {
+      if (r_i >= recv_n || my_keys[m_i] <= recv_keys[r_i])
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, my_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high: keep the my_n largest of my_keys U recv_keys
+ */
+void Merge_high(int my_keys[], int my_n, int recv_keys[], int recv_n,
+                int temp_keys[]) {
+
+   int ai = my_n-1;
+   int bi = recv_n-1;
+   int ci = my_n-1;
+
+   while (ci >= 0) {
+      if (bi < 0 || my_keys[ai] >= recv_keys[bi])
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, my_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_file: every process reads its Block_range slice of fname back
+ *    in pieces of MERGE_BUF keys and checks the header count, the
+ *    order inside and across slices and the sum of the keys.
+ *    Returns 1 on every rank if fname holds the sorted input.
+ */
+int Check_file(char* fname, long long global_n, long long key_sum,
+         int my_rank, int p, MPI_Comm comm) {
+
+   MPI_File fh;
+   long long first, sum = 0, total;
+   int local_n, local_ok = 1, ok;
+   int first_key = 0, last_key = 0, next_first = 0, next_n = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+   int *buf = malloc(MERGE_BUF*sizeof(int));
+
+   if (MPI_File_open(comm, fname, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh)
+         != MPI_SUCCESS) {
+      if (my_rank == 0) fprintf(stderr, "Can't open %s\n", fname);
+      MPI_Abort(comm, 1);
+   }
+   if (Read_header(fh, my_rank, comm) != global_n) local_ok = 0;
+
+   Block_range(global_n, my_rank, p, &first, &local_n);
+   for (int done = 0; done < local_n; ) {
+      int len = (local_n - done < MERGE_BUF) ? local_n - done : MERGE_BUF;
+      MPI_File_read_at(fh, HEADER_BYTES + (first + done) * sizeof(int),
+            buf, len, MPI_INT, MPI_STATUS_IGNORE);
+      if (done == 0) first_key = last_key = buf[0];
+      for (int i = 0; i < len; i++) {
+         if (buf[i] < last_key) local_ok = 0;
+         last_key = buf[i];
+         sum += buf[i];
+      }
+      done += len;
+   }
+   MPI_File_close(&fh);
+   free(buf);
+
+   MPI_Sendrecv(&local_n, 1, MPI_INT, left, 2,
+                &next_n, 1, MPI_INT, right, 2, comm, MPI_STATUS_IGNORE);
+   MPI_Sendrecv(&first_key, local_n > 0 ? 1 : 0, MPI_INT, left, 1,
+                &next_first, next_n > 0 ? 1 : 0, MPI_INT, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (local_n > 0 && next_n > 0 && last_key > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&sum, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok && total == key_sum;
+}
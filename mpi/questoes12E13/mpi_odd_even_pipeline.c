@@ -0,0 +1,570 @@
+/*
+ * File:     mpi_odd_even_pipeline.c
+ * Purpose:  Parallel odd-even sort with a pipelined exchange-and-merge.
+ *           In each phase the partner's block arrives in fixed-size
+ *           chunks (MPI_Isend/MPI_Irecv), and the merge consumes each
+ *           chunk as soon as it lands:
+ *           - Merge_low consumes the partner's keys from the front, so
+ *             the high partner sends its block front-to-back;
+ *           - Merge_high consumes them from the back, so the low
+ *             partner sends its block back-to-front.
+ *           Each repetition runs the blocking sort (MPI_Sendrecv, as in
+ *           mpi_odd_even_time.c) and the pipelined sort on the same
+ *           input, so the output shows how much of the exchange is
+ *           hidden behind the merge.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_pipeline mpi_odd_even_pipeline.c -lm
+ * Run:      mpirun -np <p> ./mpi_odd_even_pipeline <g|i> <global_n> [chunk]
+ *
+ * Notes:
+ * 1. global_n must be divisible by p
+ * 2. chunk is the number of keys per message (default CHUNK_DEFAULT);
+ *    it is clamped to local_n
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+
+#define REPS 5                 /* Number of repetitions for timing */
+#define CHUNK_DEFAULT 65536    /* Keys per message in the pipeline  */
+const int RMAX = 100;
+
+/* Per-sort communication counters */
+typedef struct {
+   double comm;    /* time blocked in MPI (Sendrecv or Wait) */
+   double total;   /* time spent in the phase loop           */
+} Phase_times;
+
+/* Function prototypes */
+void Usage(char* program);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n);
+int  Compare(const void* a_p, const void* b_p);
+
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+              int* chunk_p, char* gi_p, int my_rank, int p, MPI_Comm comm);
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Find_partners(int my_rank, int p, int* even_partner_p,
+          int* odd_partner_p);
+
+void Sort_blocking(int local_A[], int local_n, int my_rank,
+          int p, MPI_Comm comm, Phase_times* t_p);
+void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n);
+void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n);
+
+void Sort_pipelined(int local_A[], int local_n, int chunk, int my_rank,
+          int p, MPI_Comm comm, Phase_times* t_p);
+void Pipelined_iter(int local_A[], int temp_B[], int temp_C[],
+          MPI_Request reqs[], int local_n, int chunk, int partner,
+          int keep_low, MPI_Comm comm, double* comm_p);
+void Merge_low_chunked(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n, int chunk, MPI_Request recv_reqs[],
+          double* wait_p);
+void Merge_high_chunked(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n, int chunk, MPI_Request recv_reqs[],
+          double* wait_p);
+
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Print_stats(char* title, double times[], int reps);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char g_i;
+   int *local_A, *input;
+   int global_n, local_n, chunk;
+   MPI_Comm comm;
+   double blk_times[REPS], pip_times[REPS];
+   double blk_comm = 0.0, pip_wait = 0.0;
+   Phase_times t;
+   int ok = 1;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &local_n, &chunk, &g_i, my_rank, p,
+         comm);
+
+   local_A = (int*) malloc(local_n * sizeof(int));
+   input   = (int*) malloc(local_n * sizeof(int));
+   if (local_A == NULL || input == NULL) {
+      fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+      MPI_Abort(comm, 1);
+   }
+
+   for (int rep = 0; rep < REPS; rep++) {
+
+      /* regenerate input data each repetition */
+      if (g_i == 'g')
+         Generate_list(input, local_n, my_rank, global_n);
+      else
+         Read_list(input, local_n, my_rank, p, comm);
+
+      /* Blocking exchange (reference) */
+      memcpy(local_A, input, local_n * sizeof(int));
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+      Sort_blocking(local_A, local_n, my_rank, p, comm, &t);
+      MPI_Barrier(comm);
+      blk_times[rep] = MPI_Wtime() - start;
+      blk_comm += t.comm;
+      ok &= Check_sorted(local_A, local_n, my_rank, p, comm);
+
+      /* Pipelined exchange on the same input */
+      memcpy(local_A, input, local_n * sizeof(int));
+      MPI_Barrier(comm);
+      start = MPI_Wtime();
+      Sort_pipelined(local_A, local_n, chunk, my_rank, p, comm, &t);
+      MPI_Barrier(comm);
+      pip_times[rep] = MPI_Wtime() - start;
+      pip_wait += t.comm;
+      ok &= Check_sorted(local_A, local_n, my_rank, p, comm);
+   }
+
+   /* Exposed communication: slowest rank, averaged over repetitions */
+   double max_blk_comm, max_pip_wait;
+   blk_comm /= REPS;
+   pip_wait /= REPS;
+   MPI_Reduce(&blk_comm, &max_blk_comm, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+   MPI_Reduce(&pip_wait, &max_pip_wait, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+   if (my_rank == 0) {
+      printf("\np = %d, global_n = %d, chunk = %d keys (%d chunks/phase)\n",
+            p, global_n, chunk, (local_n + chunk - 1) / chunk);
+      Print_stats("Blocking exchange (MPI_Sendrecv)", blk_times, REPS);
+      Print_stats("Pipelined exchange (chunked MPI_Irecv)", pip_times,
+            REPS);
+
+      printf("Exchange time, blocking  : %e seconds (max over ranks)\n",
+            max_blk_comm);
+      printf("Exposed wait, pipelined  : %e seconds (max over ranks)\n",
+            max_pip_wait);
+      if (max_blk_comm > 0.0)
+         printf("Exchange hidden by merge : %.1f%%\n",
+               100.0 * (1.0 - max_pip_wait / max_blk_comm));
+      printf("Result check             : %s\n\n", ok ? "sorted" : "NOT SORTED");
+   }
+
+   free(local_A);
+   free(input);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_list
+ * Purpose:    Fill list with this process' block of the global list
+ *             (keygen.h, uniform in [0, RMAX), the same for every p)
+ */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, 'u', RMAX, KEYGEN_SEED);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n> [chunk]\n",
+       program);
+   fprintf(stderr, "   global_n must be divisible by p\n");
+   fprintf(stderr, "   chunk: keys per message (default %d)\n",
+       CHUNK_DEFAULT);
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         int* chunk_p, char* gi_p, int my_rank, int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 3 && argc != 4) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *gi_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         *chunk_p = (argc == 4) ? atoi(argv[3]) : CHUNK_DEFAULT;
+         if (*global_n_p % p != 0 || *chunk_p <= 0) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+   MPI_Bcast(chunk_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p/p;
+   if (*chunk_p > *local_n_p)
+      *chunk_p = *local_n_p;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_list
+ */
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int *temp = NULL;
+
+   if (my_rank == 0) {
+      temp = (int*) malloc(p*local_n*sizeof(int));
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (int i = 0; i < p*local_n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatter(temp, local_n, MPI_INT,
+               local_A, local_n, MPI_INT, 0, comm);
+
+   if (my_rank == 0)
+      free(temp);
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparator
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Find_partners: even/odd phase partners (MPI_PROC_NULL at the ends)
+ */
+void Find_partners(int my_rank, int p, int* even_partner_p,
+         int* odd_partner_p) {
+
+   if (my_rank % 2 != 0) {
+      *even_partner_p = my_rank - 1;
+      *odd_partner_p = my_rank + 1;
+      if (*odd_partner_p == p) *odd_partner_p = MPI_PROC_NULL;
+   } else {
+      *even_partner_p = my_rank + 1;
+      if (*even_partner_p == p) *even_partner_p = MPI_PROC_NULL;
+      *odd_partner_p = my_rank - 1;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort_blocking: odd-even transposition sort, whole-block exchange
+ */
+void Sort_blocking(int local_A[], int local_n, int my_rank,
+         int p, MPI_Comm comm, Phase_times* t_p) {
+
+   int phase, partner;
+   int even_partner, odd_partner;
+   int *temp_B = malloc(local_n*sizeof(int));
+   int *temp_C = malloc(local_n*sizeof(int));
+   MPI_Status status;
+
+   Find_partners(my_rank, p, &even_partner, &odd_partner);
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   t_p->comm = 0.0;
+   double start = MPI_Wtime();
+   for (phase = 0; phase < p; phase++) {
+      partner = (phase % 2 == 0) ? even_partner : odd_partner;
+      if (partner < 0) continue;
+
+      double c0 = MPI_Wtime();
+      MPI_Sendrecv(local_A, local_n, MPI_INT, partner, 0,
+                   temp_B, local_n, MPI_INT, partner, 0,
+                   comm, &status);
+      t_p->comm += MPI_Wtime() - c0;
+
+      if (my_rank < partner)
+         Merge_low(local_A, temp_B, temp_C, local_n);
+      else
+         Merge_high(local_A, temp_B, temp_C, local_n);
+   }
+   t_p->total = MPI_Wtime() - start;
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low
+ */
+void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
+               int local_n) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < local_n) {
+      if (my_keys[m_i] <= recv_keys[r_i])
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high
+ */
+void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
+                int local_n) {
+
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+
+   while (ci >= 0) {
+      if (my_keys[ai] >= recv_keys[bi])
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort_pipelined: odd-even transposition sort, chunked exchange
+ *    The request array holds n_chunks receives followed by n_chunks
+ *    sends and is reused by every phase.
+ */
+void Sort_pipelined(int local_A[], int local_n, int chunk, int my_rank,
+         int p, MPI_Comm comm, Phase_times* t_p) {
+
+   int phase, partner;
+   int even_partner, odd_partner;
+   int n_chunks = (local_n + chunk - 1) / chunk;
+   int *temp_B = malloc(local_n*sizeof(int));
+   int *temp_C = malloc(local_n*sizeof(int));
+   MPI_Request *reqs = malloc(2*n_chunks*sizeof(MPI_Request));
+
+   Find_partners(my_rank, p, &even_partner, &odd_partner);
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   t_p->comm = 0.0;
+   double start = MPI_Wtime();
+   for (phase = 0; phase < p; phase++) {
+      partner = (phase % 2 == 0) ? even_partner : odd_partner;
+      if (partner < 0) continue;
+
+      Pipelined_iter(local_A, temp_B, temp_C, reqs, local_n, chunk,
+            partner, my_rank < partner, comm, &t_p->comm);
+   }
+   t_p->total = MPI_Wtime() - start;
+
+   free(reqs);
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Pipelined_iter: one phase of the pipelined exchange-and-merge
+ *    keep_low != 0: this rank keeps the smaller keys, so it merges
+ *       from the front and its partner (Merge_high) needs our keys
+ *       from the back.
+ *    Chunk k of the block covers [k*chunk, (k+1)*chunk) in the
+ *    front-to-back order and the mirror range in back-to-front order.
+ *    All messages use tag 0; MPI's non-overtaking rule keeps them in
+ *    posting order.
+ */
+void Pipelined_iter(int local_A[], int temp_B[], int temp_C[],
+         MPI_Request reqs[], int local_n, int chunk, int partner,
+         int keep_low, MPI_Comm comm, double* comm_p) {
+
+   int n_chunks = (local_n + chunk - 1) / chunk;
+   MPI_Request *recv_reqs = reqs;
+   MPI_Request *send_reqs = reqs + n_chunks;
+
+   for (int k = 0; k < n_chunks; k++) {
+      int lo = k * chunk;
+      int len = (lo + chunk <= local_n) ? chunk : local_n - lo;
+      /* we receive in the order our merge consumes ... */
+      int r_off = keep_low ? lo : local_n - lo - len;
+      /* ... and send in the order the partner's merge consumes */
+      int s_off = keep_low ? local_n - lo - len : lo;
+
+      MPI_Irecv(temp_B + r_off, len, MPI_INT, partner, 0, comm,
+            &recv_reqs[k]);
+      MPI_Isend(local_A + s_off, len, MPI_INT, partner, 0, comm,
+            &send_reqs[k]);
+   }
+
+   if (keep_low)
+      Merge_low_chunked(local_A, temp_B, temp_C, local_n, chunk,
+            recv_reqs, comm_p);
+   else
+      Merge_high_chunked(local_A, temp_B, temp_C, local_n, chunk,
+            recv_reqs, comm_p);
+
+   /* local_A may only be overwritten once the partner has all of it */
+   double c0 = MPI_Wtime();
+   MPI_Waitall(n_chunks, send_reqs, MPI_STATUSES_IGNORE);
+   *comm_p += MPI_Wtime() - c0;
+
+   memcpy(local_A, temp_C, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low_chunked
+ *    Same result as Merge_low, but recv_keys[0..avail) is the only
+ *    part known to have arrived; the inner loop runs branch-for-branch
+ *    like Merge_low until it either fills temp_keys or needs
+ *    recv_keys[avail], then waits for the next chunk.
+ *    Chunks the merge never reached are still drained at the end.
+ */
+void Merge_low_chunked(int my_keys[], int recv_keys[], int temp_keys[],
+         int local_n, int chunk, MPI_Request recv_reqs[],
+         double* wait_p) {
+
+   int n_chunks = (local_n + chunk - 1) / chunk;
+   int m_i = 0, r_i = 0, t_i = 0;
+   int next = 0, avail = 0;
+   double c0;
+
+   while (t_i < local_n) {
+      if (r_i == avail) {
+         c0 = MPI_Wtime();
+         MPI_Wait(&recv_reqs[next++], MPI_STATUS_IGNORE);
+         *wait_p += MPI_Wtime() - c0;
+         avail = (avail + chunk <= local_n) ? avail + chunk : local_n;
+      }
+      while (t_i < local_n && r_i < avail) {
+         if (my_keys[m_i] <= recv_keys[r_i])
+            temp_keys[t_i++] = my_keys[m_i++];
+         else
+            temp_keys[t_i++] = recv_keys[r_i++];
+      }
+   }
+
+   c0 = MPI_Wtime();
+   MPI_Waitall(n_chunks - next, recv_reqs + next, MPI_STATUSES_IGNORE);
+   *wait_p += MPI_Wtime() - c0;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high_chunked
+ *    Mirror of Merge_low_chunked: recv_keys[lo_avail..local_n) has
+ *    arrived, and the merge walks down from the back.
+ */
+void Merge_high_chunked(int my_keys[], int recv_keys[], int temp_keys[],
+         int local_n, int chunk, MPI_Request recv_reqs[],
+         double* wait_p) {
+
+   int n_chunks = (local_n + chunk - 1) / chunk;
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+   int next = 0, lo_avail = local_n;
+   double c0;
+
+   while (ci >= 0) {
+      if (bi < lo_avail) {
+         c0 = MPI_Wtime();
+         MPI_Wait(&recv_reqs[next++], MPI_STATUS_IGNORE);
+         *wait_p += MPI_Wtime() - c0;
+         lo_avail = (lo_avail - chunk >= 0) ? lo_avail - chunk : 0;
+      }
+      while (ci >= 0 && bi >= lo_avail) {
+         if (my_keys[ai] >= recv_keys[bi])
+            temp_keys[ci--] = my_keys[ai--];
+         else
+            temp_keys[ci--] = recv_keys[bi--];
+      }
+   }
+
+   c0 = MPI_Wtime();
+   MPI_Waitall(n_chunks - next, recv_reqs + next, MPI_STATUSES_IGNORE);
+   *wait_p += MPI_Wtime() - c0;
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_sorted: local order plus first key of the right neighbour
+ *    Returns 1 on every rank if the distributed list is sorted.
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   int next_first = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   MPI_Sendrecv(&local_A[0], 1, MPI_INT, left, 1,
+                &next_first, 1, MPI_INT, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL && local_A[local_n-1] > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Print_stats: min, mean, median of times[] (sorts times in place)
+ */
+void Print_stats(char* title, double times[], int reps) {
+
+   for (int i = 0; i < reps-1; i++)
+      for (int j = i+1; j < reps; j++)
+         if (times[j] < times[i]) {
+            double tmp = times[i];
+            times[i] = times[j];
+            times[j] = tmp;
+         }
+
+   double mean = 0.0;
+   for (int i = 0; i < reps; i++)
+      mean += times[i];
+   mean /= reps;
+
+   double median =
+      (reps % 2 == 1) ? times[reps/2]
+                      : (times[reps/2 - 1] + times[reps/2]) / 2.0;
+
+   printf("\n================ %s ================\n", title);
+   printf("Repetitions: %d\n", reps);
+   printf("Minimum time : %e seconds\n", times[0]);
+   printf("Mean time    : %e seconds\n", mean);
+   printf("Median time  : %e seconds\n", median);
+   printf("================================================\n\n");
+}
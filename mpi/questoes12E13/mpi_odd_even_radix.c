@@ -0,0 +1,634 @@
+/*
+ * File:     mpi_odd_even_radix.c
+ * Purpose:  Parallel odd-even sort with a choice of local sort kernel,
+ *           timed as in mpi_odd_even_time.c (min, mean, median), with
+ *           the local sort step timed on its own:
+ *           - q: qsort with the Compare callback (original program)
+ *           - s: introsort with inlined int compares (the algorithm
+ *                behind C++ std::sort)
+ *           - r: integer kernel chosen from a sampled key range:
+ *                counting sort for small ranges, LSD radix sort
+ *                (4 x 8-bit digits) for full-range 32-bit keys
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_radix mpi_odd_even_radix.c -lm
+ * Run:      mpirun -np <p> ./mpi_odd_even_radix <g|i> <global_n> [q|s|r] [rmax]
+ *
+ * Notes:
+ * 1. global_n must be divisible by p
+ * 2. rmax is the key range used by Generate_list (default RMAX);
+ *    rmax = 0 generates full-range 32-bit keys
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+
+#define REPS 5               /* Number of repetitions for timing      */
+#define SAMPLE_SIZE 1024     /* Keys sampled to estimate the range    */
+#define COUNT_MAX_RANGE (1 << 20)  /* Largest range for counting sort */
+#define INSERTION_MAX 16     /* Introsort switches to insertion sort  */
+const int RMAX = 100;
+
+/* Function prototypes */
+void Usage(char* program);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n,
+          int rmax);
+int  Compare(const void* a_p, const void* b_p);
+
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+              char* gi_p, char* kernel_p, int* rmax_p, int my_rank, int p,
+              MPI_Comm comm);
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Sort(int local_A[], int local_n, char kernel, int my_rank,
+          int p, MPI_Comm comm, double* local_time_p);
+void Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+          int local_n, int phase, int even_partner, int odd_partner,
+          int my_rank, MPI_Comm comm);
+void Merge_low(int local_A[], int temp_B[], int temp_C[], int local_n);
+void Merge_high(int local_A[], int temp_B[], int temp_C[], int local_n);
+
+/* Local sort kernels */
+void Local_sort(int A[], int temp[], int n, char kernel);
+void Int_sort(int A[], int temp[], int n);
+void Counting_sort(int A[], int n, int min, int max);
+void Radix_sort(int A[], int temp[], int n);
+void Intro_sort(int A[], int n, int depth);
+void Insertion_sort(int A[], int n);
+void Heap_sort(int A[], int n);
+void Sift_down(int A[], int root, int end);
+
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Print_stats(char* title, double times[], int reps);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char g_i, kernel;
+   int *local_A;
+   int global_n, local_n, rmax;
+   MPI_Comm comm;
+   double times[REPS];       /* whole sort, slowest rank       */
+   double local_times[REPS]; /* local sort step, slowest rank  */
+   int ok = 1;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &local_n, &g_i, &kernel, &rmax,
+         my_rank, p, comm);
+
+   local_A = (int*) malloc(local_n * sizeof(int));
+   if (local_A == NULL) {
+      fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+      MPI_Abort(comm, 1);
+   }
+
+   for (int rep = 0; rep < REPS; rep++) {
+      double local_time;
+
+      /* regenerate input data each repetition */
+      if (g_i == 'g')
+         Generate_list(local_A, local_n, my_rank, global_n, rmax);
+      else
+         Read_list(local_A, local_n, my_rank, p, comm);
+
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+
+      Sort(local_A, local_n, kernel, my_rank, p, comm, &local_time);
+
+      MPI_Barrier(comm);
+      double finish = MPI_Wtime();
+
+      times[rep] = finish - start;
+      MPI_Reduce(&local_time, &local_times[rep], 1, MPI_DOUBLE, MPI_MAX,
+            0, comm);
+      ok &= Check_sorted(local_A, local_n, my_rank, p, comm);
+   }
+
+   if (my_rank == 0) {
+      if (rmax > 0)
+         printf("\np = %d, global_n = %d, kernel = %c, keys in [0, %d)\n",
+               p, global_n, kernel, rmax);
+      else
+         printf("\np = %d, global_n = %d, kernel = %c, full 32-bit keys\n",
+               p, global_n, kernel);
+      Print_stats("Timing results", times, REPS);
+      Print_stats("Local sort step", local_times, REPS);
+      printf("Result check: %s\n\n", ok ? "sorted" : "NOT SORTED");
+   }
+
+   free(local_A);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_list
+ * Purpose:    Fill list with this process' block of the global list
+ *             (keygen.h, the same for every p): ints in [0, rmax), or
+ *             full-range 32-bit ints when rmax == 0
+ */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n,
+      int rmax) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, rmax > 0 ? 'u' : 'f', rmax, KEYGEN_SEED);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr,
+       "usage:  mpirun -np <p> %s <g|i> <global_n> [q|s|r] [rmax]\n",
+       program);
+   fprintf(stderr, "   global_n must be divisible by p\n");
+   fprintf(stderr, "   q: qsort, s: introsort, r: counting/radix (default)\n");
+   fprintf(stderr, "   rmax: key range for g (default %d, 0 = full 32-bit)\n",
+       RMAX);
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, char* kernel_p, int* rmax_p, int my_rank, int p,
+         MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc < 3 || argc > 5) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *gi_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         *kernel_p = (argc >= 4) ? argv[3][0] : 'r';
+         *rmax_p = (argc >= 5) ? atoi(argv[4]) : RMAX;
+         if (*global_n_p % p != 0 || *rmax_p < 0 ||
+             (*kernel_p != 'q' && *kernel_p != 's' && *kernel_p != 'r')) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(kernel_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(rmax_p, 1, MPI_INT, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p/p;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_list
+ */
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int *temp = NULL;
+
+   if (my_rank == 0) {
+      temp = (int*) malloc(p*local_n*sizeof(int));
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (int i = 0; i < p*local_n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatter(temp, local_n, MPI_INT,
+               local_A, local_n, MPI_INT, 0, comm);
+
+   if (my_rank == 0)
+      free(temp);
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparator
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort
+ *    *local_time_p receives the time of the local sort step.
+ */
+void Sort(int local_A[], int local_n, char kernel, int my_rank,
+         int p, MPI_Comm comm, double* local_time_p) {
+
+   int phase;
+   int *temp_B = malloc(local_n*sizeof(int));
+   int *temp_C = malloc(local_n*sizeof(int));
+
+   int even_partner, odd_partner;
+
+   if (my_rank % 2 != 0) {
+      even_partner = my_rank - 1;
+      odd_partner = my_rank + 1;
+      if (odd_partner == p) odd_partner = MPI_PROC_NULL;
+   } else {
+      even_partner = my_rank + 1;
+      if (even_partner == p) even_partner = MPI_PROC_NULL;
+      odd_partner = my_rank - 1;
+   }
+
+   /* temp_B is free until the first exchange: radix uses it */
+   double start = MPI_Wtime();
+   Local_sort(local_A, temp_B, local_n, kernel);
+   *local_time_p = MPI_Wtime() - start;
+
+   for (phase = 0; phase < p; phase++) {
+      Odd_even_iter(local_A, temp_B, temp_C, local_n, phase,
+                    even_partner, odd_partner, my_rank, comm);
+   }
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Odd-even iteration
+ */
+void Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+        int local_n, int phase, int even_partner, int odd_partner,
+        int my_rank, MPI_Comm comm) {
+
+   MPI_Status status;
+
+   if (phase % 2 == 0) {
+      if (even_partner >= 0) {
+         MPI_Sendrecv(local_A, local_n, MPI_INT, even_partner, 0,
+                      temp_B, local_n, MPI_INT, even_partner, 0,
+                      comm, &status);
+
+         if (my_rank % 2 != 0)
+            Merge_high(local_A, temp_B, temp_C, local_n);
+         else
+            Merge_low(local_A, temp_B, temp_C, local_n);
+      }
+   } else {
+      if (odd_partner >= 0) {
+         MPI_Sendrecv(local_A, local_n, MPI_INT, odd_partner, 0,
+                      temp_B, local_n, MPI_INT, odd_partner, 0,
+                      comm, &status);
+
+         if (my_rank % 2 != 0)
+            Merge_low(local_A, temp_B, temp_C, local_n);
+         else
+            Merge_high(local_A, temp_B, temp_C, local_n);
+      }
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low
+ */
+void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
+               int local_n) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < local_n) {
+      if (my_keys[m_i] <= recv_keys[r_i])
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high
+ */
+void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
+                int local_n) {
+
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+
+   while (ci >= 0) {
+      if (my_keys[ai] >= recv_keys[bi])
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Local_sort: dispatch on the kernel letter
+ *    temp must have room for n ints (used by the radix kernel).
+ */
+void Local_sort(int A[], int temp[], int n, char kernel) {
+   int depth = 0;
+
+   switch (kernel) {
+      case 'q':
+         qsort(A, n, sizeof(int), Compare);
+         break;
+      case 's':
+         /* depth limit 2*log2(n), as in std::sort */
+         for (int m = n; m > 1; m >>= 1) depth += 2;
+         Intro_sort(A, n, depth);
+         break;
+      default:
+         Int_sort(A, temp, n);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Int_sort: pick counting or radix sort from a sampled key range
+ *    The sample only decides whether counting sort is worth a full
+ *    min/max pass; counting sort itself always uses the exact range.
+ */
+void Int_sort(int A[], int temp[], int n) {
+   int stride, min, max, i;
+
+   if (n < 2) return;
+
+   stride = (n > SAMPLE_SIZE) ? n / SAMPLE_SIZE : 1;
+   min = max = A[0];
+   for (i = 0; i < n; i += stride) {
+      if (A[i] < min) min = A[i];
+      if (A[i] > max) max = A[i];
+   }
+
+   if ((long long) max - min < COUNT_MAX_RANGE) {
+      for (i = 0; i < n; i++) {
+         if (A[i] < min) min = A[i];
+         if (A[i] > max) max = A[i];
+      }
+      /* counting sort pays off while the table is not much bigger
+         than the list itself */
+      if ((long long) max - min < COUNT_MAX_RANGE &&
+          (long long) max - min <= n) {
+         Counting_sort(A, n, min, max);
+         return;
+      }
+   }
+
+   Radix_sort(A, temp, n);
+}
+
+
+/*-------------------------------------------------------------------
+ * Counting_sort: keys in [min, max]
+ */
+void Counting_sort(int A[], int n, int min, int max) {
+   int range = max - min + 1;
+   int *count = calloc(range, sizeof(int));
+   int i, k, j = 0;
+
+   for (i = 0; i < n; i++)
+      count[A[i] - min]++;
+
+   for (k = 0; k < range; k++)
+      for (i = 0; i < count[k]; i++)
+         A[j++] = k + min;
+
+   free(count);
+}
+
+
+/*-------------------------------------------------------------------
+ * Radix_sort: LSD radix sort, 4 passes of 8 bits
+ *    - flipping the sign bit maps signed order onto unsigned order
+ *    - one read pass fills the histograms of all 4 digits; each digit
+ *      has 4 interleaved sub-histograms so that runs of equal digits
+ *      do not serialize on the same counter (the scalar form of
+ *      SIMD histogramming), and they are summed afterwards
+ *    - passes where every key has the same digit are skipped
+ */
+void Radix_sort(int A[], int temp[], int n) {
+   static unsigned hist[4][4][256];
+   unsigned count[4][256];
+   unsigned *src = (unsigned*) A, *dst = (unsigned*) temp, *swp;
+   int i, d, b;
+
+   memset(hist, 0, sizeof(hist));
+   for (i = 0; i + 4 <= n; i += 4) {
+      unsigned k0 = src[i]   ^ 0x80000000u;
+      unsigned k1 = src[i+1] ^ 0x80000000u;
+      unsigned k2 = src[i+2] ^ 0x80000000u;
+      unsigned k3 = src[i+3] ^ 0x80000000u;
+      for (d = 0; d < 4; d++) {
+         hist[d][0][(k0 >> 8*d) & 0xff]++;
+         hist[d][1][(k1 >> 8*d) & 0xff]++;
+         hist[d][2][(k2 >> 8*d) & 0xff]++;
+         hist[d][3][(k3 >> 8*d) & 0xff]++;
+      }
+   }
+   for (; i < n; i++) {
+      unsigned k = src[i] ^ 0x80000000u;
+      for (d = 0; d < 4; d++)
+         hist[d][0][(k >> 8*d) & 0xff]++;
+   }
+   for (d = 0; d < 4; d++)
+      for (b = 0; b < 256; b++)
+         count[d][b] = hist[d][0][b] + hist[d][1][b]
+                     + hist[d][2][b] + hist[d][3][b];
+
+   for (d = 0; d < 4; d++) {
+      unsigned sum = 0, c;
+      int shift = 8*d;
+
+      /* skip the pass if one bucket holds every key */
+      if (count[d][((src[0] ^ 0x80000000u) >> shift) & 0xff] == (unsigned) n)
+         continue;
+
+      for (b = 0; b < 256; b++) {
+         c = count[d][b];
+         count[d][b] = sum;
+         sum += c;
+      }
+      for (i = 0; i < n; i++) {
+         unsigned k = src[i];
+         dst[count[d][((k ^ 0x80000000u) >> shift) & 0xff]++] = k;
+      }
+      swp = src; src = dst; dst = swp;
+   }
+
+   if (src != (unsigned*) A)
+      memcpy(A, src, n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Intro_sort: median-of-3 quicksort, heapsort past the depth limit,
+ *    insertion sort for short ranges
+ */
+void Intro_sort(int A[], int n, int depth) {
+   int i, j, pivot, tmp, mid;
+
+   while (n > INSERTION_MAX) {
+      if (depth-- == 0) {
+         Heap_sort(A, n);
+         return;
+      }
+
+      /* order A[0], A[mid], A[n-1] and use the middle one */
+      mid = n / 2;
+      if (A[mid] < A[0])   { tmp = A[mid]; A[mid] = A[0];   A[0] = tmp; }
+      if (A[n-1] < A[0])   { tmp = A[n-1]; A[n-1] = A[0];   A[0] = tmp; }
+      if (A[n-1] < A[mid]) { tmp = A[n-1]; A[n-1] = A[mid]; A[mid] = tmp; }
+      pivot = A[mid];
+
+      i = 0;
+      j = n - 1;
+      for (;;) {
+         while (A[i] < pivot) i++;
+         while (pivot < A[j]) j--;
+         if (i >= j) break;
+         tmp = A[i]; A[i] = A[j]; A[j] = tmp;
+         i++;
+         j--;
+      }
+
+      /* recurse on the smaller side, loop on the larger */
+      if (j + 1 < n - j - 1) {
+         Intro_sort(A, j + 1, depth);
+         A += j + 1;
+         n -= j + 1;
+      } else {
+         Intro_sort(A + j + 1, n - j - 1, depth);
+         n = j + 1;
+      }
+   }
+   Insertion_sort(A, n);
+}
+
+
+/*-------------------------------------------------------------------
+ * Insertion_sort
+ */
+void Insertion_sort(int A[], int n) {
+   for (int i = 1; i < n; i++) {
+      int key = A[i];
+      int j = i - 1;
+      while (j >= 0 && A[j] > key) {
+         A[j+1] = A[j];
+         j--;
+      }
+      A[j+1] = key;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Sift_down: restore the max-heap property below root in A[0..end)
+ */
+void Sift_down(int A[], int root, int end) {
+   int child, tmp;
+
+   while ((child = 2*root + 1) < end) {
+      if (child + 1 < end && A[child] < A[child+1]) child++;
+      if (A[root] >= A[child]) break;
+      tmp = A[root]; A[root] = A[child]; A[child] = tmp;
+      root = child;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Heap_sort
+ */
+void Heap_sort(int A[], int n) {
+   int i, tmp;
+
+   for (i = n/2 - 1; i >= 0; i--)
+      Sift_down(A, i, n);
+   for (i = n - 1; i > 0; i--) {
+      tmp = A[0]; A[0] = A[i]; A[i] = tmp;
+      Sift_down(A, 0, i);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_sorted: local order plus first key of the right neighbour
+ *    Returns 1 on every rank if the distributed list is sorted.
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   int next_first = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   MPI_Sendrecv(&local_A[0], 1, MPI_INT, left, 1,
+                &next_first, 1, MPI_INT, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL && local_A[local_n-1] > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Print_stats: min, mean, median of times[] (sorts times in place)
+ */
+void Print_stats(char* title, double times[], int reps) {
+
+   for (int i = 0; i < reps-1; i++)
+      for (int j = i+1; j < reps; j++)
+         if (times[j] < times[i]) {
+            double tmp = times[i];
+            times[i] = times[j];
+            times[j] = tmp;
+         }
+
+   double mean = 0.0;
+   for (int i = 0; i < reps; i++)
+      mean += times[i];
+   mean /= reps;
+
+   double median =
+      (reps % 2 == 1) ? times[reps/2]
+                      : (times[reps/2 - 1] + times[reps/2]) / 2.0;
+
+   printf("\n================ %s ================\n", title);
+   printf("Repetitions: %d\n", reps);
+   printf("Minimum time : %e seconds\n", times[0]);
+   printf("Mean time    : %e seconds\n", mean);
+   printf("Median time  : %e seconds\n", median);
+   printf("================================================\n\n");
+}
@@ -0,0 +1,554 @@
+/*
+ * File:     mpi_odd_even_records.c
+ * Purpose:  Parallel odd-even sort of key-value records (64-bit key plus
+ *           a fixed-size payload), timed as in mpi_odd_even_time.c.
+ *           Two modes:
+ *           - r: whole records go through every phase, exchanged with
+ *                a committed MPI struct datatype
+ *           - k: only (key, source rank, source index) triples are
+ *                sorted; the payloads are then moved once, straight to
+ *                their final owner, with two MPI_Alltoallv calls
+ *           Throughput is reported in records/s and bytes/s.
+ *
+ * Compile:  mpicc -O2 -Wall [-DPAYLOAD_BYTES=<8..64>] -o mpi_odd_even_records mpi_odd_even_records.c -lm
+ * Run:      mpirun -np <p> ./mpi_odd_even_records <r|k> <global_n>
+ *
+ * Notes:
+ * 1. global_n must be divisible by p
+ * 2. Records are generated on each process; the payload is derived
+ *    from the key, so the final check also verifies that every
+ *    payload travelled with its key
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <mpi.h>
+#include "../include/keygen.h"
+
+#ifndef PAYLOAD_BYTES
+#define PAYLOAD_BYTES 56   /* record = 8-byte key + 56 bytes = 64 bytes */
+#endif
+#if PAYLOAD_BYTES < 8 || PAYLOAD_BYTES > 64
+#error "PAYLOAD_BYTES must be between 8 and 64"
+#endif
+
+#define REPS 5         /* Number of repetitions for timing */
+
+typedef struct {
+   long long key;
+   char      payload[PAYLOAD_BYTES];
+} Record;
+
+/* Sort key for mode k: where the record came from */
+typedef struct {
+   long long key;
+   int       src_rank;
+   int       src_idx;
+} Key_index;
+
+/* Function prototypes */
+void Usage(char* program);
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+              char* mode_p, int my_rank, int p, MPI_Comm comm);
+void Build_types(MPI_Datatype* record_type_p, MPI_Datatype* ki_type_p);
+void Generate_records(Record local_R[], int local_n, int my_rank,
+          int global_n);
+void Find_partners(int my_rank, int p, int* even_partner_p,
+          int* odd_partner_p);
+
+int  Compare_record(const void* a_p, const void* b_p);
+int  Compare_key_index(const void* a_p, const void* b_p);
+
+void Sort_records(Record local_R[], int local_n, MPI_Datatype record_type,
+          int my_rank, int p, MPI_Comm comm);
+void Merge_low_records(Record my_recs[], Record recv_recs[],
+          Record temp_recs[], int local_n);
+void Merge_high_records(Record my_recs[], Record recv_recs[],
+          Record temp_recs[], int local_n);
+
+void Sort_key_index(Record local_R[], int local_n, MPI_Datatype ki_type,
+          MPI_Datatype record_type, int my_rank, int p, MPI_Comm comm);
+void Merge_low_ki(Key_index my_keys[], Key_index recv_keys[],
+          Key_index temp_keys[], int local_n);
+void Merge_high_ki(Key_index my_keys[], Key_index recv_keys[],
+          Key_index temp_keys[], int local_n);
+void Permute_records(Record local_R[], Key_index keys[], int local_n,
+          MPI_Datatype record_type, int p, MPI_Comm comm);
+
+int  Check_records(Record local_R[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Print_stats(double times[], int reps, int global_n);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char mode;
+   Record *local_R;
+   int global_n, local_n;
+   MPI_Comm comm;
+   MPI_Datatype record_type, ki_type;
+   double times[REPS];
+   int ok = 1;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &local_n, &mode, my_rank, p, comm);
+   Build_types(&record_type, &ki_type);
+
+   local_R = (Record*) malloc(local_n * sizeof(Record));
+   if (local_R == NULL) {
+      fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+      MPI_Abort(comm, 1);
+   }
+
+   for (int rep = 0; rep < REPS; rep++) {
+
+      Generate_records(local_R, local_n, my_rank, global_n);
+
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+
+      if (mode == 'r')
+         Sort_records(local_R, local_n, record_type, my_rank, p, comm);
+      else
+         Sort_key_index(local_R, local_n, ki_type, record_type,
+               my_rank, p, comm);
+
+      MPI_Barrier(comm);
+      double finish = MPI_Wtime();
+
+      times[rep] = finish - start;
+      ok &= Check_records(local_R, local_n, my_rank, p, comm);
+   }
+
+   if (my_rank == 0) {
+      printf("\np = %d, global_n = %d, mode = %s, record = %d bytes "
+             "(payload %d)\n", p, global_n,
+             mode == 'r' ? "whole records" : "key/index + permute",
+             (int) sizeof(Record), PAYLOAD_BYTES);
+      Print_stats(times, REPS, global_n);
+      printf("Result check: %s\n\n", ok ? "sorted, payloads intact"
+                                        : "FAILED");
+   }
+
+   free(local_R);
+   MPI_Type_free(&record_type);
+   MPI_Type_free(&ki_type);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <r|k> <global_n>\n",
+       program);
+   fprintf(stderr, "   r: move whole records every phase\n");
+   fprintf(stderr, "   k: sort key/index pairs, then permute payloads\n");
+   fprintf(stderr, "   global_n must be divisible by p\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* mode_p, int my_rank, int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 3) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *mode_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         if (*global_n_p % p != 0 || (*mode_p != 'r' && *mode_p != 'k')) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(mode_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p/p;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Build_types
+ * Purpose:    Commit MPI struct datatypes matching Record and
+ *             Key_index, resized to sizeof() so that arrays of them
+ *             can be sent with count = n
+ */
+void Build_types(MPI_Datatype* record_type_p, MPI_Datatype* ki_type_p) {
+   MPI_Datatype tmp;
+
+   int          r_lens[2]  = {1, PAYLOAD_BYTES};
+   MPI_Aint     r_displs[2] = {offsetof(Record, key),
+                               offsetof(Record, payload)};
+   MPI_Datatype r_types[2] = {MPI_LONG_LONG, MPI_BYTE};
+
+   MPI_Type_create_struct(2, r_lens, r_displs, r_types, &tmp);
+   MPI_Type_create_resized(tmp, 0, sizeof(Record), record_type_p);
+   MPI_Type_commit(record_type_p);
+   MPI_Type_free(&tmp);
+
+   int          k_lens[2]  = {1, 2};
+   MPI_Aint     k_displs[2] = {offsetof(Key_index, key),
+                               offsetof(Key_index, src_rank)};
+   MPI_Datatype k_types[2] = {MPI_LONG_LONG, MPI_INT};
+
+   MPI_Type_create_struct(2, k_lens, k_displs, k_types, &tmp);
+   MPI_Type_create_resized(tmp, 0, sizeof(Key_index), ki_type_p);
+   MPI_Type_commit(ki_type_p);
+   MPI_Type_free(&tmp);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_records
+ * Purpose:    Full-range 64-bit keys from keygen.h (this process' block
+ *             of the global list, the same for every p); payload byte
+ *             i is (key + i) so the pairing can be checked after the
+ *             sort
+ */
+void Generate_records(Record local_R[], int local_n, int my_rank,
+      int global_n) {
+   for (int i = 0; i < local_n; i++) {
+      long long key = Keygen_key((long long) my_rank*local_n + i,
+            global_n, 'f', 0, KEYGEN_SEED);
+      local_R[i].key = key;
+      for (int b = 0; b < PAYLOAD_BYTES; b++)
+         local_R[i].payload[b] = (char) (key + b);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparators
+ */
+int Compare_record(const void* a_p, const void* b_p) {
+   long long a = ((const Record*) a_p)->key;
+   long long b = ((const Record*) b_p)->key;
+   return (a > b) - (a < b);
+}
+
+int Compare_key_index(const void* a_p, const void* b_p) {
+   long long a = ((const Key_index*) a_p)->key;
+   long long b = ((const Key_index*) b_p)->key;
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Find_partners: even/odd phase partners (MPI_PROC_NULL at the ends)
+ */
+void Find_partners(int my_rank, int p, int* even_partner_p,
+         int* odd_partner_p) {
+
+   if (my_rank % 2 != 0) {
+      *even_partner_p = my_rank - 1;
+      *odd_partner_p = my_rank + 1;
+      if (*odd_partner_p == p) *odd_partner_p = MPI_PROC_NULL;
+   } else {
+      *even_partner_p = my_rank + 1;
+      if (*even_partner_p == p) *even_partner_p = MPI_PROC_NULL;
+      *odd_partner_p = my_rank - 1;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort_records: odd-even transposition sort of whole records
+ */
+void Sort_records(Record local_R[], int local_n, MPI_Datatype record_type,
+         int my_rank, int p, MPI_Comm comm) {
+
+   int phase, partner, even_partner, odd_partner;
+   Record *temp_B = malloc(local_n*sizeof(Record));
+   Record *temp_C = malloc(local_n*sizeof(Record));
+
+   Find_partners(my_rank, p, &even_partner, &odd_partner);
+   qsort(local_R, local_n, sizeof(Record), Compare_record);
+
+   for (phase = 0; phase < p; phase++) {
+      partner = (phase % 2 == 0) ? even_partner : odd_partner;
+      if (partner < 0) continue;
+
+      MPI_Sendrecv(local_R, local_n, record_type, partner, 0,
+                   temp_B, local_n, record_type, partner, 0,
+                   comm, MPI_STATUS_IGNORE);
+      if (my_rank < partner)
+         Merge_low_records(local_R, temp_B, temp_C, local_n);
+      else
+         Merge_high_records(local_R, temp_B, temp_C, local_n);
+   }
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low_records
+ */
+void Merge_low_records(Record my_recs[], Record recv_recs[],
+         Record temp_recs[], int local_n) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < local_n) {
+      if (my_recs[m_i].key <= recv_recs[r_i].key)
+         temp_recs[t_i++] = my_recs[m_i++];
+      else
+         temp_recs[t_i++] = recv_recs[r_i++];
+   }
+
+   memcpy(my_recs, temp_recs, local_n*sizeof(Record));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high_records
+ */
+void Merge_high_records(Record my_recs[], Record recv_recs[],
+         Record temp_recs[], int local_n) {
+
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+
+   while (ci >= 0) {
+      if (my_recs[ai].key >= recv_recs[bi].key)
+         temp_recs[ci--] = my_recs[ai--];
+      else
+         temp_recs[ci--] = recv_recs[bi--];
+   }
+
+   memcpy(my_recs, temp_recs, local_n*sizeof(Record));
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort_key_index: sort 16-byte (key, rank, index) triples with the
+ *    odd-even sort, then move each payload once to its final place
+ */
+void Sort_key_index(Record local_R[], int local_n, MPI_Datatype ki_type,
+         MPI_Datatype record_type, int my_rank, int p, MPI_Comm comm) {
+
+   int phase, partner, even_partner, odd_partner;
+   Key_index *keys   = malloc(local_n*sizeof(Key_index));
+   Key_index *temp_B = malloc(local_n*sizeof(Key_index));
+   Key_index *temp_C = malloc(local_n*sizeof(Key_index));
+
+   for (int i = 0; i < local_n; i++) {
+      keys[i].key = local_R[i].key;
+      keys[i].src_rank = my_rank;
+      keys[i].src_idx = i;
+   }
+
+   Find_partners(my_rank, p, &even_partner, &odd_partner);
+   qsort(keys, local_n, sizeof(Key_index), Compare_key_index);
+
+   for (phase = 0; phase < p; phase++) {
+      partner = (phase % 2 == 0) ? even_partner : odd_partner;
+      if (partner < 0) continue;
+
+      MPI_Sendrecv(keys, local_n, ki_type, partner, 0,
+                   temp_B, local_n, ki_type, partner, 0,
+                   comm, MPI_STATUS_IGNORE);
+      if (my_rank < partner)
+         Merge_low_ki(keys, temp_B, temp_C, local_n);
+      else
+         Merge_high_ki(keys, temp_B, temp_C, local_n);
+   }
+
+   free(temp_B);
+   free(temp_C);
+
+   Permute_records(local_R, keys, local_n, record_type, p, comm);
+   free(keys);
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low_ki
+ */
+void Merge_low_ki(Key_index my_keys[], Key_index recv_keys[],
+         Key_index temp_keys[], int local_n) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < local_n) {
+      if (my_keys[m_i].key <= recv_keys[r_i].key)
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(Key_index));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high_ki
+ */
+void Merge_high_ki(Key_index my_keys[], Key_index recv_keys[],
+         Key_index temp_keys[], int local_n) {
+
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+
+   while (ci >= 0) {
+      if (my_keys[ai].key >= recv_keys[bi].key)
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(Key_index));
+}
+
+
+/*-------------------------------------------------------------------
+ * Permute_records: fetch the records named by keys[] into local_R
+ *    1. group the wanted source indices by source rank
+ *    2. MPI_Alltoall the counts, MPI_Alltoallv the indices
+ *    3. every rank packs the requested records in request order
+ *    4. MPI_Alltoallv the records back and drop each one into the
+ *       final position that asked for it
+ */
+void Permute_records(Record local_R[], Key_index keys[], int local_n,
+         MPI_Datatype record_type, int p, MPI_Comm comm) {
+
+   int *want_counts = calloc(p, sizeof(int));
+   int *want_displs = malloc(p*sizeof(int));
+   int *give_counts = malloc(p*sizeof(int));
+   int *give_displs = malloc(p*sizeof(int));
+   int *next        = malloc(p*sizeof(int));
+   int *want_idx    = malloc(local_n*sizeof(int));
+   int *dest_pos    = malloc(local_n*sizeof(int));
+   int *give_idx    = malloc(local_n*sizeof(int));
+   Record *out_recs = malloc(local_n*sizeof(Record));
+   Record *in_recs  = malloc(local_n*sizeof(Record));
+   int q, i;
+
+   for (i = 0; i < local_n; i++)
+      want_counts[keys[i].src_rank]++;
+   want_displs[0] = 0;
+   for (q = 1; q < p; q++)
+      want_displs[q] = want_displs[q-1] + want_counts[q-1];
+
+   memcpy(next, want_displs, p*sizeof(int));
+   for (i = 0; i < local_n; i++) {
+      int slot = next[keys[i].src_rank]++;
+      want_idx[slot] = keys[i].src_idx;
+      dest_pos[slot] = i;
+   }
+
+   MPI_Alltoall(want_counts, 1, MPI_INT, give_counts, 1, MPI_INT, comm);
+   give_displs[0] = 0;
+   for (q = 1; q < p; q++)
+      give_displs[q] = give_displs[q-1] + give_counts[q-1];
+
+   MPI_Alltoallv(want_idx, want_counts, want_displs, MPI_INT,
+                 give_idx, give_counts, give_displs, MPI_INT, comm);
+
+   /* every rank gives away exactly local_n records */
+   for (i = 0; i < local_n; i++)
+      out_recs[i] = local_R[give_idx[i]];
+
+   MPI_Alltoallv(out_recs, give_counts, give_displs, record_type,
+                 in_recs, want_counts, want_displs, record_type, comm);
+
+   for (i = 0; i < local_n; i++)
+      local_R[dest_pos[i]] = in_recs[i];
+
+   free(want_counts); free(want_displs);
+   free(give_counts); free(give_displs);
+   free(next); free(want_idx); free(dest_pos); free(give_idx);
+   free(out_recs); free(in_recs);
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_records: keys sorted within and across processes, and every
+ *    payload still matches its key. Returns 1 on every rank if so.
+ */
+int Check_records(Record local_R[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   long long next_first = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 0; i < local_n; i++) {
+      if (i > 0 && local_R[i-1].key > local_R[i].key) local_ok = 0;
+      for (int b = 0; b < PAYLOAD_BYTES; b++)
+         if (local_R[i].payload[b] != (char) (local_R[i].key + b))
+            local_ok = 0;
+   }
+
+   MPI_Sendrecv(&local_R[0].key, 1, MPI_LONG_LONG, left, 1,
+                &next_first, 1, MPI_LONG_LONG, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL && local_R[local_n-1].key > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Print_stats: min, mean, median of times[] and throughput at the
+ *    minimum time (sorts times in place)
+ */
+void Print_stats(double times[], int reps, int global_n) {
+
+   for (int i = 0; i < reps-1; i++)
+      for (int j = i+1; j < reps; j++)
+         if (times[j] < times[i]) {
+            double tmp = times[i];
+            times[i] = times[j];
+            times[j] = tmp;
+         }
+
+   double mean = 0.0;
+   for (int i = 0; i < reps; i++)
+      mean += times[i];
+   mean /= reps;
+
+   double median =
+      (reps % 2 == 1) ? times[reps/2]
+                      : (times[reps/2 - 1] + times[reps/2]) / 2.0;
+
+   printf("\n================ Timing results ================\n");
+   printf("Repetitions: %d\n", reps);
+   printf("Minimum time : %e seconds\n", times[0]);
+   printf("Mean time    : %e seconds\n", mean);
+   printf("Median time  : %e seconds\n", median);
+   printf("Throughput   : %e records/s\n", global_n / times[0]);
+   printf("Throughput   : %e bytes/s\n",
+          (double) global_n * sizeof(Record) / times[0]);
+   printf("================================================\n\n");
+}
@@ -0,0 +1,514 @@
+/*
+ * File:     mpi_odd_even_shm.c
+ * Purpose:  Parallel odd-even sort where partners on the same node
+ *           merge straight out of each other's memory.
+ *           Every rank's block lives in an MPI_Win_allocate_shared
+ *           segment of its node.  In a phase:
+ *           - intra-node pair: the partners swap only their buffer
+ *             index (one int), merge from the partner's segment into
+ *             their own spare buffer, and handshake again so nobody
+ *             overwrites a block the partner is still reading;
+ *           - inter-node pair: the partner's block is copied with
+ *             MPI_Sendrecv, as in mpi_odd_even_time.c.
+ *           Each repetition runs the message-only sort and the
+ *           shared-memory sort on the same input.  Merges, bytes
+ *           copied and phase time are reported separately for intra-
+ *           and inter-node pairs.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_shm mpi_odd_even_shm.c -lm
+ * Run:      mpirun -np <p> ./mpi_odd_even_shm <g|i> <global_n>
+ *
+ * Notes:
+ * 1. global_n must be divisible by p
+ * 2. Each segment holds two blocks (current and spare) per rank, so
+ *    merges write their output in place of a memcpy back.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+
+#define REPS 5         /* Number of repetitions for timing */
+const int RMAX = 100;
+
+#define INTRA 0
+#define INTER 1
+
+/* Per-sort counters, indexed by INTRA/INTER */
+typedef struct {
+   long long merges[2];   /* phases with a partner          */
+   long long bytes[2];    /* bytes copied between partners  */
+   double    time[2];     /* handshake/exchange + merge     */
+} Pair_stats;
+
+/* Node-shared blocks */
+typedef struct {
+   MPI_Win  win;
+   int*     base;          /* my two blocks: base, base + local_n   */
+   int*     part_base[2];  /* even/odd partner's two blocks, or NULL */
+   int      partner[2];    /* even/odd partner (rank in comm)       */
+   int      local_n;
+} Shm_blocks;
+
+/* Function prototypes */
+void Usage(char* program);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n);
+int  Compare(const void* a_p, const void* b_p);
+
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+              char* gi_p, int my_rank, int p, MPI_Comm comm);
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Find_partners(int my_rank, int p, int* even_partner_p,
+          int* odd_partner_p);
+
+void Shm_init(Shm_blocks* s, int local_n, int my_rank, int p,
+          MPI_Comm comm, int* n_nodes_p);
+void Shm_free(Shm_blocks* s);
+int* Sort(Shm_blocks* s, int use_shm, int my_rank, int p,
+          MPI_Comm comm, Pair_stats* st);
+void Merge_low(int my_keys[], int part_keys[], int out_keys[],
+          int local_n);
+void Merge_high(int my_keys[], int part_keys[], int out_keys[],
+          int local_n);
+
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Print_stats(char* title, double times[], int reps);
+void Print_pairs(char* title, Pair_stats* st, MPI_Comm comm,
+          int my_rank);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p, n_nodes;
+   char g_i;
+   int *input, *sorted;
+   int global_n, local_n;
+   MPI_Comm comm;
+   Shm_blocks s;
+   Pair_stats msg_st, shm_st, st;
+   double msg_times[REPS], shm_times[REPS];
+   int ok = 1;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &local_n, &g_i, my_rank, p, comm);
+
+   input = (int*) malloc(local_n * sizeof(int));
+   if (input == NULL) {
+      fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+      MPI_Abort(comm, 1);
+   }
+   Shm_init(&s, local_n, my_rank, p, comm, &n_nodes);
+   memset(&msg_st, 0, sizeof(Pair_stats));
+   memset(&shm_st, 0, sizeof(Pair_stats));
+
+   for (int rep = 0; rep < REPS; rep++) {
+
+      /* regenerate input data each repetition */
+      if (g_i == 'g')
+         Generate_list(input, local_n, my_rank, global_n);
+      else
+         Read_list(input, local_n, my_rank, p, comm);
+
+      /* Message path for every pair (reference) */
+      memcpy(s.base, input, local_n * sizeof(int));
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+      sorted = Sort(&s, 0, my_rank, p, comm, &st);
+      MPI_Barrier(comm);
+      msg_times[rep] = MPI_Wtime() - start;
+      ok &= Check_sorted(sorted, local_n, my_rank, p, comm);
+      for (int k = INTRA; k <= INTER; k++) {
+         msg_st.merges[k] += st.merges[k];
+         msg_st.bytes[k]  += st.bytes[k];
+         msg_st.time[k]   += st.time[k];
+      }
+
+      /* Shared memory for same-node pairs, on the same input */
+      memcpy(s.base, input, local_n * sizeof(int));
+      MPI_Barrier(comm);
+      start = MPI_Wtime();
+      sorted = Sort(&s, 1, my_rank, p, comm, &st);
+      MPI_Barrier(comm);
+      shm_times[rep] = MPI_Wtime() - start;
+      ok &= Check_sorted(sorted, local_n, my_rank, p, comm);
+      for (int k = INTRA; k <= INTER; k++) {
+         shm_st.merges[k] += st.merges[k];
+         shm_st.bytes[k]  += st.bytes[k];
+         shm_st.time[k]   += st.time[k];
+      }
+   }
+
+   if (my_rank == 0) {
+      printf("\np = %d, global_n = %d, nodes = %d\n", p, global_n,
+            n_nodes);
+      Print_stats("Message path (MPI_Sendrecv)", msg_times, REPS);
+      Print_stats("Shared-memory path for intra-node pairs", shm_times,
+            REPS);
+   }
+   Print_pairs("Message path", &msg_st, comm, my_rank);
+   Print_pairs("Shared-memory path", &shm_st, comm, my_rank);
+   if (my_rank == 0)
+      printf("Result check : %s\n\n", ok ? "sorted" : "NOT SORTED");
+
+   Shm_free(&s);
+   free(input);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_list
+ * Purpose:    Fill list with this process' block of the global list
+ *             (keygen.h, uniform in [0, RMAX), the same for every p)
+ */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, 'u', RMAX, KEYGEN_SEED);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n>\n",
+       program);
+   fprintf(stderr, "   global_n must be divisible by p\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, int my_rank, int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 3) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *gi_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         if (*global_n_p % p != 0) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p/p;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_list
+ */
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int *temp = NULL;
+
+   if (my_rank == 0) {
+      temp = (int*) malloc(p*local_n*sizeof(int));
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (int i = 0; i < p*local_n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatter(temp, local_n, MPI_INT,
+               local_A, local_n, MPI_INT, 0, comm);
+
+   if (my_rank == 0)
+      free(temp);
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparator
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Find_partners: even/odd phase partners (MPI_PROC_NULL at the ends)
+ */
+void Find_partners(int my_rank, int p, int* even_partner_p,
+         int* odd_partner_p) {
+
+   if (my_rank % 2 != 0) {
+      *even_partner_p = my_rank - 1;
+      *odd_partner_p = my_rank + 1;
+      if (*odd_partner_p == p) *odd_partner_p = MPI_PROC_NULL;
+   } else {
+      *even_partner_p = my_rank + 1;
+      if (*even_partner_p == p) *even_partner_p = MPI_PROC_NULL;
+      *odd_partner_p = my_rank - 1;
+      if (*odd_partner_p < 0) *odd_partner_p = MPI_PROC_NULL;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Shm_init: allocate the node-shared blocks and map the partners'
+ *    The window stays in a lock_all epoch until Shm_free, so that
+ *    MPI_Win_sync can order the loads/stores around each handshake.
+ */
+void Shm_init(Shm_blocks* s, int local_n, int my_rank, int p,
+      MPI_Comm comm, int* n_nodes_p) {
+
+   MPI_Comm node_comm;
+   MPI_Group group, node_group;
+   MPI_Aint size;
+   int disp_unit, node_rank, node_partner, leader;
+
+   MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, my_rank,
+         MPI_INFO_NULL, &node_comm);
+   MPI_Comm_rank(node_comm, &node_rank);
+   leader = (node_rank == 0);
+   MPI_Allreduce(&leader, n_nodes_p, 1, MPI_INT, MPI_SUM, comm);
+
+   s->local_n = local_n;
+   MPI_Win_allocate_shared(2*(MPI_Aint)local_n*sizeof(int), sizeof(int),
+         MPI_INFO_NULL, node_comm, &s->base, &s->win);
+
+   Find_partners(my_rank, p, &s->partner[0], &s->partner[1]);
+   MPI_Comm_group(comm, &group);
+   MPI_Comm_group(node_comm, &node_group);
+   for (int k = 0; k < 2; k++) {
+      s->part_base[k] = NULL;
+      if (s->partner[k] == MPI_PROC_NULL) continue;
+      MPI_Group_translate_ranks(group, 1, &s->partner[k], node_group,
+            &node_partner);
+      if (node_partner != MPI_UNDEFINED)
+         MPI_Win_shared_query(s->win, node_partner, &size, &disp_unit,
+               &s->part_base[k]);
+   }
+   MPI_Group_free(&group);
+   MPI_Group_free(&node_group);
+   MPI_Comm_free(&node_comm);
+
+   MPI_Win_lock_all(MPI_MODE_NOCHECK, s->win);
+}
+
+
+/*-------------------------------------------------------------------
+ * Shm_free
+ */
+void Shm_free(Shm_blocks* s) {
+   MPI_Win_unlock_all(s->win);
+   MPI_Win_free(&s->win);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort of s->base[0..local_n-1]
+ *    Blocks alternate between s->base and s->base + local_n; the
+ *    return value is the one holding the sorted keys.
+ *    With use_shm == 0 every pair takes the message path.
+ */
+int* Sort(Shm_blocks* s, int use_shm, int my_rank, int p,
+      MPI_Comm comm, Pair_stats* st) {
+
+   int local_n = s->local_n;
+   int cur = 0, part_cur, phase, partner, kind;
+   int *mine, *theirs, *out;
+   int *temp_B = NULL;
+
+   memset(st, 0, sizeof(Pair_stats));
+   qsort(s->base, local_n, sizeof(int), Compare);
+
+   for (phase = 0; phase < p; phase++) {
+      partner = s->partner[phase % 2];
+      if (partner == MPI_PROC_NULL) continue;
+
+      mine = s->base + cur*local_n;
+      out  = s->base + (1-cur)*local_n;
+      kind = (s->part_base[phase % 2] != NULL) ? INTRA : INTER;
+
+      double start = MPI_Wtime();
+      if (use_shm && kind == INTRA) {
+         /* "my block is ready": publish stores, trade buffer index */
+         MPI_Win_sync(s->win);
+         MPI_Sendrecv(&cur, 1, MPI_INT, partner, 0,
+                      &part_cur, 1, MPI_INT, partner, 0,
+                      comm, MPI_STATUS_IGNORE);
+         MPI_Win_sync(s->win);
+         theirs = s->part_base[phase % 2] + part_cur*local_n;
+         st->bytes[kind] += sizeof(int);
+      } else {
+         if (temp_B == NULL)
+            temp_B = (int*) malloc(local_n*sizeof(int));
+         MPI_Sendrecv(mine, local_n, MPI_INT, partner, 0,
+                      temp_B, local_n, MPI_INT, partner, 0,
+                      comm, MPI_STATUS_IGNORE);
+         theirs = temp_B;
+         st->bytes[kind] += (long long) local_n*sizeof(int);
+      }
+
+      if (my_rank < partner)
+         Merge_low(mine, theirs, out, local_n);
+      else
+         Merge_high(mine, theirs, out, local_n);
+
+      if (use_shm && kind == INTRA) {
+         /* "done reading your block": it may be overwritten now */
+         MPI_Win_sync(s->win);
+         MPI_Sendrecv(NULL, 0, MPI_INT, partner, 1,
+                      NULL, 0, MPI_INT, partner, 1,
+                      comm, MPI_STATUS_IGNORE);
+         MPI_Win_sync(s->win);
+      }
+      st->time[kind] += MPI_Wtime() - start;
+      st->merges[kind]++;
+
+      cur = 1 - cur;
+   }
+
+   free(temp_B);
+   return s->base + cur*local_n;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low: smallest local_n keys of my_keys and part_keys
+ */
+void Merge_low(int my_keys[], int part_keys[], int out_keys[],
+               int local_n) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < local_n) {
+      if (my_keys[m_i] <= part_keys[r_i])
+         out_keys[t_i++] = my_keys[m_i++];
+      else
+         out_keys[t_i++] = part_keys[r_i++];
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high: largest local_n keys of my_keys and part_keys
+ */
+void Merge_high(int my_keys[], int part_keys[], int out_keys[],
+                int local_n) {
+
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+
+   while (ci >= 0) {
+      if (my_keys[ai] >= part_keys[bi])
+         out_keys[ci--] = my_keys[ai--];
+      else
+         out_keys[ci--] = part_keys[bi--];
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_sorted: local order plus first key of the right neighbour
+ *    Returns 1 on every rank if the distributed list is sorted.
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   int next_first = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   MPI_Sendrecv(&local_A[0], 1, MPI_INT, left, 1,
+                &next_first, 1, MPI_INT, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL && local_A[local_n-1] > next_first)
+      local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Print_stats: min, mean, median of times[] (sorts times in place)
+ */
+void Print_stats(char* title, double times[], int reps) {
+
+   for (int i = 0; i < reps-1; i++)
+      for (int j = i+1; j < reps; j++)
+         if (times[j] < times[i]) {
+            double tmp = times[i];
+            times[i] = times[j];
+            times[j] = tmp;
+         }
+
+   double mean = 0.0;
+   for (int i = 0; i < reps; i++)
+      mean += times[i];
+   mean /= reps;
+
+   double median =
+      (reps % 2 == 1) ? times[reps/2]
+                      : (times[reps/2 - 1] + times[reps/2]) / 2.0;
+
+   printf("\n================ %s ================\n", title);
+   printf("Repetitions: %d\n", reps);
+   printf("Minimum time : %e seconds\n", times[0]);
+   printf("Mean time    : %e seconds\n", mean);
+   printf("Median time  : %e seconds\n", median);
+   printf("================================================\n\n");
+}
+
+
+/*-------------------------------------------------------------------
+ * Print_pairs: per-repetition merges and bytes (summed over ranks)
+ *    and phase time (slowest rank), intra- vs inter-node pairs
+ */
+void Print_pairs(char* title, Pair_stats* st, MPI_Comm comm,
+      int my_rank) {
+
+   long long merges[2], bytes[2];
+   double time[2];
+   char* kind[2] = {"intra-node", "inter-node"};
+
+   MPI_Reduce(st->merges, merges, 2, MPI_LONG_LONG, MPI_SUM, 0, comm);
+   MPI_Reduce(st->bytes, bytes, 2, MPI_LONG_LONG, MPI_SUM, 0, comm);
+   MPI_Reduce(st->time, time, 2, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+   if (my_rank == 0) {
+      printf("%s, per repetition:\n", title);
+      for (int k = INTRA; k <= INTER; k++)
+         printf("   %s: %8lld merges, %e bytes copied, "
+               "%e seconds in phases\n", kind[k], merges[k] / REPS,
+               (double) bytes[k] / REPS, time[k] / REPS);
+   }
+}
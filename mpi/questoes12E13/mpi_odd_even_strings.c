@@ -0,0 +1,778 @@
+/*
+ * File:     mpi_odd_even_strings.c
+ * Purpose:  Parallel odd-even sort of variable-length strings.
+ *           Each process holds local_n strings packed in one char
+ *           buffer (NUL-terminated), an offset array and an LCP array
+ *           (lcp[i] = length of the common prefix of strings i-1, i).
+ *           - local sort: multikey quicksort (Bentley-Sedgewick),
+ *             which never re-reads a prefix already known to be equal,
+ *             then packing in sorted order and LCPs of neighbours
+ *           - exchange: byte count, packed chars, and offsets+LCPs as
+ *             one int array (three MPI_Sendrecv calls)
+ *           - Merge_low/Merge_high: LCP merge; the LCPs of the two
+ *             heads with the last string written decide most
+ *             comparisons, and a character comparison starts at the
+ *             common prefix length instead of at 0; the output LCP
+ *             array comes out of the merge for free
+ *           Each repetition also runs the sort with plain strcmp
+ *           merges on the same input, for comparison.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_strings mpi_odd_even_strings.c -lm
+ * Run:      mpirun -np <p> ./mpi_odd_even_strings <g|i> <global_n> [dist]
+ *
+ * Notes:
+ * 1. global_n must be divisible by p; every process keeps local_n
+ *    strings, the number of bytes varies
+ * 2. dist (for g), string i of the global list depends only on i:
+ *    l  log lines: "2024-05-17T<time> node-<host> <LEVEL> <words>",
+ *       40-102 bytes (mean about 65), long shared prefixes (default)
+ *    u  URLs: "https://www.example.com/" + 1-5 path words + "?id=<n>"
+ *    w  words of random letters, log-normal length (median 7)
+ * 3. i: process 0 reads global_n whitespace-separated strings
+ * 4. Strings are at most MAX_LEN bytes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "../include/keygen.h"
+
+#define REPS 5          /* Number of repetitions for timing */
+#define MAX_LEN 255     /* Longest string, without the NUL  */
+#define INS_CUTOFF 16   /* Insertion sort below this size   */
+
+/* Packed string list */
+typedef struct {
+   char* buf;     /* strings, each NUL-terminated              */
+   int*  idx;     /* 2*n ints: offsets, then LCPs              */
+   int*  off;     /* = idx: string i starts at buf + off[i]    */
+   int*  lcp;     /* = idx + n: lcp[0] = 0                     */
+   int   n;
+   int   bytes;   /* bytes used in buf                         */
+   int   cap;     /* bytes allocated for buf                   */
+} Str_list;
+
+/* Function prototypes */
+void Usage(char* program);
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+          char* gi_p, char* dist_p, int my_rank, int p, MPI_Comm comm);
+int  Gen_string(long long i, char dist, char s[]);
+void Generate_list(Str_list* L, int local_n, int my_rank, char dist);
+void Read_list(Str_list* L, int local_n, int my_rank, int p,
+          MPI_Comm comm);
+
+void List_init(Str_list* L, int n, int cap);
+void List_reserve(Str_list* L, int cap);
+void List_free(Str_list* L);
+void List_copy(Str_list* dst, Str_list* src);
+void Offsets_from_buf(Str_list* L);
+
+void Local_sort(Str_list* L, Str_list* tmp);
+void Mkqsort(char* s[], int n, int depth);
+void Ins_sort(char* s[], int n, int depth);
+
+void Sort(Str_list* L, int use_lcp, int my_rank, int p, MPI_Comm comm,
+          long long* sent_p);
+void Exchange(Str_list* L, Str_list* R, int partner, MPI_Comm comm);
+void Merge_low(Str_list* A, Str_list* B, Str_list* C);
+void Merge_high(Str_list* A, Str_list* B, Str_list* C);
+void Merge_low_plain(Str_list* A, Str_list* B, Str_list* C);
+void Merge_high_plain(Str_list* A, Str_list* B, Str_list* C);
+int  Lcp_from(const char* a, const char* b, int h);
+
+uint64_t Hash_list(Str_list* L);
+int  Check_sorted(Str_list* L, uint64_t in_hash, int my_rank, int p,
+          MPI_Comm comm);
+void Print_stats(char* title, double times[], int reps);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char g_i, dist;
+   int global_n, local_n;
+   Str_list input, L;
+   MPI_Comm comm;
+   double lcp_times[REPS], plain_times[REPS];
+   long long sent, bytes_in, lcp_sum, tot[3], my_tot[3];
+   uint64_t in_hash;
+   int ok = 1;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &local_n, &g_i, &dist, my_rank, p,
+         comm);
+
+   if (g_i == 'g')
+      Generate_list(&input, local_n, my_rank, dist);
+   else
+      Read_list(&input, local_n, my_rank, p, comm);
+   in_hash = Hash_list(&input);
+   List_init(&L, local_n, input.bytes);
+
+   for (int rep = 0; rep < REPS; rep++) {
+
+      /* LCP-aware merges */
+      List_copy(&L, &input);
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+      Sort(&L, 1, my_rank, p, comm, &sent);
+      MPI_Barrier(comm);
+      lcp_times[rep] = MPI_Wtime() - start;
+      ok &= Check_sorted(&L, in_hash, my_rank, p, comm);
+
+      /* strcmp merges on the same input */
+      List_copy(&L, &input);
+      MPI_Barrier(comm);
+      start = MPI_Wtime();
+      Sort(&L, 0, my_rank, p, comm, &sent);
+      MPI_Barrier(comm);
+      plain_times[rep] = MPI_Wtime() - start;
+      ok &= Check_sorted(&L, in_hash, my_rank, p, comm);
+   }
+
+   /* input size, bytes exchanged per sort, and mean LCP of the result */
+   bytes_in = input.bytes - input.n;   /* without the NULs */
+   lcp_sum = 0;
+   for (int i = 0; i < L.n; i++)
+      lcp_sum += L.lcp[i];
+   my_tot[0] = bytes_in; my_tot[1] = sent; my_tot[2] = lcp_sum;
+   MPI_Reduce(my_tot, tot, 3, MPI_LONG_LONG, MPI_SUM, 0, comm);
+
+   if (my_rank == 0) {
+      printf("\np = %d, global_n = %d, dist = %c\n", p, global_n, dist);
+      printf("Mean length: %.1f bytes, mean LCP of neighbours: %.1f\n",
+            (double) tot[0] / global_n, (double) tot[2] / global_n);
+      printf("Bytes exchanged per sort: %.3e\n", (double) tot[1]);
+      Print_stats("LCP merge", lcp_times, REPS);
+      Print_stats("strcmp merge", plain_times, REPS);
+      printf("Result check : %s\n\n", ok ? "sorted" : "NOT SORTED");
+   }
+
+   List_free(&input);
+   List_free(&L);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n> [dist]\n",
+       program);
+   fprintf(stderr, "   global_n must be divisible by p\n");
+   fprintf(stderr, "   dist: l log lines (default), u URLs, w words\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, char* dist_p, int my_rank, int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 3 && argc != 4) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *gi_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         *dist_p = (argc == 4) ? argv[3][0] : 'l';
+         if (*global_n_p % p != 0 || strchr("luw", *dist_p) == NULL) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(dist_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p/p;
+}
+
+
+/*-------------------------------------------------------------------
+ * Gen_string: string i of the global list in s[], returns its length
+ *    Fields come from independent Philox streams (seed + field).
+ */
+int Gen_string(long long i, char dist, char s[]) {
+
+   static const char* words[32] = {
+      "api", "auth", "cache", "cart", "checkout", "config", "db",
+      "events", "feed", "files", "health", "images", "index", "items",
+      "login", "logout", "metrics", "orders", "pay", "profile", "queue",
+      "search", "session", "settings", "static", "status", "stream",
+      "sync", "upload", "user", "v1", "v2"};
+   static const char* levels[16] = {
+      "INFO", "INFO", "INFO", "INFO", "INFO", "INFO", "INFO", "INFO",
+      "INFO", "INFO", "DEBUG", "DEBUG", "DEBUG", "WARN", "WARN", "ERROR"};
+   uint32_t w[4], v[4];
+   int len = 0, n_words;
+
+   Keygen_bits(KEYGEN_SEED, i, w);
+   Keygen_bits(KEYGEN_SEED + 1, i, v);
+
+   if (dist == 'l') {
+      /* host: Zipf-like over 64 nodes */
+      int host = (int) exp(Keygen_unit(w[2], w[3]) * log(65.0)) - 1;
+      int secs = w[0] % 86400;
+      len = snprintf(s, MAX_LEN + 1,
+            "2024-05-17T%02d:%02d:%02d.%03u node-%03d %s",
+            secs / 3600, secs / 60 % 60, secs % 60, w[1] % 1000, host,
+            levels[v[0] % 16]);
+      n_words = 1 + v[1] % 8;
+      for (int k = 0; k < n_words; k++)
+         len += snprintf(s + len, MAX_LEN + 1 - len, " %s",
+               words[(v[2 + k/4] >> (8*(k%4))) % 32]);
+   } else if (dist == 'u') {
+      len = snprintf(s, MAX_LEN + 1, "https://www.example.com");
+      n_words = 1 + v[0] % 5;
+      for (int k = 0; k < n_words; k++) {
+         /* early path segments are more concentrated */
+         int x = (v[1 + k/4] >> (8*(k%4))) & 0xff;
+         int word = (k < 2) ? (x * x) >> 11 : x % 32;
+         len += snprintf(s + len, MAX_LEN + 1 - len, "/%s", words[word]);
+      }
+      len += snprintf(s + len, MAX_LEN + 1 - len, "?id=%u", w[0] % 100000);
+   } else {
+      /* log-normal length, median 7, from Box-Muller */
+      double u1 = 1.0 - Keygen_unit(w[0], w[1]);
+      double u2 = Keygen_unit(w[2], w[3]);
+      double z = sqrt(-2.0 * log(u1)) * cos(KEYGEN_TWO_PI * u2);
+      len = (int) (exp(log(7.0) + 0.5*z) + 0.5);
+      if (len < 1) len = 1;
+      if (len > 40) len = 40;
+      for (int k = 0; k < len; k++) {
+         if (k % 24 == 0)    /* 24 letters of 5 bits per 128 bits */
+            Keygen_bits(KEYGEN_SEED + 2 + k/24, i, v);
+         uint32_t word = v[(k % 24) / 6];
+         s[k] = 'a' + ((word >> (5*(k % 6))) & 31) % 26;
+      }
+      s[len] = '\0';
+   }
+
+   if (len > MAX_LEN) len = MAX_LEN;
+   return len;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_list
+ * Purpose:    Strings my_rank*local_n ... (my_rank+1)*local_n - 1
+ */
+void Generate_list(Str_list* L, int local_n, int my_rank, char dist) {
+
+   char s[MAX_LEN + 1];
+
+   List_init(L, local_n, 64*local_n + 1);
+   L->bytes = 0;
+   for (int i = 0; i < local_n; i++) {
+      int len = Gen_string((long long) my_rank*local_n + i, dist, s);
+      List_reserve(L, L->bytes + len + 1);
+      memcpy(L->buf + L->bytes, s, len + 1);
+      L->off[i] = L->bytes;
+      L->lcp[i] = 0;
+      L->bytes += len + 1;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_list
+ * Purpose:    Process 0 reads p*local_n strings and scatters blocks of
+ *             local_n (byte counts first, then MPI_Scatterv of chars)
+ */
+void Read_list(Str_list* L, int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   char *all = NULL, s[MAX_LEN + 1];
+   int *counts = NULL, *displs = NULL;
+   int my_bytes, used = 0, cap = 0;
+
+   if (my_rank == 0) {
+      counts = (int*) malloc(p * sizeof(int));
+      displs = (int*) malloc(p * sizeof(int));
+      printf("Enter the strings of the list\n");
+      for (int q = 0; q < p; q++) {
+         displs[q] = used;
+         for (int i = 0; i < local_n; i++) {
+            if (scanf("%255s", s) != 1) s[0] = '\0';
+            int len = strlen(s) + 1;
+            if (used + len > cap) {
+               cap = 2*(used + len);
+               all = (char*) realloc(all, cap);
+            }
+            memcpy(all + used, s, len);
+            used += len;
+         }
+         counts[q] = used - displs[q];
+      }
+   }
+
+   MPI_Scatter(counts, 1, MPI_INT, &my_bytes, 1, MPI_INT, 0, comm);
+   List_init(L, local_n, my_bytes);
+   MPI_Scatterv(all, counts, displs, MPI_CHAR, L->buf, my_bytes, MPI_CHAR,
+         0, comm);
+   L->bytes = my_bytes;
+   Offsets_from_buf(L);
+
+   if (my_rank == 0) {
+      free(all);
+      free(counts);
+      free(displs);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * List helpers
+ */
+void List_init(Str_list* L, int n, int cap) {
+   L->n = n;
+   L->bytes = 0;
+   L->cap = (cap > 0) ? cap : 1;
+   L->buf = (char*) malloc(L->cap);
+   L->idx = (int*) malloc((2*n + 1) * sizeof(int));
+   L->off = L->idx;
+   L->lcp = L->idx + n;
+}
+
+void List_reserve(Str_list* L, int cap) {
+   if (cap > L->cap) {
+      L->cap = (cap > 2*L->cap) ? cap : 2*L->cap;
+      L->buf = (char*) realloc(L->buf, L->cap);
+   }
+}
+
+void List_free(Str_list* L) {
+   free(L->buf);
+   free(L->idx);
+}
+
+void List_copy(Str_list* dst, Str_list* src) {
+   List_reserve(dst, src->bytes);
+   memcpy(dst->buf, src->buf, src->bytes);
+   memcpy(dst->idx, src->idx, 2*src->n * sizeof(int));
+   dst->bytes = src->bytes;
+}
+
+/* off[] by scanning for the NULs; lcp[] zeroed */
+void Offsets_from_buf(Str_list* L) {
+   int pos = 0;
+   for (int i = 0; i < L->n; i++) {
+      L->off[i] = pos;
+      L->lcp[i] = 0;
+      pos += strlen(L->buf + pos) + 1;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Local_sort: sort L's strings, repack them in order into L->buf and
+ *    fill in the LCP array (tmp is scratch of the same size)
+ */
+void Local_sort(Str_list* L, Str_list* tmp) {
+
+   int n = L->n;
+   char** s = (char**) malloc((n > 0 ? n : 1) * sizeof(char*));
+
+   for (int i = 0; i < n; i++)
+      s[i] = L->buf + L->off[i];
+   Mkqsort(s, n, 0);
+
+   List_reserve(tmp, L->bytes);
+   int pos = 0;
+   for (int i = 0; i < n; i++) {
+      int len = strlen(s[i]) + 1;
+      memcpy(tmp->buf + pos, s[i], len);
+      L->off[i] = pos;
+      L->lcp[i] = (i == 0) ? 0 : Lcp_from(s[i-1], s[i], 0);
+      pos += len;
+   }
+
+   /* swap buffers: L keeps the sorted copy */
+   char* b = L->buf; L->buf = tmp->buf; tmp->buf = b;
+   int c = L->cap; L->cap = tmp->cap; tmp->cap = c;
+
+   free(s);
+}
+
+
+/*-------------------------------------------------------------------
+ * Mkqsort: multikey quicksort of s[0..n) whose first depth chars
+ *    are known to be equal; three-way split on the char at depth, and
+ *    only the "equal" part moves on to depth+1
+ */
+void Mkqsort(char* s[], int n, int depth) {
+
+   while (n > INS_CUTOFF) {
+      /* median of three chars at depth as pivot */
+      unsigned char a = s[0][depth], b = s[n/2][depth], c = s[n-1][depth];
+      unsigned char v = (a < b) ? ((b < c) ? b : (a < c) ? c : a)
+                                : ((a < c) ? a : (b < c) ? c : b);
+      int lt = 0, i = 0, gt = n;
+      while (i < gt) {
+         unsigned char x = s[i][depth];
+         if (x < v) {
+            char* t = s[lt]; s[lt++] = s[i]; s[i++] = t;
+         } else if (x > v) {
+            char* t = s[--gt]; s[gt] = s[i]; s[i] = t;
+         } else {
+            i++;
+         }
+      }
+      Mkqsort(s, lt, depth);
+      if (v != '\0')
+         Mkqsort(s + lt, gt - lt, depth + 1);
+      s += gt;            /* loop on the "greater" part */
+      n -= gt;
+   }
+   Ins_sort(s, n, depth);
+}
+
+
+/*-------------------------------------------------------------------
+ * Ins_sort: insertion sort comparing from depth on
+ */
+void Ins_sort(char* s[], int n, int depth) {
+   for (int i = 1; i < n; i++) {
+      char* x = s[i];
+      int j = i;
+      while (j > 0 && strcmp(s[j-1] + depth, x + depth) > 0) {
+         s[j] = s[j-1];
+         j--;
+      }
+      s[j] = x;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort of string lists
+ *    *sent_p returns the bytes this process sent (chars + ints)
+ */
+void Sort(Str_list* L, int use_lcp, int my_rank, int p, MPI_Comm comm,
+      long long* sent_p) {
+
+   int phase, partner, even_partner, odd_partner;
+   Str_list R, C;
+
+   List_init(&R, L->n, L->bytes);
+   List_init(&C, L->n, 2*L->bytes);
+
+   if (my_rank % 2 != 0) {
+      even_partner = my_rank - 1;
+      odd_partner = my_rank + 1;
+      if (odd_partner == p) odd_partner = MPI_PROC_NULL;
+   } else {
+      even_partner = my_rank + 1;
+      if (even_partner == p) even_partner = MPI_PROC_NULL;
+      odd_partner = my_rank - 1;
+   }
+
+   Local_sort(L, &C);
+
+   *sent_p = 0;
+   for (phase = 0; phase < p; phase++) {
+      partner = (phase % 2 == 0) ? even_partner : odd_partner;
+      if (partner < 0) continue;
+
+      *sent_p += L->bytes + 2LL*L->n*sizeof(int) + sizeof(int);
+      Exchange(L, &R, partner, comm);
+
+      List_reserve(&C, L->bytes + R.bytes);
+      if (my_rank < partner) {
+         if (use_lcp) Merge_low(L, &R, &C);
+         else         Merge_low_plain(L, &R, &C);
+      } else {
+         if (use_lcp) Merge_high(L, &R, &C);
+         else         Merge_high_plain(L, &R, &C);
+      }
+
+      Str_list t = *L; *L = C; C = t;
+   }
+
+   List_free(&R);
+   List_free(&C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Exchange: send L to partner and receive the partner's list in R:
+ *    byte count, packed chars, offsets+LCPs
+ */
+void Exchange(Str_list* L, Str_list* R, int partner, MPI_Comm comm) {
+
+   MPI_Sendrecv(&L->bytes, 1, MPI_INT, partner, 0,
+                &R->bytes, 1, MPI_INT, partner, 0,
+                comm, MPI_STATUS_IGNORE);
+   List_reserve(R, R->bytes);
+   MPI_Sendrecv(L->buf, L->bytes, MPI_CHAR, partner, 1,
+                R->buf, R->bytes, MPI_CHAR, partner, 1,
+                comm, MPI_STATUS_IGNORE);
+   MPI_Sendrecv(L->idx, 2*L->n, MPI_INT, partner, 2,
+                R->idx, 2*R->n, MPI_INT, partner, 2,
+                comm, MPI_STATUS_IGNORE);
+}
+
+
+/*-------------------------------------------------------------------
+ * Lcp_from: length of the common prefix of a and b, known >= h
+ */
+int Lcp_from(const char* a, const char* b, int h) {
+   while (a[h] != '\0' && a[h] == b[h])
+      h++;
+   return h;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low: C = the n smallest strings of A and B (n = A->n)
+ *    ha/hb = LCP of the heads of A/B with the last string written.
+ *    If ha > hb the head of A is smaller (it agrees longer with a
+ *    string <= both); if equal, compare from position ha only.
+ */
+void Merge_low(Str_list* A, Str_list* B, Str_list* C) {
+
+   int n = A->n, i = 0, j = 0, pos = 0, ha = 0, hb = 0, h, k;
+   char *a, *b, *src;
+
+   for (int t = 0; t < n; t++) {
+      a = A->buf + A->off[i];
+      b = B->buf + B->off[j];
+      if (ha > hb) {
+         h = ha; src = a;
+      } else if (hb > ha) {
+         h = hb; src = b;
+      } else {
+         k = Lcp_from(a, b, ha);
+         h = ha;
+         if ((unsigned char) a[k] <= (unsigned char) b[k]) {
+            src = a; hb = k;
+         } else {
+            src = b; ha = k;
+         }
+      }
+
+      int len = strlen(src + h) + h + 1;
+      memcpy(C->buf + pos, src, len);
+      C->off[t] = pos;
+      C->lcp[t] = h;
+      pos += len;
+
+      if (src == a) {
+         i++;
+         if (i < n) ha = A->lcp[i];
+      } else {
+         j++;
+         if (j < n) hb = B->lcp[j];
+      }
+   }
+   C->bytes = pos;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high: C = the n largest strings of A and B
+ *    Same rule from the back: the head that agrees longer with the
+ *    last string written (>= both) is the larger one.  Strings are
+ *    written backwards from the end of C->buf and moved to the front.
+ */
+void Merge_high(Str_list* A, Str_list* B, Str_list* C) {
+
+   int n = A->n, i = n-1, j = n-1, end = C->cap, ha = 0, hb = 0, h, k;
+   char *a, *b, *src;
+
+   for (int t = n-1; t >= 0; t--) {
+      a = A->buf + A->off[i];
+      b = B->buf + B->off[j];
+      if (ha > hb) {
+         h = ha; src = a;
+      } else if (hb > ha) {
+         h = hb; src = b;
+      } else {
+         k = Lcp_from(a, b, ha);
+         h = ha;
+         if ((unsigned char) a[k] >= (unsigned char) b[k]) {
+            src = a; hb = k;
+         } else {
+            src = b; ha = k;
+         }
+      }
+
+      int len = strlen(src + h) + h + 1;
+      end -= len;
+      memcpy(C->buf + end, src, len);
+      C->off[t] = end;
+      if (t < n-1) C->lcp[t+1] = h;
+
+      if (src == a) {
+         ha = A->lcp[i];
+         i--;
+      } else {
+         hb = B->lcp[j];
+         j--;
+      }
+   }
+   C->lcp[0] = 0;
+
+   C->bytes = C->cap - end;
+   memmove(C->buf, C->buf + end, C->bytes);
+   for (int t = 0; t < n; t++)
+      C->off[t] -= end;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low_plain / Merge_high_plain: strcmp merges (reference),
+ *    LCPs recomputed from scratch for the next phase
+ */
+void Merge_low_plain(Str_list* A, Str_list* B, Str_list* C) {
+
+   int n = A->n, i = 0, j = 0, pos = 0;
+   char *src, *prev = NULL;
+
+   for (int t = 0; t < n; t++) {
+      char* a = A->buf + A->off[i];
+      char* b = B->buf + B->off[j];
+      if (strcmp(a, b) <= 0) { src = a; i++; }
+      else                   { src = b; j++; }
+
+      int len = strlen(src) + 1;
+      memcpy(C->buf + pos, src, len);
+      C->off[t] = pos;
+      C->lcp[t] = (prev == NULL) ? 0 : Lcp_from(prev, src, 0);
+      prev = src;
+      pos += len;
+   }
+   C->bytes = pos;
+}
+
+void Merge_high_plain(Str_list* A, Str_list* B, Str_list* C) {
+
+   int n = A->n, i = n-1, j = n-1, end = C->cap;
+   char *src, *prev = NULL;
+
+   for (int t = n-1; t >= 0; t--) {
+      char* a = A->buf + A->off[i];
+      char* b = B->buf + B->off[j];
+      if (strcmp(a, b) >= 0) { src = a; i--; }
+      else                   { src = b; j--; }
+
+      int len = strlen(src) + 1;
+      end -= len;
+      memcpy(C->buf + end, src, len);
+      C->off[t] = end;
+      if (prev != NULL) C->lcp[t+1] = Lcp_from(src, prev, 0);
+      prev = src;
+   }
+   C->lcp[0] = 0;
+
+   C->bytes = C->cap - end;
+   memmove(C->buf, C->buf + end, C->bytes);
+   for (int t = 0; t < n; t++)
+      C->off[t] -= end;
+}
+
+
+/*-------------------------------------------------------------------
+ * Hash_list: wrapping sum of FNV-1a hashes of the strings (order
+ *    independent), to check that the sort kept every string
+ */
+uint64_t Hash_list(Str_list* L) {
+   uint64_t sum = 0;
+   for (int i = 0; i < L->n; i++) {
+      uint64_t h = 0xcbf29ce484222325ULL;
+      for (const char* c = L->buf + L->off[i]; *c; c++)
+         h = (h ^ (unsigned char) *c) * 0x100000001b3ULL;
+      sum += h;
+   }
+   return sum;
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_sorted: local order, LCP array, the right neighbour's first
+ *    string, and the global string hash against the input's
+ *    Returns 1 on every rank if all hold.
+ */
+int Check_sorted(Str_list* L, uint64_t in_hash, int my_rank, int p,
+      MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   char next_first[MAX_LEN + 1];
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+   uint64_t h[2], sum[2];
+
+   for (int i = 1; i < L->n; i++) {
+      char* a = L->buf + L->off[i-1];
+      char* b = L->buf + L->off[i];
+      if (strcmp(a, b) > 0 || Lcp_from(a, b, 0) != L->lcp[i])
+         local_ok = 0;
+   }
+
+   MPI_Sendrecv(L->buf + L->off[0], strlen(L->buf + L->off[0]) + 1,
+                MPI_CHAR, left, 3,
+                next_first, MAX_LEN + 1, MPI_CHAR, right, 3,
+                comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL &&
+       strcmp(L->buf + L->off[L->n-1], next_first) > 0)
+      local_ok = 0;
+
+   h[0] = in_hash;
+   h[1] = Hash_list(L);
+   MPI_Allreduce(h, sum, 2, MPI_UINT64_T, MPI_SUM, comm);
+   if (sum[0] != sum[1]) local_ok = 0;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Print_stats: min, mean, median of times[] (sorts times in place)
+ */
+void Print_stats(char* title, double times[], int reps) {
+
+   for (int i = 0; i < reps-1; i++)
+      for (int j = i+1; j < reps; j++)
+         if (times[j] < times[i]) {
+            double tmp = times[i];
+            times[i] = times[j];
+            times[j] = tmp;
+         }
+
+   double mean = 0.0;
+   for (int i = 0; i < reps; i++)
+      mean += times[i];
+   mean /= reps;
+
+   double median =
+      (reps % 2 == 1) ? times[reps/2]
+                      : (times[reps/2 - 1] + times[reps/2]) / 2.0;
+
+   printf("\n================ %s ================\n", title);
+   printf("Repetitions: %d\n", reps);
+   printf("Minimum time : %e seconds\n", times[0]);
+   printf("Mean time    : %e seconds\n", mean);
+   printf("Median time  : %e seconds\n", median);
+   printf("================================================\n");
+}
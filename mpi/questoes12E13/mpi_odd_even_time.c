@@ -5,58 +5,108 @@
  *           - mean time
  *           - median time
  *           following Section 3.6 (IPP - Peter Pacheco).
+ *           Every repetition is validated in a distributed way (see
+ *           Validate), outside the timed region.
+ *           Buffers and MPI requests live in a Sort_ctx built once
+ *           before the repetitions, so the timed region contains
+ *           only sorting (no malloc/free, no first-touch page faults,
+ *           no request setup).
+ *           Generated input comes from keygen.h: key i of the global
+ *           list depends only on i, so runs with different p sort
+ *           the same data.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_time mpi_odd_even_time.c -lm
+ *           (add -fopenmp to generate keys and to merge with several
+ *           threads: Merge_low/Merge_high then use merge path from
+ *           ../include/mergepath.h)
+ * Run:      mpirun -np <p> ./mpi_odd_even_time <g|i> <global_n> [dist]
+ *           dist is one of the keygen.h letters u f z g s r d
+ *           (default u: uniform in [0, RMAX))
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <mpi.h>
+#include "../include/keygen.h"
+#include "../include/mergepath.h"
+#include "../include/fastio.h"
 
 #define REPS 5         /* Number of repetitions for timing */
+#define ALIGN 64       /* Buffer alignment (cache line) in bytes */
 const int RMAX = 100;
 
+/* State reused by every call to Sort */
+typedef struct {
+   int*        local_A;     /* the process' keys (sorted in place)     */
+   int*        temp_B;      /* partner's keys                          */
+   int*        temp_C;      /* merge output                            */
+   int         local_n;
+   int         p;
+   int         even_partner, odd_partner;
+   MPI_Request even_reqs[2];  /* persistent send/recv, even phases */
+   MPI_Request odd_reqs[2];   /* persistent send/recv, odd phases  */
+} Sort_ctx;
+
 /* Function prototypes */
 void Usage(char* program);
 void Print_list(int local_A[], int local_n, int rank);
 void Merge_low(int local_A[], int temp_B[], int temp_C[], int local_n);
 void Merge_high(int local_A[], int temp_B[], int temp_C[], int local_n);
-void Generate_list(int local_A[], int local_n, int my_rank);
+void Generate_list(int local_A[], int local_n, int my_rank,
+          int global_n, char dist);
 int  Compare(const void* a_p, const void* b_p);
 
 void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p, 
-              char* gi_p, int my_rank, int p, MPI_Comm comm);
-void Sort(int local_A[], int local_n, int my_rank, 
-          int p, MPI_Comm comm);
-void Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
-          int local_n, int phase, int even_partner, int odd_partner,
-          int my_rank, int p, MPI_Comm comm);
+              char* gi_p, char* dist_p, int my_rank, int p,
+              MPI_Comm comm);
+int* Alloc_keys(int n, MPI_Comm comm);
+void Ctx_init(Sort_ctx* ctx, int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Ctx_free(Sort_ctx* ctx);
+void Sort(Sort_ctx* ctx, int my_rank);
+void Odd_even_iter(Sort_ctx* ctx, int phase, int my_rank);
 void Print_local_lists(int local_A[], int local_n, 
           int my_rank, int p, MPI_Comm comm);
 void Print_global_list(int local_A[], int local_n, int my_rank,
           int p, MPI_Comm comm);
 void Read_list(int local_A[], int local_n, int my_rank, int p,
           MPI_Comm comm);
+void Hash_list(int local_A[], int local_n, uint64_t hash[2]);
+int  Validate(int local_A[], int local_n, uint64_t in_hash[2],
+          int my_rank, int p, MPI_Comm comm);
 
 /*-------------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
 
    int my_rank, p;
-   char g_i;
+   char g_i, dist;
    int *local_A;
+   Sort_ctx ctx;
    int global_n;
    int local_n;
    MPI_Comm comm;
    double times[REPS]; /* store times of each repetition */
+   uint64_t in_hash[2]; /* multiset hash of the unsorted input */
+   int valid = 0;       /* repetitions that passed Validate */
 
+#ifdef _OPENMP
+   int provided;
+   MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+#else
    MPI_Init(&argc, &argv);
+#endif
    comm = MPI_COMM_WORLD;
    MPI_Comm_size(comm, &p);
    MPI_Comm_rank(comm, &my_rank);
 
    /* Read input */
-   Get_args(argc, argv, &global_n, &local_n, &g_i, my_rank, p, comm);
+   Get_args(argc, argv, &global_n, &local_n, &g_i, &dist, my_rank, p,
+         comm);
 
-   local_A = (int*) malloc(local_n * sizeof(int));
+   Ctx_init(&ctx, local_n, my_rank, p, comm);
+   local_A = ctx.local_A;
 
    /* ----------------------------------------------------------
     * Perform REPS repetitions to measure execution time
@@ -65,21 +115,24 @@ int main(int argc, char* argv[]) {
 
       /* regenerate input data each repetition */
       if (g_i == 'g') {
-         Generate_list(local_A, local_n, my_rank);
+         Generate_list(local_A, local_n, my_rank, global_n, dist);
       } else {
          Read_list(local_A, local_n, my_rank, p, comm);
       }
+      Hash_list(local_A, local_n, in_hash);
 
       MPI_Barrier(comm);
       double start = MPI_Wtime();
 
       /* Run parallel odd-even sort */
-      Sort(local_A, local_n, my_rank, p, comm);
+      Sort(&ctx, my_rank);
 
       MPI_Barrier(comm);
       double finish = MPI_Wtime();
 
       times[rep] = finish - start;
+
+      valid += Validate(local_A, local_n, in_hash, my_rank, p, comm);
    }
 
    /* ----------------------------------------------------------
@@ -111,11 +164,11 @@ int main(int argc, char* argv[]) {
       printf("Minimum time : %e seconds\n", min);
       printf("Mean time    : %e seconds\n", mean);
       printf("Median time  : %e seconds\n", median);
+      printf("Validation   : %d/%d repetitions sorted\n", valid, REPS);
       printf("================================================\n\n");
    }
 
-   /* Print final list */
-   free(local_A);
+   Ctx_free(&ctx);
 
    MPI_Finalize();
    return 0;
@@ -124,13 +177,13 @@ int main(int argc, char* argv[]) {
 
 /*-------------------------------------------------------------------
  * Function:   Generate_list
- * Purpose:    Fill list with random ints
+ * Purpose:    Fill list with this process' block of the global list
+ *             (keys my_rank*local_n ... (my_rank+1)*local_n - 1)
  */
-void Generate_list(int local_A[], int local_n, int my_rank) {
-   int i;
-   srandom(my_rank+1);
-   for (i = 0; i < local_n; i++)
-      local_A[i] = random() % RMAX;
+void Generate_list(int local_A[], int local_n, int my_rank,
+      int global_n, char dist) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, dist, RMAX, KEYGEN_SEED);
 }
 
 
@@ -138,9 +191,11 @@ void Generate_list(int local_A[], int local_n, int my_rank) {
  * Function:  Usage
  */
 void Usage(char* program) {
-   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n>\n",
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n> [dist]\n",
        program);
    fprintf(stderr, "   global_n must be divisible by p\n");
+   fprintf(stderr, "   dist: u uniform (default), f full 32-bit, z Zipf,\n");
+   fprintf(stderr, "         g Gaussian, s sorted, r reverse, d few unique\n");
    fflush(stderr);
 }
 
@@ -149,21 +204,27 @@ void Usage(char* program) {
  * Function:    Get_args
  */
 void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p, 
-         char* gi_p, int my_rank, int p, MPI_Comm comm) {
+         char* gi_p, char* dist_p, int my_rank, int p, MPI_Comm comm) {
 
    if (my_rank == 0) {
-      if (argc != 3) {
+      if (argc != 3 && argc != 4) {
          Usage(argv[0]);
          *global_n_p = -1;
       } else {
          *gi_p = argv[1][0];
          *global_n_p = atoi(argv[2]);
+         *dist_p = (argc == 4) ? argv[3][0] : 'u';
          if (*global_n_p % p != 0)
             *global_n_p = -1;
+         if (!Keygen_valid_dist(*dist_p)) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
       }
    }
 
    MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(dist_p, 1, MPI_CHAR, 0, comm);
    MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
 
    if (*global_n_p <= 0) {
@@ -186,8 +247,10 @@ void Read_list(int local_A[], int local_n, int my_rank, int p,
    if (my_rank == 0) {
       temp = (int*) malloc(p*local_n*sizeof(int));
       printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
       for (int i = 0; i < p*local_n; i++)
-         scanf("%d", &temp[i]);
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
    } 
 
    MPI_Scatter(temp, local_n, MPI_INT,
@@ -198,6 +261,71 @@ void Read_list(int local_A[], int local_n, int my_rank, int p,
 }
 
 
+/*-------------------------------------------------------------------
+ * Function:   Hash_list
+ * Purpose:    Order-independent hash of the multiset of keys: the
+ *             wrapping sums of two different 64-bit mixes of each key
+ *             (splitmix64 finalizer with two seeds).  Equal multisets
+ *             give equal hashes however the keys are arranged.
+ */
+void Hash_list(int local_A[], int local_n, uint64_t hash[2]) {
+   hash[0] = hash[1] = 0;
+   for (int i = 0; i < local_n; i++) {
+      for (int h = 0; h < 2; h++) {
+         uint64_t z = (uint64_t) (uint32_t) local_A[i]
+                    + (h ? 0x632be59bd9b4e019ULL : 0x9e3779b97f4a7c15ULL);
+         z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+         z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+         hash[h] += z ^ (z >> 31);
+      }
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Validate
+ * Purpose:    Check the distributed sort without gathering the list:
+ *             - each process checks its own keys are in order
+ *             - each process sends its first key to its left
+ *               neighbour, which compares it with its last key
+ *             - the hashes of input and output must match globally
+ *             Cost: O(local_n) per process, one MPI_Sendrecv and one
+ *             MPI_Allreduce.
+ * Return:     1 on every process if the list is sorted and is a
+ *             permutation of the input (up to hash collisions)
+ */
+int Validate(int local_A[], int local_n, uint64_t in_hash[2],
+      int my_rank, int p, MPI_Comm comm) {
+
+   uint64_t local[5], global[5];   /* errors, in hash, out hash */
+   uint64_t out_hash[2];
+   int next_first = 0;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   local[0] = 0;
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local[0]++;
+
+   MPI_Sendrecv(&local_A[0], 1, MPI_INT, left, 1,
+                &next_first, 1, MPI_INT, right, 1,
+                comm, MPI_STATUS_IGNORE);
+   if (right != MPI_PROC_NULL && local_A[local_n-1] > next_first)
+      local[0]++;
+
+   Hash_list(local_A, local_n, out_hash);
+   local[1] = in_hash[0];
+   local[2] = in_hash[1];
+   local[3] = out_hash[0];
+   local[4] = out_hash[1];
+
+   /* unsigned sums wrap, so the global hashes are sums mod 2^64 */
+   MPI_Allreduce(local, global, 5, MPI_UINT64_T, MPI_SUM, comm);
+
+   return global[0] == 0 && global[1] == global[3] && global[2] == global[4];
+}
+
+
 /*-------------------------------------------------------------------
  * Function:   Print_global_list
  */
@@ -214,8 +342,10 @@ void Print_global_list(int local_A[], int local_n, int my_rank, int p,
 
    if (my_rank == 0) {
       printf("Global sorted list:\n");
+      Fio_out* out = Fio_out_open(stdout);
       for (int i = 0; i < p*local_n; i++)
-         printf("%d ", A[i]);
+         Fio_write_int(out, A[i], ' ');
+      Fio_out_close(out);
       printf("\n\n");
       free(A);
    }
@@ -233,69 +363,112 @@ int Compare(const void* a_p, const void* b_p) {
 
 
 /*-------------------------------------------------------------------
- * Sort: odd-even transposition sort
+ * Alloc_keys: ALIGN-aligned array of n ints, written once so that its
+ *    pages are faulted in before any timing starts
  */
-void Sort(int local_A[], int local_n, int my_rank, 
-         int p, MPI_Comm comm) {
+int* Alloc_keys(int n, MPI_Comm comm) {
+   void* buf = NULL;
 
-   int phase;
-   int *temp_B = malloc(local_n*sizeof(int));
-   int *temp_C = malloc(local_n*sizeof(int));
+   if (posix_memalign(&buf, ALIGN, (n > 0 ? n : 1)*sizeof(int)) != 0) {
+      fprintf(stderr, "Alloc_keys: can't allocate %d ints\n", n);
+      MPI_Abort(comm, 1);
+   }
+   memset(buf, 0, n*sizeof(int));
+   return (int*) buf;
+}
+
+
+/*-------------------------------------------------------------------
+ * Ctx_init: buffers, partners and persistent requests for Sort
+ *    Merges copy their result back into local_A, so every buffer
+ *    address is fixed and the requests can be built once:
+ *    send local_A / receive temp_B, one pair per partner.
+ */
+void Ctx_init(Sort_ctx* ctx, int local_n, int my_rank, int p,
+      MPI_Comm comm) {
 
-   int even_partner, odd_partner;
+   ctx->local_n = local_n;
+   ctx->p = p;
+   ctx->local_A = Alloc_keys(local_n, comm);
+   ctx->temp_B  = Alloc_keys(local_n, comm);
+   ctx->temp_C  = Alloc_keys(local_n, comm);
 
    if (my_rank % 2 != 0) {
-      even_partner = my_rank - 1;
-      odd_partner = my_rank + 1;
-      if (odd_partner == p) odd_partner = MPI_PROC_NULL;
+      ctx->even_partner = my_rank - 1;
+      ctx->odd_partner = my_rank + 1;
+      if (ctx->odd_partner == p) ctx->odd_partner = MPI_PROC_NULL;
    } else {
-      even_partner = my_rank + 1;
-      if (even_partner == p) even_partner = MPI_PROC_NULL;
-      odd_partner = my_rank - 1;
+      ctx->even_partner = my_rank + 1;
+      if (ctx->even_partner == p) ctx->even_partner = MPI_PROC_NULL;
+      ctx->odd_partner = my_rank - 1;
+      if (ctx->odd_partner < 0) ctx->odd_partner = MPI_PROC_NULL;
    }
 
-   qsort(local_A, local_n, sizeof(int), Compare);
+   MPI_Send_init(ctx->local_A, local_n, MPI_INT, ctx->even_partner, 0,
+                 comm, &ctx->even_reqs[0]);
+   MPI_Recv_init(ctx->temp_B, local_n, MPI_INT, ctx->even_partner, 0,
+                 comm, &ctx->even_reqs[1]);
+   MPI_Send_init(ctx->local_A, local_n, MPI_INT, ctx->odd_partner, 0,
+                 comm, &ctx->odd_reqs[0]);
+   MPI_Recv_init(ctx->temp_B, local_n, MPI_INT, ctx->odd_partner, 0,
+                 comm, &ctx->odd_reqs[1]);
+}
 
-   for (phase = 0; phase < p; phase++) {
-      Odd_even_iter(local_A, temp_B, temp_C, local_n, phase,
-                    even_partner, odd_partner, my_rank, p, comm);
+
+/*-------------------------------------------------------------------
+ * Ctx_free
+ */
+void Ctx_free(Sort_ctx* ctx) {
+   for (int i = 0; i < 2; i++) {
+      MPI_Request_free(&ctx->even_reqs[i]);
+      MPI_Request_free(&ctx->odd_reqs[i]);
    }
+   free(ctx->local_A);
+   free(ctx->temp_B);
+   free(ctx->temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort of ctx->local_A
+ */
+void Sort(Sort_ctx* ctx, int my_rank) {
+
+   int phase;
 
-   free(temp_B);
-   free(temp_C);
+   qsort(ctx->local_A, ctx->local_n, sizeof(int), Compare);
+
+   for (phase = 0; phase < ctx->p; phase++)
+      Odd_even_iter(ctx, phase, my_rank);
 }
 
 
 /*-------------------------------------------------------------------
- * Odd-even iteration
+ * Odd-even iteration: restart this phase's persistent requests
  */
-void Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
-        int local_n, int phase, int even_partner, int odd_partner,
-        int my_rank, int p, MPI_Comm comm) {
+void Odd_even_iter(Sort_ctx* ctx, int phase, int my_rank) {
 
-   MPI_Status status;
+   MPI_Status statuses[2];
 
    if (phase % 2 == 0) {
-      if (even_partner >= 0) {
-         MPI_Sendrecv(local_A, local_n, MPI_INT, even_partner, 0,
-                      temp_B, local_n, MPI_INT, even_partner, 0,
-                      comm, &status);
+      if (ctx->even_partner != MPI_PROC_NULL) {
+         MPI_Startall(2, ctx->even_reqs);
+         MPI_Waitall(2, ctx->even_reqs, statuses);
 
          if (my_rank % 2 != 0)
-            Merge_high(local_A, temp_B, temp_C, local_n);
+            Merge_high(ctx->local_A, ctx->temp_B, ctx->temp_C, ctx->local_n);
          else
-            Merge_low(local_A, temp_B, temp_C, local_n);
+            Merge_low(ctx->local_A, ctx->temp_B, ctx->temp_C, ctx->local_n);
       }
    } else {
-      if (odd_partner >= 0) {
-         MPI_Sendrecv(local_A, local_n, MPI_INT, odd_partner, 0,
-                      temp_B, local_n, MPI_INT, odd_partner, 0,
-                      comm, &status);
+      if (ctx->odd_partner != MPI_PROC_NULL) {
+         MPI_Startall(2, ctx->odd_reqs);
+         MPI_Waitall(2, ctx->odd_reqs, statuses);
 
          if (my_rank % 2 != 0)
-            Merge_low(local_A, temp_B, temp_C, local_n);
+            Merge_low(ctx->local_A, ctx->temp_B, ctx->temp_C, ctx->local_n);
          else
-            Merge_high(local_A, temp_B, temp_C, local_n);
+            Merge_high(ctx->local_A, ctx->temp_B, ctx->temp_C, ctx->local_n);
       }
    }
 }
@@ -307,6 +480,9 @@ void Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
 void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
                int local_n) {
 
+#ifdef _OPENMP
+   Mpath_merge(my_keys, recv_keys, local_n, temp_keys, 0, local_n);
+#else
    int m_i = 0, r_i = 0, t_i = 0;
 
    while (t_i < local_n) {
@@ -315,6 +491,7 @@ void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
       else
          temp_keys[t_i++] = recv_keys[r_i++];
    }
+#endif
 
    memcpy(my_keys, temp_keys, local_n*sizeof(int));
 }
@@ -326,6 +503,9 @@ void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
 void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
                 int local_n) {
 
+#ifdef _OPENMP
+   Mpath_merge(my_keys, recv_keys, local_n, temp_keys, local_n, local_n);
+#else
    int ai = local_n-1;
    int bi = local_n-1;
    int ci = local_n-1;
@@ -336,6 +516,7 @@ void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
       else
          temp_keys[ci--] = recv_keys[bi--];
    }
+#endif
 
    memcpy(my_keys, temp_keys, local_n*sizeof(int));
 }
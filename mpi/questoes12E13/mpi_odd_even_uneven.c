@@ -0,0 +1,560 @@
+/*
+ * File:     mpi_odd_even_uneven.c
+ * Purpose:  Parallel odd-even sort for any global_n and any number of
+ *           keys per process, timed as in mpi_odd_even_time.c:
+ *           - each phase the partners first trade their counts with
+ *             MPI_Sendrecv, then their blocks; the lower process keeps
+ *             as many of the smallest keys as it had, the higher one as
+ *             many of the largest, so the distribution never changes
+ *           - processes with no keys are left out: the exchange chain
+ *             links each nonempty process to the nearest nonempty one
+ *           - with equal counts the classic p phases suffice; with
+ *             unequal counts they do not, so after each even/odd pair
+ *             of phases an MPI_Allreduce checks whether any process
+ *             changed its keys, and the sort stops when none did
+ *           - an optional final step moves the sorted keys to the block
+ *             distribution (n/p, remainder on the first processes)
+ *             with one MPI_Alltoallv whose counts come from an
+ *             exclusive prefix sum of the current counts
+ *           Max/min keys per process are reported before and after.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_odd_even_uneven mpi_odd_even_uneven.c -lm
+ * Run:      mpirun -np <p> ./mpi_odd_even_uneven <g|i> <global_n> [skew] [b|n]
+ *
+ * Notes:
+ * 1. skew >= 0 sets the input imbalance: process q starts with keys in
+ *    proportion to 1 + skew*q/(p-1) (default 0: as even as possible)
+ * 2. b (default): rebalance to the block distribution after sorting;
+ *    n: keep the input distribution
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+
+#define REPS 5         /* Number of repetitions for timing */
+const int RMAX = 100;
+
+/* Function prototypes */
+void Usage(char* program);
+void Generate_list(int local_A[], int counts[], int my_rank, int global_n);
+int  Compare(const void* a_p, const void* b_p);
+
+void Get_args(int argc, char* argv[], int* global_n_p, double* skew_p,
+              char* gi_p, char* balance_p, int my_rank, MPI_Comm comm);
+void Input_counts(int global_n, double skew, int p, int counts[]);
+void Block_counts(int global_n, int p, int counts[]);
+void Read_list(int local_A[], int counts[], int my_rank, int p,
+          MPI_Comm comm);
+
+void Sort(int local_A[], int counts[], int my_rank, int p, MPI_Comm comm);
+int  Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+          int local_n, int partner, int my_rank, MPI_Comm comm);
+void Merge_low(int my_keys[], int my_n, int recv_keys[], int recv_n,
+          int temp_keys[]);
+void Merge_high(int my_keys[], int my_n, int recv_keys[], int recv_n,
+          int temp_keys[]);
+int  Rebalance(int** local_A_p, int local_n, int target[], int my_rank,
+          int p, MPI_Comm comm);
+
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Print_counts(char* title, int local_n, int my_rank, MPI_Comm comm);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char g_i, balance;
+   int *local_A;
+   int *counts, *target;
+   int global_n, local_n;
+   double skew;
+   MPI_Comm comm;
+   double times[REPS];
+   int ok = 1;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &skew, &g_i, &balance, my_rank, comm);
+
+   counts = malloc(p*sizeof(int));
+   target = malloc(p*sizeof(int));
+   Input_counts(global_n, skew, p, counts);
+   Block_counts(global_n, p, target);
+
+   for (int rep = 0; rep < REPS; rep++) {
+
+      /* regenerate input data each repetition */
+      local_n = counts[my_rank];
+      local_A = (int*) malloc((local_n > 0 ? local_n : 1) * sizeof(int));
+      if (g_i == 'g')
+         Generate_list(local_A, counts, my_rank, global_n);
+      else
+         Read_list(local_A, counts, my_rank, p, comm);
+
+      if (rep == 0)
+         Print_counts("Keys per process (input)", local_n, my_rank, comm);
+
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+
+      Sort(local_A, counts, my_rank, p, comm);
+      if (balance == 'b')
+         local_n = Rebalance(&local_A, local_n, target, my_rank, p, comm);
+
+      MPI_Barrier(comm);
+      double finish = MPI_Wtime();
+
+      times[rep] = finish - start;
+      ok &= Check_sorted(local_A, local_n, my_rank, p, comm);
+      if (rep == REPS-1)
+         Print_counts("Keys per process (output)", local_n, my_rank, comm);
+      free(local_A);
+   }
+
+   /* ----------------------------------------------------------
+    * Compute min, mean, median (done by rank 0)
+    * ---------------------------------------------------------- */
+   if (my_rank == 0) {
+
+      for (int i = 0; i < REPS-1; i++)
+         for (int j = i+1; j < REPS; j++)
+            if (times[j] < times[i]) {
+               double tmp = times[i];
+               times[i] = times[j];
+               times[j] = tmp;
+            }
+
+      double min = times[0];
+      double mean = 0.0;
+      for (int i = 0; i < REPS; i++)
+         mean += times[i];
+      mean /= REPS;
+
+      double median =
+         (REPS % 2 == 1) ? times[REPS/2]
+                         : (times[REPS/2 - 1] + times[REPS/2]) / 2.0;
+
+      printf("\n================ Timing results ================\n");
+      printf("global_n = %d, skew = %.2f, rebalance = %s\n", global_n,
+             skew, balance == 'b' ? "block" : "none");
+      printf("Repetitions: %d\n", REPS);
+      printf("Minimum time : %e seconds\n", min);
+      printf("Mean time    : %e seconds\n", mean);
+      printf("Median time  : %e seconds\n", median);
+      printf("Result check : %s\n", ok ? "sorted" : "NOT SORTED");
+      printf("================================================\n\n");
+   }
+
+   free(counts);
+   free(target);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_list
+ * Purpose:    Fill list with this process' counts[my_rank] keys of
+ *             the global list (keygen.h, uniform in [0, RMAX)), so the
+ *             global list is the same for every p and skew
+ */
+void Generate_list(int local_A[], int counts[], int my_rank, int global_n) {
+   long long first = 0;
+   for (int q = 0; q < my_rank; q++)
+      first += counts[q];
+   Keygen_fill_int(local_A, first, counts[my_rank], global_n, 'u', RMAX,
+         KEYGEN_SEED);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr,
+       "usage:  mpirun -np <p> %s <g|i> <global_n> [skew] [b|n]\n",
+       program);
+   fprintf(stderr, "   skew >= 0: input imbalance (default 0)\n");
+   fprintf(stderr, "   b: rebalance to n/p per process (default), "
+       "n: no rebalance\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, double* skew_p,
+         char* gi_p, char* balance_p, int my_rank, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc < 3 || argc > 5) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *gi_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         *skew_p = (argc >= 4) ? atof(argv[3]) : 0.0;
+         *balance_p = (argc >= 5) ? argv[4][0] : 'b';
+         if (*skew_p < 0.0 || (*balance_p != 'b' && *balance_p != 'n')) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(balance_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(skew_p, 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Input_counts
+ * Purpose:    Keys per process for the input: weight 1 + skew*q/(p-1)
+ *             for process q, leftovers to the first processes
+ */
+void Input_counts(int global_n, double skew, int p, int counts[]) {
+   double total_w = 0.0;
+   int assigned = 0;
+
+   for (int q = 0; q < p; q++)
+      total_w += 1.0 + (p > 1 ? skew * q / (p - 1) : 0.0);
+   for (int q = 0; q < p; q++) {
+      double w = 1.0 + (p > 1 ? skew * q / (p - 1) : 0.0);
+      counts[q] = (int) (global_n * w / total_w);
+      assigned += counts[q];
+   }
+   for (int q = 0; assigned < global_n; q = (q + 1) % p) {
+      counts[q]++;
+      assigned++;
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Block_counts
+ * Purpose:    Block distribution: n/p each, remainder to the first
+ *             processes (as in mpi_escalarV3.c)
+ */
+void Block_counts(int global_n, int p, int counts[]) {
+   int div = global_n / p;
+   int resto = global_n % p;
+
+   for (int q = 0; q < p; q++)
+      counts[q] = div + (q < resto ? 1 : 0);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_list
+ */
+void Read_list(int local_A[], int counts[], int my_rank, int p,
+         MPI_Comm comm) {
+
+   int *temp = NULL, *displs = NULL;
+
+   if (my_rank == 0) {
+      int n = 0;
+      displs = malloc(p*sizeof(int));
+      for (int q = 0; q < p; q++) {
+         displs[q] = n;
+         n += counts[q];
+      }
+      temp = (int*) malloc(n*sizeof(int));
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (int i = 0; i < n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatterv(temp, counts, displs, MPI_INT,
+                local_A, counts[my_rank], MPI_INT, 0, comm);
+
+   if (my_rank == 0) {
+      free(temp);
+      free(displs);
+   }
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparator
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort over the nonempty processes
+ *    counts[] (same on every process) never changes.  The nonempty
+ *    processes form the chain; with equal counts n_active phases sort
+ *    the list, otherwise phases run in even/odd pairs until a pair in
+ *    which no process changed its keys (then every adjacent pair is in
+ *    order, so the whole list is).
+ */
+void Sort(int local_A[], int counts[], int my_rank, int p, MPI_Comm comm) {
+
+   int phase, partner, max_n = 0, n_active = 0, my_pos = -1, equal = 1;
+   int *active = malloc(p*sizeof(int));
+   int local_n = counts[my_rank];
+
+   for (int q = 0; q < p; q++) {
+      if (counts[q] == 0) continue;
+      if (q == my_rank) my_pos = n_active;
+      if (n_active > 0 && counts[q] != counts[active[0]]) equal = 0;
+      active[n_active++] = q;
+      if (counts[q] > max_n) max_n = counts[q];
+   }
+
+   if (my_pos < 0) {
+      /* no keys: only the termination checks below */
+      int changed = 0, any = 1;
+      if (!equal)
+         while (any)
+            MPI_Allreduce(&changed, &any, 1, MPI_INT, MPI_LOR, comm);
+      free(active);
+      return;
+   }
+
+   int *temp_B = malloc(max_n*sizeof(int));
+   int *temp_C = malloc(local_n*sizeof(int));
+   int even_partner, odd_partner;
+
+   if (my_pos % 2 != 0) {
+      even_partner = active[my_pos - 1];
+      odd_partner = (my_pos + 1 < n_active) ? active[my_pos + 1]
+                                            : MPI_PROC_NULL;
+   } else {
+      even_partner = (my_pos + 1 < n_active) ? active[my_pos + 1]
+                                             : MPI_PROC_NULL;
+      odd_partner = (my_pos > 0) ? active[my_pos - 1] : MPI_PROC_NULL;
+   }
+
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   if (equal) {
+      for (phase = 0; phase < n_active; phase++) {
+         partner = (phase % 2 == 0) ? even_partner : odd_partner;
+         if (partner >= 0)
+            Odd_even_iter(local_A, temp_B, temp_C, local_n, partner,
+                          my_rank, comm);
+      }
+   } else {
+      int any = 1;
+      while (any) {
+         int changed = 0;
+         for (phase = 0; phase < 2; phase++) {
+            partner = (phase == 0) ? even_partner : odd_partner;
+            if (partner >= 0)
+               changed |= Odd_even_iter(local_A, temp_B, temp_C, local_n,
+                                        partner, my_rank, comm);
+         }
+         MPI_Allreduce(&changed, &any, 1, MPI_INT, MPI_LOR, comm);
+      }
+   }
+
+   free(temp_B);
+   free(temp_C);
+   free(active);
+}
+
+
+/*-------------------------------------------------------------------
+ * Odd-even iteration: trade counts, then blocks, then compare-split
+ *    Returns 1 if this process' keys changed.
+ */
+int Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+        int local_n, int partner, int my_rank, MPI_Comm comm) {
+
+   MPI_Status status;
+   int recv_n;
+
+   MPI_Sendrecv(&local_n, 1, MPI_INT, partner, 1,
+                &recv_n, 1, MPI_INT, partner, 1, comm, &status);
+   MPI_Sendrecv(local_A, local_n, MPI_INT, partner, 0,
+                temp_B, recv_n, MPI_INT, partner, 0, comm, &status);
+
+   /* blocks already in order: nothing to merge */
+   if (my_rank < partner) {
+      if (local_A[local_n-1] <= temp_B[0]) return 0;
+      Merge_low(local_A, local_n, temp_B, recv_n, temp_C);
+   } else {
+      if (local_A[0] >= temp_B[recv_n-1]) return 0;
+      Merge_high(local_A, local_n, temp_B, recv_n, temp_C);
+   }
+   return 1;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low: keep the my_n smallest of my_keys U recv_keys
+ */
+void Merge_low(int my_keys[], int my_n, int recv_keys[], int recv_n,
+               int temp_keys[]) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < my_n) {
+      if (r_i >= recv_n || my_keys[m_i] <= recv_keys[r_i])
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, my_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high: keep the my_n largest of my_keys U recv_keys
+ */
+void Merge_high(int my_keys[], int my_n, int recv_keys[], int recv_n,
+                int temp_keys[]) {
+
+   int ai = my_n-1;
+   int bi = recv_n-1;
+   int ci = my_n-1;
+
+   while (ci >= 0) {
+      if (bi < 0 || my_keys[ai] >= recv_keys[bi])
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, my_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Rebalance: move the sorted keys to the distribution target[]
+ *    MPI_Exscan gives this process' first global position; the
+ *    keys [my_start, my_start+local_n) go to every process whose
+ *    target range they overlap, and, symmetrically, this process
+ *    receives the parts of its target range held by the others
+ *    (their starts come from MPI_Allgather of the counts).
+ *    Returns the new local_n; *local_A_p is reallocated.
+ */
+int Rebalance(int** local_A_p, int local_n, int target[], int my_rank,
+         int p, MPI_Comm comm) {
+
+   int *counts      = malloc(p*sizeof(int));
+   int *starts      = malloc(p*sizeof(int));
+   int *t_starts    = malloc(p*sizeof(int));
+   int *send_counts = malloc(p*sizeof(int));
+   int *send_displs = malloc(p*sizeof(int));
+   int *recv_counts = malloc(p*sizeof(int));
+   int *recv_displs = malloc(p*sizeof(int));
+   int my_start = 0, new_n = target[my_rank];
+   int *new_A = malloc((new_n > 0 ? new_n : 1)*sizeof(int));
+   int q;
+
+   MPI_Exscan(&local_n, &my_start, 1, MPI_INT, MPI_SUM, comm);
+   if (my_rank == 0) my_start = 0;   /* Exscan leaves rank 0 undefined */
+   MPI_Allgather(&local_n, 1, MPI_INT, counts, 1, MPI_INT, comm);
+
+   starts[0] = t_starts[0] = 0;
+   for (q = 1; q < p; q++) {
+      starts[q] = starts[q-1] + counts[q-1];
+      t_starts[q] = t_starts[q-1] + target[q-1];
+   }
+
+   for (q = 0; q < p; q++) {
+      /* my keys that land in q's target range */
+      int lo = (my_start > t_starts[q]) ? my_start : t_starts[q];
+      int hi = (my_start + local_n < t_starts[q] + target[q])
+             ? my_start + local_n : t_starts[q] + target[q];
+      send_counts[q] = (hi > lo) ? hi - lo : 0;
+      send_displs[q] = (hi > lo) ? lo - my_start : 0;
+
+      /* q's keys that land in my target range */
+      lo = (starts[q] > t_starts[my_rank]) ? starts[q] : t_starts[my_rank];
+      hi = (starts[q] + counts[q] < t_starts[my_rank] + new_n)
+         ? starts[q] + counts[q] : t_starts[my_rank] + new_n;
+      recv_counts[q] = (hi > lo) ? hi - lo : 0;
+      recv_displs[q] = (hi > lo) ? lo - t_starts[my_rank] : 0;
+   }
+
+   MPI_Alltoallv(*local_A_p, send_counts, send_displs, MPI_INT,
+                 new_A, recv_counts, recv_displs, MPI_INT, comm);
+
+   free(*local_A_p);
+   *local_A_p = new_A;
+
+   free(counts); free(starts); free(t_starts);
+   free(send_counts); free(send_displs);
+   free(recv_counts); free(recv_displs);
+   return new_n;
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_sorted: local order plus the first key to our right
+ *    Processes with no keys pass the first key through from their
+ *    right, so the check also works with empty processes.
+ *    Returns 1 on every rank if the distributed list is sorted.
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   int has, next_has = 0, next_first = 0, my_first;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   /* right to left sweep: each process forwards the smallest key at
+      or to its right */
+   if (right != MPI_PROC_NULL) {
+      int msg[2];
+      MPI_Recv(msg, 2, MPI_INT, right, 1, comm, MPI_STATUS_IGNORE);
+      next_has = msg[0];
+      next_first = msg[1];
+   }
+   if (local_n > 0 && next_has && local_A[local_n-1] > next_first)
+      local_ok = 0;
+   has = (local_n > 0) || next_has;
+   my_first = (local_n > 0) ? local_A[0] : next_first;
+   if (left != MPI_PROC_NULL) {
+      int msg[2] = {has, my_first};
+      MPI_Send(msg, 2, MPI_INT, left, 1, comm);
+   }
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Print_counts: max/min keys per process (printed by rank 0)
+ */
+void Print_counts(char* title, int local_n, int my_rank, MPI_Comm comm) {
+   int max_n, min_n;
+
+   MPI_Reduce(&local_n, &max_n, 1, MPI_INT, MPI_MAX, 0, comm);
+   MPI_Reduce(&local_n, &min_n, 1, MPI_INT, MPI_MIN, 0, comm);
+   if (my_rank == 0)
+      printf("%s: max = %d, min = %d\n", title, max_n, min_n);
+}
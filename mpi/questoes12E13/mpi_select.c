@@ -0,0 +1,764 @@
+/*
+ * File:     mpi_select.c
+ * Purpose:  Distributed selection without a full sort:
+ *           - m: median (key of global rank (global_n-1)/2)
+ *           - q: the q-1 cut points of q quantiles, all in one search
+ *           - t: top-k (the k largest keys, largest first)
+ *           Selection narrows the candidate range of every requested
+ *           rank in rounds: each process contributes a few random
+ *           samples of its candidates (one MPI_Allgather), every
+ *           process picks the same pivots just below and above each
+ *           target rank from the weighted samples, buckets its
+ *           candidates locally by those pivots, and one MPI_Allreduce
+ *           of the bucket counts tells which bucket holds each rank.
+ *           Once a range is small it is gathered and finished locally.
+ *           Top-k keeps a size-k min-heap per process and merges the
+ *           per-process lists in a reduction tree (user MPI_Op).
+ *           Expected cost: O(n/p) local work and O(log p) latency per
+ *           round, a few rounds, instead of p exchanges of n/p keys.
+ *           Results are checked against the odd-even sort, which is
+ *           timed on the same input for comparison.
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_select mpi_select.c -lm
+ * Run:      mpirun -np <p> ./mpi_select <g|i> <global_n> <m|q|t> [arg] [dist]
+ *
+ * Notes:
+ * 1. global_n must be divisible by p
+ * 2. arg: number of quantiles for q (default 4), k for t (default 10)
+ * 3. dist: keygen.h distribution for g (default f, full 32-bit range)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <mpi.h>
+#include "../include/keygen.h"
+#include "../include/fastio.h"
+
+#define REPS 5             /* Number of repetitions for timing        */
+#define S_PER 128          /* Samples per process per search range    */
+#define SELECT_CUTOFF 4096 /* Ranges this small are gathered & solved */
+const int RMAX = 100;
+
+/* A range of candidates, identical in every process: the keys with
+   global rank base .. base+size-1, held locally in cand[first..last) */
+typedef struct {
+   int       first, last;
+   long long base, size;
+   int       k_first, k_last;  /* requested ranks ks[k_first..k_last) */
+} Segment;
+
+/* Weighted sample */
+typedef struct {
+   double value;
+   double weight;
+} Sample;
+
+/* Function prototypes */
+void Usage(char* program);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n,
+          char dist);
+int  Compare(const void* a_p, const void* b_p);
+int  Compare_desc(const void* a_p, const void* b_p);
+int  Compare_sample(const void* a_p, const void* b_p);
+
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+          char* gi_p, char* op_p, int* arg_p, char* dist_p, int my_rank,
+          int p, MPI_Comm comm);
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+
+int  Multi_select(int A[], int n, long long ks[], int m, int out[],
+          int my_rank, int p, MPI_Comm comm);
+int  Choose_pivots(double all[], int n_act, int a, int p, long long ks[],
+          Segment* g, Sample pool[], int piv[]);
+int  Bucket_of(int x, int piv[], int u);
+void Bucket_split(int cand[], int out[], int bid[], int first, int last,
+          int piv[], int u, long long cnt[]);
+void Finish_small(int cand[], Segment seg[], int n_seg, long long ks[],
+          int out[], int p, MPI_Comm comm);
+
+void Top_k(int A[], int n, int k, int out[], MPI_Comm comm);
+void Topk_merge(void* in_p, void* inout_p, int* len, MPI_Datatype* type);
+void Sift_down_min(int heap[], int k, int i);
+
+void Sort(int local_A[], int local_n, int my_rank, int p, MPI_Comm comm);
+void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n);
+void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n);
+void Values_at(int local_A[], int local_n, long long idx[], int m,
+          int out[], int my_rank, MPI_Comm comm);
+double Min_time(double times[], int reps);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char g_i, op, dist;
+   int *input, *local_A;
+   int global_n, local_n, arg, m;
+   long long* ks;
+   int *found, *expected;
+   MPI_Comm comm;
+   double sel_times[REPS], sort_times[REPS];
+   int rounds = 0;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &local_n, &g_i, &op, &arg, &dist,
+         my_rank, p, comm);
+
+   input   = (int*) malloc(local_n * sizeof(int));
+   local_A = (int*) malloc(local_n * sizeof(int));
+   if (input == NULL || local_A == NULL) {
+      fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+      MPI_Abort(comm, 1);
+   }
+   if (g_i == 'g')
+      Generate_list(input, local_n, my_rank, global_n, dist);
+   else
+      Read_list(input, local_n, my_rank, p, comm);
+
+   /* global ranks asked for, ascending */
+   m = (op == 'm') ? 1 : (op == 'q') ? arg - 1 : arg;
+   ks = (long long*) malloc(m * sizeof(long long));
+   found    = (int*) malloc(m * sizeof(int));
+   expected = (int*) malloc(m * sizeof(int));
+   if (op == 'm')
+      ks[0] = (global_n - 1) / 2;
+   else if (op == 'q')
+      for (int j = 0; j < m; j++)
+         ks[j] = (long long) (j + 1) * global_n / arg;
+   else
+      for (int j = 0; j < m; j++)      /* found[j] = j-th largest */
+         ks[j] = global_n - 1 - j;
+
+   for (int rep = 0; rep < REPS; rep++) {
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+      if (op == 't')
+         Top_k(input, local_n, arg, found, comm);
+      else
+         rounds = Multi_select(input, local_n, ks, m, found, my_rank, p,
+               comm);
+      MPI_Barrier(comm);
+      sel_times[rep] = MPI_Wtime() - start;
+   }
+
+   /* Reference: full odd-even sort of the same input */
+   for (int rep = 0; rep < REPS; rep++) {
+      memcpy(local_A, input, local_n * sizeof(int));
+      MPI_Barrier(comm);
+      double start = MPI_Wtime();
+      Sort(local_A, local_n, my_rank, p, comm);
+      MPI_Barrier(comm);
+      sort_times[rep] = MPI_Wtime() - start;
+   }
+   Values_at(local_A, local_n, ks, m, expected, my_rank, comm);
+
+   if (my_rank == 0) {
+      int ok = (memcmp(found, expected, m * sizeof(int)) == 0);
+      double t_sel = Min_time(sel_times, REPS);
+      double t_sort = Min_time(sort_times, REPS);
+
+      printf("\np = %d, global_n = %d, dist = %c\n", p, global_n, dist);
+      if (op == 'm')
+         printf("Median (rank %lld): %d\n", ks[0], found[0]);
+      else if (op == 'q')
+         printf("%d-quantile cut points:\n", arg);
+      else
+         printf("Top-%d keys, largest first:\n", arg);
+      if (op != 'm') {
+         for (int j = 0; j < m && j < 16; j++)
+            printf("   rank %lld: %d\n", ks[j], found[j]);
+         if (m > 16) printf("   ...\n");
+      }
+      if (op != 't')
+         printf("Rounds of MPI_Allgather + MPI_Allreduce: %d\n", rounds);
+      printf("Selection time (min of %d)  : %e seconds\n", REPS, t_sel);
+      printf("Odd-even sort time (min of %d): %e seconds\n", REPS, t_sort);
+      printf("Speedup over full sort       : %.1f\n", t_sort / t_sel);
+      printf("Result check : %s\n\n", ok ? "matches sort" : "MISMATCH");
+   }
+
+   free(input);
+   free(local_A);
+   free(ks);
+   free(found);
+   free(expected);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_list
+ * Purpose:    Fill list with this process' block of the global list
+ */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n,
+      char dist) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, dist, RMAX, KEYGEN_SEED);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n> <m|q|t> "
+       "[arg] [dist]\n", program);
+   fprintf(stderr, "   global_n must be divisible by p\n");
+   fprintf(stderr, "   m: median; q: quantile cut points; t: top-k\n");
+   fprintf(stderr, "   arg: quantiles for q (default 4), k for t "
+       "(default 10)\n");
+   fprintf(stderr, "   dist: keygen.h distribution (default f)\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, char* op_p, int* arg_p, char* dist_p, int my_rank,
+         int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc < 4 || argc > 6) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *gi_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         *op_p = argv[3][0];
+         *arg_p = (argc > 4) ? atoi(argv[4]) : (*op_p == 'q' ? 4 : 10);
+         *dist_p = (argc > 5) ? argv[5][0] : 'f';
+         if (*global_n_p % p != 0 || strchr("mqt", *op_p) == NULL ||
+             !Keygen_valid_dist(*dist_p) ||
+             (*op_p == 'q' && (*arg_p < 2 || *arg_p > *global_n_p)) ||
+             (*op_p == 't' && (*arg_p < 1 || *arg_p > *global_n_p))) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(op_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(dist_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(arg_p, 1, MPI_INT, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p/p;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_list
+ */
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int *temp = NULL;
+
+   if (my_rank == 0) {
+      temp = (int*) malloc(p*local_n*sizeof(int));
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (int i = 0; i < p*local_n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatter(temp, local_n, MPI_INT,
+               local_A, local_n, MPI_INT, 0, comm);
+
+   if (my_rank == 0)
+      free(temp);
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparators
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+int Compare_desc(const void* a_p, const void* b_p) {
+   return Compare(b_p, a_p);
+}
+
+int Compare_sample(const void* a_p, const void* b_p) {
+   double a = ((Sample*)a_p)->value;
+   double b = ((Sample*)b_p)->value;
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Multi_select: out[j] = key of global rank ks[j] (ks ascending)
+ *    A is left untouched; every process gets every answer.
+ *    Returns the number of narrowing rounds.
+ *
+ *    Segments partition the candidates so that all keys of a segment
+ *    are <= all keys of the next one, in every process.  A round
+ *    treats every segment larger than SELECT_CUTOFF at once, with one
+ *    MPI_Allgather of samples and one MPI_Allreduce of bucket counts;
+ *    only buckets that still hold a requested rank are kept.
+ */
+int Multi_select(int A[], int n, long long ks[], int m, int out[],
+      int my_rank, int p, MPI_Comm comm) {
+
+   int *cand = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+   int *tmp  = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+   int *bid  = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+   Segment *seg  = (Segment*) malloc(m * sizeof(Segment));
+   Segment *next = (Segment*) malloc(m * sizeof(Segment));
+   double *smp = (double*) malloc(2*m*S_PER * sizeof(double));
+   double *all = (double*) malloc((size_t) p*2*m*S_PER * sizeof(double));
+   Sample *pool = (Sample*) malloc((size_t) p*S_PER * sizeof(Sample));
+   int *piv   = (int*) malloc(2*m * sizeof(int));    /* all segments */
+   int *n_piv = (int*) malloc(m * sizeof(int));
+   long long *cnt  = (long long*) malloc((4*m + m) * sizeof(long long));
+   long long *gcnt = (long long*) malloc((4*m + m) * sizeof(long long));
+   long long local = n, global;
+   int n_seg = 1, n_act, rounds = 0;
+
+   memcpy(cand, A, n * sizeof(int));
+   MPI_Allreduce(&local, &global, 1, MPI_LONG_LONG, MPI_SUM, comm);
+   seg[0] = (Segment) {0, n, 0, global, 0, m};
+
+   while (1) {
+      n_act = 0;
+      for (int s = 0; s < n_seg; s++)
+         if (seg[s].size > SELECT_CUTOFF) n_act++;
+      if (n_act == 0) break;
+      rounds++;
+
+      /* 1. S_PER samples per active segment, weight = local count/S_PER */
+      for (int s = 0, a = 0; s < n_seg; s++) {
+         if (seg[s].size <= SELECT_CUTOFF) continue;
+         int c = seg[s].last - seg[s].first;
+         for (int j = 0; j < S_PER; j++) {
+            uint32_t w[4];
+            int v = 0;
+            if (c > 0) {
+               Keygen_bits(((uint64_t) my_rank << 32) | rounds,
+                     (long long) a*S_PER + j, w);
+               v = cand[seg[s].first + (int) (((uint64_t) w[0] * c) >> 32)];
+            }
+            smp[2*(a*S_PER + j)]     = v;
+            smp[2*(a*S_PER + j) + 1] = (double) c / S_PER;
+         }
+         a++;
+      }
+      MPI_Allgather(smp, 2*n_act*S_PER, MPI_DOUBLE,
+                    all, 2*n_act*S_PER, MPI_DOUBLE, comm);
+
+      /* 2. same pivots everywhere; 3. local bucket split into tmp,
+            which then becomes cand (small segments are copied over) */
+      int n_cnt = 0, n_pv = 0;
+      for (int s = 0, a = 0; s < n_seg; s++) {
+         if (seg[s].size <= SELECT_CUTOFF) {
+            memcpy(tmp + seg[s].first, cand + seg[s].first,
+                  (seg[s].last - seg[s].first) * sizeof(int));
+            continue;
+         }
+         n_piv[a] = Choose_pivots(all, n_act, a, p, ks, &seg[s], pool,
+               piv + n_pv);
+         Bucket_split(cand, tmp, bid, seg[s].first, seg[s].last,
+               piv + n_pv, n_piv[a], cnt + n_cnt);
+         n_cnt += 2*n_piv[a] + 1;
+         n_pv += n_piv[a];
+         a++;
+      }
+      int* swap = cand; cand = tmp; tmp = swap;
+      MPI_Allreduce(cnt, gcnt, n_cnt, MPI_LONG_LONG, MPI_SUM, comm);
+
+      /* 4. keep the buckets that hold a requested rank; an odd bucket
+            holds keys equal to one pivot and answers its ranks */
+      int n_next = 0;
+      n_cnt = n_pv = 0;
+      for (int s = 0, a = 0; s < n_seg; s++) {
+         Segment* g = &seg[s];
+         if (g->size <= SELECT_CUTOFF) {
+            next[n_next++] = *g;
+            continue;
+         }
+         int first = g->first;
+         long long base = g->base;
+         int kk = g->k_first;
+         for (int b = 0; b < 2*n_piv[a] + 1; b++) {
+            int len = (int) cnt[n_cnt + b];
+            long long size = gcnt[n_cnt + b];
+            int k0 = kk;
+            while (kk < g->k_last && ks[kk] < base + size) kk++;
+            if (kk > k0) {
+               if (b % 2 == 1) {
+                  for (int j = k0; j < kk; j++)
+                     out[j] = piv[n_pv + b/2];
+               } else {
+                  next[n_next++] = (Segment) {first, first + len, base,
+                        size, k0, kk};
+               }
+            }
+            first += len;
+            base += size;
+         }
+         n_cnt += 2*n_piv[a] + 1;
+         n_pv += n_piv[a];
+         a++;
+      }
+      Segment* t = seg; seg = next; next = t;
+      n_seg = n_next;
+   }
+
+   Finish_small(cand, seg, n_seg, ks, out, p, comm);
+
+   free(cand); free(tmp); free(bid); free(seg); free(next); free(smp); free(all);
+   free(pool); free(piv); free(n_piv); free(cnt); free(gcnt);
+   return rounds;
+}
+
+
+/*-------------------------------------------------------------------
+ * Choose_pivots: pivots of active segment a from the weighted samples
+ *    The samples estimate the segment's distribution.  For every
+ *    requested rank t, pivots are placed about size/sqrt(#samples)
+ *    ranks below and above it, so the bucket between them is small
+ *    and very likely holds t.  Returns the number u of distinct
+ *    pivots, stored ascending in piv[].  Pivots are sampled keys, so
+ *    every bucket is smaller than the segment: each round progresses.
+ */
+int Choose_pivots(double all[], int n_act, int a, int p, long long ks[],
+      Segment* g, Sample pool[], int piv[]) {
+
+   int n_pool = 0, n = 0, u = 0;
+   double delta;
+
+   for (int r = 0; r < p; r++)
+      for (int j = 0; j < S_PER; j++) {
+         double* x = &all[(size_t) r*2*n_act*S_PER + 2*(a*S_PER + j)];
+         if (x[1] > 0.0) {
+            pool[n_pool].value = x[0];
+            pool[n_pool].weight = x[1];
+            n_pool++;
+         }
+      }
+   qsort(pool, n_pool, sizeof(Sample), Compare_sample);
+   delta = g->size / sqrt((double) n_pool);
+
+   /* targets ascending, so one sweep over the cumulative weight */
+   double cum = pool[0].weight;
+   int j = 0;
+   for (int kk = g->k_first; kk < g->k_last; kk++)
+      for (int side = -1; side <= 1; side += 2) {
+         double target = (ks[kk] - g->base) + side*delta;
+         while (j < n_pool - 1 && cum <= target)
+            cum += pool[++j].weight;
+         piv[n++] = (int) pool[j].value;
+      }
+
+   for (int i = 0; i < n; i++)
+      if (u == 0 || piv[i] != piv[u-1])
+         piv[u++] = piv[i];
+   return u;
+}
+
+
+/*-------------------------------------------------------------------
+ * Bucket_of: bucket 2j holds keys strictly between piv[j-1] and
+ *    piv[j], bucket 2j+1 holds keys equal to piv[j]
+ */
+int Bucket_of(int x, int piv[], int u) {
+   int lo = 0, hi = u;      /* first pivot >= x */
+   while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (piv[mid] < x) lo = mid + 1;
+      else hi = mid;
+   }
+   return (lo < u && piv[lo] == x) ? 2*lo + 1 : 2*lo;
+}
+
+
+/*-------------------------------------------------------------------
+ * Bucket_split: out[first..last) = cand[first..last) ordered by
+ *    bucket (counting pass keeps the bucket of each key in bid[],
+ *    then a stable scatter); cnt[b] = local keys in bucket b
+ */
+void Bucket_split(int cand[], int out[], int bid[], int first, int last,
+      int piv[], int u, long long cnt[]) {
+
+   int n_b = 2*u + 1;
+   int *pos = (int*) malloc(n_b * sizeof(int));
+
+   for (int b = 0; b < n_b; b++)
+      cnt[b] = 0;
+   for (int i = first; i < last; i++) {
+      bid[i] = Bucket_of(cand[i], piv, u);
+      cnt[bid[i]]++;
+   }
+
+   pos[0] = first;
+   for (int b = 1; b < n_b; b++)
+      pos[b] = pos[b-1] + (int) cnt[b-1];
+   for (int i = first; i < last; i++)
+      out[pos[bid[i]]++] = cand[i];
+
+   free(pos);
+}
+
+
+/*-------------------------------------------------------------------
+ * Finish_small: gather the (small) remaining segments everywhere and
+ *    answer their ranks with a local sort
+ */
+void Finish_small(int cand[], Segment seg[], int n_seg, long long ks[],
+      int out[], int p, MPI_Comm comm) {
+
+   int *my_cnt  = (int*) malloc((n_seg + 1) * sizeof(int));
+   int *all_cnt = (int*) malloc((size_t) p*(n_seg + 1) * sizeof(int));
+   int *recvcounts = (int*) malloc(p * sizeof(int));
+   int *displs = (int*) malloc(p * sizeof(int));
+   int n_mine = 0, total = 0, *send, *recv, *keys;
+
+   for (int s = 0; s < n_seg; s++) {
+      my_cnt[s] = seg[s].last - seg[s].first;
+      n_mine += my_cnt[s];
+   }
+   my_cnt[n_seg] = n_mine;
+   MPI_Allgather(my_cnt, n_seg + 1, MPI_INT, all_cnt, n_seg + 1, MPI_INT,
+         comm);
+
+   for (int r = 0; r < p; r++) {
+      recvcounts[r] = all_cnt[r*(n_seg + 1) + n_seg];
+      displs[r] = total;
+      total += recvcounts[r];
+   }
+   send = (int*) malloc((n_mine + 1) * sizeof(int));
+   recv = (int*) malloc((total + 1) * sizeof(int));
+   keys = (int*) malloc((total + 1) * sizeof(int));
+   for (int s = 0, off = 0; s < n_seg; s++) {
+      memcpy(send + off, cand + seg[s].first, my_cnt[s] * sizeof(int));
+      off += my_cnt[s];
+   }
+   MPI_Allgatherv(send, n_mine, MPI_INT, recv, recvcounts, displs,
+         MPI_INT, comm);
+
+   /* segment s of process r starts after r's segments 0..s-1 */
+   for (int s = 0; s < n_seg; s++) {
+      int len = 0;
+      for (int r = 0; r < p; r++) {
+         int off = displs[r];
+         for (int s2 = 0; s2 < s; s2++)
+            off += all_cnt[r*(n_seg + 1) + s2];
+         int c = all_cnt[r*(n_seg + 1) + s];
+         memcpy(keys + len, recv + off, c * sizeof(int));
+         len += c;
+      }
+      qsort(keys, len, sizeof(int), Compare);
+      for (int j = seg[s].k_first; j < seg[s].k_last; j++)
+         out[j] = keys[ks[j] - seg[s].base];
+   }
+
+   free(my_cnt); free(all_cnt); free(recvcounts); free(displs);
+   free(send); free(recv); free(keys);
+}
+
+
+/*-------------------------------------------------------------------
+ * Top_k: out[0..k) = the k largest keys of the distributed list,
+ *    largest first, on every process
+ *    Each process keeps its k largest in a min-heap (padded with
+ *    INT_MIN when it holds fewer than k), sorts them descending, and
+ *    MPI_Allreduce merges the lists pairwise with Topk_merge over a
+ *    contiguous type of k ints.
+ */
+void Top_k(int A[], int n, int k, int out[], MPI_Comm comm) {
+
+   int *heap = (int*) malloc(k * sizeof(int));
+   MPI_Datatype list_t;
+   MPI_Op op;
+
+   for (int i = 0; i < k; i++)
+      heap[i] = INT_MIN;
+   for (int i = 0; i < n; i++)
+      if (A[i] > heap[0]) {
+         heap[0] = A[i];
+         Sift_down_min(heap, k, 0);
+      }
+   qsort(heap, k, sizeof(int), Compare_desc);
+
+   MPI_Type_contiguous(k, MPI_INT, &list_t);
+   MPI_Type_commit(&list_t);
+   MPI_Op_create(Topk_merge, 1, &op);
+   MPI_Allreduce(heap, out, 1, list_t, op, comm);
+   MPI_Op_free(&op);
+   MPI_Type_free(&list_t);
+
+   free(heap);
+}
+
+
+/*-------------------------------------------------------------------
+ * Topk_merge: MPI_Op, inout = k largest of in and inout (descending)
+ *    k comes from the size of the datatype.
+ */
+void Topk_merge(void* in_p, void* inout_p, int* len, MPI_Datatype* type) {
+
+   int size, k;
+
+   MPI_Type_size(*type, &size);
+   k = size / sizeof(int);
+   int *tmp = (int*) malloc(k * sizeof(int));
+
+   for (int l = 0; l < *len; l++) {
+      int *a = (int*) in_p + l*k, *b = (int*) inout_p + l*k;
+      int i = 0, j = 0;
+      for (int t = 0; t < k; t++)
+         tmp[t] = (a[i] >= b[j]) ? a[i++] : b[j++];
+      memcpy(b, tmp, k * sizeof(int));
+   }
+
+   free(tmp);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sift_down_min: restore the min-heap property below heap[i]
+ */
+void Sift_down_min(int heap[], int k, int i) {
+   int x = heap[i];
+   while (2*i + 1 < k) {
+      int c = 2*i + 1;
+      if (c + 1 < k && heap[c+1] < heap[c]) c++;
+      if (heap[c] >= x) break;
+      heap[i] = heap[c];
+      i = c;
+   }
+   heap[i] = x;
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort (reference)
+ */
+void Sort(int local_A[], int local_n, int my_rank, int p, MPI_Comm comm) {
+
+   int phase, partner;
+   int *temp_B = malloc(local_n*sizeof(int));
+   int *temp_C = malloc(local_n*sizeof(int));
+   int even_partner, odd_partner;
+
+   if (my_rank % 2 != 0) {
+      even_partner = my_rank - 1;
+      odd_partner = my_rank + 1;
+      if (odd_partner == p) odd_partner = MPI_PROC_NULL;
+   } else {
+      even_partner = my_rank + 1;
+      if (even_partner == p) even_partner = MPI_PROC_NULL;
+      odd_partner = my_rank - 1;
+   }
+
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   for (phase = 0; phase < p; phase++) {
+      partner = (phase % 2 == 0) ? even_partner : odd_partner;
+      if (partner < 0) continue;
+
+      MPI_Sendrecv(local_A, local_n, MPI_INT, partner, 0,
+                   temp_B, local_n, MPI_INT, partner, 0,
+                   comm, MPI_STATUS_IGNORE);
+      if (my_rank < partner)
+         Merge_low(local_A, temp_B, temp_C, local_n);
+      else
+         Merge_high(local_A, temp_B, temp_C, local_n);
+   }
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low
+ */
+void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
+               int local_n) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < local_n) {
+      if (my_keys[m_i] <= recv_keys[r_i])
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high
+ */
+void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
+                int local_n) {
+
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+
+   while (ci >= 0) {
+      if (my_keys[ai] >= recv_keys[bi])
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Values_at: out[j] = key at global index idx[j] of the sorted list
+ *    (block distribution, local_n keys per process)
+ */
+void Values_at(int local_A[], int local_n, long long idx[], int m,
+      int out[], int my_rank, MPI_Comm comm) {
+
+   int *mine = (int*) malloc(m * sizeof(int));
+
+   for (int j = 0; j < m; j++)
+      mine[j] = (idx[j] / local_n == my_rank) ? local_A[idx[j] % local_n]
+                                              : INT_MIN;
+   MPI_Allreduce(mine, out, m, MPI_INT, MPI_MAX, comm);
+   free(mine);
+}
+
+
+/*-------------------------------------------------------------------
+ * Min_time
+ */
+double Min_time(double times[], int reps) {
+   double min = times[0];
+   for (int i = 1; i < reps; i++)
+      if (times[i] < min) min = times[i];
+   return min;
+}
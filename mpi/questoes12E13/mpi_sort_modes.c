@@ -0,0 +1,618 @@
+/*
+ * File:     mpi_sort_modes.c
+ * Purpose:  Compare three distributed sorts on the same input, timed as
+ *           in mpi_odd_even_time.c (min, mean, median):
+ *           - o: odd-even transposition sort, p phases (the original)
+ *           - b: bitonic sort, log2(p)*(log2(p)+1)/2 phases of the same
+ *                compare-split (MPI_Sendrecv + Merge_low/Merge_high)
+ *           - h: hypercube quicksort: pivot broadcast in each subcube,
+ *                exchange across one dimension, MPI_Comm_split in half
+ *
+ * Compile:  mpicc -O2 -Wall -o mpi_sort_modes mpi_sort_modes.c -lm
+ * Run:      mpirun -np <p> ./mpi_sort_modes <g|i> <global_n> [modes]
+ *
+ * Notes:
+ * 1. global_n must be divisible by p
+ * 2. modes is any combination of o, b, h (default "obh")
+ * 3. p need not be a power of two:
+ *    - bitonic pads to the next power of two with virtual processes
+ *      holding +infinity; a compare-split with a virtual partner
+ *      leaves the real process unchanged, so it is skipped
+ *    - hypercube quicksort folds the processes above the largest
+ *      power of two into their partners below it first; those
+ *      processes end up empty
+ * 4. Hypercube quicksort leaves an uneven distribution; max/min keys
+ *    per process are printed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../include/fastio.h"
+#include "../include/keygen.h"
+
+#define REPS 5         /* Number of repetitions for timing */
+const int RMAX = 100;
+
+/* Function prototypes */
+void Usage(char* program);
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n);
+int  Compare(const void* a_p, const void* b_p);
+
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+              char* gi_p, char modes[], int my_rank, int p, MPI_Comm comm);
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+
+void Sort(int local_A[], int local_n, int my_rank, int p, MPI_Comm comm);
+void Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+          int local_n, int phase, int even_partner, int odd_partner,
+          int my_rank, MPI_Comm comm);
+void Bitonic_sort(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Compare_split(int local_A[], int temp_B[], int temp_C[],
+          int local_n, int partner, int my_rank, MPI_Comm comm);
+void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n);
+void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
+          int local_n);
+
+int  Hypercube_qsort(int** A_p, int n, int my_rank, int p, MPI_Comm comm);
+int  Exchange_merge(int** A_p, int keep_first, int keep_n, int send_first,
+          int send_n, int partner, MPI_Comm comm);
+void Merge_lists(int A[], int a_n, int B[], int b_n, int C[]);
+int  Lower_bound(int A[], int n, int v);
+int  Upper_bound(int A[], int n, int v);
+
+int  Check_sorted(int local_A[], int local_n, int my_rank, int p,
+          MPI_Comm comm);
+void Get_stats(double times[], int reps, double* min_p, double* mean_p,
+          double* median_p);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+
+   int my_rank, p;
+   char g_i, modes[8];
+   int *input, *local_A;
+   int global_n, local_n, n;
+   MPI_Comm comm;
+   double times[REPS], min[3], mean[3], median[3];
+   int ok[3], max_n[3], min_n[3];
+   const char* names[3] = {"odd-even", "bitonic", "hypercube quicksort"};
+   const char letters[3] = {'o', 'b', 'h'};
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &global_n, &local_n, &g_i, modes, my_rank, p, comm);
+
+   /* every mode sorts a copy of the same input */
+   input = (int*) malloc(local_n * sizeof(int));
+   if (input == NULL) {
+      fprintf(stderr, "Proc %d: malloc failed\n", my_rank);
+      MPI_Abort(comm, 1);
+   }
+   if (g_i == 'g')
+      Generate_list(input, local_n, my_rank, global_n);
+   else
+      Read_list(input, local_n, my_rank, p, comm);
+
+   for (int m = 0; m < 3; m++) {
+      if (strchr(modes, letters[m]) == NULL) continue;
+      ok[m] = 1;
+
+      for (int rep = 0; rep < REPS; rep++) {
+         local_A = (int*) malloc(local_n * sizeof(int));
+         memcpy(local_A, input, local_n * sizeof(int));
+         n = local_n;
+
+         MPI_Barrier(comm);
+         double start = MPI_Wtime();
+
+         if (letters[m] == 'o')
+            Sort(local_A, local_n, my_rank, p, comm);
+         else if (letters[m] == 'b')
+            Bitonic_sort(local_A, local_n, my_rank, p, comm);
+         else
+            n = Hypercube_qsort(&local_A, local_n, my_rank, p, comm);
+
+         MPI_Barrier(comm);
+         double finish = MPI_Wtime();
+
+         times[rep] = finish - start;
+         ok[m] &= Check_sorted(local_A, n, my_rank, p, comm);
+         free(local_A);
+      }
+
+      MPI_Reduce(&n, &max_n[m], 1, MPI_INT, MPI_MAX, 0, comm);
+      MPI_Reduce(&n, &min_n[m], 1, MPI_INT, MPI_MIN, 0, comm);
+      if (my_rank == 0)
+         Get_stats(times, REPS, &min[m], &mean[m], &median[m]);
+   }
+
+   if (my_rank == 0) {
+      printf("\n================ Timing results ================\n");
+      printf("p = %d, global_n = %d, repetitions = %d\n", p, global_n, REPS);
+      for (int m = 0; m < 3; m++) {
+         if (strchr(modes, letters[m]) == NULL) continue;
+         printf("\n%s:\n", names[m]);
+         printf("   Minimum time : %e seconds\n", min[m]);
+         printf("   Mean time    : %e seconds\n", mean[m]);
+         printf("   Median time  : %e seconds\n", median[m]);
+         if (strchr(modes, 'o') != NULL && m > 0)
+            printf("   Speedup vs odd-even (min) : %.2f\n", min[0] / min[m]);
+         printf("   Keys per process : max = %d, min = %d\n",
+                max_n[m], min_n[m]);
+         printf("   Result check : %s\n", ok[m] ? "sorted" : "NOT SORTED");
+      }
+      printf("================================================\n\n");
+   }
+
+   free(input);
+
+   MPI_Finalize();
+   return 0;
+} /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:   Generate_list
+ * Purpose:    Fill list with this process' block of the global list
+ *             (keygen.h, uniform in [0, RMAX), the same for every p)
+ */
+void Generate_list(int local_A[], int local_n, int my_rank, int global_n) {
+   Keygen_fill_int(local_A, (long long) my_rank*local_n, local_n,
+         global_n, 'u', RMAX, KEYGEN_SEED);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ */
+void Usage(char* program) {
+   fprintf(stderr, "usage:  mpirun -np <p> %s <g|i> <global_n> [modes]\n",
+       program);
+   fprintf(stderr, "   global_n must be divisible by p\n");
+   fprintf(stderr, "   modes: any of o (odd-even), b (bitonic), "
+       "h (hypercube quicksort); default obh\n");
+   fflush(stderr);
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ */
+void Get_args(int argc, char* argv[], int* global_n_p, int* local_n_p,
+         char* gi_p, char modes[], int my_rank, int p, MPI_Comm comm) {
+
+   if (my_rank == 0) {
+      if (argc != 3 && argc != 4) {
+         Usage(argv[0]);
+         *global_n_p = -1;
+      } else {
+         *gi_p = argv[1][0];
+         *global_n_p = atoi(argv[2]);
+         strncpy(modes, (argc == 4) ? argv[3] : "obh", 7);
+         modes[7] = '\0';
+         if (*global_n_p % p != 0 || strspn(modes, "obh") != strlen(modes)) {
+            Usage(argv[0]);
+            *global_n_p = -1;
+         }
+      }
+   }
+
+   MPI_Bcast(gi_p, 1, MPI_CHAR, 0, comm);
+   MPI_Bcast(modes, 8, MPI_CHAR, 0, comm);
+   MPI_Bcast(global_n_p, 1, MPI_INT, 0, comm);
+
+   if (*global_n_p <= 0) {
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   *local_n_p = *global_n_p/p;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function:   Read_list
+ */
+void Read_list(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int *temp = NULL;
+
+   if (my_rank == 0) {
+      temp = (int*) malloc(p*local_n*sizeof(int));
+      printf("Enter the elements of the list\n");
+      Fio_in* in = Fio_open(stdin);
+      for (int i = 0; i < p*local_n; i++)
+         Fio_read_int(in, &temp[i]);
+      Fio_close(in);
+   }
+
+   MPI_Scatter(temp, local_n, MPI_INT,
+               local_A, local_n, MPI_INT, 0, comm);
+
+   if (my_rank == 0)
+      free(temp);
+}
+
+
+/*-------------------------------------------------------------------
+ * qsort comparator
+ */
+int Compare(const void* a_p, const void* b_p) {
+   int a = *((int*)a_p);
+   int b = *((int*)b_p);
+   return (a > b) - (a < b);
+}
+
+
+/*-------------------------------------------------------------------
+ * Sort: odd-even transposition sort
+ */
+void Sort(int local_A[], int local_n, int my_rank,
+         int p, MPI_Comm comm) {
+
+   int phase;
+   int *temp_B = malloc(local_n*sizeof(int));
+   int *temp_C = malloc(local_n*sizeof(int));
+
+   int even_partner, odd_partner;
+
+   if (my_rank % 2 != 0) {
+      even_partner = my_rank - 1;
+      odd_partner = my_rank + 1;
+      if (odd_partner == p) odd_partner = MPI_PROC_NULL;
+   } else {
+      even_partner = my_rank + 1;
+      if (even_partner == p) even_partner = MPI_PROC_NULL;
+      odd_partner = my_rank - 1;
+   }
+
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   for (phase = 0; phase < p; phase++) {
+      Odd_even_iter(local_A, temp_B, temp_C, local_n, phase,
+                    even_partner, odd_partner, my_rank, comm);
+   }
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Odd-even iteration
+ */
+void Odd_even_iter(int local_A[], int temp_B[], int temp_C[],
+        int local_n, int phase, int even_partner, int odd_partner,
+        int my_rank, MPI_Comm comm) {
+
+   int partner = (phase % 2 == 0) ? even_partner : odd_partner;
+
+   if (partner >= 0)
+      Compare_split(local_A, temp_B, temp_C, local_n, partner, my_rank,
+            comm);
+}
+
+
+/*-------------------------------------------------------------------
+ * Bitonic_sort
+ *    Ascending-only form of the bitonic network: the first step of
+ *    stage k pairs rank with its mirror in the 2^k block
+ *    (rank ^ (2^k - 1)), the remaining steps pair rank ^ 2^j.  The
+ *    lower rank of a pair always keeps the small keys, so virtual
+ *    processes (>= p) holding +infinity never have to move, and
+ *    pairs with a virtual partner are skipped.
+ */
+void Bitonic_sort(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int *temp_B = malloc(local_n*sizeof(int));
+   int *temp_C = malloc(local_n*sizeof(int));
+   int dim = 0, partner;
+
+   while ((1 << dim) < p) dim++;
+
+   qsort(local_A, local_n, sizeof(int), Compare);
+
+   for (int k = 1; k <= dim; k++) {
+      for (int j = k-1; j >= 0; j--) {
+         if (j == k-1)
+            partner = my_rank ^ ((1 << k) - 1);
+         else
+            partner = my_rank ^ (1 << j);
+         if (partner < p)
+            Compare_split(local_A, temp_B, temp_C, local_n, partner,
+                  my_rank, comm);
+      }
+   }
+
+   free(temp_B);
+   free(temp_C);
+}
+
+
+/*-------------------------------------------------------------------
+ * Compare_split: exchange with partner; lower rank keeps the small half
+ */
+void Compare_split(int local_A[], int temp_B[], int temp_C[],
+        int local_n, int partner, int my_rank, MPI_Comm comm) {
+
+   MPI_Status status;
+
+   MPI_Sendrecv(local_A, local_n, MPI_INT, partner, 0,
+                temp_B, local_n, MPI_INT, partner, 0,
+                comm, &status);
+
+   if (my_rank < partner)
+      Merge_low(local_A, temp_B, temp_C, local_n);
+   else
+      Merge_high(local_A, temp_B, temp_C, local_n);
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_low
+ */
+void Merge_low(int my_keys[], int recv_keys[], int temp_keys[],
+               int local_n) {
+
+   int m_i = 0, r_i = 0, t_i = 0;
+
+   while (t_i < local_n) {
+      if (my_keys[m_i] <= recv_keys[r_i])
+         temp_keys[t_i++] = my_keys[m_i++];
+      else
+         temp_keys[t_i++] = recv_keys[r_i++];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_high
+ */
+void Merge_high(int my_keys[], int recv_keys[], int temp_keys[],
+                int local_n) {
+
+   int ai = local_n-1;
+   int bi = local_n-1;
+   int ci = local_n-1;
+
+   while (ci >= 0) {
+      if (my_keys[ai] >= recv_keys[bi])
+         temp_keys[ci--] = my_keys[ai--];
+      else
+         temp_keys[ci--] = recv_keys[bi--];
+   }
+
+   memcpy(my_keys, temp_keys, local_n*sizeof(int));
+}
+
+
+/*-------------------------------------------------------------------
+ * Hypercube_qsort
+ *    In a subcube of size s:
+ *    1. the subcube root gathers every local median and broadcasts
+ *       their median as the pivot
+ *    2. the lower half of the subcube should end with half the keys;
+ *       an MPI_Allreduce of the counts below/equal to the pivot tells
+ *       each process what fraction of its pivot-equal keys goes low,
+ *       so duplicate-heavy input does not pile onto one side
+ *    3. rank r exchanges with r ^ s/2 and merges what it kept with
+ *       what it received
+ *    4. MPI_Comm_split halves the subcube
+ *    *A_p is reallocated as the local count changes.
+ * Return: final local count
+ */
+int Hypercube_qsort(int** A_p, int n, int my_rank, int p, MPI_Comm comm) {
+
+   int p2 = 1, sub_rank, sub_size;
+   MPI_Comm sub, half;
+
+   while (2*p2 <= p) p2 *= 2;
+   qsort(*A_p, n, sizeof(int), Compare);
+
+   /* fold the processes above the power of two into the cube */
+   if (my_rank >= p2)
+      n = Exchange_merge(A_p, 0, 0, 0, n, my_rank - p2, comm);
+   else if (my_rank + p2 < p)
+      n = Exchange_merge(A_p, 0, n, n, 0, my_rank + p2, comm);
+
+   MPI_Comm_split(comm, my_rank < p2 ? 0 : MPI_UNDEFINED, my_rank, &sub);
+   if (sub == MPI_COMM_NULL) return n;
+
+   MPI_Comm_size(sub, &sub_size);
+   while (sub_size > 1) {
+      int med[2], *meds = NULL, pivot = 0;
+      long long counts[3], totals[3];
+
+      MPI_Comm_rank(sub, &sub_rank);
+
+      /* 1. pivot: median of the local medians */
+      med[0] = (n > 0);
+      med[1] = (n > 0) ? (*A_p)[n/2] : 0;
+      if (sub_rank == 0) meds = malloc(2*sub_size*sizeof(int));
+      MPI_Gather(med, 2, MPI_INT, meds, 2, MPI_INT, 0, sub);
+      if (sub_rank == 0) {
+         int m = 0;
+         for (int q = 0; q < sub_size; q++)
+            if (meds[2*q]) meds[m++] = meds[2*q+1];
+         if (m > 0) {
+            qsort(meds, m, sizeof(int), Compare);
+            pivot = meds[m/2];
+         }
+         free(meds);
+      }
+      MPI_Bcast(&pivot, 1, MPI_INT, 0, sub);
+
+      /* 2. where to cut the local list */
+      int lt = Lower_bound(*A_p, n, pivot);
+      int le = Upper_bound(*A_p, n, pivot);
+      counts[0] = lt;
+      counts[1] = le - lt;
+      counts[2] = n;
+      MPI_Allreduce(counts, totals, 3, MPI_LONG_LONG, MPI_SUM, sub);
+      double frac = 0.0;
+      if (totals[1] > 0) {
+         frac = (double) (totals[2]/2 - totals[0]) / totals[1];
+         if (frac < 0.0) frac = 0.0;
+         if (frac > 1.0) frac = 1.0;
+      }
+      int cut = lt + (int) (frac * (le - lt) + 0.5);
+
+      /* 3. exchange across the top dimension of the subcube */
+      int lower = sub_rank < sub_size/2;
+      int partner = sub_rank ^ (sub_size/2);
+      if (lower)
+         n = Exchange_merge(A_p, 0, cut, cut, n - cut, partner, sub);
+      else
+         n = Exchange_merge(A_p, cut, n - cut, 0, cut, partner, sub);
+
+      /* 4. recurse on my half */
+      MPI_Comm_split(sub, lower, sub_rank, &half);
+      MPI_Comm_free(&sub);
+      sub = half;
+      MPI_Comm_size(sub, &sub_size);
+   }
+   MPI_Comm_free(&sub);
+
+   return n;
+}
+
+
+/*-------------------------------------------------------------------
+ * Exchange_merge: send (*A_p)[send_first..+send_n) to partner, receive
+ *    its keys, and replace *A_p by the merge of the kept range
+ *    (*A_p)[keep_first..+keep_n) with the received keys
+ * Return: new local count
+ */
+int Exchange_merge(int** A_p, int keep_first, int keep_n, int send_first,
+         int send_n, int partner, MPI_Comm comm) {
+
+   int recv_n;
+   int *recv, *merged;
+
+   MPI_Sendrecv(&send_n, 1, MPI_INT, partner, 1,
+                &recv_n, 1, MPI_INT, partner, 1, comm, MPI_STATUS_IGNORE);
+   recv = malloc((recv_n > 0 ? recv_n : 1)*sizeof(int));
+   MPI_Sendrecv(*A_p + send_first, send_n, MPI_INT, partner, 0,
+                recv, recv_n, MPI_INT, partner, 0, comm, MPI_STATUS_IGNORE);
+
+   merged = malloc((keep_n + recv_n > 0 ? keep_n + recv_n : 1)*sizeof(int));
+   Merge_lists(*A_p + keep_first, keep_n, recv, recv_n, merged);
+
+   free(recv);
+   free(*A_p);
+   *A_p = merged;
+   return keep_n + recv_n;
+}
+
+
+/*-------------------------------------------------------------------
+ * Merge_lists: C = merge of sorted A[0..a_n) and B[0..b_n)
+ */
+void Merge_lists(int A[], int a_n, int B[], int b_n, int C[]) {
+   int a_i = 0, b_i = 0, c_i = 0;
+
+   while (a_i < a_n && b_i < b_n) {
+      if (A[a_i] <= B[b_i])
+         C[c_i++] = A[a_i++];
+      else
+         C[c_i++] = B[b_i++];
+   }
+   while (a_i < a_n) C[c_i++] = A[a_i++];
+   while (b_i < b_n) C[c_i++] = B[b_i++];
+}
+
+
+/*-------------------------------------------------------------------
+ * Lower_bound / Upper_bound: first index with A[i] >= v / A[i] > v
+ */
+int Lower_bound(int A[], int n, int v) {
+   int lo = 0, hi = n;
+   while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (A[mid] < v) lo = mid + 1; else hi = mid;
+   }
+   return lo;
+}
+
+int Upper_bound(int A[], int n, int v) {
+   int lo = 0, hi = n;
+   while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (A[mid] <= v) lo = mid + 1; else hi = mid;
+   }
+   return lo;
+}
+
+
+/*-------------------------------------------------------------------
+ * Check_sorted: local order plus the first key to our right
+ *    Processes with no keys pass the first key through from their
+ *    right, so the check also works with empty processes.
+ *    Returns 1 on every rank if the distributed list is sorted.
+ */
+int Check_sorted(int local_A[], int local_n, int my_rank, int p,
+         MPI_Comm comm) {
+
+   int local_ok = 1, ok;
+   int has, next_has = 0, next_first = 0, my_first;
+   int left  = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   int right = (my_rank < p-1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   for (int i = 1; i < local_n; i++)
+      if (local_A[i-1] > local_A[i]) local_ok = 0;
+
+   if (right != MPI_PROC_NULL) {
+      int msg[2];
+      MPI_Recv(msg, 2, MPI_INT, right, 1, comm, MPI_STATUS_IGNORE);
+      next_has = msg[0];
+      next_first = msg[1];
+   }
+   if (local_n > 0 && next_has && local_A[local_n-1] > next_first)
+      local_ok = 0;
+   has = (local_n > 0) || next_has;
+   my_first = (local_n > 0) ? local_A[0] : next_first;
+   if (left != MPI_PROC_NULL) {
+      int msg[2] = {has, my_first};
+      MPI_Send(msg, 2, MPI_INT, left, 1, comm);
+   }
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   return ok;
+}
+
+
+/*-------------------------------------------------------------------
+ * Get_stats: min, mean, median of times[] (sorts times in place)
+ */
+void Get_stats(double times[], int reps, double* min_p, double* mean_p,
+         double* median_p) {
+
+   for (int i = 0; i < reps-1; i++)
+      for (int j = i+1; j < reps; j++)
+         if (times[j] < times[i]) {
+            double tmp = times[i];
+            times[i] = times[j];
+            times[j] = tmp;
+         }
+
+   *min_p = times[0];
+   *mean_p = 0.0;
+   for (int i = 0; i < reps; i++)
+      *mean_p += times[i];
+   *mean_p /= reps;
+
+   *median_p = (reps % 2 == 1) ? times[reps/2]
+                               : (times[reps/2 - 1] + times[reps/2]) / 2.0;
+}
@@ -17,7 +17,7 @@ module load gcc/14.2.0_sequana
 module load openmpi/gnu/4.1.4_sequana
 
 # Compila
-mpicc -O2 -Wall -o mpi_odd_even_time mpi_odd_even_time.c
+mpicc -O2 -Wall -o mpi_odd_even_time mpi_odd_even_time.c -lm
 
 GLOBAL_N=96000000   # divisível por 1,2,4,8,16,24,48,96
 
@@ -0,0 +1,38 @@
+#!/bin/bash
+#SBATCH --nodes=4
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_odd_even_pipeline
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_pipeline_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questoes12E13/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O2 -Wall -o mpi_odd_even_pipeline mpi_odd_even_pipeline.c -lm
+
+GLOBAL_N=96000000   # divisível por 1,2,4,8,16,24,48,96
+
+# Tamanhos de chunk (em chaves) a comparar
+CHUNK_LIST="16384 65536 262144 1048576"
+
+for NP in 24 48 96
+do
+    for CHUNK in $CHUNK_LIST
+    do
+        echo ""
+        echo ">>> p=$NP | chunk=$CHUNK"
+        mpirun -np $NP ./mpi_odd_even_pipeline g $GLOBAL_N $CHUNK
+    done
+done
+
+echo ""
+echo "FIM DO JOB"
@@ -0,0 +1,40 @@
+#!/bin/bash
+#SBATCH --nodes=4
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_odd_even_radix
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_radix_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questoes12E13/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O2 -Wall -o mpi_odd_even_radix mpi_odd_even_radix.c -lm
+
+GLOBAL_N=96000000   # mesma carga do script13.sh
+
+# q = qsort, s = introsort (std::sort), r = counting/radix
+# RMAX: 100 (Generate_list original) e 0 (chaves de 32 bits)
+for RMAX in 100 0
+do
+    for NP in 1 24 48 96
+    do
+        for K in q s r
+        do
+            echo ""
+            echo ">>> p=$NP | kernel=$K | rmax=$RMAX"
+            mpirun -np $NP ./mpi_odd_even_radix g $GLOBAL_N $K $RMAX
+        done
+    done
+done
+
+echo ""
+echo "FIM DO JOB"
@@ -0,0 +1,36 @@
+#!/bin/bash
+#SBATCH --nodes=4
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_select
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_select_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questoes12E13/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O2 -Wall -o mpi_select mpi_select.c -lm
+
+GLOBAL_N=96000000   # divisível por 1,2,4,8,16,24,48,96
+
+# mediana, 100-quantis e top-1000, comparados com o odd-even completo
+for NP in 24 48 96
+do
+    for OP in "m" "q 100" "t 1000"
+    do
+        echo ""
+        echo ">>> p=$NP | $OP"
+        mpirun -np $NP ./mpi_select g $GLOBAL_N $OP
+    done
+done
+
+echo ""
+echo "FIM DO JOB"
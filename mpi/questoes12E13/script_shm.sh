@@ -0,0 +1,34 @@
+#!/bin/bash
+#SBATCH --nodes=4
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_odd_even_shm
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_shm_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questoes12E13/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O2 -Wall -o mpi_odd_even_shm mpi_odd_even_shm.c -lm
+
+GLOBAL_N=96000000   # divisível por 1,2,4,8,16,24,48,96
+
+# 24 tarefas por nó: com 24 só há pares intra-nó; com 48 e 96 os pares
+# na fronteira entre nós usam o caminho de mensagens
+for NP in 24 48 96
+do
+    echo ""
+    echo ">>> p=$NP"
+    mpirun -np $NP ./mpi_odd_even_shm g $GLOBAL_N
+done
+
+echo ""
+echo "FIM DO JOB"
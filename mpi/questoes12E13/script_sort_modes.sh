@@ -0,0 +1,33 @@
+#!/bin/bash
+#SBATCH --nodes=4
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_sort_modes
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_sort_modes_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questoes12E13/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O2 -Wall -o mpi_sort_modes mpi_sort_modes.c -lm
+
+GLOBAL_N=96000000   # divisível por 24, 32, 48, 64, 96
+
+# odd-even (o), bitonic (b) e hypercube quicksort (h) na mesma execução
+for NP in 24 32 48 64 96
+do
+    echo ""
+    echo ">>> Executando com $NP processos"
+    mpirun -np $NP ./mpi_sort_modes g $GLOBAL_N obh
+done
+
+echo ""
+echo "FIM DO JOB"
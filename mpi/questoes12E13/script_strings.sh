@@ -0,0 +1,36 @@
+#!/bin/bash
+#SBATCH --nodes=4
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_odd_even_strings
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_strings_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questoes12E13/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O2 -Wall -o mpi_odd_even_strings mpi_odd_even_strings.c -lm
+
+GLOBAL_N=9600000    # divisível por 1,2,4,8,16,24,48,96 (~600 MB de linhas de log)
+
+# linhas de log, URLs e palavras curtas: merge com LCP x strcmp
+for NP in 24 48 96
+do
+    for DIST in l u w
+    do
+        echo ""
+        echo ">>> p=$NP | dist=$DIST"
+        mpirun -np $NP ./mpi_odd_even_strings g $GLOBAL_N $DIST
+    done
+done
+
+echo ""
+echo "FIM DO JOB"
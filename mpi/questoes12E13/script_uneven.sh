@@ -0,0 +1,48 @@
+#!/bin/bash
+#SBATCH --nodes=4
+#SBATCH --ntasks-per-node=24
+#SBATCH -p sequana_cpu_dev
+#SBATCH -J mpi_odd_even_uneven
+#SBATCH --exclusive
+#SBATCH --time=00:20:00
+#SBATCH --output=resultado_uneven_%j.log
+
+echo "Job ID: $SLURM_JOB_ID"
+echo "Nodes allocated: $SLURM_JOB_NODELIST"
+echo "======================================"
+
+cd /scratch/pex1272-ufersa/joao.lima2/questoes12E13/ || exit 1
+
+module load gcc/14.2.0_sequana
+module load openmpi/gnu/4.1.4_sequana
+
+# Compila
+mpicc -O2 -Wall -o mpi_odd_even_uneven mpi_odd_even_uneven.c -lm
+
+GLOBAL_N=10000000   # não divisível por 24, 48, 96
+
+# desbalanceamento da entrada, com e sem redistribuição no fim
+for NP in 24 48 96
+do
+    for SKEW in 0 1 5 50
+    do
+        for BAL in b n
+        do
+            echo ""
+            echo ">>> p=$NP | skew=$SKEW | $BAL"
+            mpirun -np $NP ./mpi_odd_even_uneven g $GLOBAL_N $SKEW $BAL
+        done
+    done
+done
+
+# casos pequenos: contagens desiguais e global_n < p (processos vazios)
+for CASE in "4 30 1" "3 16 1" "4 30 5" "6 16 50" "5 7 0" "24 10 0" "96 50 3"
+do
+    set -- $CASE
+    echo ""
+    echo ">>> p=$1 | global_n=$2 | skew=$3"
+    mpirun -np $1 ./mpi_odd_even_uneven g $2 $3 b
+done
+
+echo ""
+echo "FIM DO JOB"